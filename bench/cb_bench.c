@@ -0,0 +1,3724 @@
+/**
+ * @brief cactusbot benchmark main file
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "cb.h"
+#include "cb_arena.h"
+#include "cb_journal.h"
+#include "cb_scan.h"
+#include "cb_server.h"
+#include "cb_snapshot.h"
+#include "cb_trie.h"
+#include "cb_utf8.h"
+
+/**
+ * @brief current time getting function
+ * 
+ * @return monotonic time in seconds
+ */
+static double benchTime( void ) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+} // benchTime
+
+/**
+ * @brief pseudo-random number generation function (xorshift64)
+ * 
+ * @param[in,out] state generator state (non-null, non-zero)
+ * 
+ * @return next pseudo-random number
+ */
+static size_t benchRandom( size_t *const state ) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+} // benchRandom
+
+/// @brief leaf insertion order
+typedef enum __BenchOrder {
+    BENCH_ORDER_SORTED,   ///< ascending names
+    BENCH_ORDER_REVERSED, ///< descending names
+    BENCH_ORDER_RANDOM,   ///< shuffled names
+} BenchOrder;
+
+/**
+ * @brief leaf index benchmark function
+ * 
+ * @param[in] leafCount count of leaves to insert
+ * @param[in] leafIndex leaf index kind
+ * @param[in] order     insertion order
+ * @param[in] orderName insertion order name
+ */
+static void benchLeafIndex( const size_t leafCount, const CbLeafIndex leafIndex, const BenchOrder order, const char *orderName ) {
+    size_t *permutation = (size_t *)calloc(leafCount, sizeof(size_t));
+    Cb cb = cbCtor("объект 000000000", leafIndex);
+
+    if (permutation == NULL || cb == NULL) {
+        printf("    %-8s: allocation failed\n", orderName);
+        free(permutation);
+        cbDtor(cb);
+        return;
+    }
+
+    for (size_t i = 0; i < leafCount; i++)
+        permutation[i] = order == BENCH_ORDER_REVERSED
+            ? leafCount - i
+            : i + 1;
+
+    if (order == BENCH_ORDER_RANDOM) {
+        size_t state = 0x5EED;
+
+        for (size_t i = leafCount - 1; i > 0; i--) {
+            const size_t j = benchRandom(&state) % (i + 1);
+            const size_t tmp = permutation[i];
+
+            permutation[i] = permutation[j];
+            permutation[j] = tmp;
+        }
+    }
+
+    char name[32] = {0};
+    CbIter iter = cbIter(cb);
+
+    // each new leaf becomes next insertion point, so quest tree walk is O(1)
+    const double insertStart = benchTime();
+    for (size_t i = 0; i < leafCount; i++) {
+        snprintf(name, sizeof(name), "объект %09zu", permutation[i]);
+
+        if (!cbIterInsertCorrect(&iter, "условие", name)) {
+            printf("    %-8s: insertion failed\n", orderName);
+            break;
+        }
+        cbIterNext(&iter, true);
+    }
+    const double insertTime = benchTime() - insertStart;
+
+    const double findStart = benchTime();
+    size_t found = 0;
+    for (size_t i = 0; i < leafCount; i++) {
+        snprintf(name, sizeof(name), "объект %09zu", permutation[i]);
+        found += cbDefine(cb, name, NULL) != CB_DEFINE_STATUS_NO_SUBJECT;
+    }
+    const double findTime = benchTime() - findStart;
+
+    printf("    %-8s: insert %8.1f ns/leaf, find %8.1f ns/leaf (%zu/%zu found), index overhead %zu bytes\n",
+        orderName,
+        insertTime * 1e9 / (double)leafCount,
+        findTime * 1e9 / (double)leafCount,
+        found,
+        leafCount,
+        cbLeafIndexMemoryUsage(cb)
+    );
+
+    cbDtor(cb);
+    free(permutation);
+} // benchLeafIndex
+
+/**
+ * @brief leaf index benchmark set running function
+ * 
+ * @param[in] leafCount count of leaves
+ */
+static void benchLeafIndexAll( const size_t leafCount ) {
+    const struct {
+        CbLeafIndex leafIndex;
+        const char *name;
+    } leafIndices[] = {
+        {CB_LEAF_INDEX_TREE, "tree"},
+        {CB_LEAF_INDEX_HASH, "hash"},
+    };
+
+    for (size_t i = 0; i < sizeof(leafIndices) / sizeof(leafIndices[0]); i++) {
+        printf("%s leaf index, %zu leaves:\n", leafIndices[i].name, leafCount);
+        benchLeafIndex(leafCount, leafIndices[i].leafIndex, BENCH_ORDER_SORTED,   "sorted");
+        benchLeafIndex(leafCount, leafIndices[i].leafIndex, BENCH_ORDER_REVERSED, "reversed");
+        benchLeafIndex(leafCount, leafIndices[i].leafIndex, BENCH_ORDER_RANDOM,   "random");
+    }
+} // benchLeafIndexAll
+
+/**
+ * @brief random-shaped tree building function
+ * 
+ * @param[in] leafCount count of leaves
+ * @param[in] leafIndex leaf index kind
+ * 
+ * @return built tree, NULL if something went wrong
+ * 
+ * @note each leaf is inserted at the end of random walk, so tree depth is O(log n) on average.
+ */
+static Cb benchBuildRandomTree( const size_t leafCount, const CbLeafIndex leafIndex ) {
+    Cb cb = cbCtor("объект 0", leafIndex);
+    size_t state = 0xC0FFEE;
+    char name[32] = {0};
+
+    for (size_t i = 1; cb != NULL && i < leafCount; i++) {
+        CbIter iter = cbIter(cb);
+
+        while (!cbIterFinished(&iter))
+            cbIterNext(&iter, benchRandom(&state) & 1);
+
+        snprintf(name, sizeof(name), "объект %zu", i);
+
+        if (!cbIterInsertCorrect(&iter, "условие", name)) {
+            cbDtor(cb);
+            return NULL;
+        }
+    }
+
+    return cb;
+} // benchBuildRandomTree
+
+/**
+ * @brief whole file reading function
+ * 
+ * @param[in] path file path
+ * 
+ * @return zero-terminated file contents (allocated by malloc), NULL if something went wrong.
+ */
+static char * benchReadFile( const char *path ) {
+    FILE *file = fopen(path, "rb");
+
+    if (file == NULL)
+        return NULL;
+
+    fseek(file, 0, SEEK_END);
+    const size_t size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char *text = (char *)calloc(size + 1, 1);
+
+    if (text != NULL)
+        fread(text, 1, size, file);
+    fclose(file);
+
+    return text;
+} // benchReadFile
+
+/**
+ * @brief binary snapshot against text format loading benchmark function
+ * 
+ * @param[in] leafCount count of leaves
+ */
+static void benchSnapshot( const size_t leafCount ) {
+    const char *textPath = "cb_bench_snapshot.cb";
+    const char *snapshotPath = "cb_bench_snapshot.cbs";
+
+    printf("snapshot, %zu leaves:\n", leafCount);
+
+    Cb cb = benchBuildRandomTree(leafCount, CB_LEAF_INDEX_TREE);
+
+    if (cb == NULL) {
+        printf("    tree building failed\n");
+        return;
+    }
+
+    FILE *textFile = fopen(textPath, "w");
+    FILE *snapshotFile = fopen(snapshotPath, "wb");
+
+    if (textFile != NULL)
+        cbDump(textFile, cb);
+
+    const double saveStart = benchTime();
+    const bool saved = snapshotFile != NULL && cbSaveSnapshot(snapshotFile, cb);
+    const double saveTime = benchTime() - saveStart;
+
+    if (textFile != NULL)
+        fclose(textFile);
+    if (snapshotFile != NULL)
+        fclose(snapshotFile);
+    cbDtor(cb);
+
+    char *text = benchReadFile(textPath);
+
+    if (!saved || text == NULL) {
+        printf("    file writing failed\n");
+        free(text);
+        return;
+    }
+
+    const double parseStart = benchTime();
+    Cb parsed = NULL;
+    const bool parsedOk = cbParse(text, CB_LEAF_INDEX_TREE, &parsed);
+    const double parseTime = benchTime() - parseStart;
+
+    const double loadStart = benchTime();
+    CbSnapshot snapshot = cbLoadSnapshot(snapshotPath);
+    const double loadTime = benchTime() - loadStart;
+
+    if (parsedOk && snapshot != NULL) {
+        char name[32] = {0};
+        size_t state = 0xFACE;
+        size_t mismatches = 0;
+
+        // both representations should define same objects by same properties
+        for (size_t i = 0; i < 1000; i++) {
+            snprintf(name, sizeof(name), "объект %zu", (size_t)(benchRandom(&state) % leafCount));
+
+            CbDefIter defIter = {0};
+            CbSnapshotDefIter snapshotDefIter = {0};
+
+            const CbDefineStatus status = cbDefine(parsed, name, &defIter);
+
+            if (status != cbSnapshotDefine(snapshot, name, &snapshotDefIter)) {
+                mismatches++;
+                continue;
+            }
+
+            if (status != CB_DEFINE_STATUS_OK)
+                continue;
+
+            bool defNext = true;
+            bool snapshotDefNext = true;
+
+            while (defNext && snapshotDefNext) {
+                if (false
+                    || cbDefIterGetRelation(&defIter) != cbSnapshotDefIterGetRelation(&snapshotDefIter)
+                    || strcmp(cbDefIterGetProperty(&defIter), cbSnapshotDefIterGetProperty(&snapshotDefIter)) != 0
+                ) {
+                    mismatches++;
+                    break;
+                }
+
+                defNext = cbDefIterNext(&defIter);
+                snapshotDefNext = cbSnapshotDefIterNext(&snapshotDefIter);
+            }
+
+            mismatches += defNext != snapshotDefNext;
+        }
+
+        printf("    text parse %10.3f ms, snapshot save %10.3f ms, snapshot load %10.3f ms, %zu definition mismatches\n",
+            parseTime * 1e3,
+            saveTime * 1e3,
+            loadTime * 1e3,
+            mismatches
+        );
+    } else {
+        printf("    loading failed\n");
+    }
+
+    cbSnapshotDtor(snapshot);
+    cbDtor(parsed);
+    free(text);
+
+    remove(textPath);
+    remove(snapshotPath);
+} // benchSnapshot
+
+/// @brief small-chunk reader context
+typedef struct __BenchChunkReader {
+    const char *rest;      ///< rest of text
+    const char *end;       ///< text end
+    size_t      chunkSize; ///< maximal chunk size
+} BenchChunkReader;
+
+/**
+ * @brief small-chunk reading function (CbReadFunc implementation)
+ * 
+ * @param[in,out] context reader context (BenchChunkReader pointer)
+ * @param[out]    buffer  reading destination
+ * @param[in]     size    buffer size
+ * 
+ * @return count of bytes read
+ */
+static size_t benchChunkRead( void *context, char *buffer, size_t size ) {
+    BenchChunkReader *const reader = (BenchChunkReader *)context;
+    size_t readSize = (size_t)(reader->end - reader->rest);
+
+    if (readSize > reader->chunkSize)
+        readSize = reader->chunkSize;
+    if (readSize > size)
+        readSize = size;
+
+    memcpy(buffer, reader->rest, readSize);
+    reader->rest += readSize;
+
+    return readSize;
+} // benchChunkRead
+
+/**
+ * @brief files equality checking function
+ * 
+ * @param[in] lhs first file (rewound by function)
+ * @param[in] rhs second file (rewound by function)
+ * 
+ * @return true if file contents are equal
+ */
+static bool benchFileEqual( FILE *lhs, FILE *rhs ) {
+    rewind(lhs);
+    rewind(rhs);
+
+    int lhsCh = 0;
+    int rhsCh = 0;
+
+    do {
+        lhsCh = fgetc(lhs);
+        rhsCh = fgetc(rhs);
+    } while (lhsCh == rhsCh && lhsCh != EOF);
+
+    return lhsCh == rhsCh;
+} // benchFileEqual
+
+/**
+ * @brief dumps of two trees comparison function
+ * 
+ * @param[in] lhs first tree
+ * @param[in] rhs second tree
+ * 
+ * @return true if trees dump to the same text, false if not
+ */
+static bool benchDumpEqual( const Cb lhs, const Cb rhs ) {
+    FILE *lhsFile = tmpfile();
+    FILE *rhsFile = tmpfile();
+    bool equal = lhsFile != NULL && rhsFile != NULL;
+
+    // compact format keeps comparison linear for deep trees
+    if (equal) {
+        cbDumpBuffered(lhsFile, lhs, CB_DUMP_FORMAT_COMPACT, NULL, 0);
+        cbDumpBuffered(rhsFile, rhs, CB_DUMP_FORMAT_COMPACT, NULL, 0);
+        equal = benchFileEqual(lhsFile, rhsFile);
+    }
+
+    if (lhsFile != NULL)
+        fclose(lhsFile);
+    if (rhsFile != NULL)
+        fclose(rhsFile);
+
+    return equal;
+} // benchDumpEqual
+
+/**
+ * @brief streaming parser against in-memory parser benchmark function
+ * 
+ * @param[in] leafCount count of leaves
+ */
+static void benchStream( const size_t leafCount ) {
+    const char *textPath = "cb_bench_stream.cb";
+
+    printf("stream parsing, %zu leaves:\n", leafCount);
+
+    Cb cb = benchBuildRandomTree(leafCount, CB_LEAF_INDEX_TREE);
+    FILE *file = fopen(textPath, "w");
+
+    if (cb == NULL || file == NULL) {
+        printf("    tree building failed\n");
+        if (file != NULL)
+            fclose(file);
+        cbDtor(cb);
+        return;
+    }
+
+    cbDump(file, cb);
+    fclose(file);
+
+    char *text = benchReadFile(textPath);
+    Cb parsed = NULL;
+    Cb streamed = NULL;
+    Cb chunked = NULL;
+
+    const double parseStart = benchTime();
+    const bool parsedOk = text != NULL && cbParse(text, CB_LEAF_INDEX_TREE, &parsed);
+    const double parseTime = benchTime() - parseStart;
+
+    const double streamStart = benchTime();
+    file = fopen(textPath, "r");
+    const bool streamedOk = file != NULL && cbParseFile(file, CB_LEAF_INDEX_TREE, &streamed);
+    if (file != NULL)
+        fclose(file);
+    const double streamTime = benchTime() - streamStart;
+
+    // tiny chunks split almost every token
+    BenchChunkReader reader = { text, text + (text != NULL ? strlen(text) : 0), 3 };
+    const bool chunkedOk = text != NULL && cbParseStream(benchChunkRead, &reader, CB_LEAF_INDEX_TREE, &chunked);
+
+    if (parsedOk && streamedOk && chunkedOk) {
+        printf("    in-memory %10.3f ms, file stream %10.3f ms, results %s\n",
+            parseTime * 1e3,
+            streamTime * 1e3,
+            benchDumpEqual(cb, parsed) && benchDumpEqual(cb, streamed) && benchDumpEqual(cb, chunked)
+                ? "equal"
+                : "DIFFERENT"
+        );
+    } else {
+        printf("    parsing failed\n");
+    }
+
+    cbDtor(chunked);
+    cbDtor(streamed);
+    cbDtor(parsed);
+    cbDtor(cb);
+    free(text);
+
+    remove(textPath);
+} // benchStream
+
+/// @brief deep tree dump and load time budget (in seconds per million of levels)
+#define BENCH_DEEP_TIME_BUDGET 5.0
+
+/**
+ * @brief deep chain dumping and loading stress benchmark function
+ * 
+ * @param[in] depth chain depth
+ */
+static void benchDeep( const size_t depth ) {
+    printf("deep chain, %zu levels:\n", depth);
+
+    Cb cb = cbCtor("объект 0", CB_LEAF_INDEX_TREE);
+    CbIter iter = cbIter(cb);
+    char name[32] = {0};
+
+    // every insertion makes chain one level deeper
+    for (size_t i = 1; cb != NULL && i <= depth; i++) {
+        snprintf(name, sizeof(name), "объект %zu", i);
+
+        if (!cbIterInsertCorrect(&iter, "условие", name)) {
+            cbDtor(cb);
+            cb = NULL;
+            break;
+        }
+        cbIterNext(&iter, true);
+    }
+
+    FILE *file = tmpfile();
+
+    if (cb == NULL || file == NULL) {
+        printf("    chain building failed\n");
+        if (file != NULL)
+            fclose(file);
+        cbDtor(cb);
+        return;
+    }
+
+    // indented text of chain is quadratic in depth, so compact format is used
+    const double dumpStart = benchTime();
+    cbDumpBuffered(file, cb, CB_DUMP_FORMAT_COMPACT, NULL, 0);
+    fflush(file);
+    const double dumpTime = benchTime() - dumpStart;
+
+    rewind(file);
+
+    Cb parsed = NULL;
+    const double parseStart = benchTime();
+    const bool parsedOk = cbParseFile(file, CB_LEAF_INDEX_TREE, &parsed);
+    const double parseTime = benchTime() - parseStart;
+
+    fclose(file);
+
+    if (parsedOk) {
+        const double budget = BENCH_DEEP_TIME_BUDGET * (double)depth / 1e6;
+
+        printf("    dump %10.3f ms, parse %10.3f ms, results %s, %s\n",
+            dumpTime * 1e3,
+            parseTime * 1e3,
+            benchDumpEqual(cb, parsed)
+                ? "equal"
+                : "DIFFERENT",
+            dumpTime + parseTime <= budget
+                ? "within budget"
+                : "OVER BUDGET"
+        );
+    } else {
+        printf("    parsing failed\n");
+    }
+
+    cbDtor(parsed);
+    cbDtor(cb);
+} // benchDeep
+
+/**
+ * @brief text tokenization by scanning primitives function
+ * 
+ * @param[in]  text     text to tokenize
+ * @param[in]  textSize text size
+ * @param[out] checksum token position checksum
+ * 
+ * @return count of tokens
+ */
+static size_t benchTokenize( const char *text, const size_t textSize, size_t *const checksum ) {
+    const char *rest = text;
+    const char *const end = text + textSize;
+    size_t count = 0;
+
+    *checksum = 0;
+
+    for (;;) {
+        rest = cbScanSpaces(rest, end);
+
+        if (rest >= end)
+            break;
+
+        if (*rest == '\"')
+            rest = cbScanQuote(rest + 1, end);
+
+        *checksum = *checksum * 31 + (size_t)(rest - text);
+        count++;
+        rest++;
+    }
+
+    return count;
+} // benchTokenize
+
+/**
+ * @brief vectorized scanner throughput benchmark function
+ * 
+ * @param[in] leafCount count of leaves
+ */
+static void benchScan( const size_t leafCount ) {
+    const char *textPath = "cb_bench_scan.cb";
+
+    printf("scanner, %zu leaves:\n", leafCount);
+
+    Cb cb = benchBuildRandomTree(leafCount, CB_LEAF_INDEX_TREE);
+    FILE *file = fopen(textPath, "w");
+
+    if (cb != NULL && file != NULL)
+        cbDump(file, cb);
+    if (file != NULL)
+        fclose(file);
+    cbDtor(cb);
+
+    char *text = benchReadFile(textPath);
+    remove(textPath);
+
+    if (cb == NULL || text == NULL) {
+        printf("    text building failed\n");
+        free(text);
+        return;
+    }
+
+    const size_t textSize = strlen(text);
+    const CbScanLevel initialLevel = cbScanGetLevel();
+    const struct {
+        CbScanLevel level;
+        const char *name;
+    } levels[] = {
+        {CB_SCAN_LEVEL_SCALAR, "scalar"},
+        {CB_SCAN_LEVEL_SSE2,   "sse2"  },
+        {CB_SCAN_LEVEL_AVX2,   "avx2"  },
+    };
+
+    size_t scalarCount = 0;
+    size_t scalarChecksum = 0;
+
+    for (size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); i++) {
+        if (levels[i].level > cbScanGetMaxLevel()) {
+            printf("    %-6s: not supported\n", levels[i].name);
+            continue;
+        }
+
+        cbScanSetLevel(levels[i].level);
+
+        size_t checksum = 0;
+        const double tokenizeStart = benchTime();
+        const size_t count = benchTokenize(text, textSize, &checksum);
+        const double tokenizeTime = benchTime() - tokenizeStart;
+
+        Cb parsed = NULL;
+        const double parseStart = benchTime();
+        const bool parsedOk = cbParse(text, CB_LEAF_INDEX_TREE, &parsed);
+        const double parseTime = benchTime() - parseStart;
+
+        cbDtor(parsed);
+
+        if (levels[i].level == CB_SCAN_LEVEL_SCALAR) {
+            scalarCount = count;
+            scalarChecksum = checksum;
+        }
+
+        printf("    %-6s: tokenize %8.3f GB/s, parse %8.3f GB/s, tokens %s\n",
+            levels[i].name,
+            (double)textSize / tokenizeTime * 1e-9,
+            parsedOk
+                ? (double)textSize / parseTime * 1e-9
+                : 0.0,
+            count == scalarCount && checksum == scalarChecksum
+                ? "match scalar"
+                : "DIFFER FROM SCALAR"
+        );
+    }
+
+    cbScanSetLevel(initialLevel);
+    free(text);
+} // benchScan
+
+/// @brief stdio dumper stack element
+typedef struct __BenchDumpElement {
+    CbIter iter;    ///< node iterator
+    size_t depth;   ///< node depth
+    bool   closing; ///< true if element is closing bracket of interior node
+} BenchDumpElement;
+
+/**
+ * @brief reference per-character stdio dumping function (cbDump before buffered writer)
+ * 
+ * @param[out] out  output file
+ * @param[in]  self tree to dump
+ * 
+ * @return true if dumped, false if allocation failed
+ */
+static bool benchDumpStdio( FILE *out, const Cb self ) {
+    size_t capacity = 1024;
+    size_t size = 0;
+    BenchDumpElement *stack = (BenchDumpElement *)malloc(capacity * sizeof(BenchDumpElement));
+
+    if (stack == NULL)
+        return false;
+
+    stack[size++] = (BenchDumpElement) { cbIter(self), 0, false };
+
+    while (size > 0) {
+        const BenchDumpElement element = stack[--size];
+
+        for (size_t i = 0; i < element.depth * 4; i++)
+            fputc(' ', out);
+
+        if (element.closing) {
+            fputs(")\n", out);
+            continue;
+        }
+
+        if (cbIterFinished(&element.iter)) {
+            fprintf(out, "\"%s\"\n", cbIterGetText(&element.iter));
+            continue;
+        }
+
+        fprintf(out, "(\"%s\"\n", cbIterGetText(&element.iter));
+
+        if (size + 3 > capacity) {
+            BenchDumpElement *newStack = (BenchDumpElement *)realloc(stack, capacity * 2 * sizeof(BenchDumpElement));
+
+            if (newStack == NULL) {
+                free(stack);
+                return false;
+            }
+            stack = newStack;
+            capacity *= 2;
+        }
+
+        BenchDumpElement correct = { element.iter, element.depth + 1, false };
+        BenchDumpElement incorrect = { element.iter, element.depth + 1, false };
+
+        cbIterNext(&correct.iter, true);
+        cbIterNext(&incorrect.iter, false);
+
+        stack[size++] = (BenchDumpElement) { element.iter, element.depth, true };
+        stack[size++] = incorrect;
+        stack[size++] = correct;
+    }
+
+    free(stack);
+    return true;
+} // benchDumpStdio
+
+/**
+ * @brief buffered dump writer throughput benchmark function
+ * 
+ * @param[in] leafCount count of leaves
+ */
+static void benchDump( const size_t leafCount ) {
+    printf("dump, %zu leaves:\n", leafCount);
+
+    Cb cb = benchBuildRandomTree(leafCount, CB_LEAF_INDEX_TREE);
+    FILE *stdioFile = tmpfile();
+    FILE *bufferedFile = tmpfile();
+    FILE *compactFile = tmpfile();
+
+    if (cb == NULL || stdioFile == NULL || bufferedFile == NULL || compactFile == NULL) {
+        printf("    preparation failed\n");
+    } else {
+        const double stdioStart = benchTime();
+        benchDumpStdio(stdioFile, cb);
+        fflush(stdioFile);
+        const double stdioTime = benchTime() - stdioStart;
+
+        const double bufferedStart = benchTime();
+        cbDump(bufferedFile, cb);
+        fflush(bufferedFile);
+        const double bufferedTime = benchTime() - bufferedStart;
+
+        static char userBuffer[1 << 20];
+        const double compactStart = benchTime();
+        cbDumpBuffered(compactFile, cb, CB_DUMP_FORMAT_COMPACT, userBuffer, sizeof(userBuffer));
+        fflush(compactFile);
+        const double compactTime = benchTime() - compactStart;
+
+        const double indentedSize = (double)ftell(bufferedFile);
+        const double compactSize = (double)ftell(compactFile);
+
+        printf("    stdio    %8.1f MB/s\n", indentedSize / stdioTime * 1e-6);
+        printf("    buffered %8.1f MB/s, output %s\n",
+            indentedSize / bufferedTime * 1e-6,
+            benchFileEqual(stdioFile, bufferedFile)
+                ? "equal"
+                : "DIFFERENT"
+        );
+        printf("    compact  %8.1f MB/s, %.1f%% of indented size\n",
+            compactSize / compactTime * 1e-6,
+            compactSize / indentedSize * 100.0
+        );
+    }
+
+    if (compactFile != NULL)
+        fclose(compactFile);
+    if (bufferedFile != NULL)
+        fclose(bufferedFile);
+    if (stdioFile != NULL)
+        fclose(stdioFile);
+    cbDtor(cb);
+} // benchDump
+
+/// @brief node-like allocation size range
+#define BENCH_ARENA_MIN_ALLOCATION_SIZE ((size_t)48)
+#define BENCH_ARENA_MAX_ALLOCATION_SIZE ((size_t)96)
+
+/**
+ * @brief arena allocator throughput benchmark function
+ * 
+ * @param[in] allocationCount count of node-sized allocations
+ * 
+ * @note calloc-per-allocation baseline is what arena did before geometric blocks were introduced.
+ * @note every allocation is written to, as node allocation does, so page faults are counted.
+ */
+static void benchArena( const size_t allocationCount ) {
+    printf("arena, %zu allocations:\n", allocationCount);
+
+    void **pointers = (void **)calloc(allocationCount, sizeof(void *));
+    CbArena arena = cbArenaCtor();
+
+    if (pointers == NULL || arena == NULL) {
+        printf("    preparation failed\n");
+        free(pointers);
+        cbArenaDtor(arena);
+        return;
+    }
+
+    const size_t sizeRange = BENCH_ARENA_MAX_ALLOCATION_SIZE - BENCH_ARENA_MIN_ALLOCATION_SIZE;
+    size_t state = 0xA11C;
+
+    const double arenaStart = benchTime();
+    for (size_t i = 0; i < allocationCount; i++) {
+        pointers[i] = cbArenaAlloc(arena, BENCH_ARENA_MIN_ALLOCATION_SIZE + benchRandom(&state) % sizeRange);
+        *(char *)pointers[i] = 1;
+    }
+    const double arenaTime = benchTime() - arenaStart;
+
+    state = 0xA11C;
+
+    const double callocStart = benchTime();
+    for (size_t i = 0; i < allocationCount; i++) {
+        pointers[i] = calloc(BENCH_ARENA_MIN_ALLOCATION_SIZE + benchRandom(&state) % sizeRange, 1);
+        *(char *)pointers[i] = 1;
+    }
+    const double callocTime = benchTime() - callocStart;
+
+    for (size_t i = 0; i < allocationCount; i++)
+        free(pointers[i]);
+
+    CbArenaStat stat = {0};
+    cbArenaGetStat(arena, &stat);
+
+    printf("    calloc %8.1f M allocations/s\n", (double)allocationCount / callocTime * 1e-6);
+    printf("    arena  %8.1f M allocations/s\n", (double)allocationCount / arenaTime * 1e-6);
+    printf("    arena stat: %zu bytes reserved, %zu bytes used, %zu blocks, %zu bytes wasted\n",
+        stat.bytesReserved,
+        stat.bytesUsed,
+        stat.blockCount,
+        stat.bytesWasted
+    );
+
+    // same allocations after reset should reuse blocks instead of asking system
+    cbArenaReset(arena);
+    state = 0xA11C;
+
+    const double reuseStart = benchTime();
+    for (size_t i = 0; i < allocationCount; i++) {
+        pointers[i] = cbArenaAlloc(arena, BENCH_ARENA_MIN_ALLOCATION_SIZE + benchRandom(&state) % sizeRange);
+        *(char *)pointers[i] = 1;
+    }
+    const double reuseTime = benchTime() - reuseStart;
+
+    const size_t blockCount = stat.blockCount;
+    cbArenaGetStat(arena, &stat);
+
+    printf("    reset  %8.1f M allocations/s, %zu new blocks\n",
+        (double)allocationCount / reuseTime * 1e-6,
+        stat.blockCount - blockCount
+    );
+
+    cbArenaDtor(arena);
+    free(pointers);
+} // benchArena
+
+/// @brief walk benchmark walk count
+#define BENCH_WALK_COUNT ((size_t)2000000)
+
+/**
+ * @brief pointer tree and compact snapshot walking benchmark
+ * 
+ * @param[in] leafCount count of leaves (tree has 2 * leafCount - 1 nodes, so 5000000 gives 10M-node tree)
+ */
+static void benchWalk( const size_t leafCount ) {
+    printf("walk, %zu leaves, %zu nodes:\n", leafCount, leafCount * 2 - 1);
+
+    Cb cb = benchBuildRandomTree(leafCount, CB_LEAF_INDEX_HASH);
+    CbSnapshot snapshot = NULL;
+
+    const double buildStart = benchTime();
+    if (cb != NULL)
+        snapshot = cbSnapshotCtor(cb);
+    const double buildTime = benchTime() - buildStart;
+
+    if (snapshot == NULL) {
+        printf("    preparation failed\n");
+        cbDtor(cb);
+        return;
+    }
+
+    printf("    snapshot building %10.3f ms\n", buildTime * 1e3);
+
+    // same random directions are taken, so both representations visit same nodes
+    size_t state = 0x3A1C;
+    size_t stepCount = 0;
+
+    const double treeStart = benchTime();
+    for (size_t i = 0; i < BENCH_WALK_COUNT; i++) {
+        CbIter iter = cbIter(cb);
+
+        while (!cbIterFinished(&iter)) {
+            cbIterNext(&iter, benchRandom(&state) & 1);
+            stepCount++;
+        }
+    }
+    const double treeTime = benchTime() - treeStart;
+
+    state = 0x3A1C;
+    size_t snapshotStepCount = 0;
+
+    const double snapshotStart = benchTime();
+    for (size_t i = 0; i < BENCH_WALK_COUNT; i++) {
+        CbSnapshotIter iter = cbSnapshotIter(snapshot);
+
+        while (!cbSnapshotIterFinished(&iter)) {
+            cbSnapshotIterNext(&iter, benchRandom(&state) & 1);
+            snapshotStepCount++;
+        }
+    }
+    const double snapshotTime = benchTime() - snapshotStart;
+
+    printf("    tree     walks %8.3f M walks/s, %8.3f M steps/s\n", BENCH_WALK_COUNT / treeTime * 1e-6, stepCount / treeTime * 1e-6);
+    printf("    snapshot walks %8.3f M walks/s, %8.3f M steps/s%s\n",
+        BENCH_WALK_COUNT / snapshotTime * 1e-6,
+        snapshotStepCount / snapshotTime * 1e-6,
+        snapshotStepCount == stepCount ? "" : ", STEP COUNT MISMATCH"
+    );
+
+    // definitions climb from leaves to root, so they touch parent arrays only
+    char name[32] = {0};
+    size_t propertyCount = 0;
+
+    state = 0xDEF1;
+
+    const double defineStart = benchTime();
+    for (size_t i = 0; i < BENCH_WALK_COUNT; i++) {
+        snprintf(name, sizeof(name), "объект %zu", benchRandom(&state) % leafCount);
+
+        CbDefIter iter;
+
+        if (cbDefine(cb, name, &iter) == CB_DEFINE_STATUS_OK)
+            do
+                propertyCount += cbDefIterGetRelation(&iter);
+            while (cbDefIterNext(&iter));
+    }
+    const double defineTime = benchTime() - defineStart;
+
+    size_t snapshotPropertyCount = 0;
+
+    state = 0xDEF1;
+
+    const double snapshotDefineStart = benchTime();
+    for (size_t i = 0; i < BENCH_WALK_COUNT; i++) {
+        snprintf(name, sizeof(name), "объект %zu", benchRandom(&state) % leafCount);
+
+        CbSnapshotDefIter iter;
+
+        if (cbSnapshotDefine(snapshot, name, &iter) == CB_DEFINE_STATUS_OK)
+            do
+                snapshotPropertyCount += cbSnapshotDefIterGetRelation(&iter);
+            while (cbSnapshotDefIterNext(&iter));
+    }
+    const double snapshotDefineTime = benchTime() - snapshotDefineStart;
+
+    printf("    tree     definitions %8.3f M/s\n", BENCH_WALK_COUNT / defineTime * 1e-6);
+    printf("    snapshot definitions %8.3f M/s%s\n",
+        BENCH_WALK_COUNT / snapshotDefineTime * 1e-6,
+        snapshotPropertyCount == propertyCount ? "" : ", DEFINITION MISMATCH"
+    );
+
+    cbSnapshotDtor(snapshot);
+    cbDtor(cb);
+} // benchWalk
+
+/// @brief batch benchmark query count
+#define BENCH_BATCH_QUERY_COUNT ((size_t)1000000)
+
+/// @brief batch benchmark answer count per query
+#define BENCH_BATCH_ANSWER_COUNT ((size_t)64)
+
+/**
+ * @brief batch walking benchmark
+ * 
+ * @param[in] leafCount count of leaves
+ */
+static void benchBatch( const size_t leafCount ) {
+    printf("batch, %zu leaves, %zu queries:\n", leafCount, BENCH_BATCH_QUERY_COUNT);
+
+    const long onlineCpuCount = sysconf(_SC_NPROCESSORS_ONLN);
+    const size_t cpuCount = onlineCpuCount > 0 ? (size_t)onlineCpuCount : 1;
+
+    Cb cb = benchBuildRandomTree(leafCount, CB_LEAF_INDEX_HASH);
+    uint8_t *answers = (uint8_t *)calloc(BENCH_BATCH_QUERY_COUNT, BENCH_BATCH_ANSWER_COUNT / 8);
+    CbWalkQuery *queries = (CbWalkQuery *)calloc(BENCH_BATCH_QUERY_COUNT, sizeof(CbWalkQuery));
+    CbWalkResult *expected = (CbWalkResult *)calloc(BENCH_BATCH_QUERY_COUNT, sizeof(CbWalkResult));
+    CbWalkResult *results = (CbWalkResult *)calloc(BENCH_BATCH_QUERY_COUNT, sizeof(CbWalkResult));
+
+    if (cb == NULL || answers == NULL || queries == NULL || expected == NULL || results == NULL) {
+        printf("    preparation failed\n");
+        free(results);
+        free(expected);
+        free(queries);
+        free(answers);
+        cbDtor(cb);
+        return;
+    }
+
+    size_t state = 0xBA7C;
+
+    for (size_t i = 0; i < BENCH_BATCH_QUERY_COUNT * BENCH_BATCH_ANSWER_COUNT / 8; i++)
+        answers[i] = (uint8_t)benchRandom(&state);
+
+    for (size_t i = 0; i < BENCH_BATCH_QUERY_COUNT; i++)
+        queries[i] = (CbWalkQuery) { answers + i * BENCH_BATCH_ANSWER_COUNT / 8, BENCH_BATCH_ANSWER_COUNT };
+
+    // reference: one walk at a time by iterator
+    const double iterStart = benchTime();
+    for (size_t i = 0; i < BENCH_BATCH_QUERY_COUNT; i++) {
+        CbIter iter = cbIter(cb);
+        size_t depth = 0;
+
+        while (!cbIterFinished(&iter) && depth < queries[i].answerCount) {
+            cbIterNext(&iter, (queries[i].answers[depth / 8] >> (depth % 8)) & 1);
+            depth++;
+        }
+
+        expected[i] = (CbWalkResult) { cbIterGetText(&iter), depth, cbIterFinished(&iter) };
+    }
+    const double iterTime = benchTime() - iterStart;
+
+    printf("    iterator      %8.3f M lookups/s\n", BENCH_BATCH_QUERY_COUNT / iterTime * 1e-6);
+
+    for (size_t threadCount = 1;; threadCount *= 2) {
+        if (threadCount > cpuCount)
+            threadCount = cpuCount;
+
+        memset(results, 0, BENCH_BATCH_QUERY_COUNT * sizeof(CbWalkResult));
+
+        const double start = benchTime();
+        cbWalkBatch(cb, queries, results, BENCH_BATCH_QUERY_COUNT, threadCount);
+        const double time = benchTime() - start;
+
+        size_t mismatches = 0;
+
+        for (size_t i = 0; i < BENCH_BATCH_QUERY_COUNT; i++)
+            mismatches += false
+                || results[i].text != expected[i].text
+                || results[i].depth != expected[i].depth
+                || results[i].isFinished != expected[i].isFinished;
+
+        printf("    batch %3zu thr %8.3f M lookups/s (%.2fx), %zu mismatches\n",
+            threadCount,
+            BENCH_BATCH_QUERY_COUNT / time * 1e-6,
+            iterTime / time,
+            mismatches
+        );
+
+        if (threadCount == cpuCount)
+            break;
+    }
+
+    free(results);
+    free(expected);
+    free(queries);
+    free(answers);
+    cbDtor(cb);
+} // benchBatch
+
+/// @brief path benchmark query count
+#define BENCH_PATH_QUERY_COUNT ((size_t)1000000)
+
+/**
+ * @brief definition ancestors collecting function
+ * 
+ * @param[in]  cb       tree (non-null)
+ * @param[in]  name     leaf name (non-null)
+ * @param[out] dst       ancestors, from leaf parent to root (non-null)
+ * @param[out] relations relations to ancestors (nullable)
+ * @param[in]  capacity  dst and relations capacity
+ * 
+ * @return count of ancestors written
+ */
+static size_t benchDefineAncestors( const Cb cb, const char *name, const void **dst, bool *const relations, const size_t capacity ) {
+    CbDefIter iter;
+    size_t count = 0;
+
+    if (cbDefine(cb, name, &iter) != CB_DEFINE_STATUS_OK)
+        return 0;
+
+    do {
+        if (count >= capacity)
+            break;
+
+        if (relations != NULL)
+            relations[count] = cbDefIterGetRelation(&iter);
+        dst[count++] = iter.parent;
+    } while (cbDefIterNext(&iter));
+
+    return count;
+} // benchDefineAncestors
+
+/**
+ * @brief path cache benchmark
+ * 
+ * @param[in] leafCount count of leaves
+ */
+static void benchPath( const size_t leafCount ) {
+    printf("path, %zu leaves:\n", leafCount);
+
+    Cb cb = benchBuildRandomTree(leafCount, CB_LEAF_INDEX_HASH);
+
+    if (cb == NULL) {
+        printf("    preparation failed\n");
+        return;
+    }
+
+    char name[32] = {0};
+    char otherName[32] = {0};
+    double times[2] = {0};
+    size_t relationSums[2] = {0};
+
+    // same definitions without and with cache
+    for (size_t cached = 0; cached < 2; cached++) {
+        if (cached && !cbEnablePathCache(cb)) {
+            printf("    path cache enabling failed\n");
+            cbDtor(cb);
+            return;
+        }
+
+        size_t state = 0xDEF1;
+
+        const double start = benchTime();
+        for (size_t i = 0; i < BENCH_PATH_QUERY_COUNT; i++) {
+            snprintf(name, sizeof(name), "объект %zu", benchRandom(&state) % leafCount);
+
+            CbDefIter iter;
+
+            if (cbDefine(cb, name, &iter) == CB_DEFINE_STATUS_OK)
+                do
+                    relationSums[cached] += cbDefIterGetRelation(&iter);
+                while (cbDefIterNext(&iter));
+        }
+        times[cached] = benchTime() - start;
+    }
+
+    printf("    definitions without cache %8.3f M/s\n", BENCH_PATH_QUERY_COUNT / times[0] * 1e-6);
+    printf("    definitions with cache    %8.3f M/s%s\n",
+        BENCH_PATH_QUERY_COUNT / times[1] * 1e-6,
+        relationSums[0] == relationSums[1] ? "" : ", RELATION MISMATCH"
+    );
+
+    // split point of two leaves: ancestor lists suffix matching against path XOR
+    enum { ANCESTOR_CAPACITY = 1024 };
+    static const void *lhsAncestors[ANCESTOR_CAPACITY];
+    static const void *rhsAncestors[ANCESTOR_CAPACITY];
+    size_t ancestorCommonSum = 0;
+    size_t pathCommonSum = 0;
+    size_t state = 0xC0DE;
+
+    const double ancestorStart = benchTime();
+    for (size_t i = 0; i < BENCH_PATH_QUERY_COUNT; i++) {
+        snprintf(name, sizeof(name), "объект %zu", benchRandom(&state) % leafCount);
+        snprintf(otherName, sizeof(otherName), "объект %zu", benchRandom(&state) % leafCount);
+
+        const size_t lhsCount = benchDefineAncestors(cb, name, lhsAncestors, NULL, ANCESTOR_CAPACITY);
+        const size_t rhsCount = benchDefineAncestors(cb, otherName, rhsAncestors, NULL, ANCESTOR_CAPACITY);
+        size_t common = 0;
+
+        while (common < lhsCount && common < rhsCount && lhsAncestors[lhsCount - 1 - common] == rhsAncestors[rhsCount - 1 - common])
+            common++;
+
+        // common ancestors include node paths split at, paths share one answer less
+        ancestorCommonSum += common > 0 ? common - 1 : 0;
+    }
+    const double ancestorTime = benchTime() - ancestorStart;
+
+    state = 0xC0DE;
+
+    const double pathStart = benchTime();
+    for (size_t i = 0; i < BENCH_PATH_QUERY_COUNT; i++) {
+        snprintf(name, sizeof(name), "объект %zu", benchRandom(&state) % leafCount);
+        snprintf(otherName, sizeof(otherName), "объект %zu", benchRandom(&state) % leafCount);
+
+        CbPath lhs, rhs;
+
+        if (cbGetPath(cb, name, &lhs) && cbGetPath(cb, otherName, &rhs)) {
+            const size_t common = cbPathCommonLength(&lhs, &rhs);
+
+            // same leaf has no split point
+            pathCommonSum += common == lhs.depth && common == rhs.depth && common > 0 ? common - 1 : common;
+        }
+    }
+    const double pathTime = benchTime() - pathStart;
+
+    printf("    split by definitions      %8.3f M/s\n", BENCH_PATH_QUERY_COUNT / ancestorTime * 1e-6);
+    printf("    split by paths            %8.3f M/s%s\n",
+        BENCH_PATH_QUERY_COUNT / pathTime * 1e-6,
+        ancestorCommonSum == pathCommonSum ? "" : ", SPLIT MISMATCH"
+    );
+
+    cbDtor(cb);
+} // benchPath
+
+/// @brief compare benchmark query count
+#define BENCH_COMPARE_QUERY_COUNT ((size_t)1000000)
+
+/// @brief compare benchmark ancestor list capacity
+#define BENCH_COMPARE_ANCESTOR_CAPACITY ((size_t)1024)
+
+/**
+ * @brief object comparison benchmark
+ * 
+ * @param[in] leafCount count of leaves
+ */
+static void benchCompare( const size_t leafCount ) {
+    printf("compare, %zu leaves:\n", leafCount);
+
+    Cb cb = benchBuildRandomTree(leafCount, CB_LEAF_INDEX_HASH);
+
+    if (cb == NULL || leafCount < 2) {
+        printf("    preparation failed\n");
+        cbDtor(cb);
+        return;
+    }
+
+    static const void *lhsAncestors[BENCH_COMPARE_ANCESTOR_CAPACITY];
+    static const void *rhsAncestors[BENCH_COMPARE_ANCESTOR_CAPACITY];
+    static bool lhsRelations[BENCH_COMPARE_ANCESTOR_CAPACITY];
+
+    char lhs[32] = {0};
+    char rhs[32] = {0};
+    size_t definitionChecksum = 0;
+    size_t state = 0xC0C0;
+
+    // reference: two definitions and quadratic search of first common ancestor
+    const double definitionStart = benchTime();
+    for (size_t i = 0; i < BENCH_COMPARE_QUERY_COUNT; i++) {
+        snprintf(lhs, sizeof(lhs), "объект %zu", benchRandom(&state) % leafCount);
+        snprintf(rhs, sizeof(rhs), "объект %zu", benchRandom(&state) % leafCount);
+
+        if (strcmp(lhs, rhs) == 0)
+            continue;
+
+        const size_t lhsCount = benchDefineAncestors(cb, lhs, lhsAncestors, lhsRelations, BENCH_COMPARE_ANCESTOR_CAPACITY);
+        const size_t rhsCount = benchDefineAncestors(cb, rhs, rhsAncestors, NULL, BENCH_COMPARE_ANCESTOR_CAPACITY);
+        bool found = false;
+
+        for (size_t l = 0; !found && l < lhsCount; l++)
+            for (size_t r = 0; !found && r < rhsCount; r++)
+                if (lhsAncestors[l] == rhsAncestors[r]) {
+                    // common properties are ones above split property
+                    definitionChecksum += (lhsCount - l - 1) * 2 + lhsRelations[l];
+                    found = true;
+                }
+    }
+    const double definitionTime = benchTime() - definitionStart;
+
+    CbComparison comparison;
+
+    const double buildStart = benchTime();
+    const CbCompareStatus buildStatus = cbCompare(cb, "объект 0", "объект 1", &comparison);
+    const double buildTime = benchTime() - buildStart;
+
+    size_t compareChecksum = 0;
+    state = 0xC0C0;
+
+    const double compareStart = benchTime();
+    for (size_t i = 0; i < BENCH_COMPARE_QUERY_COUNT; i++) {
+        snprintf(lhs, sizeof(lhs), "объект %zu", benchRandom(&state) % leafCount);
+        snprintf(rhs, sizeof(rhs), "объект %zu", benchRandom(&state) % leafCount);
+
+        if (cbCompare(cb, lhs, rhs, &comparison) != CB_COMPARE_STATUS_OK)
+            continue;
+
+        size_t commonCount = 0;
+
+        if (comparison.hasCommon)
+            do
+                commonCount++;
+            while (cbDefIterNext(&comparison.common));
+
+        compareChecksum += commonCount * 2 + comparison.lhsRelation;
+    }
+    const double compareTime = benchTime() - compareStart;
+
+    // leaves inserted after index building are compared by parent links until index is rebuilt
+    const size_t insertCount = leafCount / 16 + 1;
+    size_t insertState = 0xC0FFEE0;
+    char name[32] = {0};
+
+    for (size_t i = 0; i < insertCount; i++) {
+        CbIter iter = cbIter(cb);
+
+        while (!cbIterFinished(&iter))
+            cbIterNext(&iter, benchRandom(&insertState) & 1);
+
+        snprintf(name, sizeof(name), "объект %zu", leafCount + i);
+
+        if (!cbIterInsertCorrect(&iter, "новое условие", name)) {
+            printf("    insertion failed\n");
+            cbDtor(cb);
+            return;
+        }
+    }
+
+    size_t newDefinitionChecksum = 0;
+    state = 0xC0C1;
+
+    for (size_t i = 0; i < BENCH_COMPARE_QUERY_COUNT; i++) {
+        snprintf(lhs, sizeof(lhs), "объект %zu", leafCount + benchRandom(&state) % insertCount);
+        snprintf(rhs, sizeof(rhs), "объект %zu", benchRandom(&state) % leafCount);
+
+        const size_t lhsCount = benchDefineAncestors(cb, lhs, lhsAncestors, lhsRelations, BENCH_COMPARE_ANCESTOR_CAPACITY);
+        const size_t rhsCount = benchDefineAncestors(cb, rhs, rhsAncestors, NULL, BENCH_COMPARE_ANCESTOR_CAPACITY);
+        bool found = false;
+
+        for (size_t l = 0; !found && l < lhsCount; l++)
+            for (size_t r = 0; !found && r < rhsCount; r++)
+                if (lhsAncestors[l] == rhsAncestors[r]) {
+                    newDefinitionChecksum += (lhsCount - l - 1) * 2 + lhsRelations[l];
+                    found = true;
+                }
+    }
+
+    size_t newCompareChecksum = 0;
+    state = 0xC0C1;
+
+    const double newCompareStart = benchTime();
+    for (size_t i = 0; i < BENCH_COMPARE_QUERY_COUNT; i++) {
+        snprintf(lhs, sizeof(lhs), "объект %zu", leafCount + benchRandom(&state) % insertCount);
+        snprintf(rhs, sizeof(rhs), "объект %zu", benchRandom(&state) % leafCount);
+
+        if (cbCompare(cb, lhs, rhs, &comparison) != CB_COMPARE_STATUS_OK)
+            continue;
+
+        size_t commonCount = 0;
+
+        if (comparison.hasCommon)
+            do
+                commonCount++;
+            while (cbDefIterNext(&comparison.common));
+
+        newCompareChecksum += commonCount * 2 + comparison.lhsRelation;
+    }
+    const double newCompareTime = benchTime() - newCompareStart;
+
+    printf("    definitions  %8.3f M comparisons/s\n", BENCH_COMPARE_QUERY_COUNT / definitionTime * 1e-6);
+    printf("    index build  %8.3f ms%s\n", buildTime * 1e3, buildStatus == CB_COMPARE_STATUS_OK ? "" : ", FAILED");
+    printf("    cbCompare    %8.3f M comparisons/s%s\n",
+        BENCH_COMPARE_QUERY_COUNT / compareTime * 1e-6,
+        compareChecksum == definitionChecksum ? "" : ", MISMATCH"
+    );
+    printf("    new leaves   %8.3f M comparisons/s%s\n",
+        BENCH_COMPARE_QUERY_COUNT / newCompareTime * 1e-6,
+        newCompareChecksum == newDefinitionChecksum ? "" : ", MISMATCH"
+    );
+
+    cbDtor(cb);
+} // benchCompare
+
+/// @brief concurrent benchmark reader operation count
+#define BENCH_CONCURRENT_READ_COUNT ((size_t)1000000)
+
+/// @brief concurrent benchmark shared state
+typedef struct __BenchConcurrentState {
+    Cb     cb;          ///< shared tree
+    size_t leafCount;   ///< count of leaves that are inserted and must be findable (atomic)
+    bool   writerDone;  ///< true if writer finished (atomic)
+    bool   stopOnWrite; ///< true if readers work until writer finishes, false if they do BENCH_CONCURRENT_READ_COUNT operations
+} BenchConcurrentState;
+
+/// @brief concurrent benchmark reader
+typedef struct __BenchConcurrentReader {
+    BenchConcurrentState *state;          ///< shared state
+    pthread_t             thread;         ///< reader thread
+    size_t                seed;           ///< random state
+    size_t                operationCount; ///< count of performed operations
+    size_t                errorCount;     ///< count of inconsistencies found
+} BenchConcurrentReader;
+
+/**
+ * @brief concurrent benchmark reader thread function
+ * 
+ * @param[in,out] context reader (BenchConcurrentReader *)
+ * 
+ * @return NULL
+ * 
+ * @note each operation is a random guessing session, definition of random published leaf and comparison of two ones.
+ */
+static void * benchConcurrentRead( void *context ) {
+    BenchConcurrentReader *const reader = (BenchConcurrentReader *)context;
+    BenchConcurrentState *const state = reader->state;
+    char name[32] = {0};
+
+    for (;;) {
+        if (state->stopOnWrite
+            ? __atomic_load_n(&state->writerDone, __ATOMIC_ACQUIRE)
+            : reader->operationCount >= BENCH_CONCURRENT_READ_COUNT
+        )
+            break;
+
+        // leaves are published before count, so all of them must be found
+        const size_t leafCount = __atomic_load_n(&state->leafCount, __ATOMIC_ACQUIRE);
+        CbIter iter = cbIter(state->cb);
+        size_t depth = 0;
+
+        while (!cbIterFinished(&iter)) {
+            if (strcmp(cbIterGetText(&iter), "условие") != 0)
+                reader->errorCount++;
+            cbIterNext(&iter, benchRandom(&reader->seed) & 1);
+            depth++;
+        }
+
+        if (strncmp(cbIterGetText(&iter), "объект ", strlen("объект ")) != 0)
+            reader->errorCount++;
+
+        snprintf(name, sizeof(name), "объект %zu", benchRandom(&reader->seed) % leafCount);
+
+        CbDefIter defIter;
+        const CbDefineStatus status = cbDefine(state->cb, name, &defIter);
+
+        if (status == CB_DEFINE_STATUS_NO_SUBJECT) {
+            reader->errorCount++;
+        } else if (status == CB_DEFINE_STATUS_OK) {
+            do {
+                if (strcmp(cbDefIterGetProperty(&defIter), "условие") != 0)
+                    reader->errorCount++;
+                (void)cbDefIterGetRelation(&defIter);
+            } while (cbDefIterNext(&defIter));
+        }
+
+        char otherName[32] = {0};
+        CbComparison comparison;
+
+        snprintf(otherName, sizeof(otherName), "объект %zu", benchRandom(&reader->seed) % leafCount);
+
+        switch (cbCompare(state->cb, name, otherName, &comparison)) {
+        case CB_COMPARE_STATUS_OK:
+            if (strcmp(comparison.splitProperty, "условие") != 0)
+                reader->errorCount++;
+            break;
+
+        case CB_COMPARE_STATUS_SAME:
+            reader->errorCount += strcmp(name, otherName) != 0;
+            break;
+
+        default:
+            reader->errorCount++;
+            break;
+        }
+
+        reader->operationCount++;
+    }
+
+    return NULL;
+} // benchConcurrentRead
+
+/**
+ * @brief concurrent readers running function
+ * 
+ * @param[in,out] state       shared state (non-null)
+ * @param[in]     readerCount count of readers
+ * @param[in]     insertCount count of leaves to insert by writer concurrently with readers
+ * @param[out]    errorCount  count of inconsistencies found by readers and writer (non-null)
+ * @param[out]    readCount   total count of reader operations destination (non-null)
+ * 
+ * @return true if all threads are started, false otherwise
+ * 
+ * @note readers run until writer finishes, so they may do no operations at all if they aren't scheduled meanwhile.
+ */
+static bool benchConcurrentRun( BenchConcurrentState *const state, const size_t readerCount, const size_t insertCount, size_t *const errorCount, size_t *const readCount ) {
+    BenchConcurrentReader *const readers = (BenchConcurrentReader *)calloc(readerCount, sizeof(BenchConcurrentReader));
+    size_t startedCount = 0;
+
+    state->writerDone = false;
+    state->stopOnWrite = insertCount != 0;
+    *errorCount = 0;
+
+    for (; readers != NULL && startedCount < readerCount; startedCount++) {
+        readers[startedCount].state = state;
+        readers[startedCount].seed = 0x5EED + startedCount * 0x9E3779B9;
+
+        if (pthread_create(&readers[startedCount].thread, NULL, benchConcurrentRead, &readers[startedCount]) != 0)
+            break;
+    }
+
+    // main thread is the writer
+    size_t seed = 0xBADC0DE;
+    size_t leafCount = state->leafCount;
+    char name[32] = {0};
+
+    for (size_t i = 0; i < insertCount; i++) {
+        CbIter iter = cbIter(state->cb);
+
+        while (!cbIterFinished(&iter))
+            cbIterNext(&iter, benchRandom(&seed) & 1);
+
+        snprintf(name, sizeof(name), "объект %zu", leafCount);
+
+        if (!cbIterInsertCorrect(&iter, "условие", name)) {
+            (*errorCount)++;
+            break;
+        }
+
+        __atomic_store_n(&state->leafCount, ++leafCount, __ATOMIC_RELEASE);
+    }
+
+    __atomic_store_n(&state->writerDone, true, __ATOMIC_RELEASE);
+
+    size_t operationCount = 0;
+
+    for (size_t i = 0; i < startedCount; i++) {
+        pthread_join(readers[i].thread, NULL);
+        operationCount += readers[i].operationCount;
+        *errorCount += readers[i].errorCount;
+    }
+
+    free(readers);
+
+    *readCount = operationCount;
+
+    return startedCount == readerCount;
+} // benchConcurrentRun
+
+/**
+ * @brief concurrent reading benchmark (stress test with single writer and read scaling by thread count)
+ * 
+ * @param[in] leafCount count of leaves
+ */
+static void benchConcurrent( const size_t leafCount ) {
+    printf("concurrent, %zu leaves:\n", leafCount);
+
+    const long onlineCpuCount = sysconf(_SC_NPROCESSORS_ONLN);
+    const size_t cpuCount = onlineCpuCount > 0 ? (size_t)onlineCpuCount : 1;
+
+    const struct {
+        CbLeafIndex leafIndex;
+        bool        isPathCached;
+        bool        isVersioned;
+        const char *name;
+    } leafIndices[] = {
+        {CB_LEAF_INDEX_TREE, false, false, "tree"},
+        {CB_LEAF_INDEX_HASH, false, false, "hash"},
+        {CB_LEAF_INDEX_HASH, true,  false, "path"},
+        {CB_LEAF_INDEX_HASH, false, true,  "versions"},
+    };
+
+    for (size_t i = 0; i < sizeof(leafIndices) / sizeof(leafIndices[0]); i++) {
+        const size_t initialCount = leafCount / 2 > 0 ? leafCount / 2 : 1;
+        BenchConcurrentState state = {
+            .cb          = benchBuildRandomTree(initialCount, leafIndices[i].leafIndex),
+            .leafCount   = initialCount,
+            .writerDone  = false,
+            .stopOnWrite = false,
+        };
+
+        // versioned insertion relinks shared interior nodes while readers climb by parent links
+        if (state.cb != NULL && (false
+            || (leafIndices[i].isPathCached && !cbEnablePathCache(state.cb))
+            || (leafIndices[i].isVersioned && !cbEnableVersions(state.cb))
+        )) {
+            cbDtor(state.cb);
+            state.cb = NULL;
+        }
+
+        if (state.cb == NULL) {
+            printf("    %s: preparation failed\n", leafIndices[i].name);
+            continue;
+        }
+
+        // readers race with writer which doubles the tree
+        const size_t stressReaderCount = cpuCount > 4 ? cpuCount : 4;
+        size_t errorCount = 0;
+        size_t stressCount = 0;
+
+        const double stressStart = benchTime();
+        const bool isStressStarted = benchConcurrentRun(&state, stressReaderCount, leafCount - initialCount, &errorCount, &stressCount);
+        const double stressTime = benchTime() - stressStart;
+
+        // readers that got no CPU time while writer ran (e.g. on single core) prove nothing, but aren't a failure
+        printf("    %s stress: %zu readers, %zu inserts, %zu reads in %.3f s, %s (%zu errors)\n",
+            leafIndices[i].name,
+            stressReaderCount,
+            leafCount - initialCount,
+            stressCount,
+            stressTime,
+            !isStressStarted || errorCount != 0
+                ? "FAILED"
+                : stressCount == 0
+                    ? "skipped, no reads overlapped insertions"
+                    : stressCount < stressReaderCount
+                        ? "ok, low confidence"
+                        : "ok",
+            errorCount
+        );
+
+        // read-only scaling
+        for (size_t readerCount = 1;; readerCount *= 2) {
+            if (readerCount > cpuCount)
+                readerCount = cpuCount;
+
+            size_t count = 0;
+
+            const double start = benchTime();
+            const bool isStarted = benchConcurrentRun(&state, readerCount, 0, &errorCount, &count);
+            const double time = benchTime() - start;
+
+            printf("    %s %3zu threads %8.3f M reads/s%s\n",
+                leafIndices[i].name,
+                readerCount,
+                (double)count / time * 1e-6,
+                isStarted && errorCount == 0 ? "" : ", FAILED"
+            );
+
+            if (readerCount == cpuCount)
+                break;
+        }
+
+        cbDtor(state.cb);
+    }
+} // benchConcurrent
+
+/// @brief optimize benchmark attribute count
+#define BENCH_OPTIMIZE_ATTRIBUTE_COUNT 64
+
+/**
+ * @brief optimize benchmark object walking function
+ * 
+ * @param[in] cb         tree (non-null)
+ * @param[in] attributes object attributes
+ * 
+ * @return iterator at leaf object is classified as
+ * 
+ * @note questions are "признак k" and "нет признака k", answers are taken from attribute bit k.
+ */
+static CbIter benchOptimizeWalk( const Cb cb, const uint64_t attributes ) {
+    CbIter iter = cbIter(cb);
+
+    while (!cbIterFinished(&iter)) {
+        const char *const text = cbIterGetText(&iter);
+        unsigned int attribute = 0;
+        bool answer = false;
+
+        if (sscanf(text, "признак %u", &attribute) == 1)
+            answer = (attributes >> attribute) & 1;
+        else if (sscanf(text, "нет признака %u", &attribute) == 1)
+            answer = !((attributes >> attribute) & 1);
+
+        cbIterNext(&iter, answer);
+    }
+
+    return iter;
+} // benchOptimizeWalk
+
+/**
+ * @brief tree optimization benchmark
+ * 
+ * @param[in] leafCount count of objects
+ * 
+ * @note tree is built as interactive sessions do: object is classified and distinguished from
+ * leaf it reached by a random differing attribute, so same questions repeat across branches.
+ * objects added earlier are more popular (Zipf distribution). every object is classified again
+ * after optimization to check that leaves kept valid properties.
+ */
+static void benchOptimize( const size_t leafCount ) {
+    printf("optimize, %zu leaves:\n", leafCount);
+
+    uint64_t *const attributes = (uint64_t *)calloc(leafCount, sizeof(uint64_t));
+    CbLeafFrequency *const frequencies = (CbLeafFrequency *)calloc(leafCount, sizeof(CbLeafFrequency));
+    char *const names = (char *)calloc(leafCount, 32);
+    Cb cb = cbCtor("объект 0", CB_LEAF_INDEX_HASH);
+
+    if (attributes == NULL || frequencies == NULL || names == NULL || cb == NULL) {
+        printf("    preparation failed\n");
+        cbDtor(cb);
+        free(names);
+        free(frequencies);
+        free(attributes);
+        return;
+    }
+
+    // attribute vocabulary is kept small, so objects share most of questions
+    unsigned int attributeCount = 4;
+
+    while (attributeCount < BENCH_OPTIMIZE_ATTRIBUTE_COUNT && ((size_t)1 << (attributeCount - 4)) < leafCount)
+        attributeCount++;
+
+    const uint64_t attributeMask = attributeCount == 64 ? ~(uint64_t)0 : ((uint64_t)1 << attributeCount) - 1;
+    size_t state = 0x0971;
+    char question[32] = {0};
+    size_t objectCount = 0;
+    bool ok = true;
+
+    for (size_t i = 0; ok && i < leafCount; i++) {
+        attributes[i] = (uint64_t)benchRandom(&state) & attributeMask;
+        snprintf(names + i * 32, 32, "объект %zu", i);
+
+        if (i != 0) {
+            CbIter iter = benchOptimizeWalk(cb, attributes[i]);
+            size_t leaf = 0;
+
+            sscanf(cbIterGetText(&iter), "объект %zu", &leaf);
+
+            const uint64_t satisfied = attributes[i] & ~attributes[leaf];
+            const uint64_t unsatisfied = ~attributes[i] & attributes[leaf];
+            const uint64_t candidates = satisfied != 0 ? satisfied : unsatisfied;
+
+            // objects with same attributes can't be distinguished
+            if (candidates == 0)
+                continue;
+
+            // random candidate attribute
+            unsigned int attribute = (unsigned int)(benchRandom(&state) % attributeCount);
+
+            while (((candidates >> attribute) & 1) == 0)
+                attribute = (attribute + 1) % attributeCount;
+
+            snprintf(question, sizeof(question), satisfied != 0 ? "признак %u" : "нет признака %u", attribute);
+            ok = cbIterInsertCorrect(&iter, question, names + i * 32);
+        }
+
+        frequencies[objectCount++] = (CbLeafFrequency) { names + i * 32, 1.0 / (double)(i + 1) };
+    }
+
+    CbDepthStat before = {0};
+    CbDepthStat after = {0};
+
+    const double optimizeStart = benchTime();
+    const bool optimized = ok && cbOptimize(cb, frequencies, objectCount, &before, &after);
+    const double optimizeTime = benchTime() - optimizeStart;
+
+    // every object must still be classified as itself
+    size_t errorCount = 0;
+
+    for (size_t i = 0; optimized && i < objectCount; i++) {
+        size_t object = 0;
+
+        sscanf(frequencies[i].name, "объект %zu", &object);
+
+        const CbIter iter = benchOptimizeWalk(cb, attributes[object]);
+
+        if (strcmp(cbIterGetText(&iter), frequencies[i].name) != 0)
+            errorCount++;
+    }
+
+    if (!optimized) {
+        printf("    optimization failed\n");
+    } else {
+        printf("    time          %8.3f ms\n", optimizeTime * 1e3);
+        printf("    expected depth %7.3f -> %7.3f\n", before.expectedDepth, after.expectedDepth);
+        printf("    average depth  %7.3f -> %7.3f\n", before.averageDepth, after.averageDepth);
+        printf("    max depth      %7zu -> %7zu\n", before.maxDepth, after.maxDepth);
+        printf("    misclassified  %7zu\n", errorCount);
+    }
+
+    cbDtor(cb);
+    free(names);
+    free(frequencies);
+    free(attributes);
+} // benchOptimize
+
+/// @brief statistics benchmark session count
+#define BENCH_STAT_SESSION_COUNT ((size_t)2000000)
+
+/**
+ * @brief random session performing function
+ * 
+ * @param[in]     cb    tree (non-null)
+ * @param[in,out] state random generator state (non-null)
+ * 
+ * @return session length
+ */
+static size_t benchStatSession( const Cb cb, size_t *const state ) {
+    CbIter iter = cbIter(cb);
+    size_t bits = benchRandom(state);
+    size_t bitCount = 64;
+
+    while (!cbIterFinished(&iter)) {
+        if (bitCount == 0) {
+            bits = benchRandom(state);
+            bitCount = 64;
+        }
+
+        cbIterNext(&iter, bits & 1);
+        bits >>= 1;
+        bitCount--;
+    }
+
+    return iter.depth;
+} // benchStatSession
+
+/**
+ * @brief visit statistics benchmark
+ * 
+ * @param[in] leafCount count of leaves
+ */
+static void benchStat( const size_t leafCount ) {
+    printf("stat, %zu leaves:\n", leafCount);
+
+    Cb cb = benchBuildRandomTree(leafCount, CB_LEAF_INDEX_HASH);
+    CbLeafFrequency *const hits = (CbLeafFrequency *)calloc(leafCount, sizeof(CbLeafFrequency));
+
+    if (cb == NULL || hits == NULL) {
+        printf("    preparation failed\n");
+        free(hits);
+        cbDtor(cb);
+        return;
+    }
+
+    size_t state = 0x5747;
+    size_t plainLengthSum = 0;
+
+    const double plainStart = benchTime();
+    for (size_t i = 0; i < BENCH_STAT_SESSION_COUNT; i++)
+        plainLengthSum += benchStatSession(cb, &state);
+    const double plainTime = benchTime() - plainStart;
+
+    const bool enabled = cbEnableStat(cb);
+    size_t countedLengthSum = 0;
+    state = 0x5747;
+
+    const double countedStart = benchTime();
+    for (size_t i = 0; i < BENCH_STAT_SESSION_COUNT; i++)
+        countedLengthSum += benchStatSession(cb, &state);
+    const double countedTime = benchTime() - countedStart;
+
+    // every session must be counted once at root, once at some leaf and once in histogram
+    CbSessionStat sessionStat;
+    CbNodeStat rootStat = {0};
+    const CbIter root = cbIterTraversal(cb);
+    double hitSum = 0.0;
+    uint64_t histogramSum = 0;
+
+    // full tree traversal must not be counted as sessions
+    cbLeafTrieDtor(cbLeafTrieCtor(cb));
+
+    cbIterGetStat(&root, &rootStat);
+    cbGetSessionStat(cb, &sessionStat);
+
+    const size_t hitCount = cbGetLeafHits(cb, hits, leafCount);
+
+    for (size_t i = 0; i < hitCount && i < leafCount; i++)
+        hitSum += hits[i].frequency;
+    for (size_t i = 0; i < CB_SESSION_LENGTH_COUNT; i++)
+        histogramSum += sessionStat.lengths[i];
+
+    const bool isConsistent = true
+        && enabled
+        && plainLengthSum == countedLengthSum
+        && sessionStat.count == BENCH_STAT_SESSION_COUNT
+        && sessionStat.lengthSum == countedLengthSum
+        && histogramSum == sessionStat.count
+        && rootStat.visits == BENCH_STAT_SESSION_COUNT
+        && rootStat.correct + rootStat.incorrect == BENCH_STAT_SESSION_COUNT
+        && hitSum == (double)BENCH_STAT_SESSION_COUNT;
+
+    printf("    no counters  %8.3f M sessions/s\n", BENCH_STAT_SESSION_COUNT / plainTime * 1e-6);
+    printf("    counters     %8.3f M sessions/s%s\n", BENCH_STAT_SESSION_COUNT / countedTime * 1e-6, isConsistent ? "" : ", MISMATCH");
+    printf("    average length %7.3f\n", (double)sessionStat.lengthSum / (double)(sessionStat.count == 0 ? 1 : sessionStat.count));
+
+    free(hits);
+    cbDtor(cb);
+} // benchStat
+
+/// @brief maximal count of insertions journaled with sync per record
+#define BENCH_JOURNAL_SYNC_INSERT_COUNT ((size_t)2000)
+
+/**
+ * @brief journaled random tree building function
+ * 
+ * @param[in]  path      journal path (journal is truncated)
+ * @param[in]  groupSize journal group size, 0 to build without journal
+ * @param[in]  leafCount count of leaves
+ * @param[out] time      insertion time destination (non-null)
+ * 
+ * @return built tree, NULL if something went wrong
+ * 
+ * @note tree is same as benchBuildRandomTree one.
+ */
+static Cb benchJournalBuild( const char *path, const size_t groupSize, const size_t leafCount, double *const time ) {
+    Cb cb = cbCtor("объект 0", CB_LEAF_INDEX_HASH);
+    CbJournal journal = NULL;
+    size_t state = 0xC0FFEE;
+    char name[32] = {0};
+
+    remove(path);
+
+    if (groupSize != 0 && cb != NULL) {
+        journal = cbJournalCtor(path, groupSize);
+        if (journal == NULL) {
+            cbDtor(cb);
+            return NULL;
+        }
+        cbJournalAttach(journal, cb);
+    }
+
+    const double start = benchTime();
+
+    for (size_t i = 1; cb != NULL && i < leafCount; i++) {
+        CbIter iter = cbIter(cb);
+
+        while (!cbIterFinished(&iter))
+            cbIterNext(&iter, benchRandom(&state) & 1);
+
+        snprintf(name, sizeof(name), "объект %zu", i);
+
+        if (!cbIterInsertCorrect(&iter, "условие", name)) {
+            cbDtor(cb);
+            cb = NULL;
+        }
+    }
+
+    // pending group is a part of insertion cost
+    if (journal != NULL) {
+        if (cb != NULL)
+            cbJournalDetach(journal, cb);
+        if (!cbJournalSync(journal)) {
+            cbDtor(cb);
+            cb = NULL;
+        }
+        cbJournalDtor(journal);
+    }
+
+    *time = benchTime() - start;
+
+    return cb;
+} // benchJournalBuild
+
+/**
+ * @brief journal insertion, replay and compaction benchmark function
+ * 
+ * @param[in] leafCount count of leaves
+ */
+static void benchJournal( const size_t leafCount ) {
+    const char *journalPath = "cb_bench_journal.cbj";
+    const char *basePath = "cb_bench_journal.cb";
+    const size_t groupSizes[] = {0, 1, 64, 4096};
+
+    printf("journal, %zu leaves:\n", leafCount);
+
+    for (size_t i = 0; i < sizeof(groupSizes) / sizeof(groupSizes[0]); i++) {
+        // sync per record is limited by disk, so it's measured on prefix only
+        const size_t count = groupSizes[i] == 1 && leafCount > BENCH_JOURNAL_SYNC_INSERT_COUNT
+            ? BENCH_JOURNAL_SYNC_INSERT_COUNT
+            : leafCount;
+        double time = 0.0;
+        Cb cb = benchJournalBuild(journalPath, groupSizes[i], count, &time);
+
+        if (cb == NULL) {
+            printf("    group %4zu: building failed\n", groupSizes[i]);
+            continue;
+        }
+
+        if (groupSizes[i] == 0)
+            printf("    no journal %12.3f K inserts/s\n", (double)(count - 1) / time * 1e-3);
+        else
+            printf("    group %4zu %12.3f K inserts/s (%zu inserts)\n", groupSizes[i], (double)(count - 1) / time * 1e-3, count - 1);
+        cbDtor(cb);
+    }
+
+    // journal of whole tree against full text dump
+    double buildTime = 0.0;
+    Cb cb = benchJournalBuild(journalPath, 4096, leafCount, &buildTime);
+    FILE *baseFile = cb != NULL
+        ? fopen(basePath, "w")
+        : NULL;
+
+    if (baseFile == NULL) {
+        printf("    preparation failed\n");
+        cbDtor(cb);
+        remove(journalPath);
+        return;
+    }
+
+    cbDumpBuffered(baseFile, cb, CB_DUMP_FORMAT_COMPACT, NULL, 0);
+    fclose(baseFile);
+
+    Cb replayed = cbCtor("объект 0", CB_LEAF_INDEX_HASH);
+    size_t recordCount = 0;
+
+    const double replayStart = benchTime();
+    const bool isReplayed = replayed != NULL && cbJournalReplay(journalPath, replayed, &recordCount);
+    const double replayTime = benchTime() - replayStart;
+
+    // second replay must skip every record
+    size_t repeatedCount = 0;
+    const bool isIdempotent = isReplayed && cbJournalReplay(journalPath, replayed, &repeatedCount) && repeatedCount == 0;
+
+    Cb parsed = NULL;
+    baseFile = fopen(basePath, "r");
+
+    const double parseStart = benchTime();
+    const bool isParsed = baseFile != NULL && cbParseFile(baseFile, CB_LEAF_INDEX_HASH, &parsed);
+    const double parseTime = benchTime() - parseStart;
+
+    if (baseFile != NULL)
+        fclose(baseFile);
+
+    CbJournal journal = cbJournalCtor(journalPath, 4096);
+    const size_t journalRecordCount = journal != NULL
+        ? cbJournalGetRecordCount(journal)
+        : 0;
+
+    const double compactStart = benchTime();
+    const bool isCompacted = journal != NULL && cbJournalCompact(journal, cb, basePath);
+    const double compactTime = benchTime() - compactStart;
+
+    const bool isValid = true
+        && isReplayed
+        && isIdempotent
+        && isParsed
+        && isCompacted
+        && recordCount == leafCount - 1
+        && journalRecordCount == recordCount
+        && cbJournalGetRecordCount(journal) == 0
+        && benchDumpEqual(cb, replayed)
+        && benchDumpEqual(cb, parsed);
+
+    printf("    replay  %10.3f ms (%zu records)\n", replayTime * 1e3, recordCount);
+    printf("    parse   %10.3f ms\n", parseTime * 1e3);
+    printf("    compact %10.3f ms%s\n", compactTime * 1e3, isValid ? "" : ", MISMATCH");
+
+    cbJournalDtor(journal);
+    cbDtor(parsed);
+    cbDtor(replayed);
+    cbDtor(cb);
+
+    remove(journalPath);
+    remove(basePath);
+} // benchJournal
+
+/// @brief count of distinct question texts in text pool benchmark
+#define BENCH_STRPOOL_QUESTION_COUNT ((size_t)1000)
+
+/**
+ * @brief question text interning benchmark function
+ * 
+ * @param[in] leafCount count of leaves
+ * 
+ * @note tree with few distinct questions is dumped and parsed back, as large imported trees are.
+ */
+static void benchStrPool( const size_t leafCount ) {
+    printf("strpool, %zu leaves, %zu distinct questions:\n", leafCount, BENCH_STRPOOL_QUESTION_COUNT);
+
+    Cb cb = cbCtor("объект 0", CB_LEAF_INDEX_HASH);
+    size_t state = 0x57A7;
+    char name[32] = {0};
+    char condition[64] = {0};
+
+    for (size_t i = 1; cb != NULL && i < leafCount; i++) {
+        CbIter iter = cbIter(cb);
+
+        while (!cbIterFinished(&iter))
+            cbIterNext(&iter, benchRandom(&state) & 1);
+
+        snprintf(name, sizeof(name), "объект %zu", i);
+        snprintf(condition, sizeof(condition), "обладает признаком номер %zu", benchRandom(&state) % BENCH_STRPOOL_QUESTION_COUNT);
+
+        if (!cbIterInsertCorrect(&iter, condition, name)) {
+            cbDtor(cb);
+            cb = NULL;
+        }
+    }
+
+    FILE *dumpFile = tmpfile();
+    FILE *snapshotFile = tmpfile();
+
+    if (cb == NULL || dumpFile == NULL || snapshotFile == NULL) {
+        printf("    preparation failed\n");
+        if (dumpFile != NULL)
+            fclose(dumpFile);
+        if (snapshotFile != NULL)
+            fclose(snapshotFile);
+        cbDtor(cb);
+        return;
+    }
+
+    cbDumpBuffered(dumpFile, cb, CB_DUMP_FORMAT_COMPACT, NULL, 0);
+    rewind(dumpFile);
+
+    Cb parsed = NULL;
+
+    const double parseStart = benchTime();
+    const bool isParsed = cbParseFile(dumpFile, CB_LEAF_INDEX_HASH, &parsed);
+    const double parseTime = benchTime() - parseStart;
+
+    const bool isSaved = cbSaveSnapshot(snapshotFile, cb);
+    const size_t snapshotSize = (size_t)ftell(snapshotFile);
+
+    if (isParsed && isSaved) {
+        CbArenaStat arenaStat;
+        CbStrPoolStat poolStat;
+
+        cbGetArenaStat(parsed, &arenaStat);
+        cbGetTextPoolStat(parsed, &poolStat);
+
+        printf("    parse         %10.3f ms%s\n", parseTime * 1e3, benchDumpEqual(cb, parsed) ? "" : ", MISMATCH");
+        printf("    tree arena    %10.3f MB\n", (double)arenaStat.bytesUsed * 1e-6);
+        printf("    question pool %10.3f MB (%zu texts)\n", (double)poolStat.stringSize * 1e-6, poolStat.stringCount);
+        printf("    saved         %10.3f MB (%zu questions)\n", (double)(poolStat.internSize - poolStat.stringSize) * 1e-6, poolStat.internCount);
+        printf("    snapshot      %10.3f MB\n", (double)snapshotSize * 1e-6);
+    } else {
+        printf("    parsing or snapshot saving failed\n");
+    }
+
+    fclose(snapshotFile);
+    fclose(dumpFile);
+    cbDtor(parsed);
+    cbDtor(cb);
+} // benchStrPool
+
+/// @brief synthetic tree shape
+typedef enum __BenchShape {
+    BENCH_SHAPE_BALANCED, ///< complete levels, depth is log2 of leaf count
+    BENCH_SHAPE_CHAIN,    ///< every interior node has leaf as incorrect child, depth is leaf count
+    BENCH_SHAPE_RANDOM,   ///< leaves inserted at ends of random walks, depth is O(log n) on average
+} BenchShape;
+
+/// @brief synthetic tree shape names
+static const char *const benchShapeNames[] = {
+    "balanced",
+    "chain",
+    "random",
+};
+
+/// @brief suite smallest tree node count
+#define BENCH_SUITE_MIN_NODE_COUNT ((size_t)1000)
+
+/// @brief suite default largest tree node count
+#define BENCH_SUITE_DEFAULT_MAX_NODE_COUNT ((size_t)10000000)
+
+/// @brief suite maximal count of measurement repetitions
+#define BENCH_SUITE_MAX_REPETITION_COUNT ((size_t)5)
+
+/// @brief suite node budget of measurement repetitions (fewer repetitions are made for larger trees)
+#define BENCH_SUITE_REPETITION_NODE_BUDGET ((size_t)10000000)
+
+/// @brief suite maximal count of lookup, walk and definition queries per repetition
+#define BENCH_SUITE_MAX_QUERY_COUNT ((size_t)1000000)
+
+/// @brief suite node step budget of walk and definition queries per repetition (limits queries on chains)
+#define BENCH_SUITE_STEP_BUDGET ((size_t)100000000)
+
+/// @brief suite leaf name buffer size
+#define BENCH_SUITE_NAME_SIZE ((size_t)32)
+
+/// @brief suite per-tree state
+typedef struct __BenchSuiteContext {
+    BenchShape  shape;      ///< tree shape
+    size_t      nodeCount;  ///< count of tree nodes
+    size_t      leafCount;  ///< count of tree leaves
+    Cb          cb;         ///< tree (built by insert measurement)
+    Cb          result;     ///< tree built by last insert or parse repetition
+    CbArena     arena;      ///< arena for allocation measurement
+    FILE       *dumpFile;   ///< file tree is dumped to (by dump measurement)
+    char       *text;       ///< dumped tree text (read after dump measurement)
+    size_t      textSize;   ///< dumped tree text size
+    char       *names;      ///< query leaf names (BENCH_SUITE_NAME_SIZE bytes each)
+    size_t      queryCount; ///< count of query leaf names
+    size_t      stepCount;  ///< count of node steps made by last measurement (walk and define only)
+} BenchSuiteContext;
+
+/**
+ * @brief suite synthetic tree building function
+ * 
+ * @param[in] shape     tree shape
+ * @param[in] leafCount count of leaves
+ * 
+ * @return built tree, NULL if something went wrong
+ * 
+ * @note leaves are named "объект i", i is insertion index, so names of all shapes are same.
+ */
+static Cb benchSuiteBuild( const BenchShape shape, const size_t leafCount ) {
+    Cb cb = cbCtor("объект 0", CB_LEAF_INDEX_TREE);
+    CbIter chainIter = cbIter(cb);
+    size_t state = 0xB0B0;
+    size_t levelSize = 1;
+    char name[BENCH_SUITE_NAME_SIZE] = {0};
+
+    for (size_t i = 1; cb != NULL && i < leafCount; i++) {
+        CbIter iter = chainIter;
+
+        if (shape == BENCH_SHAPE_BALANCED) {
+            // i-th insertion splits leaf (i - levelSize) of the last complete level
+            if (i == levelSize * 2)
+                levelSize *= 2;
+
+            iter = cbIter(cb);
+
+            for (size_t path = i - levelSize; !cbIterFinished(&iter); path >>= 1)
+                cbIterNext(&iter, path & 1);
+        } else if (shape == BENCH_SHAPE_RANDOM) {
+            iter = cbIter(cb);
+
+            while (!cbIterFinished(&iter))
+                cbIterNext(&iter, benchRandom(&state) & 1);
+        }
+
+        snprintf(name, sizeof(name), "объект %zu", i);
+
+        if (!cbIterInsertCorrect(&iter, "условие", name)) {
+            cbDtor(cb);
+            return NULL;
+        }
+
+        // chain grows from its new leaf
+        if (shape == BENCH_SHAPE_CHAIN) {
+            cbIterNext(&iter, true);
+            chainIter = iter;
+        }
+    }
+
+    return cb;
+} // benchSuiteBuild
+
+/**
+ * @brief suite walk performing function
+ * 
+ * @param[in]     context suite context (non-null, tree is built)
+ * @param[in,out] state   random generator state (non-null)
+ * 
+ * @return count of answers given
+ * 
+ * @note chain walks end at uniformly distributed depth, other walks are random.
+ */
+static size_t benchSuiteWalk( const BenchSuiteContext *const context, size_t *const state ) {
+    CbIter iter = cbIter(context->cb);
+    const size_t target = benchRandom(state) % context->leafCount;
+    size_t bits = benchRandom(state);
+    size_t steps = 0;
+
+    while (!cbIterFinished(&iter)) {
+        if (steps != 0 && steps % 64 == 0)
+            bits = benchRandom(state);
+
+        cbIterNext(&iter, context->shape == BENCH_SHAPE_CHAIN
+            ? steps < target
+            : (bits >> (steps % 64)) & 1
+        );
+        steps++;
+    }
+
+    return steps;
+} // benchSuiteWalk
+
+/**
+ * @brief suite walk and definition query count getting function
+ * 
+ * @param[in] context suite context (non-null)
+ * 
+ * @return count of queries fitting into step budget
+ */
+static size_t benchSuiteStepQueryCount( const BenchSuiteContext *const context ) {
+    if (context->shape != BENCH_SHAPE_CHAIN)
+        return context->queryCount;
+
+    // chain queries take leafCount / 2 steps on average
+    const size_t count = BENCH_SUITE_STEP_BUDGET / (context->leafCount / 2 + 1);
+
+    return count < 16
+        ? 16
+        : count < context->queryCount
+            ? count
+            : context->queryCount;
+} // benchSuiteStepQueryCount
+
+/**
+ * @brief cbIterInsertCorrect measurement
+ * 
+ * @param[in,out] context suite context (non-null)
+ * 
+ * @return count of insertions performed, 0 if measurement failed
+ */
+static size_t benchSuiteInsert( BenchSuiteContext *const context ) {
+    context->result = benchSuiteBuild(context->shape, context->leafCount);
+
+    return context->result == NULL ? 0 : context->leafCount - 1;
+} // benchSuiteInsert
+
+/**
+ * @brief insert measurement cleanup, built tree becomes context tree
+ * 
+ * @param[in,out] context suite context (non-null)
+ */
+static void benchSuiteInsertCleanup( BenchSuiteContext *const context ) {
+    cbDtor(context->cb);
+    context->cb = context->result;
+    context->result = NULL;
+} // benchSuiteInsertCleanup
+
+/**
+ * @brief cbDump (compact format) measurement
+ * 
+ * @param[in,out] context suite context (non-null)
+ * 
+ * @return count of nodes dumped, 0 if measurement failed
+ */
+static size_t benchSuiteDump( BenchSuiteContext *const context ) {
+    rewind(context->dumpFile);
+
+    // indented text of chain is quadratic in depth, so compact format is used for all shapes
+    const bool dumped = cbDumpBuffered(context->dumpFile, context->cb, CB_DUMP_FORMAT_COMPACT, NULL, 0);
+
+    fflush(context->dumpFile);
+
+    return dumped ? context->nodeCount : 0;
+} // benchSuiteDump
+
+/**
+ * @brief cbParse measurement
+ * 
+ * @param[in,out] context suite context (non-null, text is read)
+ * 
+ * @return count of nodes parsed, 0 if measurement failed
+ */
+static size_t benchSuiteParse( BenchSuiteContext *const context ) {
+    return cbParse(context->text, CB_LEAF_INDEX_TREE, &context->result)
+        ? context->nodeCount
+        : 0;
+} // benchSuiteParse
+
+/**
+ * @brief parse measurement cleanup
+ * 
+ * @param[in,out] context suite context (non-null)
+ */
+static void benchSuiteParseCleanup( BenchSuiteContext *const context ) {
+    cbDtor(context->result);
+    context->result = NULL;
+} // benchSuiteParseCleanup
+
+/**
+ * @brief leaf tree lookup (cbDefine without definition) measurement
+ * 
+ * @param[in,out] context suite context (non-null)
+ * 
+ * @return count of leaves found, 0 if measurement failed
+ */
+static size_t benchSuiteFind( BenchSuiteContext *const context ) {
+    size_t found = 0;
+
+    for (size_t i = 0; i < context->queryCount; i++)
+        found += cbDefine(context->cb, context->names + i * BENCH_SUITE_NAME_SIZE, NULL) != CB_DEFINE_STATUS_NO_SUBJECT;
+
+    return found == context->queryCount ? found : 0;
+} // benchSuiteFind
+
+/**
+ * @brief full cbIter walk measurement
+ * 
+ * @param[in,out] context suite context (non-null)
+ * 
+ * @return count of walks performed
+ */
+static size_t benchSuiteWalkAll( BenchSuiteContext *const context ) {
+    const size_t count = benchSuiteStepQueryCount(context);
+    size_t state = 0xA11;
+
+    context->stepCount = 0;
+
+    for (size_t i = 0; i < count; i++)
+        context->stepCount += benchSuiteWalk(context, &state);
+
+    return count;
+} // benchSuiteWalkAll
+
+/**
+ * @brief cbDefine with full definition iteration measurement
+ * 
+ * @param[in,out] context suite context (non-null)
+ * 
+ * @return count of definitions iterated, 0 if measurement failed
+ */
+static size_t benchSuiteDefine( BenchSuiteContext *const context ) {
+    const size_t count = benchSuiteStepQueryCount(context);
+
+    context->stepCount = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        CbDefIter iter;
+        const CbDefineStatus status = cbDefine(context->cb, context->names + i * BENCH_SUITE_NAME_SIZE, &iter);
+
+        if (status == CB_DEFINE_STATUS_NO_SUBJECT)
+            return 0;
+
+        if (status == CB_DEFINE_STATUS_OK)
+            do
+                context->stepCount++;
+            while (cbDefIterNext(&iter));
+    }
+
+    return count;
+} // benchSuiteDefine
+
+/**
+ * @brief cbArenaAlloc measurement (one node-sized allocation per tree node)
+ * 
+ * @param[in,out] context suite context (non-null)
+ * 
+ * @return count of allocations, 0 if measurement failed
+ */
+static size_t benchSuiteArena( BenchSuiteContext *const context ) {
+    size_t state = 0xA7E7A;
+
+    for (size_t i = 0; i < context->nodeCount; i++)
+        if (cbArenaAlloc(context->arena, 48 + benchRandom(&state) % 32) == NULL)
+            return 0;
+
+    return context->nodeCount;
+} // benchSuiteArena
+
+/**
+ * @brief arena measurement cleanup
+ * 
+ * @param[in,out] context suite context (non-null)
+ */
+static void benchSuiteArenaCleanup( BenchSuiteContext *const context ) {
+    cbArenaReset(context->arena);
+} // benchSuiteArenaCleanup
+
+/// @brief suite operation descriptor
+typedef struct __BenchSuiteOperation {
+    const char *name;                                ///< operation name
+    size_t (*run)( BenchSuiteContext *context );     ///< measurement function, returns operation count (0 on failure)
+    void (*cleanup)( BenchSuiteContext *context );   ///< untimed after-repetition cleanup function (nullable)
+} BenchSuiteOperation;
+
+/// @brief suite operations (in order of execution, insert builds tree the rest use)
+static const BenchSuiteOperation benchSuiteOperations[] = {
+    {"insert", benchSuiteInsert,  benchSuiteInsertCleanup},
+    {"dump",   benchSuiteDump,    NULL                   },
+    {"parse",  benchSuiteParse,   benchSuiteParseCleanup },
+    {"find",   benchSuiteFind,    NULL                   },
+    {"walk",   benchSuiteWalkAll, NULL                   },
+    {"define", benchSuiteDefine,  NULL                   },
+    {"arena",  benchSuiteArena,   benchSuiteArenaCleanup },
+};
+
+/**
+ * @brief double comparison function (for qsort)
+ * 
+ * @param[in] lhs first number pointer
+ * @param[in] rhs second number pointer
+ * 
+ * @return comparison result
+ */
+static int benchCompareDouble( const void *lhs, const void *rhs ) {
+    const double l = *(const double *)lhs;
+    const double r = *(const double *)rhs;
+
+    return (l > r) - (l < r);
+} // benchCompareDouble
+
+/**
+ * @brief suite measurement running function
+ * 
+ * @param[in,out] context         suite context (non-null)
+ * @param[in]     operation       operation to measure (non-null)
+ * @param[in]     repetitionCount count of repetitions
+ * @param[in,out] isFirst         true if no results are printed yet (non-null)
+ * 
+ * @return true if measured, false if some repetition failed
+ */
+static bool benchSuiteMeasure( BenchSuiteContext *const context, const BenchSuiteOperation *const operation, const size_t repetitionCount, bool *const isFirst ) {
+    double times[BENCH_SUITE_MAX_REPETITION_COUNT] = {0};
+    size_t operationCount = 0;
+
+    for (size_t i = 0; i < repetitionCount; i++) {
+        const double start = benchTime();
+        operationCount = operation->run(context);
+        times[i] = benchTime() - start;
+
+        if (operation->cleanup != NULL)
+            operation->cleanup(context);
+
+        if (operationCount == 0) {
+            fprintf(stderr, "%s/%s/%zu: FAILED\n", operation->name, benchShapeNames[context->shape], context->nodeCount);
+            return false;
+        }
+    }
+
+    qsort(times, repetitionCount, sizeof(double), benchCompareDouble);
+
+    const double median = times[repetitionCount / 2];
+
+    printf("%s    {\"name\": \"%s/%s/%zu\", \"operation\": \"%s\", \"shape\": \"%s\", \"nodes\": %zu, "
+        "\"repetitions\": %zu, \"iterations\": %zu, \"time_unit\": \"ns\", \"real_time\": %.3f, \"min_time\": %.3f, "
+        "\"items_per_second\": %.1f",
+        *isFirst ? "" : ",\n",
+        operation->name, benchShapeNames[context->shape], context->nodeCount,
+        operation->name,
+        benchShapeNames[context->shape],
+        context->nodeCount,
+        repetitionCount,
+        operationCount,
+        median * 1e9 / (double)operationCount,
+        times[0] * 1e9 / (double)operationCount,
+        (double)operationCount / median
+    );
+
+    if (operation->run == benchSuiteDump)
+        printf(", \"bytes\": %ld", ftell(context->dumpFile));
+    if (operation->run == benchSuiteWalkAll || operation->run == benchSuiteDefine)
+        printf(", \"steps\": %zu", context->stepCount);
+    printf("}");
+
+    fflush(stdout);
+    fprintf(stderr, " %12.1f ns/op\n", median * 1e9 / (double)operationCount);
+
+    *isFirst = false;
+
+    return true;
+} // benchSuiteMeasure
+
+/**
+ * @brief suite dump file reading function
+ * 
+ * @param[in,out] context suite context (non-null, tree is dumped)
+ * 
+ * @return true if read, false otherwise
+ */
+static bool benchSuiteReadDump( BenchSuiteContext *const context ) {
+    context->textSize = ftell(context->dumpFile);
+    context->text = (char *)calloc(context->textSize + 1, 1);
+
+    if (context->text == NULL)
+        return false;
+
+    rewind(context->dumpFile);
+
+    return fread(context->text, 1, context->textSize, context->dumpFile) == context->textSize;
+} // benchSuiteReadDump
+
+/**
+ * @brief suite single tree running function
+ * 
+ * @param[in]     shape     tree shape
+ * @param[in]     nodeCount count of tree nodes
+ * @param[in,out] isFirst   true if no results are printed yet (non-null)
+ * 
+ * @return true if all operations are measured, false otherwise
+ */
+static bool benchSuiteRunTree( const BenchShape shape, const size_t nodeCount, bool *const isFirst ) {
+    BenchSuiteContext context = {
+        .shape     = shape,
+        .nodeCount = nodeCount,
+        .leafCount = (nodeCount + 1) / 2,
+    };
+    size_t repetitionCount = BENCH_SUITE_REPETITION_NODE_BUDGET / nodeCount;
+
+    if (repetitionCount < 1)
+        repetitionCount = 1;
+    if (repetitionCount > BENCH_SUITE_MAX_REPETITION_COUNT)
+        repetitionCount = BENCH_SUITE_MAX_REPETITION_COUNT;
+
+    context.queryCount = context.leafCount < BENCH_SUITE_MAX_QUERY_COUNT ? context.leafCount : BENCH_SUITE_MAX_QUERY_COUNT;
+    context.names = (char *)calloc(context.queryCount, BENCH_SUITE_NAME_SIZE);
+    context.dumpFile = tmpfile();
+    context.arena = cbArenaCtor();
+
+    bool ok = context.names != NULL && context.dumpFile != NULL && context.arena != NULL;
+    size_t state = 0x9E3779B97F4A7C15;
+
+    for (size_t i = 0; ok && i < context.queryCount; i++)
+        snprintf(context.names + i * BENCH_SUITE_NAME_SIZE, BENCH_SUITE_NAME_SIZE, "объект %zu", benchRandom(&state) % context.leafCount);
+
+    for (size_t i = 0; ok && i < sizeof(benchSuiteOperations) / sizeof(benchSuiteOperations[0]); i++) {
+        fprintf(stderr, "%-8s %-8s %9zu", benchSuiteOperations[i].name, benchShapeNames[shape], nodeCount);
+
+        ok = benchSuiteMeasure(&context, &benchSuiteOperations[i], repetitionCount, isFirst);
+
+        if (ok && benchSuiteOperations[i].run == benchSuiteDump)
+            ok = benchSuiteReadDump(&context);
+    }
+
+    if (context.dumpFile != NULL)
+        fclose(context.dumpFile);
+    if (context.arena != NULL)
+        cbArenaDtor(context.arena);
+    free(context.names);
+    free(context.text);
+    cbDtor(context.result);
+    cbDtor(context.cb);
+
+    return ok;
+} // benchSuiteRunTree
+
+/**
+ * @brief benchmark suite running function
+ * 
+ * @param[in] maxNodeCount largest tree node count
+ * 
+ * @return true if all measurements succeeded, false otherwise
+ * 
+ * @note results are printed to stdout as JSON (Google Benchmark-like layout), progress is printed to stderr.
+ * every tree shape is measured at node counts 1e3, 1e4, ... up to maxNodeCount, all inputs are seeded,
+ * so runs are repeatable, and every measurement reports median and minimal time of its repetitions.
+ */
+static bool benchSuite( const size_t maxNodeCount ) {
+    const time_t now = time(NULL);
+    char date[32] = {0};
+
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+    static const char *const scanLevelNames[] = {"scalar", "sse2", "avx2"};
+
+    printf("{\n");
+    printf("  \"context\": {\"date\": \"%s\", \"num_cpus\": %ld, \"library_build_type\": \"%s\", \"scan_level\": \"%s\", \"max_nodes\": %zu},\n",
+        date,
+        sysconf(_SC_NPROCESSORS_ONLN),
+#ifdef NDEBUG
+        "release",
+#else
+        "debug",
+#endif
+        scanLevelNames[cbScanGetLevel()],
+        maxNodeCount
+    );
+    printf("  \"benchmarks\": [\n");
+
+    bool ok = true;
+    bool isFirst = true;
+
+    for (size_t nodeCount = BENCH_SUITE_MIN_NODE_COUNT; ok && nodeCount <= maxNodeCount; nodeCount *= 10)
+        for (size_t shape = 0; ok && shape < sizeof(benchShapeNames) / sizeof(benchShapeNames[0]); shape++)
+            ok = benchSuiteRunTree((BenchShape)shape, nodeCount, &isFirst);
+
+    printf("\n  ]\n}\n");
+
+    return ok;
+} // benchSuite
+
+/**
+ * @brief tree compact dump to string function
+ * 
+ * @param[in] cb cb to dump (non-null)
+ * 
+ * @return zero-terminated dump (allocated by malloc), NULL if something went wrong.
+ */
+static char * benchDumpToString( const Cb cb ) {
+    FILE *file = tmpfile();
+
+    if (file == NULL)
+        return NULL;
+
+    cbDumpBuffered(file, cb, CB_DUMP_FORMAT_COMPACT, NULL, 0);
+
+    const size_t size = (size_t)ftell(file);
+    char *text = (char *)calloc(size + 1, 1);
+
+    rewind(file);
+    if (text != NULL && fread(text, 1, size, file) != size) {
+        free(text);
+        text = NULL;
+    }
+    fclose(file);
+
+    return text;
+} // benchDumpToString
+
+/**
+ * @brief parallel parsing benchmark function
+ * 
+ * @param[in] leafCount count of leaves
+ */
+static void benchParallelParse( const size_t leafCount ) {
+    const size_t threadCounts[] = {2, 4, 8, 16};
+    const BenchShape shapes[] = {BENCH_SHAPE_RANDOM, BENCH_SHAPE_BALANCED, BENCH_SHAPE_CHAIN};
+
+    printf("parallel parse, %zu leaves, %ld cores:\n", leafCount, sysconf(_SC_NPROCESSORS_ONLN));
+
+    for (size_t i = 0; i < sizeof(shapes) / sizeof(shapes[0]); i++) {
+        Cb cb = benchSuiteBuild(shapes[i], leafCount);
+        char *const text = cb != NULL
+            ? benchDumpToString(cb)
+            : NULL;
+        Cb serial = NULL;
+
+        printf("    %s:\n", benchShapeNames[shapes[i]]);
+
+        const double serialStart = benchTime();
+        const bool isSerialParsed = text != NULL && cbParse(text, CB_LEAF_INDEX_HASH, &serial);
+        const double serialTime = benchTime() - serialStart;
+
+        if (!isSerialParsed) {
+            printf("        preparation failed\n");
+            free(text);
+            cbDtor(cb);
+            continue;
+        }
+
+        printf("        serial     %10.3f ms\n", serialTime * 1e3);
+
+        for (size_t j = 0; j < sizeof(threadCounts) / sizeof(threadCounts[0]); j++) {
+            Cb parallel = NULL;
+
+            const double parallelStart = benchTime();
+            const bool isParsed = cbParseParallel(text, CB_LEAF_INDEX_HASH, threadCounts[j], &parallel);
+            const double parallelTime = benchTime() - parallelStart;
+
+            // result must be the same tree with the same leaf index
+            bool isSame = true
+                && isParsed
+                && benchDumpEqual(serial, parallel)
+                && cbLeafIndexMemoryUsage(serial) == cbLeafIndexMemoryUsage(parallel);
+
+            for (size_t k = 0; isSame && k < leafCount; k += leafCount / 1000 + 1) {
+                char name[BENCH_SUITE_NAME_SIZE] = {0};
+                CbIter iter;
+
+                snprintf(name, sizeof(name), "объект %zu", k);
+                isSame = cbIterFindLeaf(parallel, name, &iter);
+            }
+
+            printf("        %2zu threads %10.3f ms%s\n", threadCounts[j], parallelTime * 1e3, isSame ? "" : ", MISMATCH");
+            cbDtor(parallel);
+        }
+
+        cbDtor(serial);
+        free(text);
+        cbDtor(cb);
+    }
+} // benchParallelParse
+
+/// @brief count of queries of every kind in trie benchmark
+#define BENCH_TRIE_QUERY_COUNT ((size_t)1000)
+
+/// @brief count of queries checked against full scan in trie benchmark
+#define BENCH_TRIE_CHECK_COUNT ((size_t)3)
+
+/**
+ * @brief code point Levenshtein distance computation function
+ * 
+ * @param[in] lhs first string
+ * @param[in] rhs second string
+ * 
+ * @return edit distance, SIZE_MAX if string is too long
+ */
+static size_t benchLevenshtein( const char *lhs, const char *rhs ) {
+    uint32_t l[64], r[64];
+    size_t rows[2][65];
+    size_t lLength = 0, rLength = 0;
+    uint32_t codePoint;
+
+    while ((codePoint = cbUtf8Next(&lhs)) != 0) {
+        if (lLength == 64)
+            return SIZE_MAX;
+        l[lLength++] = codePoint;
+    }
+    while ((codePoint = cbUtf8Next(&rhs)) != 0) {
+        if (rLength == 64)
+            return SIZE_MAX;
+        r[rLength++] = codePoint;
+    }
+
+    for (size_t j = 0; j <= rLength; j++)
+        rows[0][j] = j;
+
+    for (size_t i = 1; i <= lLength; i++) {
+        const size_t *const prev = rows[(i - 1) % 2];
+        size_t *const row = rows[i % 2];
+
+        row[0] = i;
+        for (size_t j = 1; j <= rLength; j++) {
+            size_t distance = prev[j - 1] + (l[i - 1] != r[j - 1]);
+
+            if (prev[j] + 1 < distance)
+                distance = prev[j] + 1;
+            if (row[j - 1] + 1 < distance)
+                distance = row[j - 1] + 1;
+            row[j] = distance;
+        }
+    }
+
+    return rows[lLength % 2][rLength];
+} // benchLevenshtein
+
+/**
+ * @brief leaf name trie benchmark function
+ * 
+ * @param[in] leafCount count of leaves
+ * 
+ * @note fuzzy queries are misspelled leaf names ("обьект" instead of "объект", plus extra digit for distance 2).
+ */
+static void benchTrie( const size_t leafCount ) {
+    printf("leaf trie, %zu leaves:\n", leafCount);
+
+    Cb cb = benchBuildRandomTree(leafCount, CB_LEAF_INDEX_HASH);
+
+    if (cb == NULL) {
+        printf("    preparation failed\n");
+        return;
+    }
+
+    const double buildStart = benchTime();
+    CbLeafTrie trie = cbLeafTrieCtor(cb);
+    const double buildTime = benchTime() - buildStart;
+
+    if (trie == NULL) {
+        printf("    building failed\n");
+        cbDtor(cb);
+        return;
+    }
+
+    printf("    build         %10.3f ms\n", buildTime * 1e3);
+    printf("    memory        %10.3f MB\n", (double)cbLeafTrieMemoryUsage(trie) * 1e-6);
+
+    const char *found[16];
+    CbLeafMatch matches[16];
+    char query[BENCH_SUITE_NAME_SIZE + 1] = {0};
+    char name[BENCH_SUITE_NAME_SIZE] = {0};
+    size_t state = 0x7219;
+    size_t resultCount = 0;
+    bool isCorrect = true;
+
+    // prefixes of random names
+    const double prefixStart = benchTime();
+    for (size_t i = 0; i < BENCH_TRIE_QUERY_COUNT; i++) {
+        snprintf(query, sizeof(query), "объект %zu", benchRandom(&state) % leafCount / 10 + 1);
+        resultCount += cbLeafTrieFindPrefix(trie, query, found, sizeof(found) / sizeof(found[0]));
+    }
+    const double prefixTime = benchTime() - prefixStart;
+
+    for (size_t i = 0; isCorrect && i < BENCH_TRIE_CHECK_COUNT; i++) {
+        const size_t prefixLength = (size_t)snprintf(query, sizeof(query), "объект %zu", benchRandom(&state) % leafCount / 10 + 1);
+        size_t expectedCount = 0;
+
+        for (size_t j = 0; j < leafCount; j++) {
+            snprintf(name, sizeof(name), "объект %zu", j);
+            expectedCount += strncmp(name, query, prefixLength) == 0;
+        }
+        isCorrect = cbLeafTrieFindPrefix(trie, query, NULL, 0) == expectedCount;
+    }
+
+    printf("    prefix        %10.3f us/query (%.1f names per query)%s\n",
+        prefixTime * 1e6 / BENCH_TRIE_QUERY_COUNT,
+        (double)resultCount / BENCH_TRIE_QUERY_COUNT,
+        isCorrect ? "" : ", MISMATCH"
+    );
+
+    for (size_t maxDistance = 1; maxDistance <= 2; maxDistance++) {
+        const char *const format = maxDistance == 1
+            ? "обьект %zu"
+            : "обьект %zu7";
+
+        resultCount = 0;
+        isCorrect = true;
+
+        const double fuzzyStart = benchTime();
+        for (size_t i = 0; i < BENCH_TRIE_QUERY_COUNT; i++) {
+            snprintf(query, sizeof(query), format, benchRandom(&state) % leafCount);
+            resultCount += cbLeafTrieFindFuzzy(trie, query, maxDistance, matches, sizeof(matches) / sizeof(matches[0]));
+        }
+        const double fuzzyTime = benchTime() - fuzzyStart;
+
+        for (size_t i = 0; isCorrect && i < BENCH_TRIE_CHECK_COUNT; i++) {
+            snprintf(query, sizeof(query), format, benchRandom(&state) % leafCount);
+            size_t expectedCount = 0;
+
+            for (size_t j = 0; j < leafCount; j++) {
+                snprintf(name, sizeof(name), "объект %zu", j);
+                expectedCount += benchLevenshtein(name, query) <= maxDistance;
+            }
+
+            const size_t count = cbLeafTrieFindFuzzy(trie, query, maxDistance, matches, 1);
+
+            isCorrect = true
+                && count == expectedCount
+                && (count == 0 || benchLevenshtein(matches[0].name, query) == matches[0].distance);
+        }
+
+        printf("    fuzzy, d = %zu  %10.3f us/query (%.1f names per query)%s\n",
+            maxDistance,
+            fuzzyTime * 1e6 / BENCH_TRIE_QUERY_COUNT,
+            (double)resultCount / BENCH_TRIE_QUERY_COUNT,
+            isCorrect ? "" : ", MISMATCH"
+        );
+    }
+
+    cbLeafTrieDtor(trie);
+    cbDtor(cb);
+} // benchTrie
+
+/**
+ * @brief named random tree building function
+ * 
+ * @param[in] rootName  root leaf name
+ * @param[in] prefix    other leaf name prefix
+ * @param[in] leafCount count of leaves
+ * @param[in] leafIndex leaf index kind
+ * @param[in] seed      random walk seed
+ * 
+ * @return built tree, NULL if something went wrong
+ */
+static Cb benchMergeBuild( const char *rootName, const char *prefix, const size_t leafCount, const CbLeafIndex leafIndex, size_t seed ) {
+    Cb cb = cbCtor(rootName, leafIndex);
+    char name[BENCH_SUITE_NAME_SIZE] = {0};
+    char condition[BENCH_SUITE_NAME_SIZE] = {0};
+
+    for (size_t i = 1; cb != NULL && i < leafCount; i++) {
+        CbIter iter = cbIter(cb);
+
+        while (!cbIterFinished(&iter))
+            cbIterNext(&iter, benchRandom(&seed) & 1);
+
+        snprintf(name, sizeof(name), "%s %zu", prefix, i);
+        snprintf(condition, sizeof(condition), "признак %zu", benchRandom(&seed) % 1000);
+
+        if (!cbIterInsertCorrect(&iter, condition, name)) {
+            cbDtor(cb);
+            return NULL;
+        }
+    }
+
+    return cb;
+} // benchMergeBuild
+
+/**
+ * @brief tree merging benchmark function
+ * 
+ * @param[in] leafCount count of leaves of every merged tree
+ * 
+ * @note merged tree is compared with parsed text merge of dumps, which is what merging took before.
+ */
+static void benchMerge( const size_t leafCount ) {
+    const CbLeafIndex leafIndices[] = {CB_LEAF_INDEX_TREE, CB_LEAF_INDEX_HASH};
+    const char *const leafIndexNames[] = {"tree", "hash"};
+
+    printf("merge, %zu + %zu leaves:\n", leafCount, leafCount);
+
+    for (size_t i = 0; i < sizeof(leafIndices) / sizeof(leafIndices[0]); i++) {
+        for (size_t isGraft = 0; isGraft < 2; isGraft++) {
+            char graftName[BENCH_SUITE_NAME_SIZE] = {0};
+
+            snprintf(graftName, sizeof(graftName), "объект %zu", leafCount / 2);
+
+            Cb dst = benchMergeBuild("объект 0", "объект", leafCount, leafIndices[i], 0xD57);
+            Cb src = benchMergeBuild(isGraft ? graftName : "регион 0", "регион", leafCount, leafIndices[i], 0x5EC);
+            char *const dstText = dst != NULL ? benchDumpToString(dst) : NULL;
+            char *const srcText = src != NULL ? benchDumpToString(src) : NULL;
+
+            printf("    %s index, %s:\n", leafIndexNames[i], isGraft ? "graft at common leaf" : "new root question");
+
+            if (dstText == NULL || srcText == NULL) {
+                printf("        preparation failed\n");
+                free(srcText);
+                free(dstText);
+                cbDtor(src);
+                cbDtor(dst);
+                continue;
+            }
+
+            // text merge: src dump is put in place of common leaf or under new root question
+            const double textStart = benchTime();
+            const size_t dstSize = strlen(dstText) - 1;
+            const size_t srcSize = strlen(srcText) - 1;
+            char *const text = (char *)calloc(dstSize + srcSize + 64, 1);
+            Cb parsed = NULL;
+
+            if (text != NULL) {
+                if (isGraft) {
+                    char quoted[BENCH_SUITE_NAME_SIZE + 2] = {0};
+
+                    snprintf(quoted, sizeof(quoted), "\"%s\"", graftName);
+
+                    const char *const leaf = strstr(dstText, quoted);
+                    const size_t prefixSize = (size_t)(leaf - dstText);
+
+                    memcpy(text, dstText, prefixSize);
+                    memcpy(text + prefixSize, srcText, srcSize);
+                    strcpy(text + prefixSize + srcSize, leaf + strlen(quoted));
+                } else {
+                    snprintf(text, dstSize + srcSize + 64, "(\"условие слияния\"%.*s%.*s)", (int)srcSize, srcText, (int)dstSize, dstText);
+                }
+                cbParse(text, leafIndices[i], &parsed);
+            }
+            const double textTime = benchTime() - textStart;
+
+            const double mergeStart = benchTime();
+            const CbMergeStatus status = cbMerge(dst, src, "условие слияния");
+            const double mergeTime = benchTime() - mergeStart;
+
+            bool isSame = status == CB_MERGE_STATUS_OK && parsed != NULL && benchDumpEqual(dst, parsed);
+
+            for (size_t k = 1; isSame && k < leafCount; k += leafCount / 1000 + 1) {
+                char name[BENCH_SUITE_NAME_SIZE] = {0};
+                CbIter iter;
+
+                snprintf(name, sizeof(name), k % 2 == 0 ? "объект %zu" : "регион %zu", k);
+                isSame = cbIterFindLeaf(dst, name, &iter);
+            }
+
+            printf("        text merge %10.3f ms\n", textTime * 1e3);
+            printf("        cbMerge    %10.3f ms%s\n", mergeTime * 1e3, isSame ? "" : ", MISMATCH");
+
+            // src is consumed only by successful merge
+            if (status != CB_MERGE_STATUS_OK)
+                cbDtor(src);
+            cbDtor(parsed);
+            free(text);
+            free(srcText);
+            free(dstText);
+            cbDtor(dst);
+        }
+    }
+
+    // second common leaf makes graft point ambiguous
+    Cb dst = cbCtor("объект", CB_LEAF_INDEX_TREE);
+    Cb src = cbCtor("объект", CB_LEAF_INDEX_HASH);
+    CbIter iter;
+    bool isRejected = false;
+
+    if (dst != NULL && src != NULL) {
+        iter = cbIter(dst);
+        cbIterInsertCorrect(&iter, "признак", "регион");
+        iter = cbIter(src);
+        cbIterInsertCorrect(&iter, "признак", "регион");
+        isRejected = cbMerge(dst, src, NULL) == CB_MERGE_STATUS_COLLISION;
+    }
+
+    printf("    collision  %s\n", isRejected ? "rejected" : "MISMATCH");
+
+    cbDtor(src);
+    cbDtor(dst);
+} // benchMerge
+
+/**
+ * @brief tree dumping and parsing back measurement function
+ * 
+ * @param[in]  cb     tree to dump (non-null)
+ * @param[in]  format dump format
+ * @param[out] size   dump size destination (non-null)
+ * @param[out] parsed parsed tree destination (non-null, NULL if dumping or parsing failed)
+ * 
+ * @return parsing time (in seconds)
+ */
+static double benchPackedMeasure( const Cb cb, const CbDumpFormat format, size_t *const size, Cb *const parsed ) {
+    FILE *file = tmpfile();
+
+    *size = 0;
+    *parsed = NULL;
+
+    if (file == NULL)
+        return 0.0;
+
+    cbDumpBuffered(file, cb, format, NULL, 0);
+    *size = (size_t)ftell(file);
+    rewind(file);
+
+    const double start = benchTime();
+    const bool isParsed = format == CB_DUMP_FORMAT_PACKED
+        ? cbParsePackedFile(file, CB_LEAF_INDEX_HASH, parsed)
+        : cbParseFile(file, CB_LEAF_INDEX_HASH, parsed);
+    const double time = benchTime() - start;
+
+    if (!isParsed)
+        *parsed = NULL;
+    fclose(file);
+
+    return time;
+} // benchPackedMeasure
+
+/**
+ * @brief packed format benchmark function
+ * 
+ * @param[in] leafCount count of leaves
+ * 
+ * @note packed dump is also corrupted and truncated to check it's rejected.
+ */
+static void benchPacked( const size_t leafCount ) {
+    const CbDumpFormat formats[] = {CB_DUMP_FORMAT_INDENTED, CB_DUMP_FORMAT_COMPACT, CB_DUMP_FORMAT_PACKED};
+    const char *const formatNames[] = {"indented", "compact", "packed"};
+    const char *const treeNames[] = {"random, 1 question", "random, 1000 questions", "chain"};
+
+    printf("packed format, %zu leaves:\n", leafCount);
+
+    for (size_t i = 0; i < sizeof(treeNames) / sizeof(treeNames[0]); i++) {
+        Cb cb = i == 0
+            ? benchBuildRandomTree(leafCount, CB_LEAF_INDEX_HASH)
+            : i == 1
+                ? benchMergeBuild("объект 0", "объект", leafCount, CB_LEAF_INDEX_HASH, 0xFAC)
+                : benchSuiteBuild(BENCH_SHAPE_CHAIN, leafCount);
+
+        printf("    %s:\n", treeNames[i]);
+
+        if (cb == NULL) {
+            printf("        preparation failed\n");
+            continue;
+        }
+
+        // indented dump of chain is quadratic, so it's skipped
+        for (size_t j = i == 2 ? 1 : 0; j < sizeof(formats) / sizeof(formats[0]); j++) {
+            size_t size = 0;
+            Cb parsed = NULL;
+            const double time = benchPackedMeasure(cb, formats[j], &size, &parsed);
+
+            printf("        %-8s %10.3f MB, parse %10.3f ms%s\n",
+                formatNames[j],
+                (double)size * 1e-6,
+                time * 1e3,
+                parsed != NULL && benchDumpEqual(cb, parsed) ? "" : ", MISMATCH"
+            );
+            cbDtor(parsed);
+        }
+
+        cbDtor(cb);
+    }
+
+    // every flipped byte or cut tail must be detected
+    Cb cb = benchBuildRandomTree(1000, CB_LEAF_INDEX_HASH);
+    FILE *file = tmpfile();
+    char *data = NULL;
+    size_t size = 0;
+    bool isRejected = cb != NULL && file != NULL;
+
+    if (isRejected) {
+        cbDumpBuffered(file, cb, CB_DUMP_FORMAT_PACKED, NULL, 0);
+        size = (size_t)ftell(file);
+        rewind(file);
+        data = (char *)malloc(size);
+        isRejected = data != NULL && fread(data, 1, size, file) == size;
+    }
+
+    for (size_t i = 0; isRejected && i < size; i += size / 97 + 1) {
+        Cb parsed = NULL;
+
+        data[i] ^= 0x10;
+        BenchChunkReader flipped = { data, data + size, size };
+        isRejected = !cbParsePacked(benchChunkRead, &flipped, CB_LEAF_INDEX_HASH, &parsed);
+        data[i] ^= 0x10;
+
+        BenchChunkReader truncated = { data, data + i, size };
+        isRejected = isRejected && !cbParsePacked(benchChunkRead, &truncated, CB_LEAF_INDEX_HASH, &parsed);
+    }
+
+    printf("    corruption %s\n", isRejected ? "rejected" : "MISMATCH");
+
+    free(data);
+    if (file != NULL)
+        fclose(file);
+    cbDtor(cb);
+} // benchPacked
+
+/**
+ * @brief version tree leaf counting function
+ * 
+ * @param[in] cb      cb (non-null)
+ * @param[in] version version to walk (non-null)
+ * 
+ * @return count of version leaves, 0 if allocation failed
+ */
+static size_t benchVersionLeafCount( const Cb cb, const CbVersion version ) {
+    size_t stackCapacity = 1024;
+    size_t stackSize = 0;
+    CbIter *stack = (CbIter *)malloc(stackCapacity * sizeof(CbIter));
+    size_t leafCount = 0;
+
+    if (stack == NULL)
+        return 0;
+
+    stack[stackSize++] = cbIterVersion(cb, version);
+
+    while (stackSize != 0) {
+        CbIter correct = stack[--stackSize];
+
+        if (cbIterFinished(&correct)) {
+            leafCount++;
+            continue;
+        }
+
+        if (stackSize + 2 > stackCapacity) {
+            CbIter *const newStack = (CbIter *)realloc(stack, stackCapacity * 2 * sizeof(CbIter));
+
+            if (newStack == NULL) {
+                free(stack);
+                return 0;
+            }
+            stack = newStack;
+            stackCapacity *= 2;
+        }
+
+        CbIter incorrect = correct;
+
+        cbIterNext(&correct, true);
+        cbIterNext(&incorrect, false);
+        stack[stackSize++] = incorrect;
+        stack[stackSize++] = correct;
+    }
+
+    free(stack);
+
+    return leafCount;
+} // benchVersionLeafCount
+
+/**
+ * @brief tree versions benchmark function
+ * 
+ * @param[in] leafCount count of leaves
+ * 
+ * @note versioned tree is checked against unversioned ones built by same insertions, snapshot of
+ * version is compared with full tree snapshot (cbSnapshotCtor), which is what keeping old tree took before.
+ */
+static void benchVersions( const size_t leafCount ) {
+    printf("versions, %zu leaves:\n", leafCount);
+
+    // same seed gives same insertions, so half-built tree is version of full one
+    const size_t halfCount = leafCount / 2 + 1;
+    const double plainStart = benchTime();
+    Cb plain = benchMergeBuild("объект 0", "объект", leafCount, CB_LEAF_INDEX_HASH, 0x7E5);
+    const double plainTime = benchTime() - plainStart;
+    Cb half = benchMergeBuild("объект 0", "объект", halfCount, CB_LEAF_INDEX_HASH, 0x7E5);
+    Cb cb = cbCtor("объект 0", CB_LEAF_INDEX_HASH);
+
+    if (plain == NULL || half == NULL || cb == NULL || !cbEnableVersions(cb)) {
+        printf("    preparation failed\n");
+        cbDtor(cb);
+        cbDtor(half);
+        cbDtor(plain);
+        return;
+    }
+
+    // versioned tree is built by same insertions, snapshot is taken in the middle
+    size_t seed = 0x7E5;
+    char name[BENCH_SUITE_NAME_SIZE] = {0};
+    char condition[BENCH_SUITE_NAME_SIZE] = {0};
+    CbVersion halfVersion = NULL;
+    bool ok = true;
+    const double versionedStart = benchTime();
+
+    for (size_t i = 1; ok && i < leafCount; i++) {
+        CbIter iter = cbIter(cb);
+
+        while (!cbIterFinished(&iter))
+            cbIterNext(&iter, benchRandom(&seed) & 1);
+
+        snprintf(name, sizeof(name), "объект %zu", i);
+        snprintf(condition, sizeof(condition), "признак %zu", benchRandom(&seed) % 1000);
+
+        ok = cbIterInsertCorrect(&iter, condition, name);
+
+        if (i + 1 == halfCount)
+            halfVersion = cbGetVersion(cb);
+    }
+
+    const double versionedTime = benchTime() - versionedStart;
+
+    CbArenaStat plainStat = {0};
+    CbArenaStat versionedStat = {0};
+
+    cbGetArenaStat(plain, &plainStat);
+    cbGetArenaStat(cb, &versionedStat);
+
+    printf("    insertion, plain     %10.3f ms, %10.3f MB\n", plainTime * 1e3, (double)plainStat.bytesUsed / (1 << 20));
+    printf("    insertion, versioned %10.3f ms, %10.3f MB%s\n",
+        versionedTime * 1e3,
+        (double)versionedStat.bytesUsed / (1 << 20),
+        ok && benchDumpEqual(cb, plain) ? "" : ", MISMATCH"
+    );
+
+    if (!ok || halfVersion == NULL) {
+        cbDtor(cb);
+        cbDtor(half);
+        cbDtor(plain);
+        return;
+    }
+
+    // old tree copy is what serving it during edits took before
+    const double snapshotStart = benchTime();
+    CbSnapshot snapshot = cbSnapshotCtor(half);
+    const double snapshotTime = benchTime() - snapshotStart;
+
+    const double versionStart = benchTime();
+    const CbVersion version = cbGetVersion(cb);
+    const double versionTime = benchTime() - versionStart;
+
+    printf("    snapshot, copy       %10.3f ms\n", snapshotTime * 1e3);
+    printf("    snapshot, version    %10.3f ms\n", versionTime * 1e3);
+
+    const double walkStart = benchTime();
+    const size_t halfLeafCount = benchVersionLeafCount(cb, halfVersion);
+    const double walkTime = benchTime() - walkStart;
+
+    printf("    old version walk     %10.3f ms%s\n", walkTime * 1e3, halfLeafCount == halfCount ? "" : ", MISMATCH");
+
+    // diff of adjacent versions touches single path
+    CbVersionInfo info = {0};
+    CbVersionChange change = {0};
+    size_t changeCount = 0;
+
+    cbVersionGetInfo(version, &info);
+
+    const double lastDiffStart = benchTime();
+    const bool lastDiffOk = true
+        && cbVersionDiff(info.prev, version, &change, 1, &changeCount)
+        && changeCount == 1
+        && change.isAdded
+        && strcmp(change.name, info.leaf) == 0;
+    const double lastDiffTime = benchTime() - lastDiffStart;
+
+    const double diffStart = benchTime();
+    const bool diffOk = true
+        && cbVersionDiff(halfVersion, version, NULL, 0, &changeCount)
+        && changeCount == leafCount - halfCount;
+    const double diffTime = benchTime() - diffStart;
+
+    printf("    diff, 1 insertion    %10.3f ms%s\n", lastDiffTime * 1e3, lastDiffOk ? "" : ", MISMATCH");
+    printf("    diff, %zu insertions %10.3f ms%s\n", leafCount - halfCount, diffTime * 1e3, diffOk ? "" : ", MISMATCH");
+
+    // rollback hides newer leaves, reinsertion reuses them and switching back restores full tree
+    const double rollbackStart = benchTime();
+    bool isSame = cbSetVersion(cb, halfVersion);
+    const double rollbackTime = benchTime() - rollbackStart;
+    CbDefIter defIter;
+
+    snprintf(name, sizeof(name), "объект %zu", leafCount - 1);
+    isSame = isSame && benchDumpEqual(cb, half) && (leafCount == halfCount || cbDefine(cb, name, &defIter) == CB_DEFINE_STATUS_NO_SUBJECT);
+
+    CbIter iter = cbIter(cb);
+
+    snprintf(condition, sizeof(condition), "признак ветки");
+    while (!cbIterFinished(&iter))
+        cbIterNext(&iter, false);
+    isSame = isSame && (leafCount == halfCount || cbIterInsertCorrect(&iter, condition, name));
+
+    const double restoreStart = benchTime();
+    isSame = isSame && cbSetVersion(cb, version);
+    const double restoreTime = benchTime() - restoreStart;
+
+    isSame = isSame && benchDumpEqual(cb, plain) && cbDefine(cb, name, &defIter) == CB_DEFINE_STATUS_OK;
+
+    printf("    rollback             %10.3f ms\n", rollbackTime * 1e3);
+    printf("    restore              %10.3f ms%s\n", restoreTime * 1e3, isSame ? "" : ", MISMATCH");
+
+    // restructured tree is version too, while versions before it stay as they were (unique questions keep leaves distinguishable)
+    Cb small = cbCtor("объект 0", CB_LEAF_INDEX_TREE);
+    const size_t smallCount = leafCount < 1000 ? leafCount : 1000;
+
+    isSame = small != NULL && cbEnableVersions(small);
+
+    for (size_t i = 1; isSame && i < smallCount; i++) {
+        CbIter smallIter = cbIter(small);
+
+        while (!cbIterFinished(&smallIter))
+            cbIterNext(&smallIter, benchRandom(&seed) & 1);
+
+        snprintf(name, sizeof(name), "объект %zu", i);
+        snprintf(condition, sizeof(condition), "признак %zu", i);
+        isSame = cbIterInsertCorrect(&smallIter, condition, name);
+    }
+
+    const CbVersion smallVersion = isSame ? cbGetVersion(small) : NULL;
+    char *const smallText = isSame ? benchDumpToString(small) : NULL;
+    char *restoredText = NULL;
+
+    isSame = true
+        && smallText != NULL
+        && cbOptimize(small, NULL, 0, NULL, NULL)
+        && cbVersionDiff(smallVersion, cbGetVersion(small), NULL, 0, &changeCount)
+        && changeCount == 0
+        && cbSetVersion(small, smallVersion)
+        && (restoredText = benchDumpToString(small)) != NULL
+        && strcmp(smallText, restoredText) == 0;
+
+    printf("    optimize rollback    %s\n", isSame ? "ok" : "MISMATCH");
+
+    free(restoredText);
+    free(smallText);
+    cbDtor(small);
+
+    cbSnapshotDtor(snapshot);
+    cbDtor(cb);
+    cbDtor(half);
+    cbDtor(plain);
+} // benchVersions
+
+/// @brief count of simultaneous load test connections
+#define BENCH_SERVER_CONNECTION_COUNT ((size_t)1000)
+
+/// @brief count of load test sessions
+#define BENCH_SERVER_SESSION_COUNT ((size_t)20000)
+
+/// @brief every this count of guesses is rejected, so session ends by insertion
+#define BENCH_SERVER_ADD_PERIOD ((size_t)16)
+
+/// @brief load test client reply buffer size
+#define BENCH_SERVER_LINE_SIZE ((size_t)256)
+
+/// @brief load test connection
+typedef struct __BenchServerClient {
+    int    fd;                             ///< connection socket
+    size_t seed;                           ///< answer generator state
+    double sendTime;                       ///< time of last request
+    bool   isAdding;                       ///< true if last request is ADD
+    size_t inputSize;                      ///< count of received bytes
+    char   input[BENCH_SERVER_LINE_SIZE];  ///< received bytes
+} BenchServerClient;
+
+/// @brief load test state
+typedef struct __BenchServerLoad {
+    double *latencies;        ///< request latencies (in seconds)
+    size_t  latencyCount;     ///< count of latencies
+    size_t  latencyCapacity;  ///< latencies capacity
+    size_t  startedCount;     ///< count of started sessions
+    size_t  finishedCount;    ///< count of finished sessions
+    size_t  insertionCount;   ///< count of sent insertions
+    size_t  conflictCount;    ///< count of insertions rejected as other session replaced same leaf before
+    size_t  errorCount;       ///< count of other ERR and unexpected replies
+} BenchServerLoad;
+
+/**
+ * @brief server event loop thread function
+ * 
+ * @param[in] context server (non-null)
+ * 
+ * @return NULL
+ */
+static void * benchServerThread( void *context ) {
+    cbServerRun((CbServer)context);
+    return NULL;
+} // benchServerThread
+
+/**
+ * @brief load test request sending function
+ * 
+ * @param[in,out] client client (non-null)
+ * @param[in]     line   request line with '\n' (non-null)
+ * 
+ * @return true if request is sent, false otherwise
+ */
+static bool benchServerSend( BenchServerClient *const client, const char *const line ) {
+    const size_t size = strlen(line);
+
+    client->sendTime = benchTime();
+
+    return send(client->fd, line, size, MSG_NOSIGNAL) == (ssize_t)size;
+} // benchServerSend
+
+/**
+ * @brief load test reply handling function
+ * 
+ * @param[in,out] load   load test state (non-null)
+ * @param[in,out] client client (non-null)
+ * @param[in]     line   reply line without '\n' (non-null)
+ * 
+ * @return true if connection should stay open, false if all sessions are started or request can't be sent
+ */
+static bool benchServerHandleReply( BenchServerLoad *const load, BenchServerClient *const client, const char *const line ) {
+    // latencies are kept, so percentiles are exact
+    if (load->latencyCount == load->latencyCapacity) {
+        const size_t capacity = load->latencyCapacity == 0 ? 1024 : load->latencyCapacity * 2;
+        double *const latencies = (double *)realloc(load->latencies, capacity * sizeof(double));
+
+        if (latencies == NULL)
+            return false;
+
+        load->latencies = latencies;
+        load->latencyCapacity = capacity;
+    }
+    load->latencies[load->latencyCount++] = benchTime() - client->sendTime;
+
+    const bool isAdding = client->isAdding;
+
+    client->isAdding = false;
+
+    if (line[0] == 'Q')
+        return benchServerSend(client, benchRandom(&client->seed) & 1 ? "YES\n" : "NO\n");
+
+    if (line[0] == 'L')
+        return benchServerSend(client, benchRandom(&client->seed) % BENCH_SERVER_ADD_PERIOD == 0 ? "NO\n" : "YES\n");
+
+    if (strcmp(line, "ASK") == 0) {
+        char request[BENCH_SERVER_LINE_SIZE] = {0};
+
+        snprintf(request, sizeof(request), "ADD признак клиента %zu\tклиент %zu\n", load->insertionCount, load->insertionCount);
+        load->insertionCount++;
+        client->isAdding = true;
+
+        return benchServerSend(client, request);
+    }
+
+    // rejected insertion ends session too, new one is started
+    if (strcmp(line, "OK") == 0)
+        load->finishedCount++;
+    else if (isAdding && strncmp(line, "ERR", 3) == 0)
+        load->conflictCount++;
+    else
+        load->errorCount++;
+
+    if (load->startedCount == BENCH_SERVER_SESSION_COUNT)
+        return false;
+
+    load->startedCount++;
+
+    return benchServerSend(client, "START\n");
+} // benchServerHandleReply
+
+/**
+ * @brief load test running function
+ * 
+ * @param[in]     socketPath server socket path (non-null)
+ * @param[in,out] load       load test state (non-null, zeroed)
+ * 
+ * @return true if all connections are served till the end, false if something failed
+ */
+static bool benchServerLoad( const char *const socketPath, BenchServerLoad *const load ) {
+    BenchServerClient *const clients = (BenchServerClient *)calloc(BENCH_SERVER_CONNECTION_COUNT, sizeof(BenchServerClient));
+    const int epollFd = epoll_create1(0);
+    struct sockaddr_un address = {};
+    size_t openCount = 0;
+    bool ok = clients != NULL && epollFd >= 0;
+
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socketPath, sizeof(address.sun_path) - 1);
+
+    // every connection starts its first session at once
+    for (size_t i = 0; ok && i < BENCH_SERVER_CONNECTION_COUNT; i++) {
+        BenchServerClient *const client = &clients[i];
+        struct epoll_event event = {};
+
+        event.events = EPOLLIN;
+        event.data.ptr = client;
+        client->seed = 0x5E55 + i * 0x9E3779B9;
+
+        ok = true
+            && (client->fd = socket(AF_UNIX, SOCK_STREAM, 0)) >= 0
+            && connect(client->fd, (const struct sockaddr *)&address, sizeof(address)) == 0
+            && epoll_ctl(epollFd, EPOLL_CTL_ADD, client->fd, &event) == 0
+            && benchServerSend(client, "START\n");
+
+        if (client->fd >= 0)
+            openCount++;
+        load->startedCount++;
+    }
+
+    struct epoll_event events[64];
+
+    while (ok && openCount != 0) {
+        const int eventCount = epoll_wait(epollFd, events, 64, -1);
+
+        ok = eventCount > 0;
+
+        for (int i = 0; ok && i < eventCount; i++) {
+            BenchServerClient *const client = (BenchServerClient *)events[i].data.ptr;
+            const ssize_t size = recv(client->fd, client->input + client->inputSize, BENCH_SERVER_LINE_SIZE - client->inputSize, 0);
+            bool isOpen = size > 0;
+
+            if (isOpen)
+                client->inputSize += (size_t)size;
+
+            // every connection has single request in flight, so it gets single reply line
+            char *const end = (char *)memchr(client->input, '\n', client->inputSize);
+
+            if (isOpen && end != NULL) {
+                *end = '\0';
+                client->inputSize = 0;
+                isOpen = benchServerHandleReply(load, client, client->input);
+            }
+
+            if (!isOpen) {
+                ok = size > 0;
+                close(client->fd);
+                client->fd = -1;
+                openCount--;
+            }
+        }
+    }
+
+    for (size_t i = 0; clients != NULL && i < BENCH_SERVER_CONNECTION_COUNT; i++)
+        if (clients[i].fd > 0)
+            close(clients[i].fd);
+    if (epollFd >= 0)
+        close(epollFd);
+    free(clients);
+
+    return ok;
+} // benchServerLoad
+
+/**
+ * @brief server load test benchmark function
+ * 
+ * @param[in] leafCount count of leaves of served tree
+ * 
+ * @note client runs in same process and shares CPU with server, so numbers are a lower bound.
+ */
+static void benchServer( const size_t leafCount ) {
+    printf("server, %zu leaves, %zu connections, %zu sessions:\n", leafCount, BENCH_SERVER_CONNECTION_COUNT, BENCH_SERVER_SESSION_COUNT);
+
+    char socketPath[64] = {0};
+
+    snprintf(socketPath, sizeof(socketPath), "/tmp/cactusbot_bench_%d.sock", (int)getpid());
+
+    Cb cb = benchMergeBuild("объект 0", "объект", leafCount, CB_LEAF_INDEX_HASH, 0x5E7);
+    CbServer server = cb != NULL ? cbServerCtor(cb, socketPath, 0) : NULL;
+    pthread_t thread;
+
+    if (server == NULL || pthread_create(&thread, NULL, benchServerThread, server) != 0) {
+        printf("    preparation failed\n");
+        cbServerDtor(server);
+        cbDtor(cb);
+        return;
+    }
+
+    BenchServerLoad load = {0};
+    const double start = benchTime();
+    const bool ok = benchServerLoad(socketPath, &load);
+    const double time = benchTime() - start;
+
+    cbServerStop(server);
+    pthread_join(thread, NULL);
+
+    CbServerStat stat = {0};
+
+    cbServerGetStat(server, &stat);
+
+    // every accepted insertion must be visible in tree
+    size_t definedCount = 0;
+
+    for (size_t i = 0; i < load.insertionCount; i++) {
+        char name[BENCH_SUITE_NAME_SIZE] = {0};
+        CbDefIter iter;
+
+        snprintf(name, sizeof(name), "клиент %zu", i);
+        definedCount += cbDefine(cb, name, &iter) == CB_DEFINE_STATUS_OK;
+    }
+
+    const bool isSame = true
+        && ok
+        && load.errorCount == 0
+        && stat.sessionCount == load.finishedCount
+        && stat.insertionCount == load.insertionCount - load.conflictCount
+        && stat.insertionCount == definedCount
+        && stat.requestCount == load.latencyCount;
+
+    qsort(load.latencies, load.latencyCount, sizeof(double), benchCompareDouble);
+
+    const double p50 = load.latencyCount == 0 ? 0.0 : load.latencies[load.latencyCount / 2];
+    const double p99 = load.latencyCount == 0 ? 0.0 : load.latencies[load.latencyCount * 99 / 100];
+
+    printf("    sessions     %10.0f per second (%zu insertions, %zu conflicts)\n", (double)load.finishedCount / time, stat.insertionCount, load.conflictCount);
+    printf("    requests     %10.0f per second\n", (double)load.latencyCount / time);
+    printf("    latency p50  %10.3f us\n", p50 * 1e6);
+    printf("    latency p99  %10.3f us%s\n", p99 * 1e6, isSame ? "" : ", MISMATCH");
+
+    free(load.latencies);
+    cbServerDtor(server);
+    cbDtor(cb);
+} // benchServer
+
+/// @brief benchmark descriptor
+typedef struct __BenchDescriptor {
+    const char *name;                ///< benchmark name
+    void (*run)( size_t leafCount ); ///< benchmark function
+} BenchDescriptor;
+
+/// @brief benchmark table
+static const BenchDescriptor benchDescriptors[] = {
+    {"leaf",       benchLeafIndexAll },
+    {"snapshot",   benchSnapshot     },
+    {"stream",     benchStream       },
+    {"deep",       benchDeep         },
+    {"scan",       benchScan         },
+    {"dump",       benchDump         },
+    {"arena",      benchArena        },
+    {"concurrent", benchConcurrent   },
+    {"walk",       benchWalk         },
+    {"batch",      benchBatch        },
+    {"path",       benchPath         },
+    {"compare",    benchCompare      },
+    {"optimize",   benchOptimize     },
+    {"stat",       benchStat         },
+    {"journal",    benchJournal      },
+    {"strpool",    benchStrPool      },
+    {"pparse",     benchParallelParse},
+    {"trie",       benchTrie         },
+    {"merge",      benchMerge        },
+    {"packed",     benchPacked       },
+    {"versions",   benchVersions     },
+    {"server",     benchServer       },
+};
+
+/**
+ * @brief benchmark main function
+ * 
+ * @param[in] argc argument count
+ * @param[in] argv arguments (optional benchmark name and leaf count)
+ * 
+ * @return exit status
+ */
+int main( int argc, const char **argv ) {
+    const char *benchName = argc > 1
+        ? argv[1]
+        : "all";
+    const size_t leafCount = argc > 2
+        ? strtoull(argv[2], NULL, 10)
+        : 1000000;
+
+    if (leafCount == 0) {
+        printf("usage: %s [benchmark name|all] [leaf count]\n", argv[0]);
+        printf("       %s suite [max node count] > result.json\n", argv[0]);
+        return 1;
+    }
+
+    // suite prints JSON only, so it isn't a part of 'all'
+    if (strcmp(benchName, "suite") == 0)
+        return benchSuite(argc > 2 ? leafCount : BENCH_SUITE_DEFAULT_MAX_NODE_COUNT) ? 0 : 1;
+
+    bool found = false;
+
+    for (size_t i = 0; i < sizeof(benchDescriptors) / sizeof(benchDescriptors[0]); i++) {
+        if (strcmp(benchName, "all") == 0 || strcmp(benchName, benchDescriptors[i].name) == 0) {
+            benchDescriptors[i].run(leafCount);
+            found = true;
+        }
+    }
+
+    if (!found) {
+        printf("unknown benchmark: %s\n", benchName);
+        return 1;
+    }
+
+    return 0;
+} // main
+
+// cb_bench.c
@@ -3,12 +3,17 @@
  */
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 
+#include <pthread.h>
+
 #include "cb.h"
 #include "cb_arena.h"
+#include "cb_scan.h"
 
 /// @brief constant string slice
 typedef struct __CbStr {
@@ -19,18 +24,57 @@ typedef struct __CbStr {
 /// @brief string slice from constant string construction macro.
 #define CB_STR(str) ((CbStr) { (const char *)(str), (const char *)(str) + strlen((str)) })
 
+/*
+ * concurrency model:
+ *     any count of reader threads may use cbIter* and cbDefine/cbDefIter* functions without locks
+ *     while single writer thread calls cbIterInsertCorrect (writers must be serialized by user).
+ *     all other functions require exclusive access to cactusbot.
+ *
+ *     main tree is RCU-like: nodes are never changed after publication except for child and parent
+ *     links, and new nodes are completely built before being published by release store. nodes
+ *     are never freed until cbReset/cbDtor, so readers need no reclamation scheme.
+ *
+ *     leaf index is guarded by sequence lock: readers retry lookup if writer changed index during it.
+ *     replaced hash tables are kept in arena, so readers may safely finish lookup in outdated one.
+ *
+ *     visit statistics are the only data readers write: counters are changed by relaxed atomic
+ *     increments only, so they may be read at any moment, but aren't a consistent snapshot.
+ */
+
+/// @brief atomic load with acquire semantics (pairs with CB_STORE_RELEASE)
+#define CB_LOAD_ACQUIRE(ptr) __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+
+/// @brief atomic store with release semantics
+#define CB_STORE_RELEASE(ptr, value) __atomic_store_n((ptr), (value), __ATOMIC_RELEASE)
+
+/// @brief relaxed atomic counter increment (counters only need to be free of lost updates)
+#define CB_COUNT_RELAXED(ptr) __atomic_fetch_add((ptr), 1, __ATOMIC_RELAXED)
+
+/// @brief relaxed atomic counter load
+#define CB_LOAD_RELAXED(ptr) __atomic_load_n((ptr), __ATOMIC_RELAXED)
+
 /// @brief node structure forward declaration
 typedef struct __CbNode CbNode;
 
+/// @brief leaf path record (immutable after publication)
+typedef struct __CbLeafPath {
+    const CbNode *parent;  ///< leaf parent path is built for (so path may be matched with parent link)
+    size_t        depth;   ///< count of answers
+    uint64_t      bits[1]; ///< answers (see CbPath), bits after depth are zero
+} CbLeafPath;
+
 /// @brief node structure
 struct __CbNode {
     bool    isLeaf;     ///< if true leaf content should be used, interior otherwise
+    uint8_t leafHeight; ///< height of leaf tree subtree rooted in this node (leaf nodes only)
+    bool    isRemoved;  ///< leaf is removed by version switch (it's kept in leaf index to be reused by insertion of same name)
     CbNode *parent;     ///< parent node pointer
 
     union {
         struct {
-            CbNode *left;  ///< left child
-            CbNode *right; ///< right child
+            CbNode           *left;  ///< left child
+            CbNode           *right; ///< right child
+            const CbLeafPath *path;  ///< root-to-leaf path (path cache only)
         } leaf; ///< leaf node contents
 
         struct {
@@ -39,464 +83,4928 @@ struct __CbNode {
         } interior; ///< interior node contents
     };
 
-    char text[1]; ///< node text
+    CbNodeStat *stat;        ///< visit counters (statistics only)
+    uint32_t    hash;        ///< text hash, computed once on allocation
+    uint32_t    lcaPosition; ///< position in LCA index (valid only if index entry at this position refers to node)
+    const char *text;        ///< node text (interned in text pool for interior nodes, so equal questions share it)
+    char        leafText[1]; ///< leaf text storage (leaf names are unique, so they aren't interned)
 }; // struct __CbNode
 
-/// @brief cactusbot implementation structure
-typedef struct __CbImpl {
-    CbNode       *treeRoot;     ///< root of main (quest) tree
-    size_t        treeSize;     ///< count of elements in tree
-    CbNode       *leafTreeRoot; ///< root of leaf tree
-    size_t        leafTreeSize; ///< count of elements in leaf tree
-    CbArena       arena;        ///< arena allocator
-} CbImpl;
+/// @brief open addressing leaf table
+typedef struct __CbLeafTable {
+    size_t  capacity; ///< slot count (power of two)
+    CbNode *slots[1]; ///< slots, NULL for empty ones
+} CbLeafTable;
 
 /**
- * @brief node allocation function
+ * @brief array capacity ensuring function
  * 
- * @param[in,out] arena arena to allocate node in pointer (non-null)
- * @param[in]     text  node text (non-null)
+ * @param[in,out] array       array pointer (non-null)
+ * @param[in,out] capacity    array capacity (non-null)
+ * @param[in]     size        required array size
+ * @param[in]     elementSize array element size
  * 
- * @return allocated node pointer
+ * @return true if array has at least 'size' capacity, false if reallocation failed
  */
-static CbNode * cbAllocNode( CbArena arena, CbStr text ) {
-    assert(arena != NULL);
-
-    const size_t textSize = text.end - text.begin;
-    CbNode *const node = (CbNode *)cbArenaAlloc(arena, sizeof(CbNode) + textSize);
-
-    if (node == NULL)
-        return NULL;
+static bool cbReserve( void **const array, size_t *const capacity, const size_t size, const size_t elementSize ) {
+    if (size <= *capacity)
+        return true;
 
-    memcpy(node->text, text.begin, textSize);
+    const size_t newCapacity = *capacity * 2 > size ? *capacity * 2 : size;
+    void *const newArray = realloc(*array, newCapacity * elementSize);
 
-    return node;
-} // cbAllocNode
+    if (newArray == NULL)
+        return false;
 
-Cb cbCtor( const char *rootEntry ) {
-    CbImpl *impl = NULL;
-    CbArena arena = NULL;
-    CbNode *node = NULL;
+    *array = newArray;
+    *capacity = newCapacity;
+    return true;
+} // cbReserve
 
-    if (false
-        || (arena = cbArenaCtor()) == NULL
-        || (impl = (CbImpl *)cbArenaAlloc(arena, sizeof(CbImpl))) == NULL
-        || (node = cbAllocNode(arena, CB_STR(rootEntry))) == NULL
-    ) {
-        cbArenaDtor(arena);
-        return NULL;
-    }
+/// @brief LCA index block size (in positions, one mask bit per position)
+#define CB_LCA_BLOCK_SIZE ((size_t)64)
 
-    impl->arena = arena;
-    node->isLeaf = true;
+/// @brief LCA index is rebuilt after count / CB_LCA_MISS_RATIO comparisons of nodes it misses
+#define CB_LCA_MISS_RATIO ((size_t)8)
 
-    impl->treeRoot = node;
-    impl->treeSize = 1;
+/// @brief LCA index entry
+typedef struct __CbLcaEntry {
+    const CbNode *node;  ///< node
+    size_t        depth; ///< node depth
+} CbLcaEntry;
 
-    impl->leafTreeRoot = node;
-    impl->leafTreeSize = 1;
+/// @brief lowest common ancestor index (range minimum queries over in-order node depths)
+typedef struct __CbLcaIndex {
+    CbLcaEntry *entries;    ///< nodes in order (correct subtree, node, incorrect subtree)
+    size_t      count;      ///< count of entries
+    uint64_t   *masks;      ///< in-block minimum masks (bit j of masks[i] is set if j-th depth is less than all depths after it up to i-th)
+    size_t     *table;      ///< sparse table of block minimum positions, levelCount rows of blockCount elements
+    size_t      blockCount; ///< count of blocks
+} CbLcaIndex;
 
+/*
+ * LCA index:
+ *     in-order sequence of binary tree nodes places LCA of two nodes between them, and it's
+ *     the only node of minimal depth there, so LCA query is range minimum query over depths.
+ *     range minimum is found in O(1) by in-block masks for range ends and sparse table over
+ *     block minimums for whole blocks between, index takes O(n) memory.
+ */
 
-    return impl;
-} // cbCtor
+/**
+ * @brief LCA index destructor
+ * 
+ * @param[in] index index to destroy (nullable)
+ */
+static void cbLcaIndexDtor( CbLcaIndex *const index ) {
+    if (index == NULL)
+        return;
 
-void cbDtor( Cb self ) {
-    if (self != NULL)
-        cbArenaDtor(self->arena); // self is allocated by self->arena
-} // cbDtor
+    free(index->table);
+    free(index->masks);
+    free(index->entries);
+    free(index);
+} // cbLcaIndexDtor
 
 /**
- * @brief node pointer in leaf tree searching function
+ * @brief minimal depth position of two getting function
  * 
- * @param[in] root leaf tree root (non-null)
- * @param[in] name leaf to insert name, non-null
+ * @param[in] index LCA index (non-null)
+ * @param[in] lhs   first position
+ * @param[in] rhs   second position
  * 
- * @return (non-null) pointer to place to where node with 'name' name should be located.
+ * @return position with lower depth
  */
-CbNode ** cbLeafTreeFind( CbNode **root, const char *name ) {
-    while (*root != NULL) {
-        const int cmp = strcmp(name, (*root)->text);
+static size_t cbLcaIndexMin( const CbLcaIndex *const index, const size_t lhs, const size_t rhs ) {
+    return index->entries[lhs].depth <= index->entries[rhs].depth ? lhs : rhs;
+} // cbLcaIndexMin
 
-        if (cmp > 0)
-            root = &(*root)->leaf.left;
-        else if (cmp < 0)
-            root = &(*root)->leaf.right;
-        else
-            return root;
-    }
-
-    return root;
-} // cbLeafTreeInsert
+/**
+ * @brief in-block minimal depth position getting function
+ * 
+ * @param[in] index LCA index (non-null)
+ * @param[in] begin range begin (inclusive)
+ * @param[in] end   range end (inclusive, in same block with begin, not less than begin)
+ * 
+ * @return position of minimal depth in range
+ */
+static size_t cbLcaIndexBlockMin( const CbLcaIndex *const index, const size_t begin, const size_t end ) {
+    const size_t blockBegin = begin / CB_LCA_BLOCK_SIZE * CB_LCA_BLOCK_SIZE;
 
-CbIter cbIter( Cb const self ) {
-    return (CbIter) {
-        .self = self,
-        .node = &self->treeRoot,
-    };
-} // cbIter
+    // lowest mask bit not before begin is position of minimum
+    return blockBegin + __builtin_ctzll(index->masks[end] & (~(uint64_t)0 << (begin - blockBegin)));
+} // cbLcaIndexBlockMin
 
-const char * cbIterGetText( const CbIter *const iter ) {
-    assert(iter != NULL);
+/**
+ * @brief minimal depth position in range getting function
+ * 
+ * @param[in] index LCA index (non-null)
+ * @param[in] begin range begin (inclusive)
+ * @param[in] end   range end (inclusive, not less than begin)
+ * 
+ * @return position of minimal depth in range
+ */
+static size_t cbLcaIndexQuery( const CbLcaIndex *const index, const size_t begin, const size_t end ) {
+    const size_t beginBlock = begin / CB_LCA_BLOCK_SIZE;
+    const size_t endBlock = end / CB_LCA_BLOCK_SIZE;
 
-    return (*iter->node)->text;
-} // cbIterGetText
+    if (beginBlock == endBlock)
+        return cbLcaIndexBlockMin(index, begin, end);
 
-void cbIterNext( CbIter *const entry, const bool isCorrect ) {
-    assert(entry != NULL);
+    size_t result = cbLcaIndexMin(index,
+        cbLcaIndexBlockMin(index, begin, (beginBlock + 1) * CB_LCA_BLOCK_SIZE - 1),
+        cbLcaIndexBlockMin(index, endBlock * CB_LCA_BLOCK_SIZE, end)
+    );
 
-    if ((*entry->node)->isLeaf)
-        return;
+    if (endBlock - beginBlock > 1) {
+        // two overlapping power-of-two block ranges cover blocks between
+        const size_t level = 63 - __builtin_clzll(endBlock - beginBlock - 1);
+        const size_t *const row = index->table + level * index->blockCount;
 
-    if (isCorrect)
-        entry->node = &(*entry->node)->interior.correct;
-    else
-        entry->node = &(*entry->node)->interior.incorrect;
-} // cbIterNext
+        result = cbLcaIndexMin(index, result, cbLcaIndexMin(index,
+            row[beginBlock + 1],
+            row[endBlock - ((size_t)1 << level)]
+        ));
+    }
 
-bool cbIterFinished( const CbIter *entry ) {
-    return (*entry->node)->isLeaf;
-} // cbIterFinished
+    return result;
+} // cbLcaIndexQuery
 
-bool cbIterInsertCorrect( CbIter *entry, const char *condition, const char *correct ) {
-    if (!(*entry->node)->isLeaf)
-        return false;
-    
-    CbNode **leafTreeDst = cbLeafTreeFind(&entry->self->leafTreeRoot, correct);
+/// @brief LCA index building stack element
+typedef struct __CbLcaStackElement {
+    const CbNode *node;       ///< node
+    size_t        depth;      ///< node depth
+    bool          isExpanded; ///< true if node children are already pushed
+} CbLcaStackElement;
 
-    if (*leafTreeDst != NULL) // leaf is already added
-        return false;
+/**
+ * @brief tree nodes in order collecting function
+ * 
+ * @param[in,out] index index to collect entries to (non-null, empty)
+ * @param[in]     root  tree root (non-null)
+ * 
+ * @return true if succeeded, false if allocation failed
+ * 
+ * @note tree is traversed by child links only, so it may be changed concurrently
+ * (entries correspond to some state of tree then).
+ */
+static bool cbLcaIndexCollect( CbLcaIndex *const index, const CbNode *const root ) {
+    CbLcaStackElement *stack = NULL;
+    size_t stackCapacity = 0;
+    size_t stackSize = 0;
+    size_t entryCapacity = 0;
 
-    CbNode *conditionNode = cbAllocNode(entry->self->arena, CB_STR(condition));
-    CbNode *correctNode = cbAllocNode(entry->self->arena, CB_STR(correct));
+    bool ok = cbReserve((void **)&stack, &stackCapacity, 1, sizeof(CbLcaStackElement));
 
-    if (conditionNode == NULL || correctNode == NULL)
-        return false;
+    if (ok)
+        stack[stackSize++] = (CbLcaStackElement) { root, 0, false };
 
-    conditionNode->parent = (*entry->node)->parent;
-    (*entry->node)->parent = conditionNode;
+    while (ok && stackSize > 0) {
+        const CbLcaStackElement element = stack[--stackSize];
+        const CbNode *const node = element.node;
 
-    conditionNode->interior.correct = correctNode;
-    conditionNode->interior.incorrect = *entry->node;
+        if (node->isLeaf || element.isExpanded) {
+            // positions are stored in nodes as 32-bit numbers
+            if (index->count >= UINT32_MAX || !cbReserve((void **)&index->entries, &entryCapacity, index->count + 1, sizeof(CbLcaEntry))) {
+                ok = false;
+                break;
+            }
 
-    correctNode->isLeaf = true;
-    correctNode->parent = conditionNode;
+            index->entries[index->count++] = (CbLcaEntry) { node, element.depth };
+            continue;
+        }
 
-    *entry->node = conditionNode;
+        if (!cbReserve((void **)&stack, &stackCapacity, stackSize + 3, sizeof(CbLcaStackElement))) {
+            ok = false;
+            break;
+        }
 
-    *leafTreeDst = correctNode;
+        // correct subtree goes first
+        stack[stackSize++] = (CbLcaStackElement) { CB_LOAD_ACQUIRE(&node->interior.incorrect), element.depth + 1, false };
+        stack[stackSize++] = (CbLcaStackElement) { node, element.depth, true };
+        stack[stackSize++] = (CbLcaStackElement) { CB_LOAD_ACQUIRE(&node->interior.correct), element.depth + 1, false };
+    }
 
-    entry->self->treeSize += 2;
+    free(stack);
 
-    return true;
-} // cbIterInsertCorrect
+    return ok;
+} // cbLcaIndexCollect
 
 /**
- * @brief node dumping funciton
+ * @brief LCA index constructor
+ * 
+ * @param[in] root tree root (non-null)
  * 
- * @param[out] out   output file
- * @param[in]  node  node to dump pointer
- * @param[in]  depth current node depth
+ * @return built index, NULL if allocation failed
+ * 
+ * @note each indexed node gets its position (CbNode::lcaPosition).
  */
-static void cbDumpNode( FILE *out, const CbNode *node, const size_t depth ) {
-    for (size_t i = 0; i < depth * 4; i++)
-        fputc(' ', out);
+static CbLcaIndex * cbLcaIndexCtor( const CbNode *const root ) {
+    CbLcaIndex *const index = (CbLcaIndex *)calloc(1, sizeof(CbLcaIndex));
 
-    if (node->isLeaf) {
-        fprintf(out, "\"%s\"\n", node->text);
-    } else {
-        fprintf(out, "(\"%s\"\n", node->text);
-        cbDumpNode(out, node->interior.correct,   depth + 1);
-        cbDumpNode(out, node->interior.incorrect, depth + 1);
+    if (index == NULL)
+        return NULL;
 
-        for (size_t i = 0; i < depth * 4; i++)
-            fputc(' ', out);
-        fputs(")\n", out);
+    if (!cbLcaIndexCollect(index, root)) {
+        cbLcaIndexDtor(index);
+        return NULL;
     }
-} // cbDump
-
-void cbDump( FILE *out, const Cb self ) {
-    cbDumpNode(out, self->treeRoot, 0);
-} // cbDump
 
-/// @brief token type enumeration
-typedef enum __CbTokenType {
-    CB_TOKEN_LEFT_BRACKET,  ///< (
-    CB_TOKEN_RIGHT_BRACKET, ///< )
-    CB_TOKEN_STRING,        ///< "<smth>"
-} CbTokenType;
+    const size_t count = index->count;
+    const size_t blockCount = (count + CB_LCA_BLOCK_SIZE - 1) / CB_LCA_BLOCK_SIZE;
+    const size_t levelCount = 64 - __builtin_clzll(blockCount);
 
-/// @brief token contents
-typedef struct __CbToken {
-    CbTokenType type;   ///< token type
-    CbStr       string; ///< string (if token type is CB_TOKEN_STRING). actually, this structure is tagged union.
-} CbToken;
+    index->blockCount = blockCount;
 
-/**
- * @brief checking for character is space function
- * 
- * @param[in] ch character to check
- * 
- * @return true if character is space, false if not.
- */
-static bool cbIsSpace( const char ch ) {
-    return false
-        || ch == ' '
-        || ch == '\r'
-        || ch == '\n'
-        || ch == '\t'
-    ;
-} // cbIsSpace
+    if (false
+        || (index->masks = (uint64_t *)calloc(count, sizeof(uint64_t))) == NULL
+        || (index->table = (size_t *)calloc(levelCount * blockCount, sizeof(size_t))) == NULL
+    ) {
+        cbLcaIndexDtor(index);
+        return NULL;
+    }
 
-/**
- * @brief next token parsing function
- * 
- * @param[in,out] str token string
- * @param[out]    dst parsing destination
- */
-static bool cbNextToken( CbStr *const str, CbToken *const dst ) {
-    while (str->begin < str->end && cbIsSpace(*str->begin))
-        str->begin++;
+    for (size_t block = 0; block < blockCount; block++) {
+        const size_t blockBegin = block * CB_LCA_BLOCK_SIZE;
+        const size_t blockEnd = blockBegin + CB_LCA_BLOCK_SIZE < count ? blockBegin + CB_LCA_BLOCK_SIZE : count;
+        uint64_t mask = 0;
 
-    if (str->begin >= str->end)
-        return false;
+        // mask is stack of positions with increasing depths
+        for (size_t i = blockBegin; i < blockEnd; i++) {
+            while (mask != 0) {
+                const size_t top = blockBegin + 63 - __builtin_clzll(mask);
 
-    switch (*str->begin) {
-    case '(': {
-        str->begin++;
-        dst->type = CB_TOKEN_LEFT_BRACKET;
-        return true;
-    }
+                if (index->entries[top].depth < index->entries[i].depth)
+                    break;
+                mask &= ~((uint64_t)1 << (top - blockBegin));
+            }
 
-    case ')': {
-        str->begin++;
-        dst->type = CB_TOKEN_RIGHT_BRACKET;
-        return true;
-    }
+            mask |= (uint64_t)1 << (i - blockBegin);
+            index->masks[i] = mask;
 
-    case '\"': {
-        str->begin++;
+            ((CbNode *)index->entries[i].node)->lcaPosition = (uint32_t)i;
+        }
 
-        const char *strBegin = str->begin;
-        while (str->begin < str->end && *str->begin != '\"')
-            str->begin++;
+        index->table[block] = cbLcaIndexBlockMin(index, blockBegin, blockEnd - 1);
+    }
 
-        dst->string = (CbStr) {strBegin, str->begin};
-        str->begin++;
-        dst->type = CB_TOKEN_STRING;
+    for (size_t level = 1; level < levelCount; level++) {
+        const size_t *const previous = index->table + (level - 1) * blockCount;
+        size_t *const row = index->table + level * blockCount;
+        const size_t half = (size_t)1 << (level - 1);
 
-        return true;
+        for (size_t block = 0; block + 2 * half <= blockCount; block++)
+            row[block] = cbLcaIndexMin(index, previous[block], previous[block + half]);
     }
 
-    default:
-        return false; // error?
-    }
-} // cbNextToken
+    return index;
+} // cbLcaIndexCtor
 
 /**
- * @brief node parsing function
+ * @brief node position in LCA index getting function
+ * 
+ * @param[in]  index    LCA index (non-null)
+ * @param[in]  node     node (non-null)
+ * @param[out] position node position destination (non-null)
+ * 
+ * @return true if node is indexed, false if it's inserted after index is built
  */
-size_t cbParseNode( CbStr *const rest, CbArena arena, CbNode **dst, CbNode **leafTreeRoot, size_t *leafTreeSize ) {
-    CbToken token = {};
-
-    if (!cbNextToken(rest, &token))
-        return 0;
+static bool cbLcaIndexFind( const CbLcaIndex *const index, const CbNode *const node, size_t *const position ) {
+    *position = node->lcaPosition;
 
-    switch (token.type) {
-    case CB_TOKEN_LEFT_BRACKET: {
-        CbToken identToken = {};
-        CbToken rightBracketToken = {};
-        CbNode *correct = NULL;
-        CbNode *incorrect = NULL;
-        size_t correctCount = 0;
-        size_t incorrectCount = 0;
-        CbNode *node = NULL;
+    return *position < index->count && index->entries[*position].node == node;
+} // cbLcaIndexFind
 
-        if (false
-            || !cbNextToken(rest, &identToken)
-            || identToken.type != CB_TOKEN_STRING
-            || (correctCount   = cbParseNode(rest, arena, &correct  , leafTreeRoot, leafTreeSize))  == 0
-            || (incorrectCount = cbParseNode(rest, arena, &incorrect, leafTreeRoot, leafTreeSize))  == 0
-            || (node           = cbAllocNode(arena, identToken.string)) == NULL
-            || !cbNextToken(rest, &rightBracketToken)
-            || rightBracketToken.type != CB_TOKEN_RIGHT_BRACKET
-        ) {
-            return 0;
-        }
+/// @brief tree version (immutable after publication, kept in arena until cbReset/cbDtor)
+typedef struct __CbVersionImpl {
+    const struct __CbVersionImpl *prev;     ///< version this one is derived from (NULL for first one)
+    const struct __CbVersionImpl *older;    ///< version created right before this one (NULL for first one)
+    CbNode                       *root;     ///< version tree root
+    CbNode                       *leaf;     ///< leaf added by version (NULL if version is created by cbOptimize or is first one)
+    size_t                        number;   ///< version number (order of creation)
+    size_t                        treeSize; ///< count of elements in version tree
+} CbVersionImpl;
 
-        correct->parent = node;
-        incorrect->parent = node;
+/// @brief cactusbot implementation structure
+typedef struct __CbImpl {
+    CbNode           *treeRoot;          ///< root of main (quest) tree
+    size_t            treeSize;          ///< count of elements in tree
+    CbLeafIndex       leafIndex;         ///< leaf index kind
+    CbNode           *leafTreeRoot;      ///< root of leaf tree (CB_LEAF_INDEX_TREE only)
+    CbLeafTable      *leafTable;         ///< leaf table (CB_LEAF_INDEX_HASH only)
+    size_t            leafTableMemory;   ///< memory taken by current and replaced leaf tables
+    size_t            leafTreeSize;      ///< count of elements in leaf index
+    size_t            leafIndexSequence; ///< leaf index sequence lock counter, odd while index is changed
+    bool              isPathCached;      ///< true if leaves keep root-to-leaf paths
+    CbLcaIndex       *lcaIndex;          ///< LCA index (nullable, built by first cbCompare that needs it)
+    pthread_rwlock_t  lcaLock;           ///< LCA index lock
+    size_t            lcaMissCount;      ///< count of comparisons of nodes missing in LCA index since its building
+    bool              isStatEnabled;     ///< true if nodes have visit counters
+    CbSessionStat     sessionStat;       ///< session statistics (statistics only)
+    CbInsertHook      insertHook;        ///< insertion hook (nullable)
+    void             *insertHookContext; ///< insertion hook context
+    CbVersion         version;           ///< current version (NULL if cb keeps no versions)
+    CbVersion         lastVersion;       ///< most recently created version (NULL if cb keeps no versions)
+    CbStrPool         textPool;          ///< interior node text pool
+    CbArena           arena;             ///< arena allocator
+    CbArenaMark       treeMark;          ///< arena state right after implementation allocation (tree is allocated after)
+} CbImpl;
 
-        node->interior.correct   = correct;
-        node->interior.incorrect = incorrect;
+/**
+ * @brief string hash computation function (32-bit FNV-1a)
+ * 
+ * @param[in] str string to hash
+ * 
+ * @return string hash
+ */
+static uint32_t cbHashStr( CbStr str ) {
+    uint32_t hash = 0x811C9DC5;
 
-        *dst = node;
+    for (const char *ch = str.begin; ch < str.end; ch++)
+        hash = (hash ^ (uint8_t)*ch) * 0x01000193;
 
-        return correctCount + incorrectCount + 1;
-    }
+    return hash;
+} // cbHashStr
 
-    case CB_TOKEN_RIGHT_BRACKET: {
-        return 0;
-    }
+/**
+ * @brief leaf node allocation function
+ * 
+ * @param[in,out] arena arena to allocate node in pointer (non-null)
+ * @param[in]     text  node text (non-null)
+ * 
+ * @return allocated node pointer
+ */
+static CbNode * cbAllocNode( CbArena arena, CbStr text ) {
+    assert(arena != NULL);
 
-    case CB_TOKEN_STRING: {
-        CbNode *node = NULL;
-        CbNode **leafTreeDst = NULL;
+    const size_t textSize = text.end - text.begin;
+    CbNode *const node = (CbNode *)cbArenaAlloc(arena, sizeof(CbNode) + textSize);
 
-        if (false
-            || (node = (CbNode *)cbAllocNode(arena, token.string)) == NULL
-            || *(leafTreeDst = cbLeafTreeFind(leafTreeRoot, node->text)) != NULL
-        )
-            return 0;
+    if (node == NULL)
+        return NULL;
 
-        node->isLeaf = true;
-        (*leafTreeSize)++;
+    memcpy(node->leafText, text.begin, textSize);
+    node->text = node->leafText;
+    node->hash = cbHashStr(text);
 
-        *dst = node;
-        *leafTreeDst = node;
+    return node;
+} // cbAllocNode
 
-        return 1;
-    }
-    }
+/**
+ * @brief interior node with interned text allocation function
+ * 
+ * @param[in,out] arena arena to allocate node in pointer (non-null)
+ * @param[in,out] pool  pool to intern text in (non-null)
+ * @param[in]     text  node text (non-null)
+ * 
+ * @return allocated node pointer, NULL if allocation failed
+ * 
+ * @note pool has its own arena, so interned text outlives rollback of node arena.
+ */
+static CbNode * cbAllocQuestionNode( CbArena arena, CbStrPool pool, CbStr text ) {
+    assert(arena != NULL);
+    assert(pool != NULL);
 
-    return 0;
-} // cbParseNode
+    CbPoolStr str;
 
-bool cbParse( const char *const str, Cb *const dst ) {
-    CbStr text = CB_STR(str);
+    if (!cbStrPoolIntern(pool, text.begin, text.end - text.begin, &str))
+        return NULL;
 
-    CbArena arena = NULL;
+    CbNode *const node = (CbNode *)cbArenaAlloc(arena, sizeof(CbNode));
 
-    CbNode * treeRoot = NULL;
-    size_t   treeSize = 0;
+    if (node == NULL)
+        return NULL;
 
-    CbNode * leafTreeRoot = NULL;
-    size_t   leafTreeSize = 0;
+    node->text = str.text;
+    node->hash = str.hash;
 
-    CbImpl *impl = NULL;
+    return node;
+} // cbAllocQuestionNode
 
-    if (false
-        || (arena = cbArenaCtor()) == NULL
-        || (treeSize = cbParseNode(&text, arena, &treeRoot, &leafTreeRoot, &leafTreeSize)) == 0
-        || (impl = (CbImpl *)cbArenaAlloc(arena, sizeof(CbImpl))) == NULL
-    ) {
-        cbArenaDtor(arena);
-        return false;
-    }
+/**
+ * @brief leaf path allocation function
+ * 
+ * @param[in,out] arena  arena to allocate path in (non-null)
+ * @param[in]     parent leaf parent (nullable)
+ * @param[in]     depth  path depth
+ * 
+ * @return allocated path with all answers set to incorrect, NULL if allocation failed
+ */
+static CbLeafPath * cbAllocLeafPath( CbArena arena, const CbNode *const parent, const size_t depth ) {
+    const size_t wordCount = depth / 64 + 1;
+    CbLeafPath *const path = (CbLeafPath *)cbArenaAlloc(arena, offsetof(CbLeafPath, bits) + wordCount * sizeof(uint64_t));
 
-    impl->arena = arena;
+    if (path == NULL)
+        return NULL;
 
-    impl->leafTreeRoot = leafTreeRoot;
-    impl->leafTreeSize = leafTreeSize;
+    path->parent = parent;
+    path->depth = depth;
 
-    impl->treeRoot = treeRoot;
-    impl->treeSize = treeSize;
+    return path;
+} // cbAllocLeafPath
 
-    *dst = impl;
+/**
+ * @brief leaf path answers copying function
+ * 
+ * @param[in,out] path  path to copy answers to (non-null, with depth not less than count)
+ * @param[in]     bits  answers to copy (nullable if count is 0)
+ * @param[in]     count count of answers to copy
+ */
+static void cbLeafPathCopy( CbLeafPath *const path, const uint64_t *const bits, const size_t count ) {
+    // root leaf has no answers, so there may be no bits at all
+    if (count >= 64)
+        memcpy(path->bits, bits, count / 64 * sizeof(uint64_t));
 
-    return true;
-} // cbParse
+    // bits after count must stay zero
+    if (count % 64 != 0)
+        path->bits[count / 64] = bits[count / 64] & (((uint64_t)1 << (count % 64)) - 1);
+} // cbLeafPathCopy
 
-void cbDbgDumpNodeDot( FILE *out, const CbNode *node ) {
-    fprintf(out, "    node%016zX [label = \"{<location>location: 0x%016zX|<text>text: \\\"%s\\\"|<isLeaf> isLeaf: %s}\"];\n",
-        (size_t)node,
-        (size_t)node,
-        node->text,
-        node->isLeaf
-            ? "true"
-            : "false"
-    );
+/**
+ * @brief leaf path by one answer extending function
+ * 
+ * @param[in,out] arena  arena to allocate path in (non-null)
+ * @param[in]     path   path to extend (non-null)
+ * @param[in]     parent new path leaf parent (non-null)
+ * @param[in]     answer answer to append
+ * 
+ * @return extended path, NULL if allocation failed
+ */
+static CbLeafPath * cbLeafPathExtend( CbArena arena, const CbLeafPath *const path, const CbNode *const parent, const bool answer ) {
+    CbLeafPath *const extended = cbAllocLeafPath(arena, parent, path->depth + 1);
 
-    if (!node->isLeaf) {
-        cbDbgDumpNodeDot(out, node->interior.correct);
-        cbDbgDumpNodeDot(out, node->interior.incorrect);
+    if (extended == NULL)
+        return NULL;
 
-        fprintf(out, "    node%016zX -> node%016zX [label = \"T\"];\n", (size_t)node, (size_t)node->interior.correct);
-        fprintf(out, "    node%016zX -> node%016zX [label = \"F\"];\n", (size_t)node, (size_t)node->interior.incorrect);
-    }
+    cbLeafPathCopy(extended, path->bits, path->depth);
+    extended->bits[path->depth / 64] |= (uint64_t)answer << (path->depth % 64);
 
-    fprintf(out, "    node%016zX -> node%016zX [color = \"#00FF00\"]\n", (size_t)node, (size_t)node->parent);
-} // cbDbgDumpNodeDot
+    return extended;
+} // cbLeafPathExtend
 
-void cbDbgDumpDot( FILE *out, const Cb self ) {
-    fprintf(out, "digraph {\n");
-    fprintf(out, "    node [shape = record];\n");
-    fprintf(out, "    nodeStat [label = \"{<treeSize>tree size: %zu|<leafTreeSize>leaf tree size: %zu}\"];\n", self->treeSize, self->leafTreeSize);
-    cbDbgDumpNodeDot(out, self->treeRoot);
-    fprintf(out, "}");
-} // cbDbgDumpDot
+/// @brief leaf tree height limit (AVL tree of any addressable size is lower)
+#define CB_LEAF_TREE_STACK_SIZE ((size_t)128)
 
 /**
- * @brief leaf tree node dumping in dot format function
+ * @brief leaf in leaf tree searching function
+ * 
+ * @param[in] root leaf tree root (nullable)
+ * @param[in] name leaf to find name (non-null)
  * 
- * @param[in,out] out    output file
- * @param[in]     node   node to dump
- * @param[in,out] nodeId last node identifier
+ * @return leaf with 'name' name, NULL if there is no such leaf.
+ * 
+ * @note search takes CB_LEAF_TREE_STACK_SIZE steps at most, so it terminates even
+ * on tree which is being changed concurrently (result must be validated by caller then).
  */
-static void cbDbgLeafTreeNodeDumpDot( FILE *const out, const CbNode *const node ) {
-    assert(node != NULL);
-    assert(node->isLeaf);
-
-    fprintf(out, "    node%016zX [label = \"{<location>location: %016zX|<text>text: \\\"%s\\\"}\"];\n", (size_t)node, (size_t)node, node->text);
+static CbNode * cbLeafTreeFind( CbNode *root, const char *name ) {
+    for (size_t step = 0; root != NULL && step < CB_LEAF_TREE_STACK_SIZE; step++) {
+        const int cmp = strcmp(name, root->text);
 
-    if (node->leaf.left != NULL) {
-        cbDbgLeafTreeNodeDumpDot(out, node->leaf.left);
-        fprintf(out, "    node%016zX -> node%016zX [label = \"L\"];\n", (size_t)node->leaf.left, (size_t)node);
+        if (cmp < 0)
+            root = CB_LOAD_ACQUIRE(&root->leaf.left);
+        else if (cmp > 0)
+            root = CB_LOAD_ACQUIRE(&root->leaf.right);
+        else
+            return root;
     }
 
-    if (node->leaf.right != NULL) {
-        cbDbgLeafTreeNodeDumpDot(out, node->leaf.right);
-        fprintf(out, "    node%016zX -> node%016zX [label = \"R\"];\n", (size_t)node->leaf.right, (size_t)node);
-    }
-} // cbDbgLeafTreeNodeDumpDot
+    return NULL;
+} // cbLeafTreeFind
 
-void cbDbgLeafTreeDumpDot( FILE *out, const Cb self ) {
+/**
+ * @brief leaf tree subtree height getting function
+ * 
+ * @param[in] node subtree root (nullable)
+ * 
+ * @return subtree height, 0 for empty subtree
+ */
+static int cbLeafTreeHeight( const CbNode *const node ) {
+    return node == NULL ? 0 : node->leafHeight;
+} // cbLeafTreeHeight
+
+/**
+ * @brief leaf tree node height recalculation function
+ * 
+ * @param[in,out] node node to update height of (non-null)
+ */
+static void cbLeafTreeUpdateHeight( CbNode *const node ) {
+    const int leftHeight = cbLeafTreeHeight(node->leaf.left);
+    const int rightHeight = cbLeafTreeHeight(node->leaf.right);
+
+    node->leafHeight = (uint8_t)(1 + (leftHeight > rightHeight ? leftHeight : rightHeight));
+} // cbLeafTreeUpdateHeight
+
+/**
+ * @brief leaf tree subtree right rotation function
+ * 
+ * @param[in,out] node subtree root (non-null, with non-null left child)
+ * 
+ * @return new subtree root
+ */
+static CbNode * cbLeafTreeRotateRight( CbNode *const node ) {
+    CbNode *const left = node->leaf.left;
+
+    CB_STORE_RELEASE(&node->leaf.left, left->leaf.right);
+    CB_STORE_RELEASE(&left->leaf.right, node);
+
+    cbLeafTreeUpdateHeight(node);
+    cbLeafTreeUpdateHeight(left);
+
+    return left;
+} // cbLeafTreeRotateRight
+
+/**
+ * @brief leaf tree subtree left rotation function
+ * 
+ * @param[in,out] node subtree root (non-null, with non-null right child)
+ * 
+ * @return new subtree root
+ */
+static CbNode * cbLeafTreeRotateLeft( CbNode *const node ) {
+    CbNode *const right = node->leaf.right;
+
+    CB_STORE_RELEASE(&node->leaf.right, right->leaf.left);
+    CB_STORE_RELEASE(&right->leaf.left, node);
+
+    cbLeafTreeUpdateHeight(node);
+    cbLeafTreeUpdateHeight(right);
+
+    return right;
+} // cbLeafTreeRotateLeft
+
+/**
+ * @brief leaf tree subtree AVL balance restoring function
+ * 
+ * @param[in,out] node subtree root (non-null, children heights differ by 2 at most)
+ * 
+ * @return new subtree root
+ */
+static CbNode * cbLeafTreeBalance( CbNode *const node ) {
+    cbLeafTreeUpdateHeight(node);
+
+    const int balance = cbLeafTreeHeight(node->leaf.left) - cbLeafTreeHeight(node->leaf.right);
+
+    if (balance > 1) {
+        if (cbLeafTreeHeight(node->leaf.left->leaf.left) < cbLeafTreeHeight(node->leaf.left->leaf.right))
+            CB_STORE_RELEASE(&node->leaf.left, cbLeafTreeRotateLeft(node->leaf.left));
+        return cbLeafTreeRotateRight(node);
+    }
+
+    if (balance < -1) {
+        if (cbLeafTreeHeight(node->leaf.right->leaf.right) < cbLeafTreeHeight(node->leaf.right->leaf.left))
+            CB_STORE_RELEASE(&node->leaf.right, cbLeafTreeRotateRight(node->leaf.right));
+        return cbLeafTreeRotateLeft(node);
+    }
+
+    return node;
+} // cbLeafTreeBalance
+
+/**
+ * @brief leaf into leaf tree inserting function
+ * 
+ * @param[in]     root leaf tree root (nullable)
+ * @param[in,out] leaf leaf to insert (non-null, there must be no leaf with same text in tree)
+ * 
+ * @return new leaf tree root
+ * 
+ * @note tree is AVL-balanced, so recursion depth is O(log n).
+ */
+static CbNode * cbLeafTreeInsert( CbNode *const root, CbNode *const leaf ) {
+    if (root == NULL) {
+        leaf->leaf.left = NULL;
+        leaf->leaf.right = NULL;
+        leaf->leafHeight = 1;
+        return leaf;
+    }
+
+    if (strcmp(leaf->text, root->text) < 0)
+        CB_STORE_RELEASE(&root->leaf.left, cbLeafTreeInsert(root->leaf.left, leaf));
+    else
+        CB_STORE_RELEASE(&root->leaf.right, cbLeafTreeInsert(root->leaf.right, leaf));
+
+    return cbLeafTreeBalance(root);
+} // cbLeafTreeInsert
+
+/// @brief minimal leaf table capacity
+#define CB_LEAF_TABLE_MIN_CAPACITY ((size_t)16)
+
+/**
+ * @brief leaf table slot searching function
+ * 
+ * @param[in] table leaf table (non-null)
+ * @param[in] name  leaf name (non-null)
+ * @param[in] hash  leaf name hash
+ * 
+ * @return pointer to slot containing leaf with 'name' name or to empty slot it should be inserted in,
+ * NULL if there is no such slot (may occur only in table which is being changed concurrently).
+ */
+static CbNode ** cbLeafTableFind( CbLeafTable *const table, const char *name, const uint32_t hash ) {
+    const size_t mask = table->capacity - 1;
+    size_t index = hash & mask;
+
+    // linear probing
+    for (size_t step = 0; step < table->capacity; step++) {
+        const CbNode *const leaf = CB_LOAD_ACQUIRE(&table->slots[index]);
+
+        if (leaf == NULL || (leaf->hash == hash && strcmp(leaf->text, name) == 0))
+            return &table->slots[index];
+        index = (index + 1) & mask;
+    }
+
+    return NULL;
+} // cbLeafTableFind
+
+/**
+ * @brief leaf table capacity growing function
+ * 
+ * @param[in,out] self     cactusbot implementation (non-null, leaf index must be locked for writing)
+ * @param[in]     capacity new capacity (power of two, greater than leaf count)
+ * 
+ * @return true if succeeded, false if allocation failed
+ * 
+ * @note old table isn't freed, because concurrent readers may still use it.
+ * It's kept in arena until cbReset/cbDtor, and all tables take 2x of the last one memory at most.
+ */
+static bool cbLeafTableResize( CbImpl *const self, const size_t capacity ) {
+    const size_t size = offsetof(CbLeafTable, slots) + capacity * sizeof(CbNode *);
+    CbLeafTable *const table = (CbLeafTable *)cbArenaAlloc(self->arena, size);
+
+    if (table == NULL)
+        return false;
+
+    table->capacity = capacity;
+
+    if (self->leafTable != NULL)
+        for (size_t i = 0; i < self->leafTable->capacity; i++) {
+            CbNode *const leaf = self->leafTable->slots[i];
+
+            if (leaf != NULL)
+                *cbLeafTableFind(table, leaf->text, leaf->hash) = leaf;
+        }
+
+    // table is published only after it's completely filled
+    CB_STORE_RELEASE(&self->leafTable, table);
+    self->leafTableMemory += size;
+
+    return true;
+} // cbLeafTableResize
+
+/**
+ * @brief leaf by name in leaf index searching function (including leaves removed by version switch)
+ * 
+ * @param[in] self cactusbot implementation (non-null)
+ * @param[in] name leaf name (non-null)
+ * @param[in] hash leaf name hash (cbHashStr result)
+ * 
+ * @return leaf with 'name' name, NULL if there is no such leaf.
+ * 
+ * @note function may be called concurrently with leaf index changes.
+ */
+static CbNode * cbLeafIndexLookup( CbImpl *const self, const char *const name, const uint32_t hash ) {
+    for (;;) {
+        const size_t sequence = CB_LOAD_ACQUIRE(&self->leafIndexSequence);
+
+        // writer is changing index
+        if (sequence % 2 != 0)
+            continue;
+
+        CbNode *leaf = NULL;
+
+        if (self->leafIndex == CB_LEAF_INDEX_TREE) {
+            leaf = cbLeafTreeFind(CB_LOAD_ACQUIRE(&self->leafTreeRoot), name);
+        } else {
+            CbLeafTable *const table = CB_LOAD_ACQUIRE(&self->leafTable);
+            CbNode **const slot = table == NULL ? NULL : cbLeafTableFind(table, name, hash);
+
+            if (slot != NULL)
+                leaf = CB_LOAD_ACQUIRE(slot);
+        }
+
+        // result is valid only if index wasn't changed during search
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&self->leafIndexSequence, __ATOMIC_RELAXED) == sequence)
+            return leaf;
+    }
+} // cbLeafIndexLookup
+
+/**
+ * @brief leaf by name in leaf index searching function
+ * 
+ * @param[in] self cactusbot implementation (non-null)
+ * @param[in] name leaf name (non-null)
+ * @param[in] hash leaf name hash (cbHashStr result)
+ * 
+ * @return leaf with 'name' name, NULL if there is no such leaf in current tree.
+ * 
+ * @note function may be called concurrently with leaf index changes.
+ */
+static CbNode * cbLeafIndexFind( CbImpl *const self, const char *const name, const uint32_t hash ) {
+    CbNode *const leaf = cbLeafIndexLookup(self, name, hash);
+
+    return leaf == NULL || CB_LOAD_ACQUIRE(&leaf->isRemoved) ? NULL : leaf;
+} // cbLeafIndexFind
+
+/**
+ * @brief leaf index writing start function
+ * 
+ * @param[in,out] self cactusbot implementation (non-null)
+ */
+static void cbLeafIndexWriteBegin( CbImpl *const self ) {
+    __atomic_store_n(&self->leafIndexSequence, self->leafIndexSequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+} // cbLeafIndexWriteBegin
+
+/**
+ * @brief leaf index writing end function
+ * 
+ * @param[in,out] self cactusbot implementation (non-null)
+ */
+static void cbLeafIndexWriteEnd( CbImpl *const self ) {
+    CB_STORE_RELEASE(&self->leafIndexSequence, self->leafIndexSequence + 1);
+} // cbLeafIndexWriteEnd
+
+/**
+ * @brief leaf index space for one more leaf reserving function
+ * 
+ * @param[in,out] self cactusbot implementation (non-null)
+ * 
+ * @return true if next cbLeafIndexInsert call won't need allocation, false if allocation failed
+ */
+static bool cbLeafIndexReserve( CbImpl *const self ) {
+    if (self->leafIndex == CB_LEAF_INDEX_TREE)
+        return true;
+
+    const size_t capacity = self->leafTable == NULL ? 0 : self->leafTable->capacity;
+
+    // keep load factor below 1/2
+    if ((self->leafTreeSize + 1) * 2 <= capacity)
+        return true;
+
+    cbLeafIndexWriteBegin(self);
+    const bool resized = cbLeafTableResize(self, capacity == 0 ? CB_LEAF_TABLE_MIN_CAPACITY : capacity * 2);
+    cbLeafIndexWriteEnd(self);
+
+    return resized;
+} // cbLeafIndexReserve
+
+/**
+ * @brief leaf into leaf index inserting function
+ * 
+ * @param[in,out] self cactusbot implementation (non-null, cbLeafIndexReserve must succeed before)
+ * @param[in,out] leaf leaf to insert (non-null, there must be no leaf with same text in index)
+ */
+static void cbLeafIndexInsert( CbImpl *const self, CbNode *const leaf ) {
+    cbLeafIndexWriteBegin(self);
+
+    if (self->leafIndex == CB_LEAF_INDEX_TREE)
+        CB_STORE_RELEASE(&self->leafTreeRoot, cbLeafTreeInsert(self->leafTreeRoot, leaf));
+    else
+        CB_STORE_RELEASE(cbLeafTableFind(self->leafTable, leaf->text, leaf->hash), leaf);
+
+    cbLeafIndexWriteEnd(self);
+
+    self->leafTreeSize++;
+} // cbLeafIndexInsert
+
+size_t cbLeafIndexMemoryUsage( const Cb self ) {
     assert(self != NULL);
 
-    fprintf(out, "digraph {\n");
-    fprintf(out, "    node [shape = record];\n");
-    fprintf(out, "    nodeStat [label = \"{<treeSize>tree size: %zu|<leafTreeSize>leaf tree size: %zu}\"];\n", self->treeSize, self->leafTreeSize);
-    cbDbgLeafTreeNodeDumpDot(out, self->leafTreeRoot);
-    fprintf(out, "}");
-} // cbDbgLeafTreeDumpDot
+    // tree index is intrusive, so only hash tables take extra memory
+    return self->leafTableMemory;
+} // cbLeafIndexMemoryUsage
 
-CbDefineStatus cbDefine( const Cb self, const char *subject, CbDefIter *dst ) {
-    const CbNode *node = *cbLeafTreeFind(&self->leafTreeRoot, subject);
+void cbGetArenaStat( const Cb self, CbArenaStat *const dst ) {
+    assert(self != NULL);
+
+    cbArenaGetStat(self->arena, dst);
+} // cbGetArenaStat
+
+void cbGetTextPoolStat( const Cb self, CbStrPoolStat *const dst ) {
+    assert(self != NULL);
+
+    cbStrPoolGetStat(self->textPool, dst);
+} // cbGetTextPoolStat
+
+/**
+ * @brief tree with single root leaf initialization function
+ * 
+ * @param[in,out] self      cactusbot implementation with empty tree (non-null)
+ * @param[in]     rootEntry root entry name (non-null)
+ * 
+ * @return true if succeeded, false if allocation failed
+ */
+static bool cbInitTree( CbImpl *const self, const char *const rootEntry ) {
+    CbNode *const node = cbAllocNode(self->arena, CB_STR(rootEntry));
 
     if (node == NULL)
-        return CB_DEFINE_STATUS_NO_SUBJECT;
+        return false;
 
-    if (dst != NULL)
-        *dst = (CbDefIter) { .element = node };
+    node->isLeaf = true;
 
-    return node->parent == NULL
-        ? CB_DEFINE_STATUS_NO_DEFINITION
-        : CB_DEFINE_STATUS_OK;
-} // cbDefine
+    if (false
+        || (self->isPathCached && (node->leaf.path = cbAllocLeafPath(self->arena, NULL, 0)) == NULL)
+        || (self->isStatEnabled && (node->stat = (CbNodeStat *)cbArenaAlloc(self->arena, sizeof(CbNodeStat))) == NULL)
+        || !cbLeafIndexReserve(self)
+    )
+        return false;
 
-const char * cbDefIterGetProperty( const CbDefIter *iter ) {
-    assert(iter != NULL);
-    assert(iter->element != NULL);
-    assert(iter->element->parent != NULL);
+    cbLeafIndexInsert(self, node);
 
-    return iter->element->parent->text;
-} // cbDefIterGetProperty
+    self->treeRoot = node;
+    self->treeSize = 1;
 
-bool cbDefIterGetRelation( const CbDefIter *iter ) {
-    assert(iter != NULL);
-    assert(iter->element != NULL);
-    assert(iter->element->parent != NULL);
+    return true;
+} // cbInitTree
 
-    return iter->element->parent->interior.correct == iter->element;
-} // cbDefIterGetRelation
+/**
+ * @brief cactusbot implementation allocation function
+ * 
+ * @param[in] leafIndex leaf index kind
+ * 
+ * @return allocated implementation with empty tree, NULL if allocation failed
+ */
+static CbImpl * cbAllocImpl( const CbLeafIndex leafIndex ) {
+    CbArena arena = NULL;
+    CbImpl *impl = NULL;
 
-bool cbDefIterNext( CbDefIter *iter ) {
+    CbStrPool textPool = NULL;
+
+    if (false
+        || (arena = cbArenaCtor()) == NULL
+        || (impl = (CbImpl *)cbArenaAlloc(arena, sizeof(CbImpl))) == NULL
+        || (textPool = cbStrPoolCtor()) == NULL
+    ) {
+        cbArenaDtor(arena);
+        return NULL;
+    }
+
+    if (pthread_rwlock_init(&impl->lcaLock, NULL) != 0) {
+        cbStrPoolDtor(textPool);
+        cbArenaDtor(arena);
+        return NULL;
+    }
+
+    impl->textPool = textPool;
+
+    impl->arena = arena;
+    impl->leafIndex = leafIndex;
+    impl->treeMark = cbArenaMark(arena);
+
+    return impl;
+} // cbAllocImpl
+
+Cb cbCtor( const char *rootEntry, const CbLeafIndex leafIndex ) {
+    CbImpl *const impl = cbAllocImpl(leafIndex);
+
+    if (impl == NULL)
+        return NULL;
+
+    if (!cbInitTree(impl, rootEntry)) {
+        cbDtor(impl);
+        return NULL;
+    }
+
+    return impl;
+} // cbCtor
+
+void cbDtor( Cb self ) {
+    if (self == NULL)
+        return;
+
+    cbLcaIndexDtor(self->lcaIndex);
+    pthread_rwlock_destroy(&self->lcaLock);
+    cbStrPoolDtor(self->textPool);
+    cbArenaDtor(self->arena); // self is allocated by self->arena
+} // cbDtor
+
+bool cbReset( Cb self, const char *rootEntry ) {
+    assert(self != NULL);
+    assert(rootEntry != NULL);
+
+    cbArenaRollback(self->arena, &self->treeMark);
+    cbStrPoolClear(self->textPool);
+
+    self->treeRoot = NULL;
+    self->treeSize = 0;
+
+    // leaf tables are allocated after tree mark, so they're dropped too
+    self->leafTreeRoot = NULL;
+    self->leafTreeSize = 0;
+    self->leafTable = NULL;
+    self->leafTableMemory = 0;
+
+    cbLcaIndexDtor(self->lcaIndex);
+    self->lcaIndex = NULL;
+
+    memset(&self->sessionStat, 0, sizeof(CbSessionStat));
+
+    // versions are dropped with tree, new tree starts new history
+    const bool isVersioned = self->version != NULL;
+
+    self->version = NULL;
+    self->lastVersion = NULL;
+
+    return cbInitTree(self, rootEntry) && (!isVersioned || cbEnableVersions(self));
+} // cbReset
+
+/**
+ * @brief iterator current node visit counting function
+ * 
+ * @param[in] iter iterator (non-null)
+ */
+static void cbIterVisit( const CbIter *const iter ) {
+    CbNodeStat *const stat = iter->current->stat;
+
+    if (stat == NULL || !iter->isCounted)
+        return;
+
+    CB_COUNT_RELAXED(&stat->visits);
+
+    if (iter->current->isLeaf) {
+        CbSessionStat *const sessionStat = &iter->self->sessionStat;
+
+        CB_COUNT_RELAXED(&sessionStat->count);
+        __atomic_fetch_add(&sessionStat->lengthSum, iter->depth, __ATOMIC_RELAXED);
+        CB_COUNT_RELAXED(&sessionStat->lengths[iter->depth < CB_SESSION_LENGTH_COUNT ? iter->depth : CB_SESSION_LENGTH_COUNT - 1]);
+    }
+} // cbIterVisit
+
+/**
+ * @brief root iterator getting function
+ * 
+ * @param[in] self      cactusbot implementation (non-null)
+ * @param[in] version   version to walk (nullable, NULL means current tree of unversioned cb)
+ * @param[in] isCounted true if iterator should update visit counters
+ * 
+ * @return new iterator
+ */
+static CbIter cbIterStart( Cb const self, const CbVersion version, const bool isCounted ) {
+    // version root is never changed after publication, so slot isn't written through
+    CbNode **const node = version != NULL
+        ? &((CbVersionImpl *)version)->root
+        : &self->treeRoot;
+
+    const CbIter iter = {
+        .self      = self,
+        .node      = node,
+        .current   = CB_LOAD_ACQUIRE(node),
+        .depth     = 0,
+        .version   = version,
+        .isCounted = isCounted,
+    };
+
+    cbIterVisit(&iter);
+
+    return iter;
+} // cbIterStart
+
+CbIter cbIter( Cb const self ) {
+    // version root is loaded with version, so insertion may check that iterator walks current tree
+    return cbIterStart(self, CB_LOAD_ACQUIRE(&self->version), true);
+} // cbIter
+
+CbIter cbIterVersion( Cb const self, CbVersion version ) {
+    assert(self != NULL);
+    assert(version != NULL);
+
+    return cbIterStart(self, version, true);
+} // cbIterVersion
+
+CbIter cbIterTraversal( Cb const self ) {
+    assert(self != NULL);
+
+    return cbIterStart(self, CB_LOAD_ACQUIRE(&self->version), false);
+} // cbIterTraversal
+
+const char * cbIterGetText( const CbIter *const iter ) {
     assert(iter != NULL);
-    assert(iter->element != NULL);
-    assert(iter->element->parent != NULL);
 
-    iter->element = iter->element->parent;
+    return iter->current->text;
+} // cbIterGetText
+
+void cbIterNext( CbIter *const entry, const bool isCorrect ) {
+    assert(entry != NULL);
 
-    return iter->element->parent != NULL;
-} // cbDefIterNext
+    if (entry->current->isLeaf)
+        return;
+
+    CbNodeStat *const stat = entry->current->stat;
+
+    if (stat != NULL && entry->isCounted)
+        CB_COUNT_RELAXED(isCorrect ? &stat->correct : &stat->incorrect);
+
+    if (isCorrect)
+        entry->node = &entry->current->interior.correct;
+    else
+        entry->node = &entry->current->interior.incorrect;
+
+    entry->current = CB_LOAD_ACQUIRE(entry->node);
+    entry->depth++;
+
+    cbIterVisit(entry);
+} // cbIterNext
+
+bool cbIterFinished( const CbIter *entry ) {
+    return entry->current->isLeaf;
+} // cbIterFinished
+
+/**
+ * @brief version allocation function
+ * 
+ * @param[in,out] self cactusbot implementation (non-null)
+ * @param[in]     root version tree root (non-null)
+ * @param[in]     leaf leaf added by version (nullable)
+ * 
+ * @return version derived from current one (to be published by cbVersionPublish), NULL if allocation failed
+ */
+static CbVersionImpl * cbAllocVersion( CbImpl *const self, CbNode *const root, CbNode *const leaf ) {
+    CbVersionImpl *const version = (CbVersionImpl *)cbArenaAlloc(self->arena, sizeof(CbVersionImpl));
+
+    if (version == NULL)
+        return NULL;
+
+    version->prev = self->version;
+    version->older = self->lastVersion;
+    version->root = root;
+    version->leaf = leaf;
+    version->number = self->lastVersion == NULL ? 0 : self->lastVersion->number + 1;
+
+    return version;
+} // cbAllocVersion
+
+/**
+ * @brief version publishing function
+ * 
+ * @param[in,out] self    cactusbot implementation (non-null)
+ * @param[in,out] version version to make current (non-null, parent links must already match its tree)
+ */
+static void cbVersionPublish( CbImpl *const self, CbVersionImpl *const version ) {
+    version->treeSize = self->treeSize;
+    self->lastVersion = version;
+
+    CB_STORE_RELEASE(&self->treeRoot, version->root);
+    CB_STORE_RELEASE(&self->version, version);
+} // cbVersionPublish
+
+/**
+ * @brief root-to-node path copying function
+ * 
+ * @param[in,out] self        cactusbot implementation (non-null)
+ * @param[in]     node        node to replace (non-null, node of current tree)
+ * @param[in,out] replacement node to take node place in copy (non-null, its parent link is set to parent copy)
+ * 
+ * @return root of tree with node replaced, NULL if allocation failed
+ * 
+ * @note only O(depth) nodes are copied, the rest is shared with current tree, whose child links aren't changed
+ * (parent links of shared nodes are switched to copies by cbVersionRelinkPath).
+ */
+static CbNode * cbVersionCopyPath( CbImpl *const self, const CbNode *node, CbNode *const replacement ) {
+    CbNode *child = replacement;
+
+    for (const CbNode *parent = node->parent; parent != NULL; node = parent, parent = parent->parent) {
+        // copies are interior nodes, so leaf text storage isn't allocated
+        CbNode *const copy = (CbNode *)cbArenaAlloc(self->arena, offsetof(CbNode, leafText));
+
+        if (copy == NULL)
+            return NULL;
+
+        copy->interior = parent->interior;
+        copy->stat = parent->stat;
+        copy->hash = parent->hash;
+        copy->text = parent->text;
+
+        if (copy->interior.correct == node)
+            copy->interior.correct = child;
+        else
+            copy->interior.incorrect = child;
+
+        child->parent = copy;
+        child = copy;
+    }
+
+    child->parent = NULL;
+
+    return child;
+} // cbVersionCopyPath
+
+/**
+ * @brief insertion version parent links switching function
+ * 
+ * @param[in] version   version created by insertion (non-null)
+ * @param[in] isApplied true if links should match version tree, false if they should match previous version one
+ * 
+ * @note trees differ only in copied path, so only nodes hanging off it are relinked, it takes O(depth).
+ * links are rewritten while readers run, so caller holds LCA index write lock to exclude cbCompare parent walks.
+ */
+static void cbVersionRelinkPath( const CbVersionImpl *const version, const bool isApplied ) {
+    CbNode *copy = version->root;
+    CbNode *original = version->prev->root;
+    CbNode *originalParent = NULL;
+
+    // copied path goes where children differ
+    while (!original->isLeaf) {
+        const bool isCorrect = copy->interior.correct != original->interior.correct;
+        CbNode *const shared = isCorrect ? copy->interior.incorrect : copy->interior.correct;
+
+        CB_STORE_RELEASE(&shared->parent, isApplied ? copy : original);
+
+        originalParent = original;
+        copy = isCorrect ? copy->interior.correct : copy->interior.incorrect;
+        original = isCorrect ? original->interior.correct : original->interior.incorrect;
+    }
+
+    // original is leaf condition is inserted at, copy is the condition
+    CB_STORE_RELEASE(&original->parent, isApplied ? copy : originalParent);
+    CB_STORE_RELEASE(&version->leaf->parent, copy);
+    CB_STORE_RELEASE(&version->leaf->isRemoved, !isApplied);
+} // cbVersionRelinkPath
+
+bool cbIterInsertCorrect( CbIter *entry, const char *condition, const char *correct ) {
+    CbImpl *const self = entry->self;
+    CbNode *const leaf = entry->current;
+
+    // iterator must point to leaf that isn't replaced since iterator got it (every insertion creates new version)
+    if (!leaf->isLeaf || (self->version == NULL ? *entry->node != leaf : entry->version != self->version))
+        return false;
+
+    // leaf removed by version switch is still in leaf index, so it's reused
+    CbNode *correctNode = cbLeafIndexLookup(self, correct, cbHashStr(CB_STR(correct)));
+
+    if (correctNode != NULL && !correctNode->isRemoved) // leaf is already added
+        return false;
+
+    const bool isReused = correctNode != NULL;
+
+    // failed insertion gives all its memory back
+    const CbArenaMark mark = cbArenaMark(self->arena);
+    CbNode *conditionNode = NULL;
+    const CbLeafPath *correctPath = NULL;
+    const CbLeafPath *incorrectPath = NULL;
+    CbNode *root = NULL;
+    CbVersionImpl *version = NULL;
+
+    if (false
+        || (conditionNode = cbAllocQuestionNode(self->arena, self->textPool, CB_STR(condition))) == NULL
+        || (!isReused && (correctNode = cbAllocNode(self->arena, CB_STR(correct))) == NULL)
+        || (self->isPathCached && (false
+            || (correctPath = cbLeafPathExtend(self->arena, leaf->leaf.path, conditionNode, true)) == NULL
+            || (incorrectPath = cbLeafPathExtend(self->arena, leaf->leaf.path, conditionNode, false)) == NULL
+        ))
+        || (self->isStatEnabled && (false
+            || (conditionNode->stat = (CbNodeStat *)cbArenaAlloc(self->arena, sizeof(CbNodeStat))) == NULL
+            || (correctNode->stat == NULL && (correctNode->stat = (CbNodeStat *)cbArenaAlloc(self->arena, sizeof(CbNodeStat))) == NULL)
+        ))
+        || (self->version != NULL && (false
+            || (root = cbVersionCopyPath(self, leaf, conditionNode)) == NULL
+            || (version = cbAllocVersion(self, root, correctNode)) == NULL
+        ))
+        || (!isReused && !cbLeafIndexReserve(self))
+    ) {
+        cbArenaRollback(self->arena, &mark);
+        return false;
+    }
+
+    // new nodes are completely built before publication
+    correctNode->isLeaf = true;
+    correctNode->parent = conditionNode;
+    correctNode->leaf.path = correctPath;
+
+    conditionNode->interior.correct = correctNode;
+    conditionNode->interior.incorrect = leaf;
+
+    self->treeSize += 2;
+
+    if (version != NULL) {
+        // current tree is left as is, new one is published by single root store, relinking excludes cbCompare parent walks
+        pthread_rwlock_wrlock(&self->lcaLock);
+        cbVersionRelinkPath(version, true);
+        cbVersionPublish(self, version);
+        pthread_rwlock_unlock(&self->lcaLock);
+
+        CbNode *const parent = conditionNode->parent;
+
+        entry->version = version;
+        entry->node = parent == NULL
+            ? &version->root
+            : parent->interior.correct == conditionNode
+                ? &parent->interior.correct
+                : &parent->interior.incorrect;
+    } else {
+        conditionNode->parent = leaf->parent;
+
+        // parent link is updated before child one, so reader that sees new child sees new parent too (see cbDefIterLoad)
+        CB_STORE_RELEASE(&leaf->parent, conditionNode);
+        CB_STORE_RELEASE(entry->node, conditionNode);
+    }
+
+    // path matches parent link only after both are updated (see cbLeafLoadPath)
+    if (self->isPathCached)
+        CB_STORE_RELEASE(&leaf->leaf.path, incorrectPath);
+
+    // new leaf is findable only after it's reachable from root
+    if (!isReused)
+        cbLeafIndexInsert(self, correctNode);
+
+    entry->current = conditionNode;
+
+    if (self->insertHook != NULL)
+        self->insertHook(self->insertHookContext, leaf->text, condition, correct);
+
+    return true;
+} // cbIterInsertCorrect
+
+bool cbIterFindLeaf( Cb self, const char *leaf, CbIter *dst ) {
+    assert(self != NULL);
+    assert(leaf != NULL);
+    assert(dst != NULL);
+
+    // version is loaded first, so newer parent link may only make insertion fail
+    const CbVersion version = CB_LOAD_ACQUIRE(&self->version);
+    CbNode *const node = cbLeafIndexFind(self, leaf, cbHashStr(CB_STR(leaf)));
+
+    if (node == NULL)
+        return false;
+
+    // stale slot (if leaf is replaced concurrently) is detected by cbIterInsertCorrect
+    CbNode *const parent = CB_LOAD_ACQUIRE(&node->parent);
+
+    *dst = (CbIter) {
+        .self    = self,
+        .node    = parent == NULL
+            ? &self->treeRoot
+            : CB_LOAD_ACQUIRE(&parent->interior.correct) == node
+                ? &parent->interior.correct
+                : &parent->interior.incorrect,
+        .current   = node,
+        .depth     = 0,
+        .version   = version,
+        .isCounted = false,
+    };
+
+    return true;
+} // cbIterFindLeaf
+
+void cbSetInsertHook( Cb self, CbInsertHook hook, void *context ) {
+    assert(self != NULL);
+
+    self->insertHook = hook;
+    self->insertHookContext = context;
+} // cbSetInsertHook
+
+CbInsertHook cbGetInsertHook( const Cb self, void **const context ) {
+    assert(self != NULL);
+
+    if (context != NULL)
+        *context = self->insertHookContext;
+
+    return self->insertHook;
+} // cbGetInsertHook
+
+/// @brief count of walks interleaved by cbWalkBatch thread
+#define CB_WALK_GROUP_SIZE ((size_t)32)
+
+/// @brief minimal count of queries worth separate cbWalkBatch thread
+#define CB_WALK_THREAD_MIN_COUNT ((size_t)4096)
+
+/// @brief cbWalkBatch thread task
+typedef struct __CbWalkTask {
+    const CbImpl      *self;      ///< cactusbot implementation
+    const CbWalkQuery *queries;   ///< queries to perform
+    CbWalkResult      *results;   ///< query results
+    size_t             count;     ///< count of queries
+    pthread_t          thread;    ///< thread task is performed by
+    bool               isStarted; ///< true if thread is started
+} CbWalkTask;
+
+/**
+ * @brief walk group performing function
+ * 
+ * @param[in,out] task task to perform (non-null)
+ * 
+ * @note CB_WALK_GROUP_SIZE walks are advanced by one step in turn, and each step prefetches
+ * node it moves to, so node is (hopefully) loaded when its walk gets its turn again.
+ * finished walk slot is immediately taken by next query.
+ */
+static void cbWalkGroup( CbWalkTask *const task ) {
+    const CbNode *nodes[CB_WALK_GROUP_SIZE];
+    size_t queries[CB_WALK_GROUP_SIZE];
+    size_t depths[CB_WALK_GROUP_SIZE];
+    size_t activeCount = 0;
+    size_t nextQuery = 0;
+
+    CbNode *const root = CB_LOAD_ACQUIRE(&task->self->treeRoot);
+
+    while (activeCount < CB_WALK_GROUP_SIZE && nextQuery < task->count) {
+        nodes[activeCount] = root;
+        queries[activeCount] = nextQuery++;
+        depths[activeCount] = 0;
+        activeCount++;
+    }
+
+    while (activeCount > 0) {
+        for (size_t slot = 0; slot < activeCount; ) {
+            const CbNode *const node = nodes[slot];
+            const CbWalkQuery *const query = &task->queries[queries[slot]];
+            const size_t depth = depths[slot];
+
+            if (node->isLeaf || depth >= query->answerCount) {
+                task->results[queries[slot]] = (CbWalkResult) {
+                    .text       = node->text,
+                    .depth      = depth,
+                    .isFinished = node->isLeaf,
+                };
+
+                if (nextQuery < task->count) {
+                    nodes[slot] = root;
+                    queries[slot] = nextQuery++;
+                    depths[slot] = 0;
+                    slot++;
+                } else {
+                    // last active walk takes finished one slot
+                    activeCount--;
+                    nodes[slot] = nodes[activeCount];
+                    queries[slot] = queries[activeCount];
+                    depths[slot] = depths[activeCount];
+                }
+                continue;
+            }
+
+            const bool isCorrect = (query->answers[depth / 8] >> (depth % 8)) & 1;
+            const CbNode *const next = CB_LOAD_ACQUIRE(isCorrect
+                ? &node->interior.correct
+                : &node->interior.incorrect
+            );
+
+            __builtin_prefetch(next);
+
+            nodes[slot] = next;
+            depths[slot] = depth + 1;
+            slot++;
+        }
+    }
+} // cbWalkGroup
+
+/**
+ * @brief cbWalkBatch thread function
+ * 
+ * @param[in,out] context task to perform (CbWalkTask *)
+ * 
+ * @return NULL
+ */
+static void * cbWalkThread( void *context ) {
+    cbWalkGroup((CbWalkTask *)context);
+    return NULL;
+} // cbWalkThread
+
+void cbWalkBatch( const Cb self, const CbWalkQuery *const queries, CbWalkResult *const results, const size_t count, size_t threadCount ) {
+    assert(self != NULL);
+    assert(count == 0 || (queries != NULL && results != NULL));
+
+    if (threadCount > count / CB_WALK_THREAD_MIN_COUNT)
+        threadCount = count / CB_WALK_THREAD_MIN_COUNT;
+
+    CbWalkTask *const tasks = (CbWalkTask *)calloc(threadCount > 1 ? threadCount : 1, sizeof(CbWalkTask));
+
+    // calling thread does everything itself if tasks can't be allocated
+    if (tasks == NULL) {
+        CbWalkTask task = {0};
+
+        task.self = self;
+        task.queries = queries;
+        task.results = results;
+        task.count = count;
+
+        cbWalkGroup(&task);
+        return;
+    }
+
+    if (threadCount < 1)
+        threadCount = 1;
+
+    size_t begin = 0;
+
+    for (size_t i = 0; i < threadCount; i++) {
+        const size_t end = count * (i + 1) / threadCount;
+
+        tasks[i].self = self;
+        tasks[i].queries = queries + begin;
+        tasks[i].results = results + begin;
+        tasks[i].count = end - begin;
+
+        begin = end;
+    }
+
+    // first task is performed by calling thread
+    for (size_t i = 1; i < threadCount; i++)
+        tasks[i].isStarted = pthread_create(&tasks[i].thread, NULL, cbWalkThread, &tasks[i]) == 0;
+
+    // tasks of threads that failed to start are performed by calling thread too
+    for (size_t i = 0; i < threadCount; i++)
+        if (!tasks[i].isStarted)
+            cbWalkGroup(&tasks[i]);
+
+    for (size_t i = 1; i < threadCount; i++)
+        if (tasks[i].isStarted)
+            pthread_join(tasks[i].thread, NULL);
+
+    free(tasks);
+} // cbWalkBatch
+
+/**
+ * @brief next node in preorder getting function
+ * 
+ * @param[in]  node   current node (non-null)
+ * @param[in]  root   traversed subtree root (non-null)
+ * @param[out] closed count of interior nodes whose subtrees are finished by this step (nullable)
+ * 
+ * @return next node, NULL if whole subtree is traversed.
+ * 
+ * @note parent links are used instead of stack, so traversal takes O(1) memory for any tree depth.
+ */
+static const CbNode * cbNodeNextPreorder( const CbNode *node, const CbNode *const root, size_t *const closed ) {
+    size_t closedCount = 0;
+
+    if (!node->isLeaf) {
+        node = node->interior.correct;
+    } else {
+        for (;;) {
+            if (node == root) {
+                node = NULL;
+                break;
+            }
+
+            const CbNode *const parent = node->parent;
+
+            if (parent->interior.correct == node) {
+                node = parent->interior.incorrect;
+                break;
+            }
+
+            node = parent;
+            closedCount++;
+        }
+    }
+
+    if (closed != NULL)
+        *closed = closedCount;
+
+    return node;
+} // cbNodeNextPreorder
+
+bool cbEnablePathCache( Cb self ) {
+    assert(self != NULL);
+
+    if (self->isPathCached)
+        return true;
+
+    // versions share leaves between trees, while path belongs to single tree
+    if (self->version != NULL)
+        return false;
+
+    // answers to current node
+    uint64_t *bits = NULL;
+    size_t wordCapacity = 0;
+    size_t depth = 0;
+
+    // paths are given back if building fails
+    const CbArenaMark mark = cbArenaMark(self->arena);
+    const CbNode *const root = self->treeRoot;
+    const CbNode *node = root;
+
+    while (node != NULL) {
+        if (node->isLeaf) {
+            CbLeafPath *const path = cbAllocLeafPath(self->arena, node->parent, depth);
+
+            if (path == NULL)
+                break;
+
+            cbLeafPathCopy(path, bits, depth);
+            ((CbNode *)node)->leaf.path = path;
+        }
+
+        size_t closed = 0;
+        const CbNode *const next = cbNodeNextPreorder(node, root, &closed);
+
+        if (next != NULL && !node->isLeaf) {
+            // interior node is followed by its correct child
+            if (depth / 64 + 1 > wordCapacity) {
+                const size_t newCapacity = wordCapacity == 0 ? 16 : wordCapacity * 2;
+                uint64_t *const newBits = (uint64_t *)realloc(bits, newCapacity * sizeof(uint64_t));
+
+                if (newBits == NULL)
+                    break;
+
+                bits = newBits;
+                wordCapacity = newCapacity;
+            }
+
+            bits[depth / 64] |= (uint64_t)1 << (depth % 64);
+            depth++;
+        } else if (next != NULL) {
+            // leaf is followed by incorrect child of its 'closed'-th ancestor
+            depth -= closed;
+            bits[(depth - 1) / 64] &= ~((uint64_t)1 << ((depth - 1) % 64));
+        }
+
+        node = next;
+    }
+
+    free(bits);
+
+    if (node != NULL) {
+        for (const CbNode *leaf = root; leaf != NULL; leaf = cbNodeNextPreorder(leaf, root, NULL))
+            if (leaf->isLeaf)
+                ((CbNode *)leaf)->leaf.path = NULL;
+        cbArenaRollback(self->arena, &mark);
+    }
+
+    self->isPathCached = node == NULL;
+
+    return self->isPathCached;
+} // cbEnablePathCache
+
+/**
+ * @brief leaf path and parent consistent loading function
+ * 
+ * @param[in]  leaf   leaf to load path of (non-null, path cache must be enabled)
+ * @param[out] parent leaf parent destination (non-null)
+ * 
+ * @return leaf path
+ * 
+ * @note leaf moved under new condition node concurrently gets new parent before new path,
+ * so path and parent are loaded again until path is built for the parent.
+ */
+static const CbLeafPath * cbLeafLoadPath( const CbNode *const leaf, const CbNode **const parent ) {
+    for (;;) {
+        const CbLeafPath *const path = CB_LOAD_ACQUIRE(&leaf->leaf.path);
+
+        *parent = CB_LOAD_ACQUIRE(&leaf->parent);
+
+        if (path->parent == *parent)
+            return path;
+    }
+} // cbLeafLoadPath
+
+bool cbGetPath( const Cb self, const char *subject, CbPath *dst ) {
+    assert(self != NULL);
+    assert(subject != NULL);
+    assert(dst != NULL);
+
+    if (!self->isPathCached)
+        return false;
+
+    const CbNode *const leaf = cbLeafIndexFind(self, subject, cbHashStr(CB_STR(subject)));
+
+    if (leaf == NULL)
+        return false;
+
+    const CbNode *parent = NULL;
+    const CbLeafPath *const path = cbLeafLoadPath(leaf, &parent);
+
+    dst->depth = path->depth;
+    dst->bits = path->bits;
+
+    return true;
+} // cbGetPath
+
+size_t cbPathCommonLength( const CbPath *lhs, const CbPath *rhs ) {
+    assert(lhs != NULL);
+    assert(rhs != NULL);
+
+    const size_t depth = lhs->depth < rhs->depth ? lhs->depth : rhs->depth;
+
+    for (size_t i = 0; i * 64 < depth; i++) {
+        const uint64_t difference = lhs->bits[i] ^ rhs->bits[i];
+
+        if (difference != 0) {
+            const size_t index = i * 64 + __builtin_ctzll(difference);
+
+            return index < depth ? index : depth;
+        }
+    }
+
+    return depth;
+} // cbPathCommonLength
+
+bool cbEnableVersions( Cb self ) {
+    assert(self != NULL);
+
+    if (self->version != NULL)
+        return true;
+
+    if (self->isPathCached)
+        return false;
+
+    CbVersionImpl *const version = cbAllocVersion(self, self->treeRoot, NULL);
+
+    if (version == NULL)
+        return false;
+
+    cbVersionPublish(self, version);
+
+    return true;
+} // cbEnableVersions
+
+CbVersion cbGetVersion( const Cb self ) {
+    assert(self != NULL);
+
+    return CB_LOAD_ACQUIRE(&self->version);
+} // cbGetVersion
+
+CbVersion cbFindVersion( const Cb self, const size_t number ) {
+    assert(self != NULL);
+
+    CbVersion version = CB_LOAD_ACQUIRE(&self->lastVersion);
+
+    while (version != NULL && version->number > number)
+        version = version->older;
+
+    return version != NULL && version->number == number ? version : NULL;
+} // cbFindVersion
+
+void cbVersionGetInfo( CbVersion version, CbVersionInfo *const dst ) {
+    assert(version != NULL);
+    assert(dst != NULL);
+
+    *dst = (CbVersionInfo) {
+        .number   = version->number,
+        .treeSize = version->treeSize,
+        .leaf     = version->leaf == NULL ? NULL : version->leaf->text,
+        .prev     = version->prev,
+    };
+} // cbVersionGetInfo
+
+/**
+ * @brief all tree parent links setting function
+ * 
+ * @param[in,out] root tree root (non-null)
+ * 
+ * @note links are set top-down, so traversal may go up by links set before.
+ */
+static void cbNodeRelinkTree( CbNode *const root ) {
+    root->parent = NULL;
+
+    for (const CbNode *node = root; node != NULL; node = cbNodeNextPreorder(node, root, NULL)) {
+        if (!node->isLeaf) {
+            node->interior.correct->parent = (CbNode *)node;
+            node->interior.incorrect->parent = (CbNode *)node;
+        }
+    }
+} // cbNodeRelinkTree
+
+/**
+ * @brief version parent links switching function
+ * 
+ * @param[in] version   version that has previous one (non-null)
+ * @param[in] isApplied true if links should match version tree, false if they should match previous version one
+ */
+static void cbVersionRelink( const CbVersionImpl *const version, const bool isApplied ) {
+    // restructured tree shares only leaves with previous one
+    if (version->leaf == NULL)
+        cbNodeRelinkTree(isApplied ? version->root : version->prev->root);
+    else
+        cbVersionRelinkPath(version, isApplied);
+} // cbVersionRelink
+
+bool cbSetVersion( Cb self, CbVersion version ) {
+    assert(self != NULL);
+    assert(version != NULL);
+    assert(self->version != NULL);
+
+    // common ancestor is found by creation order, as versions are created after ones they're derived from
+    CbVersion common = self->version;
+    CbVersion target = version;
+    size_t applyCount = 0;
+
+    while (common != target) {
+        if (common->number > target->number) {
+            common = common->prev;
+        } else {
+            target = target->prev;
+            applyCount++;
+        }
+    }
+
+    // versions to apply are linked from target to common one, so they're reversed
+    CbVersion *applied = (CbVersion *)calloc(applyCount, sizeof(CbVersion));
+
+    if (applyCount != 0 && applied == NULL)
+        return false;
+
+    target = version;
+    for (size_t i = applyCount; i > 0; i--, target = target->prev)
+        applied[i - 1] = target;
+
+    // relinking excludes cbCompare parent walks and index readers
+    pthread_rwlock_wrlock(&self->lcaLock);
+
+    for (CbVersion reverted = self->version; reverted != common; reverted = reverted->prev)
+        cbVersionRelink(reverted, false);
+    for (size_t i = 0; i < applyCount; i++)
+        cbVersionRelink(applied[i], true);
+
+    free(applied);
+
+    self->treeRoot = version->root;
+    self->treeSize = version->treeSize;
+    self->version = version;
+
+    // LCA index may refer to nodes of other tree
+    cbLcaIndexDtor(self->lcaIndex);
+    self->lcaIndex = NULL;
+
+    pthread_rwlock_unlock(&self->lcaLock);
+
+    return true;
+} // cbSetVersion
+
+/// @brief pair of nodes at same place of two version trees (NULL side means subtree belongs to other tree only)
+typedef struct __CbVersionDiffPair {
+    const CbNode *from; ///< 'from' version node (nullable)
+    const CbNode *to;   ///< 'to' version node (nullable)
+} CbVersionDiffPair;
+
+/**
+ * @brief node pointers comparison function (for qsort)
+ * 
+ * @param[in] lhs first node pointer pointer
+ * @param[in] rhs second node pointer pointer
+ * 
+ * @return comparison result
+ */
+static int cbVersionLeafCompare( const void *lhs, const void *rhs ) {
+    const uintptr_t l = (uintptr_t)*(const CbNode *const *)lhs;
+    const uintptr_t r = (uintptr_t)*(const CbNode *const *)rhs;
+
+    return (l > r) - (l < r);
+} // cbVersionLeafCompare
+
+bool cbVersionDiff( CbVersion from, CbVersion to, CbVersionChange *dst, size_t capacity, size_t *changeCount ) {
+    assert(from != NULL);
+    assert(to != NULL);
+    assert(capacity == 0 || dst != NULL);
+    assert(changeCount != NULL);
+
+    CbVersionDiffPair *stack = NULL;
+    size_t stackSize = 0;
+    size_t stackCapacity = 0;
+
+    // leaves of differing subtrees, 0 - 'from' ones, 1 - 'to' ones
+    const CbNode **leaves[2] = {NULL, NULL};
+    size_t leafCounts[2] = {0, 0};
+    size_t leafCapacities[2] = {0, 0};
+
+    bool ok = cbReserve((void **)&stack, &stackCapacity, 1, sizeof(CbVersionDiffPair));
+
+    if (ok)
+        stack[stackSize++] = (CbVersionDiffPair) { from->root, to->root };
+
+    while (ok && stackSize != 0) {
+        const CbVersionDiffPair pair = stack[--stackSize];
+
+        // shared subtrees are skipped, so diff of close versions takes O(depth)
+        if (pair.from == pair.to)
+            continue;
+
+        if (!cbReserve((void **)&stack, &stackCapacity, stackSize + 2, sizeof(CbVersionDiffPair))) {
+            ok = false;
+            break;
+        }
+
+        if (pair.from != NULL && pair.to != NULL) {
+            // question texts are interned, so equal questions have equal text pointers
+            if (!pair.from->isLeaf && !pair.to->isLeaf && pair.from->text == pair.to->text) {
+                stack[stackSize++] = (CbVersionDiffPair) { pair.from->interior.correct, pair.to->interior.correct };
+                stack[stackSize++] = (CbVersionDiffPair) { pair.from->interior.incorrect, pair.to->interior.incorrect };
+            } else {
+                stack[stackSize++] = (CbVersionDiffPair) { pair.from, NULL };
+                stack[stackSize++] = (CbVersionDiffPair) { NULL, pair.to };
+            }
+            continue;
+        }
+
+        const size_t side = pair.from == NULL;
+        const CbNode *const node = side == 0 ? pair.from : pair.to;
+
+        if (node->isLeaf) {
+            ok = cbReserve((void **)&leaves[side], &leafCapacities[side], leafCounts[side] + 1, sizeof(const CbNode *));
+
+            if (ok)
+                leaves[side][leafCounts[side]++] = node;
+        } else if (side == 0) {
+            stack[stackSize++] = (CbVersionDiffPair) { node->interior.correct, NULL };
+            stack[stackSize++] = (CbVersionDiffPair) { node->interior.incorrect, NULL };
+        } else {
+            stack[stackSize++] = (CbVersionDiffPair) { NULL, node->interior.correct };
+            stack[stackSize++] = (CbVersionDiffPair) { NULL, node->interior.incorrect };
+        }
+    }
+
+    free(stack);
+
+    if (!ok) {
+        free(leaves[0]);
+        free(leaves[1]);
+        return false;
+    }
+
+    // leaf nodes are shared between versions, so moved leaf is found on both sides (side may have no leaves)
+    for (size_t side = 0; side < 2; side++)
+        if (leafCounts[side] > 1)
+            qsort(leaves[side], leafCounts[side], sizeof(const CbNode *), cbVersionLeafCompare);
+
+    size_t count = 0;
+    size_t i = 0;
+    size_t j = 0;
+
+    while (i < leafCounts[0] || j < leafCounts[1]) {
+        if (i < leafCounts[0] && j < leafCounts[1] && leaves[0][i] == leaves[1][j]) {
+            i++;
+            j++;
+            continue;
+        }
+
+        const bool isAdded = i == leafCounts[0] || (j < leafCounts[1] && (uintptr_t)leaves[1][j] < (uintptr_t)leaves[0][i]);
+        const CbNode *const leaf = isAdded ? leaves[1][j++] : leaves[0][i++];
+
+        if (count < capacity)
+            dst[count] = (CbVersionChange) { leaf->text, isAdded };
+        count++;
+    }
+
+    free(leaves[0]);
+    free(leaves[1]);
+
+    *changeCount = count;
+
+    return true;
+} // cbVersionDiff
+
+bool cbEnableStat( Cb self ) {
+    assert(self != NULL);
+
+    const CbNode *const root = self->treeRoot;
+    size_t count = 0;
+
+    for (const CbNode *node = root; node != NULL; node = cbNodeNextPreorder(node, root, NULL))
+        count += node->stat == NULL;
+
+    // counters are allocated at once, so failed call leaves cb unchanged
+    CbNodeStat *stats = NULL;
+
+    if (count != 0 && (stats = (CbNodeStat *)cbArenaAlloc(self->arena, count * sizeof(CbNodeStat))) == NULL)
+        return false;
+
+    for (const CbNode *node = root; node != NULL; node = cbNodeNextPreorder(node, root, NULL))
+        if (node->stat == NULL)
+            ((CbNode *)node)->stat = stats++;
+
+    self->isStatEnabled = true;
+
+    return true;
+} // cbEnableStat
+
+/**
+ * @brief node visit counters loading function
+ * 
+ * @param[in]  node node (non-null)
+ * @param[out] dst  counters destination (non-null)
+ * 
+ * @return true if node has counters, false otherwise
+ */
+static bool cbNodeLoadStat( const CbNode *const node, CbNodeStat *const dst ) {
+    const CbNodeStat *const stat = node->stat;
+
+    if (stat == NULL)
+        return false;
+
+    dst->visits = CB_LOAD_RELAXED(&stat->visits);
+    dst->correct = CB_LOAD_RELAXED(&stat->correct);
+    dst->incorrect = CB_LOAD_RELAXED(&stat->incorrect);
+
+    return true;
+} // cbNodeLoadStat
+
+bool cbIterGetStat( const CbIter *iter, CbNodeStat *dst ) {
+    assert(iter != NULL);
+    assert(dst != NULL);
+
+    return cbNodeLoadStat(iter->current, dst);
+} // cbIterGetStat
+
+void cbGetSessionStat( const Cb self, CbSessionStat *dst ) {
+    assert(self != NULL);
+    assert(dst != NULL);
+
+    dst->count = CB_LOAD_RELAXED(&self->sessionStat.count);
+    dst->lengthSum = CB_LOAD_RELAXED(&self->sessionStat.lengthSum);
+
+    for (size_t i = 0; i < CB_SESSION_LENGTH_COUNT; i++)
+        dst->lengths[i] = CB_LOAD_RELAXED(&self->sessionStat.lengths[i]);
+} // cbGetSessionStat
+
+size_t cbGetLeafHits( const Cb self, CbLeafFrequency *dst, size_t capacity ) {
+    assert(self != NULL);
+    assert(capacity == 0 || dst != NULL);
+
+    if (!self->isStatEnabled)
+        return 0;
+
+    const CbNode *const root = self->treeRoot;
+    size_t count = 0;
+
+    for (const CbNode *node = root; node != NULL; node = cbNodeNextPreorder(node, root, NULL)) {
+        if (!node->isLeaf)
+            continue;
+
+        if (count < capacity)
+            dst[count] = (CbLeafFrequency) { node->text, (double)CB_LOAD_RELAXED(&node->stat->visits) };
+        count++;
+    }
+
+    return count;
+} // cbGetLeafHits
+
+/**
+ * @brief JSON string literal dumping function
+ * 
+ * @param[out] out destination file (non-null)
+ * @param[in]  str string to dump (non-null)
+ */
+static void cbDumpJsonString( FILE *out, const char *str ) {
+    fputc('\"', out);
+
+    for (; *str != '\0'; str++) {
+        const unsigned char ch = (unsigned char)*str;
+
+        if (ch == '\"' || ch == '\\')
+            fprintf(out, "\\%c", ch);
+        else if (ch < 0x20)
+            fprintf(out, "\\u%04X", ch);
+        else
+            fputc(ch, out);
+    }
+
+    fputc('\"', out);
+} // cbDumpJsonString
+
+bool cbDumpStat( FILE *out, const Cb self, const CbStatFormat format ) {
+    assert(out != NULL);
+    assert(self != NULL);
+
+    if (!self->isStatEnabled)
+        return false;
+
+    CbSessionStat sessionStat;
+
+    cbGetSessionStat(self, &sessionStat);
+
+    if (format == CB_STAT_FORMAT_JSON) {
+        fprintf(out, "{\"sessions\":{\"count\":%llu,\"lengthSum\":%llu,\"lengths\":[",
+            (unsigned long long)sessionStat.count,
+            (unsigned long long)sessionStat.lengthSum
+        );
+
+        for (size_t i = 0; i < CB_SESSION_LENGTH_COUNT; i++)
+            fprintf(out, i == 0 ? "%llu" : ",%llu", (unsigned long long)sessionStat.lengths[i]);
+
+        fprintf(out, "]},\"nodes\":[");
+    } else {
+        fprintf(out, "sessions: %llu, average length: %.3f\n",
+            (unsigned long long)sessionStat.count,
+            sessionStat.count == 0 ? 0.0 : (double)sessionStat.lengthSum / (double)sessionStat.count
+        );
+
+        for (size_t i = 0; i < CB_SESSION_LENGTH_COUNT; i++)
+            if (sessionStat.lengths[i] != 0)
+                fprintf(out, "    length %2zu%s: %llu\n", i, i == CB_SESSION_LENGTH_COUNT - 1 ? "+" : "", (unsigned long long)sessionStat.lengths[i]);
+
+        fprintf(out, "nodes:\n");
+    }
+
+    // only visited nodes are reported
+    const CbNode *const root = self->treeRoot;
+    const CbNode *node = root;
+    size_t depth = 0;
+    bool isFirst = true;
+
+    while (node != NULL) {
+        CbNodeStat stat;
+
+        if (cbNodeLoadStat(node, &stat) && stat.visits != 0) {
+            if (format == CB_STAT_FORMAT_JSON) {
+                fprintf(out, isFirst ? "{\"text\":" : ",{\"text\":");
+                cbDumpJsonString(out, node->text);
+                fprintf(out, ",\"depth\":%zu,\"isLeaf\":%s,\"visits\":%llu,\"correct\":%llu,\"incorrect\":%llu}",
+                    depth,
+                    node->isLeaf ? "true" : "false",
+                    (unsigned long long)stat.visits,
+                    (unsigned long long)stat.correct,
+                    (unsigned long long)stat.incorrect
+                );
+            } else if (node->isLeaf) {
+                fprintf(out, "%*s\"%s\": hits %llu\n", (int)(depth * 4 + 4), "", node->text, (unsigned long long)stat.visits);
+            } else {
+                fprintf(out, "%*s\"%s\"?: visits %llu, correct %llu, incorrect %llu\n",
+                    (int)(depth * 4 + 4), "",
+                    node->text,
+                    (unsigned long long)stat.visits,
+                    (unsigned long long)stat.correct,
+                    (unsigned long long)stat.incorrect
+                );
+            }
+
+            isFirst = false;
+        }
+
+        size_t closed = 0;
+        const CbNode *const next = cbNodeNextPreorder(node, root, &closed);
+
+        if (!node->isLeaf)
+            depth++;
+        else
+            depth -= closed;
+
+        node = next;
+    }
+
+    if (format == CB_STAT_FORMAT_JSON)
+        fprintf(out, "]}\n");
+
+    return ferror(out) == 0;
+} // cbDumpStat
+
+/// @brief default dump buffer size
+#define CB_DUMP_BUFFER_SIZE ((size_t)32768)
+
+/// @brief spaces to copy indentation from
+static const char cbDumpSpaces[] =
+    "                                                                "
+    "                                                                "
+    "                                                                "
+    "                                                                ";
+
+/// @brief buffered dump writer
+typedef struct __CbWriter {
+    FILE   *out;      ///< output file
+    char   *buffer;   ///< write buffer
+    size_t  capacity; ///< write buffer capacity
+    size_t  size;     ///< count of bytes in write buffer
+    bool    failed;   ///< true if some write failed
+} CbWriter;
+
+/**
+ * @brief writer buffer flushing function
+ * 
+ * @param[in,out] writer writer (non-null)
+ */
+static void cbWriterFlush( CbWriter *const writer ) {
+    if (writer->size != 0 && fwrite(writer->buffer, 1, writer->size, writer->out) != writer->size)
+        writer->failed = true;
+    writer->size = 0;
+} // cbWriterFlush
+
+/**
+ * @brief bytes writing function
+ * 
+ * @param[in,out] writer writer (non-null)
+ * @param[in]     data   data to write
+ * @param[in]     size   data size
+ */
+static void cbWriterWrite( CbWriter *const writer, const char *data, size_t size ) {
+    while (size > 0) {
+        if (writer->size == writer->capacity)
+            cbWriterFlush(writer);
+
+        const size_t chunkSize = size < writer->capacity - writer->size
+            ? size
+            : writer->capacity - writer->size;
+
+        memcpy(writer->buffer + writer->size, data, chunkSize);
+        writer->size += chunkSize;
+        data += chunkSize;
+        size -= chunkSize;
+    }
+} // cbWriterWrite
+
+/**
+ * @brief single character writing function
+ * 
+ * @param[in,out] writer writer (non-null)
+ * @param[in]     ch     character to write
+ */
+static void cbWriterPutc( CbWriter *const writer, const char ch ) {
+    if (writer->size == writer->capacity)
+        cbWriterFlush(writer);
+    writer->buffer[writer->size++] = ch;
+} // cbWriterPutc
+
+/**
+ * @brief indentation writing function
+ * 
+ * @param[in,out] writer writer (non-null)
+ * @param[in]     depth  indentation depth
+ */
+static void cbWriterIndent( CbWriter *const writer, const size_t depth ) {
+    size_t rest = depth * 4;
+
+    while (rest > 0) {
+        const size_t chunkSize = rest < sizeof(cbDumpSpaces) - 1
+            ? rest
+            : sizeof(cbDumpSpaces) - 1;
+
+        cbWriterWrite(writer, cbDumpSpaces, chunkSize);
+        rest -= chunkSize;
+    }
+} // cbWriterIndent
+
+/**
+ * @brief subtree dumping funciton
+ * 
+ * @param[in,out] writer writer (non-null)
+ * @param[in]     root   subtree root pointer
+ * @param[in]     format dump format
+ */
+static void cbDumpNode( CbWriter *const writer, const CbNode *const root, const CbDumpFormat format ) {
+    const bool indent = format == CB_DUMP_FORMAT_INDENTED;
+    const CbNode *node = root;
+    size_t depth = 0;
+
+    while (node != NULL) {
+        if (indent)
+            cbWriterIndent(writer, depth);
+
+        if (!node->isLeaf)
+            cbWriterPutc(writer, '(');
+
+        cbWriterPutc(writer, '\"');
+        cbWriterWrite(writer, node->text, strlen(node->text));
+        cbWriterPutc(writer, '\"');
+        if (indent)
+            cbWriterPutc(writer, '\n');
+
+        if (!node->isLeaf) {
+            node = cbNodeNextPreorder(node, root, NULL);
+            depth++;
+            continue;
+        }
+
+        size_t closed = 0;
+        node = cbNodeNextPreorder(node, root, &closed);
+
+        for (size_t i = 0; i < closed; i++) {
+            depth--;
+            if (indent)
+                cbWriterIndent(writer, depth);
+            cbWriterPutc(writer, ')');
+            if (indent)
+                cbWriterPutc(writer, '\n');
+        }
+    }
+
+    if (!indent)
+        cbWriterPutc(writer, '\n');
+} // cbDumpNode
+
+/// @brief packed format file magic (format version is its last byte)
+#define CB_PACKED_MAGIC "CBPACK\0\1"
+
+/// @brief packed format block string section size, block is finished after it's reached
+#define CB_PACKED_BLOCK_SIZE ((size_t)65536)
+
+/// @brief maximal packed format block payload size (larger blocks are considered corrupted)
+#define CB_PACKED_MAX_PAYLOAD_SIZE ((size_t)1 << 30)
+
+/*
+ * packed format:
+ *     magic (8 bytes), node count (uint64_t), then blocks of consecutive nodes in preorder.
+ *     block is header (CbPackedBlockHeader) and payload: topology bits (bit i of byte i / 8 is
+ *     set if i-th node of block is interior), then string section with node texts in same order.
+ *
+ *     texts are front-coded: varint count of bytes shared with previous text of same kind, varint
+ *     suffix length and suffix bytes. leaf texts are coded against previous leaf. questions are
+ *     dictionary-coded: varint 0 is followed by new question text (coded against previous new
+ *     question), varint i > 0 refers to (i - 1)-th new question. varints are LEB128, numbers
+ *     in headers use native byte order.
+ */
+
+/// @brief packed format block header
+typedef struct __CbPackedBlockHeader {
+    uint32_t nodeCount;   ///< count of nodes in block
+    uint32_t payloadSize; ///< payload size (in bytes)
+    uint32_t checksum;    ///< payload checksum (32-bit FNV-1a)
+} CbPackedBlockHeader;
+
+/// @brief packed format encoder
+typedef struct __CbPackedEncoder {
+    CbWriter   *writer;         ///< writer blocks are written to
+    uint8_t    *bits;           ///< topology bits of current block
+    size_t      bitCapacity;    ///< topology bit buffer capacity (in bytes)
+    uint8_t    *strings;        ///< string section of current block
+    size_t      stringSize;     ///< string section size
+    size_t      stringCapacity; ///< string section buffer capacity
+    size_t      nodeCount;      ///< count of nodes in current block
+    uint32_t   *questionIds;    ///< question dictionary references by text pool index (0 if question isn't written yet)
+    uint32_t    questionCount;  ///< count of written distinct questions
+    const char *prevQuestion;   ///< last new question text
+    const char *prevLeaf;       ///< last leaf text
+    bool        failed;         ///< true if allocation failed
+} CbPackedEncoder;
+
+/**
+ * @brief encoder string section space reserving function
+ * 
+ * @param[in,out] encoder encoder (non-null)
+ * @param[in]     size    count of bytes to be appended
+ * 
+ * @return true if space is reserved, false if allocation failed
+ */
+static bool cbPackedReserve( CbPackedEncoder *const encoder, const size_t size ) {
+    if (!cbReserve((void **)&encoder->strings, &encoder->stringCapacity, encoder->stringSize + size, 1))
+        encoder->failed = true;
+
+    return !encoder->failed;
+} // cbPackedReserve
+
+/**
+ * @brief varint encoding function
+ * 
+ * @param[in,out] encoder encoder (non-null)
+ * @param[in]     value   value to encode
+ */
+static void cbPackedPutVarint( CbPackedEncoder *const encoder, uint64_t value ) {
+    if (!cbPackedReserve(encoder, 10))
+        return;
+
+    while (value >= 0x80) {
+        encoder->strings[encoder->stringSize++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    encoder->strings[encoder->stringSize++] = (uint8_t)value;
+} // cbPackedPutVarint
+
+/**
+ * @brief front-coded text encoding function
+ * 
+ * @param[in,out] encoder encoder (non-null)
+ * @param[in]     prev    previous text of same kind (nullable)
+ * @param[in]     text    text to encode (non-null)
+ */
+static void cbPackedPutText( CbPackedEncoder *const encoder, const char *prev, const char *const text ) {
+    size_t shared = 0;
+
+    if (prev != NULL)
+        while (prev[shared] != '\0' && prev[shared] == text[shared])
+            shared++;
+
+    const size_t suffixLength = strlen(text + shared);
+
+    cbPackedPutVarint(encoder, shared);
+    cbPackedPutVarint(encoder, suffixLength);
+
+    if (!cbPackedReserve(encoder, suffixLength))
+        return;
+
+    memcpy(encoder->strings + encoder->stringSize, text + shared, suffixLength);
+    encoder->stringSize += suffixLength;
+} // cbPackedPutText
+
+/**
+ * @brief current block writing function
+ * 
+ * @param[in,out] encoder encoder (non-null)
+ */
+static void cbPackedFlush( CbPackedEncoder *const encoder ) {
+    if (encoder->nodeCount == 0 || encoder->failed)
+        return;
+
+    const size_t bitSize = (encoder->nodeCount + 7) / 8;
+    uint32_t checksum = 0x811C9DC5;
+
+    // checksum is FNV-1a of topology bits and strings, as if they were single buffer
+    for (size_t i = 0; i < bitSize; i++)
+        checksum = (checksum ^ encoder->bits[i]) * 0x01000193;
+    for (size_t i = 0; i < encoder->stringSize; i++)
+        checksum = (checksum ^ encoder->strings[i]) * 0x01000193;
+
+    const CbPackedBlockHeader header = {
+        .nodeCount   = (uint32_t)encoder->nodeCount,
+        .payloadSize = (uint32_t)(bitSize + encoder->stringSize),
+        .checksum    = checksum,
+    };
+
+    cbWriterWrite(encoder->writer, (const char *)&header, sizeof(CbPackedBlockHeader));
+    cbWriterWrite(encoder->writer, (const char *)encoder->bits, bitSize);
+    cbWriterWrite(encoder->writer, (const char *)encoder->strings, encoder->stringSize);
+
+    memset(encoder->bits, 0, bitSize);
+    encoder->nodeCount = 0;
+    encoder->stringSize = 0;
+} // cbPackedFlush
+
+/**
+ * @brief node encoding function
+ * 
+ * @param[in,out] encoder encoder (non-null)
+ * @param[in]     pool    text pool of node tree (non-null)
+ * @param[in]     node    node to encode (non-null)
+ */
+static void cbPackedPutNode( CbPackedEncoder *const encoder, const CbStrPool pool, const CbNode *const node ) {
+    const size_t bitSize = encoder->nodeCount / 8 + 1;
+
+    if (bitSize > encoder->bitCapacity) {
+        const size_t oldCapacity = encoder->bitCapacity;
+
+        if (!cbReserve((void **)&encoder->bits, &encoder->bitCapacity, bitSize, 1)) {
+            encoder->failed = true;
+            return;
+        }
+        memset(encoder->bits + oldCapacity, 0, encoder->bitCapacity - oldCapacity);
+    }
+
+    if (node->isLeaf) {
+        cbPackedPutText(encoder, encoder->prevLeaf, node->text);
+        encoder->prevLeaf = node->text;
+    } else {
+        CbPoolStr str;
+
+        // question texts are interned, so pool index identifies question
+        if (!cbStrPoolFind(pool, node->text, strlen(node->text), &str)) {
+            encoder->failed = true;
+            return;
+        }
+
+        encoder->bits[encoder->nodeCount / 8] |= (uint8_t)(1 << (encoder->nodeCount % 8));
+
+        if (encoder->questionIds[str.index] != 0) {
+            cbPackedPutVarint(encoder, encoder->questionIds[str.index]);
+        } else {
+            cbPackedPutVarint(encoder, 0);
+            cbPackedPutText(encoder, encoder->prevQuestion, node->text);
+            encoder->prevQuestion = node->text;
+            encoder->questionIds[str.index] = ++encoder->questionCount;
+        }
+    }
+
+    encoder->nodeCount++;
+
+    if (encoder->stringSize >= CB_PACKED_BLOCK_SIZE)
+        cbPackedFlush(encoder);
+} // cbPackedPutNode
+
+/**
+ * @brief tree in packed format dumping function
+ * 
+ * @param[in,out] writer writer (non-null)
+ * @param[in]     self   cactusbot to dump (non-null)
+ * 
+ * @return true if encoded, false if allocation failed
+ */
+static bool cbDumpPacked( CbWriter *const writer, const CbImpl *const self ) {
+    CbStrPoolStat poolStat;
+
+    cbStrPoolGetStat(self->textPool, &poolStat);
+
+    CbPackedEncoder encoder = {
+        .writer      = writer,
+        .questionIds = (uint32_t *)calloc(poolStat.stringCount + 1, sizeof(uint32_t)),
+    };
+    const uint64_t nodeCount = self->treeSize;
+
+    encoder.failed = encoder.questionIds == NULL;
+
+    cbWriterWrite(writer, CB_PACKED_MAGIC, sizeof(CB_PACKED_MAGIC) - 1);
+    cbWriterWrite(writer, (const char *)&nodeCount, sizeof(uint64_t));
+
+    for (const CbNode *node = self->treeRoot; node != NULL && !encoder.failed; node = cbNodeNextPreorder(node, self->treeRoot, NULL))
+        cbPackedPutNode(&encoder, self->textPool, node);
+    cbPackedFlush(&encoder);
+
+    free(encoder.questionIds);
+    free(encoder.strings);
+    free(encoder.bits);
+
+    return !encoder.failed;
+} // cbDumpPacked
+
+bool cbDumpBuffered( FILE *out, const Cb self, const CbDumpFormat format, void *buffer, size_t bufferSize ) {
+    assert(out != NULL);
+    assert(self != NULL);
+
+    char defaultBuffer[CB_DUMP_BUFFER_SIZE];
+
+    if (buffer == NULL || bufferSize == 0) {
+        buffer = defaultBuffer;
+        bufferSize = sizeof(defaultBuffer);
+    }
+
+    CbWriter writer = {
+        .out      = out,
+        .buffer   = (char *)buffer,
+        .capacity = bufferSize,
+        .size     = 0,
+        .failed   = false,
+    };
+
+    bool encoded = true;
+
+    if (format == CB_DUMP_FORMAT_PACKED)
+        encoded = cbDumpPacked(&writer, self);
+    else
+        cbDumpNode(&writer, self->treeRoot, format);
+    cbWriterFlush(&writer);
+
+    return encoded && !writer.failed;
+} // cbDumpBuffered
+
+void cbDump( FILE *out, const Cb self ) {
+    cbDumpBuffered(out, self, CB_DUMP_FORMAT_INDENTED, NULL, 0);
+} // cbDump
+
+/// @brief token type enumeration
+typedef enum __CbTokenType {
+    CB_TOKEN_LEFT_BRACKET,  ///< (
+    CB_TOKEN_RIGHT_BRACKET, ///< )
+    CB_TOKEN_STRING,        ///< "<smth>"
+} CbTokenType;
+
+/// @brief token contents
+typedef struct __CbToken {
+    CbTokenType type;   ///< token type
+    CbStr       string; ///< string (if token type is CB_TOKEN_STRING). actually, this structure is tagged union.
+} CbToken;
+
+/**
+ * @brief next token parsing function
+ * 
+ * @param[in,out] str token string
+ * @param[out]    dst parsing destination
+ */
+static bool cbNextToken( CbStr *const str, CbToken *const dst ) {
+    str->begin = cbScanSpaces(str->begin, str->end);
+
+    if (str->begin >= str->end)
+        return false;
+
+    switch (*str->begin) {
+    case '(': {
+        str->begin++;
+        dst->type = CB_TOKEN_LEFT_BRACKET;
+        return true;
+    }
+
+    case ')': {
+        str->begin++;
+        dst->type = CB_TOKEN_RIGHT_BRACKET;
+        return true;
+    }
+
+    case '\"': {
+        str->begin++;
+
+        const char *strBegin = str->begin;
+        str->begin = cbScanQuote(str->begin, str->end);
+
+        dst->string = (CbStr) {strBegin, str->begin};
+        str->begin++;
+        dst->type = CB_TOKEN_STRING;
+
+        return true;
+    }
+
+    default:
+        return false; // error?
+    }
+} // cbNextToken
+
+/// @brief streaming tokenizer buffer initial size
+#define CB_TOKENIZER_CHUNK_SIZE ((size_t)65536)
+
+/// @brief tokenizer (token stream over in-memory string or chunked input)
+typedef struct __CbTokenizer {
+    CbStr      rest;           ///< not tokenized yet part of input
+    CbReadFunc read;           ///< input reading function, NULL if whole input is in 'rest'
+    void      *readContext;    ///< input reading function context
+    char      *buffer;         ///< chunk buffer (read != NULL only)
+    size_t     bufferCapacity; ///< chunk buffer capacity
+    bool       readFinished;   ///< true if 'read' reported end of input
+} CbTokenizer;
+
+/**
+ * @brief tokenizer buffer refilling function
+ * 
+ * @param[in,out] tokenizer tokenizer (non-null)
+ * 
+ * @return true if some new input arrived, false if input finished or something went wrong.
+ * 
+ * @note unparsed rest is moved to buffer start, so partially read token is kept. buffer is grown only if it is completely filled by single token.
+ */
+static bool cbTokenizerRefill( CbTokenizer *const tokenizer ) {
+    if (tokenizer->read == NULL || tokenizer->readFinished)
+        return false;
+
+    const size_t restSize = tokenizer->rest.end - tokenizer->rest.begin;
+
+    if (restSize == tokenizer->bufferCapacity) {
+        const size_t newCapacity = tokenizer->bufferCapacity == 0
+            ? CB_TOKENIZER_CHUNK_SIZE
+            : tokenizer->bufferCapacity * 2;
+        char *const newBuffer = (char *)malloc(newCapacity);
+
+        if (newBuffer == NULL)
+            return false;
+
+        // first refill has no buffer to copy from
+        if (restSize != 0)
+            memcpy(newBuffer, tokenizer->rest.begin, restSize);
+        free(tokenizer->buffer);
+
+        tokenizer->buffer = newBuffer;
+        tokenizer->bufferCapacity = newCapacity;
+    } else {
+        memmove(tokenizer->buffer, tokenizer->rest.begin, restSize);
+    }
+
+    const size_t readSize = tokenizer->read(
+        tokenizer->readContext,
+        tokenizer->buffer + restSize,
+        tokenizer->bufferCapacity - restSize
+    );
+
+    tokenizer->rest = (CbStr) { tokenizer->buffer, tokenizer->buffer + restSize + readSize };
+
+    if (readSize == 0)
+        tokenizer->readFinished = true;
+
+    return readSize != 0;
+} // cbTokenizerRefill
+
+/**
+ * @brief next token from tokenizer getting function
+ * 
+ * @param[in,out] tokenizer tokenizer (non-null)
+ * @param[out]    dst       parsing destination (non-null)
+ * 
+ * @return true if token parsed, false if input finished or is invalid.
+ * 
+ * @note token string is valid only until next cbTokenizerNext call.
+ */
+static bool cbTokenizerNext( CbTokenizer *const tokenizer, CbToken *const dst ) {
+    // make sure that whole token is located in buffer
+    for (;;) {
+        CbStr *const rest = &tokenizer->rest;
+
+        rest->begin = cbScanSpaces(rest->begin, rest->end);
+
+        if (rest->begin < rest->end && *rest->begin != '\"')
+            break;
+
+        if (rest->begin < rest->end && cbScanQuote(rest->begin + 1, rest->end) != rest->end)
+            break;
+
+        if (!cbTokenizerRefill(tokenizer))
+            break;
+    }
+
+    return cbNextToken(&tokenizer->rest, dst);
+} // cbTokenizerNext
+
+/**
+ * @brief tree parsing function
+ * 
+ * @param[in,out] tokenizer     tokenizer (non-null)
+ * @param[in,out] self          cactusbot to parse node into (non-null)
+ * @param[in]     isLeafIndexed true if leaves should be checked for uniqueness and inserted into leaf index
+ * @param[out]    dst           parsed tree root destination (non-null)
+ * 
+ * @return count of parsed nodes, 0 if parsing failed.
+ * 
+ * @note parser is a loop, not yet finished interior nodes are tracked by parent links,
+ *       so arena-allocated nodes are the parser stack and tree depth isn't limited by native stack.
+ */
+static size_t cbParseNode( CbTokenizer *const tokenizer, CbImpl *const self, const bool isLeafIndexed, CbNode **dst ) {
+    CbNode *current = NULL; // innermost not finished interior node
+    size_t count = 0;
+    CbToken token = {};
+
+    *dst = NULL;
+
+    do {
+        CbNode *node = NULL;
+
+        if (!cbTokenizerNext(tokenizer, &token))
+            return 0;
+
+        switch (token.type) {
+        case CB_TOKEN_LEFT_BRACKET: {
+            CbToken identToken = {};
+
+            // node is allocated before children are parsed, because identToken may be overwritten by next chunk
+            if (false
+                || !cbTokenizerNext(tokenizer, &identToken)
+                || identToken.type != CB_TOKEN_STRING
+                || (node = cbAllocQuestionNode(self->arena, self->textPool, identToken.string)) == NULL
+            )
+                return 0;
+            break;
+        }
+
+        case CB_TOKEN_RIGHT_BRACKET: {
+            return 0;
+        }
+
+        case CB_TOKEN_STRING: {
+            if (false
+                || (node = (CbNode *)cbAllocNode(self->arena, token.string)) == NULL
+                || (isLeafIndexed && (false
+                    || cbLeafIndexFind(self, node->text, node->hash) != NULL
+                    || !cbLeafIndexReserve(self)
+                ))
+            )
+                return 0;
+
+            node->isLeaf = true;
+            if (isLeafIndexed)
+                cbLeafIndexInsert(self, node);
+            break;
+        }
+        }
+
+        count++;
+
+        // attach node to innermost unfinished interior
+        node->parent = current;
+        if (current == NULL)
+            *dst = node;
+        else if (current->interior.correct == NULL)
+            current->interior.correct = node;
+        else
+            current->interior.incorrect = node;
+
+        if (!node->isLeaf) {
+            current = node;
+            continue;
+        }
+
+        // close all interior nodes with both children parsed
+        while (current != NULL && current->interior.incorrect != NULL) {
+            if (!cbTokenizerNext(tokenizer, &token) || token.type != CB_TOKEN_RIGHT_BRACKET)
+                return 0;
+            current = current->parent;
+        }
+    } while (current != NULL);
+
+    return count;
+} // cbParseNode
+
+/**
+ * @brief CB from tokenizer parsing function
+ * 
+ * @param[in,out] tokenizer tokenizer (non-null)
+ * @param[in]     leafIndex leaf index kind
+ * @param[out]    dst       parsing destination (non-null)
+ * 
+ * @return true if parsed, false if not.
+ */
+static bool cbParseTokenizer( CbTokenizer *const tokenizer, const CbLeafIndex leafIndex, Cb *const dst ) {
+    CbImpl *const impl = cbAllocImpl(leafIndex);
+
+    if (impl == NULL)
+        return false;
+
+    if ((impl->treeSize = cbParseNode(tokenizer, impl, true, &impl->treeRoot)) == 0) {
+        cbDtor(impl);
+        return false;
+    }
+
+    *dst = impl;
+
+    return true;
+} // cbParseTokenizer
+
+bool cbParse( const char *const str, const CbLeafIndex leafIndex, Cb *const dst ) {
+    CbTokenizer tokenizer = {
+        .rest           = CB_STR(str),
+        .read           = NULL,
+        .readContext    = NULL,
+        .buffer         = NULL,
+        .bufferCapacity = 0,
+        .readFinished   = true,
+    };
+
+    return cbParseTokenizer(&tokenizer, leafIndex, dst);
+} // cbParse
+
+bool cbParseStream( const CbReadFunc read, void *const readContext, const CbLeafIndex leafIndex, Cb *const dst ) {
+    assert(read != NULL);
+
+    CbTokenizer tokenizer = {
+        .rest           = (CbStr) { NULL, NULL },
+        .read           = read,
+        .readContext    = readContext,
+        .buffer         = NULL,
+        .bufferCapacity = 0,
+        .readFinished   = false,
+    };
+
+    const bool result = cbParseTokenizer(&tokenizer, leafIndex, dst);
+
+    free(tokenizer.buffer);
+
+    return result;
+} // cbParseStream
+
+/**
+ * @brief from file reading function (CbReadFunc implementation for cbParseFile)
+ * 
+ * @param[in]  context file pointer
+ * @param[out] buffer  reading destination
+ * @param[in]  size    buffer size
+ * 
+ * @return count of bytes read
+ */
+static size_t cbReadFile( void *const context, char *const buffer, const size_t size ) {
+    return fread(buffer, 1, size, (FILE *)context);
+} // cbReadFile
+
+bool cbParseFile( FILE *const file, const CbLeafIndex leafIndex, Cb *const dst ) {
+    assert(file != NULL);
+
+    return cbParseStream(cbReadFile, file, leafIndex, dst);
+} // cbParseFile
+
+/// @brief packed format decoder
+typedef struct __CbPackedDecoder {
+    CbReadFunc     read;             ///< reading function
+    void          *readContext;      ///< reading function context
+    uint8_t       *payload;          ///< current block payload
+    size_t         payloadCapacity;  ///< payload buffer capacity
+    const uint8_t *bits;             ///< current block topology bits
+    const uint8_t *rest;             ///< not decoded part of current block string section
+    const uint8_t *end;              ///< current block end
+    size_t         blockNodeCount;   ///< count of nodes in current block
+    size_t         blockNodeIndex;   ///< index of next node in current block
+    CbPoolStr     *questions;        ///< decoded distinct questions (interned in tree pool)
+    size_t         questionCount;    ///< count of decoded distinct questions
+    size_t         questionCapacity; ///< question array capacity
+    CbStr          prevQuestion;     ///< last new question text
+    CbStr          prevLeaf;         ///< last leaf text
+    char          *text;             ///< text assembling buffer
+    size_t         textCapacity;     ///< text assembling buffer capacity
+} CbPackedDecoder;
+
+/**
+ * @brief exact byte count reading function
+ * 
+ * @param[in,out] decoder decoder (non-null)
+ * @param[out]    dst     reading destination
+ * @param[in]     size    count of bytes to read
+ * 
+ * @return true if all bytes are read, false if stream ended before
+ */
+static bool cbPackedRead( CbPackedDecoder *const decoder, void *const dst, const size_t size ) {
+    size_t total = 0;
+
+    while (total < size) {
+        const size_t count = decoder->read(decoder->readContext, (char *)dst + total, size - total);
+
+        if (count == 0)
+            return false;
+        total += count;
+    }
+
+    return true;
+} // cbPackedRead
+
+/**
+ * @brief next block reading function
+ * 
+ * @param[in,out] decoder decoder (non-null)
+ * 
+ * @return true if block is read and its checksum matches, false otherwise
+ */
+static bool cbPackedReadBlock( CbPackedDecoder *const decoder ) {
+    CbPackedBlockHeader header;
+
+    if (false
+        || !cbPackedRead(decoder, &header, sizeof(CbPackedBlockHeader))
+        || header.nodeCount == 0
+        || header.payloadSize > CB_PACKED_MAX_PAYLOAD_SIZE
+        || (header.nodeCount + 7) / 8 > header.payloadSize
+        || !cbReserve((void **)&decoder->payload, &decoder->payloadCapacity, header.payloadSize, 1)
+        || !cbPackedRead(decoder, decoder->payload, header.payloadSize)
+        || cbHashStr((CbStr) { (const char *)decoder->payload, (const char *)decoder->payload + header.payloadSize }) != header.checksum
+    )
+        return false;
+
+    decoder->bits = decoder->payload;
+    decoder->rest = decoder->payload + (header.nodeCount + 7) / 8;
+    decoder->end = decoder->payload + header.payloadSize;
+    decoder->blockNodeCount = header.nodeCount;
+    decoder->blockNodeIndex = 0;
+
+    return true;
+} // cbPackedReadBlock
+
+/**
+ * @brief varint decoding function
+ * 
+ * @param[in,out] decoder decoder (non-null)
+ * @param[out]    dst     value destination (non-null)
+ * 
+ * @return true if decoded, false if varint is truncated or too long
+ */
+static bool cbPackedGetVarint( CbPackedDecoder *const decoder, uint64_t *const dst ) {
+    uint64_t value = 0;
+
+    for (size_t shift = 0; shift < 64 && decoder->rest < decoder->end; shift += 7) {
+        const uint8_t byte = *decoder->rest++;
+
+        value |= (uint64_t)(byte & 0x7F) << shift;
+
+        if ((byte & 0x80) == 0) {
+            *dst = value;
+            return true;
+        }
+    }
+
+    return false;
+} // cbPackedGetVarint
+
+/**
+ * @brief front-coded text decoding function
+ * 
+ * @param[in,out] decoder decoder (non-null)
+ * @param[in]     prev    previous text of same kind
+ * @param[out]    dst     decoded text destination (non-null, valid until next decoding)
+ * 
+ * @return true if decoded, false if text is corrupted
+ */
+static bool cbPackedGetText( CbPackedDecoder *const decoder, const CbStr prev, CbStr *const dst ) {
+    uint64_t shared = 0;
+    uint64_t suffixLength = 0;
+
+    if (false
+        || !cbPackedGetVarint(decoder, &shared)
+        || !cbPackedGetVarint(decoder, &suffixLength)
+        || shared > (uint64_t)(prev.end - prev.begin)
+        || suffixLength > (uint64_t)(decoder->end - decoder->rest)
+        || memchr(decoder->rest, '\0', suffixLength) != NULL
+        || !cbReserve((void **)&decoder->text, &decoder->textCapacity, shared + suffixLength + 1, 1)
+    )
+        return false;
+
+    memcpy(decoder->text, prev.begin, shared);
+    memcpy(decoder->text + shared, decoder->rest, suffixLength);
+    decoder->rest += suffixLength;
+
+    *dst = (CbStr) { decoder->text, decoder->text + shared + suffixLength };
+
+    return true;
+} // cbPackedGetText
+
+/**
+ * @brief next node decoding function
+ * 
+ * @param[in,out] decoder decoder (non-null)
+ * @param[in,out] self    cactusbot to allocate node in (non-null)
+ * 
+ * @return decoded node (not linked and not indexed), NULL if decoding or allocation failed
+ */
+static CbNode * cbPackedGetNode( CbPackedDecoder *const decoder, CbImpl *const self ) {
+    if (decoder->blockNodeIndex == decoder->blockNodeCount) {
+        // previous block must be decoded completely
+        if (decoder->rest != decoder->end || !cbPackedReadBlock(decoder))
+            return NULL;
+    }
+
+    const size_t index = decoder->blockNodeIndex++;
+    CbStr text;
+    CbNode *node = NULL;
+
+    if ((decoder->bits[index / 8] >> (index % 8) & 1) == 0) {
+        if (!cbPackedGetText(decoder, decoder->prevLeaf, &text) || (node = cbAllocNode(self->arena, text)) == NULL)
+            return NULL;
+
+        node->isLeaf = true;
+        decoder->prevLeaf = (CbStr) { node->text, node->text + (text.end - text.begin) };
+
+        return node;
+    }
+
+    uint64_t reference = 0;
+
+    if (!cbPackedGetVarint(decoder, &reference) || reference > decoder->questionCount)
+        return NULL;
+
+    // repeated question text is already interned
+    if (reference != 0) {
+        if ((node = (CbNode *)cbArenaAlloc(self->arena, sizeof(CbNode))) == NULL)
+            return NULL;
+
+        node->text = decoder->questions[reference - 1].text;
+        node->hash = decoder->questions[reference - 1].hash;
+
+        return node;
+    }
+
+    CbPoolStr str;
+
+    if (false
+        || !cbPackedGetText(decoder, decoder->prevQuestion, &text)
+        || !cbStrPoolIntern(self->textPool, text.begin, text.end - text.begin, &str)
+        || (node = (CbNode *)cbArenaAlloc(self->arena, sizeof(CbNode))) == NULL
+        || !cbReserve((void **)&decoder->questions, &decoder->questionCapacity, decoder->questionCount + 1, sizeof(CbPoolStr))
+    )
+        return NULL;
+
+    node->text = str.text;
+    node->hash = str.hash;
+
+    decoder->questions[decoder->questionCount++] = str;
+    decoder->prevQuestion = (CbStr) { str.text, str.text + (text.end - text.begin) };
+
+    return node;
+} // cbPackedGetNode
+
+/**
+ * @brief packed tree decoding function
+ * 
+ * @param[in,out] decoder decoder (non-null)
+ * @param[in,out] self    cactusbot with empty tree to decode tree into (non-null)
+ * 
+ * @return true if decoded, false if stream is corrupted or allocation failed
+ * 
+ * @note nodes are linked as cbParseNode does: unfinished interior nodes are tracked by parent links.
+ */
+static bool cbPackedDecode( CbPackedDecoder *const decoder, CbImpl *const self ) {
+    char magic[sizeof(CB_PACKED_MAGIC) - 1];
+    uint64_t nodeCount = 0;
+    size_t count = 0;
+    CbNode *current = NULL; // innermost not finished interior node
+
+    if (false
+        || !cbPackedRead(decoder, magic, sizeof(magic))
+        || memcmp(magic, CB_PACKED_MAGIC, sizeof(magic)) != 0
+        || !cbPackedRead(decoder, &nodeCount, sizeof(uint64_t))
+    )
+        return false;
+
+    do {
+        CbNode *const node = cbPackedGetNode(decoder, self);
+
+        if (node == NULL)
+            return false;
+
+        if (node->isLeaf) {
+            if (false
+                || cbLeafIndexFind(self, node->text, node->hash) != NULL
+                || !cbLeafIndexReserve(self)
+            )
+                return false;
+            cbLeafIndexInsert(self, node);
+        }
+
+        count++;
+
+        node->parent = current;
+        if (current == NULL)
+            self->treeRoot = node;
+        else if (current->interior.correct == NULL)
+            current->interior.correct = node;
+        else
+            current->interior.incorrect = node;
+
+        if (!node->isLeaf) {
+            current = node;
+            continue;
+        }
+
+        while (current != NULL && current->interior.incorrect != NULL)
+            current = current->parent;
+    } while (current != NULL);
+
+    self->treeSize = count;
+
+    return true
+        && count == nodeCount
+        && decoder->blockNodeIndex == decoder->blockNodeCount
+        && decoder->rest == decoder->end;
+} // cbPackedDecode
+
+bool cbParsePacked( const CbReadFunc read, void *const readContext, const CbLeafIndex leafIndex, Cb *const dst ) {
+    assert(read != NULL);
+    assert(dst != NULL);
+
+    CbImpl *const impl = cbAllocImpl(leafIndex);
+
+    if (impl == NULL)
+        return false;
+
+    CbPackedDecoder decoder = {
+        .read         = read,
+        .readContext  = readContext,
+        .prevQuestion = CB_STR(""),
+        .prevLeaf     = CB_STR(""),
+    };
+
+    const bool decoded = cbPackedDecode(&decoder, impl);
+
+    free(decoder.text);
+    free(decoder.questions);
+    free(decoder.payload);
+
+    if (!decoded) {
+        cbDtor(impl);
+        return false;
+    }
+
+    *dst = impl;
+
+    return true;
+} // cbParsePacked
+
+bool cbParsePackedFile( FILE *const file, const CbLeafIndex leafIndex, Cb *const dst ) {
+    assert(file != NULL);
+
+    return cbParsePacked(cbReadFile, file, leafIndex, dst);
+} // cbParsePackedFile
+
+/// @brief reader that gives back format detection prefix before the rest of input
+typedef struct __CbPrefixReader {
+    CbReadFunc read;                                ///< underlying reading function
+    void      *readContext;                         ///< underlying reading function context
+    char       prefix[sizeof(CB_PACKED_MAGIC) - 1]; ///< bytes read for detection
+    size_t     prefixSize;                          ///< count of bytes read for detection
+    size_t     prefixOffset;                        ///< count of prefix bytes already given back
+} CbPrefixReader;
+
+/**
+ * @brief prefix replaying reading function (CbReadFunc implementation for cbParseDetect)
+ * 
+ * @param[in,out] context prefix reader pointer
+ * @param[out]    buffer  reading destination
+ * @param[in]     size    buffer size
+ * 
+ * @return count of bytes read
+ */
+static size_t cbReadPrefixed( void *const context, char *const buffer, const size_t size ) {
+    CbPrefixReader *const reader = (CbPrefixReader *)context;
+
+    if (reader->prefixOffset == reader->prefixSize)
+        return reader->read(reader->readContext, buffer, size);
+
+    const size_t rest = reader->prefixSize - reader->prefixOffset;
+    const size_t count = rest < size ? rest : size;
+
+    memcpy(buffer, reader->prefix + reader->prefixOffset, count);
+    reader->prefixOffset += count;
+
+    return count;
+} // cbReadPrefixed
+
+bool cbParseDetect( const CbReadFunc read, void *const readContext, const CbLeafIndex leafIndex, Cb *const dst ) {
+    assert(read != NULL);
+    assert(dst != NULL);
+
+    CbPrefixReader reader = {
+        .read         = read,
+        .readContext  = readContext,
+        .prefixSize   = 0,
+        .prefixOffset = 0,
+    };
+
+    // input may be pipe, so detection bytes are given back to parser instead of seeking
+    while (reader.prefixSize < sizeof(reader.prefix)) {
+        const size_t count = read(readContext, reader.prefix + reader.prefixSize, sizeof(reader.prefix) - reader.prefixSize);
+
+        if (count == 0)
+            break;
+        reader.prefixSize += count;
+    }
+
+    const bool isPacked = true
+        && reader.prefixSize == sizeof(reader.prefix)
+        && memcmp(reader.prefix, CB_PACKED_MAGIC, sizeof(reader.prefix)) == 0;
+
+    return isPacked
+        ? cbParsePacked(cbReadPrefixed, &reader, leafIndex, dst)
+        : cbParseStream(cbReadPrefixed, &reader, leafIndex, dst);
+} // cbParseDetect
+
+bool cbParseDetectFile( FILE *const file, const CbLeafIndex leafIndex, Cb *const dst ) {
+    assert(file != NULL);
+
+    return cbParseDetect(cbReadFile, file, leafIndex, dst);
+} // cbParseDetectFile
+
+/// @brief minimal size of text (in bytes) parsed by single parallel parsing task
+#define CB_PARSE_TASK_MIN_SIZE ((size_t)16384)
+
+/// @brief count of parallel parsing tasks per thread (more tasks balance load better)
+#define CB_PARSE_TASKS_PER_THREAD ((size_t)8)
+
+/// @brief 'no skeleton node' index
+#define CB_PARSE_NONE SIZE_MAX
+
+/// @brief closed subtree found by structural pass
+typedef struct __CbParseSpan {
+    const char *begin;    ///< subtree text begin
+    const char *end;      ///< subtree text end
+    size_t      skeleton; ///< skeleton node index, CB_PARSE_NONE if subtree is small enough to be parsed by task
+} CbParseSpan;
+
+/// @brief structural pass stack frame (not yet closed interior node)
+typedef struct __CbParseFrame {
+    const char  *begin;       ///< node text begin
+    CbStr        question;    ///< question text
+    CbParseSpan  children[2]; ///< closed children
+    size_t       childCount;  ///< count of closed children
+} CbParseFrame;
+
+/// @brief skeleton node child kind
+typedef enum __CbParseRefType {
+    CB_PARSE_REF_SKELETON, ///< skeleton node
+    CB_PARSE_REF_TASK,     ///< task subtree
+    CB_PARSE_REF_LEAF,     ///< leaf (built by calling thread, as task for single leaf costs more than leaf itself)
+} CbParseRefType;
+
+/// @brief skeleton node child reference
+typedef struct __CbParseRef {
+    CbParseRefType type;  ///< child kind
+    size_t         index; ///< skeleton node, task or leaf index
+} CbParseRef;
+
+/// @brief skeleton node (interior node with too large subtree, built by calling thread)
+typedef struct __CbParseSkeleton {
+    CbStr       question;    ///< question text
+    CbParseRef  children[2]; ///< correct and incorrect children
+    CbNode     *node;        ///< built node
+} CbParseSkeleton;
+
+/// @brief independent subtree parsing task
+typedef struct __CbParseTask {
+    CbStr    text;         ///< subtree text
+    size_t   worker;       ///< index of worker task is parsed by
+    CbNode  *root;         ///< parsed subtree root
+    size_t   nodeCount;    ///< count of parsed nodes, 0 if parsing failed
+    bool     isLinked;     ///< true if subtree texts are moved to main text pool and leaves are collected
+    CbNode **leaves;       ///< subtree leaves in preorder
+    size_t   leafCount;    ///< count of leaves
+    size_t   leafCapacity; ///< leaf array capacity
+} CbParseTask;
+
+/// @brief parallel parsing plan (structural pass result)
+typedef struct __CbParsePlan {
+    CbParseSkeleton *skeletons;        ///< skeleton nodes (in postorder)
+    size_t           skeletonCount;    ///< count of skeleton nodes
+    size_t           skeletonCapacity; ///< skeleton node array capacity
+    CbParseTask     *tasks;            ///< subtree parsing tasks
+    size_t           taskCount;        ///< count of tasks
+    size_t           taskCapacity;     ///< task array capacity
+    CbStr           *leaves;           ///< skeleton node leaf children texts
+    CbNode         **leafNodes;        ///< skeleton node leaf children (built by stitching)
+    size_t           leafCount;        ///< count of skeleton node leaf children
+    size_t           leafCapacity;     ///< leaf array capacity
+    size_t           root;             ///< root skeleton node index, CB_PARSE_NONE if whole text is single task
+} CbParsePlan;
+
+/// @brief parallel parsing worker forward declaration
+typedef struct __CbParseWorker CbParseWorker;
+
+/// @brief parallel parsing state shared by workers
+typedef struct __CbParseShared {
+    CbParsePlan   *plan;      ///< parsing plan
+    CbParseWorker *workers;   ///< workers
+    size_t         nextTask;  ///< index of next not taken task (atomic)
+    bool           isLinking; ///< false while tasks are parsed, true while they're linked
+} CbParseShared;
+
+/// @brief parallel parsing worker
+struct __CbParseWorker {
+    CbParseShared  *shared;    ///< shared state
+    size_t          index;     ///< worker index
+    CbImpl          scratch;   ///< worker arena and text pool holder (leaf index isn't used)
+    const char    **textMap;   ///< worker pool text index to main pool text map
+    pthread_t       thread;    ///< worker thread
+    bool            isStarted; ///< true if thread is started
+}; // struct __CbParseWorker
+
+/**
+ * @brief parsing plan destructor
+ * 
+ * @param[in,out] plan plan to destroy (non-null)
+ */
+static void cbParsePlanDtor( CbParsePlan *const plan ) {
+    for (size_t i = 0; i < plan->taskCount; i++)
+        free(plan->tasks[i].leaves);
+    free(plan->tasks);
+    free(plan->skeletons);
+    free(plan->leaves);
+    free(plan->leafNodes);
+} // cbParsePlanDtor
+
+/**
+ * @brief skeleton node adding function
+ * 
+ * @param[in,out] plan  plan (non-null)
+ * @param[in]     frame closed interior node frame (non-null, both children are closed)
+ * @param[out]    dst   new skeleton node index destination (non-null)
+ * 
+ * @return true if added, false if allocation failed
+ * 
+ * @note children that aren't skeleton nodes or leaves become tasks.
+ */
+static bool cbParsePlanAddSkeleton( CbParsePlan *const plan, const CbParseFrame *const frame, size_t *const dst ) {
+    if (false
+        || !cbReserve((void **)&plan->skeletons, &plan->skeletonCapacity, plan->skeletonCount + 1, sizeof(CbParseSkeleton))
+        || !cbReserve((void **)&plan->tasks, &plan->taskCapacity, plan->taskCount + 2, sizeof(CbParseTask))
+        || !cbReserve((void **)&plan->leaves, &plan->leafCapacity, plan->leafCount + 2, sizeof(CbStr))
+    )
+        return false;
+
+    CbParseSkeleton *const skeleton = &plan->skeletons[plan->skeletonCount];
+
+    skeleton->question = frame->question;
+    skeleton->node = NULL;
+
+    for (size_t i = 0; i < 2; i++) {
+        const CbParseSpan *const child = &frame->children[i];
+
+        if (child->skeleton != CB_PARSE_NONE) {
+            skeleton->children[i] = (CbParseRef) { CB_PARSE_REF_SKELETON, child->skeleton };
+        } else if (*child->begin == '\"') {
+            // span includes quotes
+            plan->leaves[plan->leafCount] = (CbStr) { child->begin + 1, child->end - 1 };
+            skeleton->children[i] = (CbParseRef) { CB_PARSE_REF_LEAF, plan->leafCount++ };
+        } else {
+            memset(&plan->tasks[plan->taskCount], 0, sizeof(CbParseTask));
+            plan->tasks[plan->taskCount].text = (CbStr) { child->begin, child->end };
+            skeleton->children[i] = (CbParseRef) { CB_PARSE_REF_TASK, plan->taskCount++ };
+        }
+    }
+
+    *dst = plan->skeletonCount++;
+
+    return true;
+} // cbParsePlanAddSkeleton
+
+/**
+ * @brief structural pass function
+ * 
+ * @param[in]  text     text to split (subtree is one node)
+ * @param[in]  taskSize maximal size of task subtree text
+ * @param[out] plan     parsing plan destination (non-null, zeroed)
+ * 
+ * @return true if text contains tree, false if it's invalid or allocation failed
+ * 
+ * @note interior nodes with subtree text larger than taskSize become skeleton nodes, their other children become tasks.
+ *       nodes aren't allocated, so pass is as fast as tokenization.
+ */
+static bool cbParsePlanBuild( CbStr text, const size_t taskSize, CbParsePlan *const plan ) {
+    CbParseFrame *frames = NULL;
+    size_t frameCount = 0;
+    size_t frameCapacity = 0;
+    bool ok = true;
+
+    plan->root = CB_PARSE_NONE;
+
+    while (ok) {
+        const char *const tokenBegin = cbScanSpaces(text.begin, text.end);
+        CbToken token = {};
+        CbParseSpan closed = {};
+
+        if (!cbNextToken(&text, &token)) {
+            ok = false;
+            break;
+        }
+
+        if (token.type == CB_TOKEN_LEFT_BRACKET) {
+            CbToken questionToken = {};
+
+            ok = true
+                && cbNextToken(&text, &questionToken)
+                && questionToken.type == CB_TOKEN_STRING
+                && cbReserve((void **)&frames, &frameCapacity, frameCount + 1, sizeof(CbParseFrame));
+
+            if (ok)
+                frames[frameCount++] = (CbParseFrame) { tokenBegin, questionToken.string, {}, 0 };
+            continue;
+        }
+
+        if (token.type == CB_TOKEN_RIGHT_BRACKET) {
+            if (frameCount == 0 || frames[frameCount - 1].childCount != 2) {
+                ok = false;
+                break;
+            }
+
+            const CbParseFrame *const frame = &frames[--frameCount];
+
+            closed = (CbParseSpan) { frame->begin, text.begin, CB_PARSE_NONE };
+
+            if ((size_t)(closed.end - closed.begin) > taskSize)
+                ok = cbParsePlanAddSkeleton(plan, frame, &closed.skeleton);
+        } else {
+            closed = (CbParseSpan) { tokenBegin, text.begin, CB_PARSE_NONE };
+        }
+
+        // text after root is ignored, as cbParse does
+        if (frameCount == 0) {
+            plan->root = closed.skeleton;
+            break;
+        }
+
+        CbParseFrame *const parent = &frames[frameCount - 1];
+
+        if (parent->childCount == 2) {
+            ok = false;
+            break;
+        }
+
+        parent->children[parent->childCount++] = closed;
+    }
+
+    free(frames);
+
+    return ok;
+} // cbParsePlanBuild
+
+/**
+ * @brief parsed task linking function
+ * 
+ * @param[in]     shared shared parsing state (non-null, all tasks are parsed and worker text maps are built)
+ * @param[in,out] task   task to link (non-null)
+ * 
+ * @return true if linked, false if allocation failed
+ */
+static bool cbParseLinkTask( const CbParseShared *const shared, CbParseTask *const task ) {
+    const CbParseWorker *const worker = &shared->workers[task->worker];
+
+    for (CbNode *node = task->root; node != NULL; node = (CbNode *)cbNodeNextPreorder(node, task->root, NULL)) {
+        if (node->isLeaf) {
+            if (!cbReserve((void **)&task->leaves, &task->leafCapacity, task->leafCount + 1, sizeof(CbNode *)))
+                return false;
+            task->leaves[task->leafCount++] = node;
+            continue;
+        }
+
+        // question is interned into main pool, so it has to be equal to texts of other workers
+        CbPoolStr str;
+
+        if (!cbStrPoolFind(worker->scratch.textPool, node->text, strlen(node->text), &str))
+            return false;
+        node->text = worker->textMap[str.index];
+    }
+
+    return true;
+} // cbParseLinkTask
+
+/**
+ * @brief parallel parsing worker function
+ * 
+ * @param[in,out] worker worker (non-null)
+ * 
+ * @note tasks are taken dynamically, so worker that failed to start is just replaced by other ones.
+ */
+static void cbParseWork( CbParseWorker *const worker ) {
+    CbParseShared *const shared = worker->shared;
+    CbParsePlan *const plan = shared->plan;
+
+    for (;;) {
+        const size_t index = __atomic_fetch_add(&shared->nextTask, 1, __ATOMIC_RELAXED);
+
+        if (index >= plan->taskCount)
+            break;
+
+        CbParseTask *const task = &plan->tasks[index];
+
+        if (shared->isLinking) {
+            task->isLinked = cbParseLinkTask(shared, task);
+            continue;
+        }
+
+        CbTokenizer tokenizer = {
+            .rest           = task->text,
+            .read           = NULL,
+            .readContext    = NULL,
+            .buffer         = NULL,
+            .bufferCapacity = 0,
+            .readFinished   = true,
+        };
+
+        task->worker = worker->index;
+        task->nodeCount = cbParseNode(&tokenizer, &worker->scratch, false, &task->root);
+    }
+} // cbParseWork
+
+/**
+ * @brief parallel parsing thread function
+ * 
+ * @param[in,out] context worker (CbParseWorker *)
+ * 
+ * @return NULL
+ */
+static void * cbParseThread( void *context ) {
+    cbParseWork((CbParseWorker *)context);
+    return NULL;
+} // cbParseThread
+
+/**
+ * @brief parallel parsing phase running function
+ * 
+ * @param[in,out] shared      shared parsing state (non-null)
+ * @param[in]     workerCount count of workers
+ */
+static void cbParseRunPhase( CbParseShared *const shared, const size_t workerCount ) {
+    shared->nextTask = 0;
+
+    // first worker is calling thread
+    for (size_t i = 1; i < workerCount; i++)
+        shared->workers[i].isStarted = pthread_create(&shared->workers[i].thread, NULL, cbParseThread, &shared->workers[i]) == 0;
+
+    cbParseWork(&shared->workers[0]);
+
+    for (size_t i = 1; i < workerCount; i++)
+        if (shared->workers[i].isStarted)
+            pthread_join(shared->workers[i].thread, NULL);
+} // cbParseRunPhase
+
+/**
+ * @brief skeleton building and task subtree attaching function
+ * 
+ * @param[in,out] self cactusbot with empty tree (non-null)
+ * @param[in,out] plan parsing plan with linked tasks (non-null)
+ * 
+ * @return true if succeeded, false if some leaf is duplicated or allocation failed
+ */
+static bool cbParseStitch( CbImpl *const self, CbParsePlan *const plan ) {
+    for (size_t i = 0; i < plan->skeletonCount; i++)
+        if ((plan->skeletons[i].node = cbAllocQuestionNode(self->arena, self->textPool, plan->skeletons[i].question)) == NULL)
+            return false;
+
+    if (plan->leafCount != 0 && (plan->leafNodes = (CbNode **)calloc(plan->leafCount, sizeof(CbNode *))) == NULL)
+        return false;
+
+    for (size_t i = 0; i < plan->leafCount; i++) {
+        if ((plan->leafNodes[i] = cbAllocNode(self->arena, plan->leaves[i])) == NULL)
+            return false;
+        plan->leafNodes[i]->isLeaf = true;
+    }
+
+    self->treeSize = plan->skeletonCount + plan->leafCount;
+
+    for (size_t i = 0; i < plan->taskCount; i++)
+        self->treeSize += plan->tasks[i].nodeCount;
+
+    for (size_t i = 0; i < plan->skeletonCount; i++) {
+        CbNode *const node = plan->skeletons[i].node;
+        CbNode *children[2];
+
+        for (size_t j = 0; j < 2; j++) {
+            const CbParseRef ref = plan->skeletons[i].children[j];
+
+            if (ref.type == CB_PARSE_REF_SKELETON)
+                children[j] = plan->skeletons[ref.index].node;
+            else if (ref.type == CB_PARSE_REF_TASK)
+                children[j] = plan->tasks[ref.index].root;
+            else
+                children[j] = plan->leafNodes[ref.index];
+            children[j]->parent = node;
+        }
+
+        node->interior.correct = children[0];
+        node->interior.incorrect = children[1];
+    }
+
+    self->treeRoot = plan->skeletons[plan->root].node;
+
+    // leaves are indexed in preorder, as serial parser does, so leaf index is the same
+    CbParseRef *stack = NULL;
+    size_t stackCapacity = 0;
+    size_t stackSize = 0;
+    bool ok = cbReserve((void **)&stack, &stackCapacity, 1, sizeof(CbParseRef));
+
+    if (ok)
+        stack[stackSize++] = (CbParseRef) { CB_PARSE_REF_SKELETON, plan->root };
+
+    while (ok && stackSize > 0) {
+        const CbParseRef ref = stack[--stackSize];
+
+        if (ref.type == CB_PARSE_REF_SKELETON) {
+            ok = cbReserve((void **)&stack, &stackCapacity, stackSize + 2, sizeof(CbParseRef));
+            if (ok) {
+                stack[stackSize++] = plan->skeletons[ref.index].children[1];
+                stack[stackSize++] = plan->skeletons[ref.index].children[0];
+            }
+            continue;
+        }
+
+        // single leaf is handled as task with one leaf
+        CbNode *const *const leaves = ref.type == CB_PARSE_REF_TASK
+            ? plan->tasks[ref.index].leaves
+            : &plan->leafNodes[ref.index];
+        const size_t leafCount = ref.type == CB_PARSE_REF_TASK
+            ? plan->tasks[ref.index].leafCount
+            : 1;
+
+        for (size_t i = 0; ok && i < leafCount; i++) {
+            CbNode *const leaf = leaves[i];
+
+            ok = cbLeafIndexFind(self, leaf->text, leaf->hash) == NULL && cbLeafIndexReserve(self);
+            if (ok)
+                cbLeafIndexInsert(self, leaf);
+        }
+    }
+
+    free(stack);
+
+    return ok;
+} // cbParseStitch
+
+bool cbParseParallel( const char *const str, const CbLeafIndex leafIndex, size_t threadCount, Cb *const dst ) {
+    assert(str != NULL);
+    assert(dst != NULL);
+
+    const CbStr text = CB_STR(str);
+
+    if (threadCount < 1)
+        threadCount = 1;
+
+    size_t taskSize = (size_t)(text.end - text.begin) / (threadCount * CB_PARSE_TASKS_PER_THREAD);
+
+    if (taskSize < CB_PARSE_TASK_MIN_SIZE)
+        taskSize = CB_PARSE_TASK_MIN_SIZE;
+
+    CbParsePlan plan = {0};
+
+    // small trees (and invalid texts) are left to serial parser
+    if (threadCount == 1 || !cbParsePlanBuild(text, taskSize, &plan) || plan.root == CB_PARSE_NONE) {
+        cbParsePlanDtor(&plan);
+        return cbParse(str, leafIndex, dst);
+    }
+
+    // calling thread is always a worker, even if every subtree is built by it
+    const size_t workerCount = threadCount < plan.taskCount
+        ? threadCount
+        : plan.taskCount + (plan.taskCount == 0);
+
+    CbImpl *const impl = cbAllocImpl(leafIndex);
+    CbParseWorker *const workers = (CbParseWorker *)calloc(workerCount, sizeof(CbParseWorker));
+    CbParseShared shared = {
+        .plan      = &plan,
+        .workers   = workers,
+        .nextTask  = 0,
+        .isLinking = false,
+    };
+    bool ok = impl != NULL && workers != NULL;
+
+    for (size_t i = 0; ok && i < workerCount; i++) {
+        workers[i].shared = &shared;
+        workers[i].index = i;
+
+        ok = true
+            && (workers[i].scratch.arena = cbArenaCtor()) != NULL
+            && (workers[i].scratch.textPool = cbStrPoolCtor()) != NULL;
+    }
+
+    if (ok)
+        cbParseRunPhase(&shared, workerCount);
+
+    for (size_t i = 0; ok && i < plan.taskCount; i++)
+        ok = plan.tasks[i].nodeCount != 0;
+
+    // distinct texts of each worker are interned into main pool once
+    for (size_t i = 0; ok && i < workerCount; i++) {
+        CbStrPoolStat poolStat;
+
+        cbStrPoolGetStat(workers[i].scratch.textPool, &poolStat);
+
+        ok = poolStat.stringCount == 0
+            || (workers[i].textMap = (const char **)calloc(poolStat.stringCount, sizeof(const char *))) != NULL;
+
+        for (size_t j = 0; ok && j < poolStat.stringCount; j++) {
+            const char *const localText = cbStrPoolGet(workers[i].scratch.textPool, (uint32_t)j);
+            CbPoolStr mainStr;
+
+            if ((ok = cbStrPoolIntern(impl->textPool, localText, strlen(localText), &mainStr)))
+                workers[i].textMap[j] = mainStr.text;
+        }
+    }
+
+    if (ok) {
+        shared.isLinking = true;
+        cbParseRunPhase(&shared, workerCount);
+    }
+
+    for (size_t i = 0; ok && i < plan.taskCount; i++)
+        ok = plan.tasks[i].isLinked;
+
+    ok = ok && cbParseStitch(impl, &plan);
+
+    // worker nodes become part of main arena
+    for (size_t i = 0; workers != NULL && i < workerCount; i++) {
+        if (workers[i].scratch.arena != NULL) {
+            if (ok)
+                cbArenaAdopt(impl->arena, workers[i].scratch.arena);
+            else
+                cbArenaDtor(workers[i].scratch.arena);
+        }
+        cbStrPoolDtor(workers[i].scratch.textPool);
+        free(workers[i].textMap);
+    }
+
+    free(workers);
+    cbParsePlanDtor(&plan);
+
+    if (!ok) {
+        cbDtor(impl);
+        return false;
+    }
+
+    *dst = impl;
+
+    return true;
+} // cbParseParallel
+
+/**
+ * @brief subtree in dot format dumping function
+ * 
+ * @param[in,out] out  output file
+ * @param[in]     root subtree root
+ */
+static void cbDbgDumpNodeDot( FILE *out, const CbNode *const root ) {
+    for (const CbNode *node = root; node != NULL; node = cbNodeNextPreorder(node, root, NULL)) {
+        fprintf(out, "    node%016zX [label = \"{<location>location: 0x%016zX|<text>text: \\\"%s\\\"|<isLeaf> isLeaf: %s",
+            (size_t)node,
+            (size_t)node,
+            node->text,
+            node->isLeaf
+                ? "true"
+                : "false"
+        );
+
+        CbNodeStat stat;
+
+        if (cbNodeLoadStat(node, &stat)) {
+            if (node->isLeaf)
+                fprintf(out, "|<hits> hits: %llu", (unsigned long long)stat.visits);
+            else
+                fprintf(out, "|<visits> visits: %llu (T: %llu, F: %llu)",
+                    (unsigned long long)stat.visits,
+                    (unsigned long long)stat.correct,
+                    (unsigned long long)stat.incorrect
+                );
+        }
+
+        fprintf(out, "}\"];\n");
+
+        if (!node->isLeaf) {
+            fprintf(out, "    node%016zX -> node%016zX [label = \"T\"];\n", (size_t)node, (size_t)node->interior.correct);
+            fprintf(out, "    node%016zX -> node%016zX [label = \"F\"];\n", (size_t)node, (size_t)node->interior.incorrect);
+        }
+
+        fprintf(out, "    node%016zX -> node%016zX [color = \"#00FF00\"]\n", (size_t)node, (size_t)node->parent);
+    }
+} // cbDbgDumpNodeDot
+
+void cbDbgDumpDot( FILE *out, const Cb self ) {
+    fprintf(out, "digraph {\n");
+    fprintf(out, "    node [shape = record];\n");
+    fprintf(out, "    nodeStat [label = \"{<treeSize>tree size: %zu|<leafTreeSize>leaf tree size: %zu}\"];\n", self->treeSize, self->leafTreeSize);
+    cbDbgDumpNodeDot(out, self->treeRoot);
+    fprintf(out, "}");
+} // cbDbgDumpDot
+
+/**
+ * @brief leaf tree in dot format dumping function
+ * 
+ * @param[in,out] out  output file
+ * @param[in]     root leaf tree root (non-null)
+ */
+static void cbDbgLeafTreeNodeDumpDot( FILE *const out, const CbNode *const root ) {
+    assert(root != NULL);
+
+    const CbNode *stack[CB_LEAF_TREE_STACK_SIZE];
+    size_t stackSize = 0;
+
+    stack[stackSize++] = root;
+
+    while (stackSize > 0) {
+        const CbNode *const node = stack[--stackSize];
+
+        assert(node->isLeaf);
+
+        fprintf(out, "    node%016zX [label = \"{<location>location: %016zX|<text>text: \\\"%s\\\"}\"];\n", (size_t)node, (size_t)node, node->text);
+
+        // stack size is bounded by twice tree height
+        if (node->leaf.right != NULL) {
+            assert(stackSize < CB_LEAF_TREE_STACK_SIZE);
+            stack[stackSize++] = node->leaf.right;
+            fprintf(out, "    node%016zX -> node%016zX [label = \"R\"];\n", (size_t)node->leaf.right, (size_t)node);
+        }
+
+        if (node->leaf.left != NULL) {
+            assert(stackSize < CB_LEAF_TREE_STACK_SIZE);
+            stack[stackSize++] = node->leaf.left;
+            fprintf(out, "    node%016zX -> node%016zX [label = \"L\"];\n", (size_t)node->leaf.left, (size_t)node);
+        }
+    }
+} // cbDbgLeafTreeNodeDumpDot
+
+void cbDbgLeafTreeDumpDot( FILE *out, const Cb self ) {
+    assert(self != NULL);
+
+    fprintf(out, "digraph {\n");
+    fprintf(out, "    node [shape = record];\n");
+    fprintf(out, "    nodeStat [label = \"{<treeSize>tree size: %zu|<leafTreeSize>leaf tree size: %zu}\"];\n", self->treeSize, self->leafTreeSize);
+    if (self->leafTreeRoot != NULL)
+        cbDbgLeafTreeNodeDumpDot(out, self->leafTreeRoot);
+    fprintf(out, "}");
+} // cbDbgLeafTreeDumpDot
+
+/**
+ * @brief definition iterator element setting function
+ * 
+ * @param[out] iter    iterator to set element of (non-null)
+ * @param[in]  element element (non-null)
+ * 
+ * @note element parent and relation to it are loaded once and consistently, even if
+ * element is moved under new condition node concurrently: in this case its parent
+ * link is updated before parent child link, so parent link is loaded again.
+ */
+static void cbDefIterLoad( CbDefIter *const iter, const CbNode *const element ) {
+    iter->element = element;
+
+    for (;;) {
+        const CbNode *const parent = CB_LOAD_ACQUIRE(&element->parent);
+
+        iter->parent = parent;
+
+        if (parent == NULL) {
+            iter->isCorrect = false;
+            return;
+        }
+
+        if (CB_LOAD_ACQUIRE(&parent->interior.correct) == element) {
+            iter->isCorrect = true;
+            return;
+        }
+
+        if (CB_LOAD_ACQUIRE(&parent->interior.incorrect) == element) {
+            iter->isCorrect = false;
+            return;
+        }
+    }
+} // cbDefIterLoad
+
+/**
+ * @brief definition iterator relation from path getting function
+ * 
+ * @param[in,out] iter iterator with path and depth set (non-null)
+ */
+static void cbDefIterLoadPathRelation( CbDefIter *const iter ) {
+    const size_t index = iter->depth - 1;
+
+    iter->isCorrect = iter->depth > 0 && ((iter->path->bits[index / 64] >> (index % 64)) & 1);
+} // cbDefIterLoadPathRelation
+
+CbDefineStatus cbDefine( const Cb self, const char *subject, CbDefIter *dst ) {
+    const CbNode *node = cbLeafIndexFind(self, subject, cbHashStr(CB_STR(subject)));
+
+    if (node == NULL)
+        return CB_DEFINE_STATUS_NO_SUBJECT;
+
+    CbDefIter iter;
+
+    if (self->isPathCached) {
+        // relations are taken from path, so child links are never compared
+        iter.element = node;
+        iter.path = cbLeafLoadPath(node, &iter.parent);
+        iter.depth = iter.path->depth;
+        cbDefIterLoadPathRelation(&iter);
+    } else {
+        iter.path = NULL;
+        iter.depth = 0;
+        cbDefIterLoad(&iter, node);
+    }
+
+    if (dst != NULL)
+        *dst = iter;
+
+    return iter.parent == NULL
+        ? CB_DEFINE_STATUS_NO_DEFINITION
+        : CB_DEFINE_STATUS_OK;
+} // cbDefine
+
+const char * cbDefIterGetProperty( const CbDefIter *iter ) {
+    assert(iter != NULL);
+    assert(iter->element != NULL);
+    assert(iter->parent != NULL);
+
+    return iter->parent->text;
+} // cbDefIterGetProperty
+
+bool cbDefIterGetRelation( const CbDefIter *iter ) {
+    assert(iter != NULL);
+    assert(iter->element != NULL);
+    assert(iter->parent != NULL);
+
+    return iter->isCorrect;
+} // cbDefIterGetRelation
+
+bool cbDefIterNext( CbDefIter *iter ) {
+    assert(iter != NULL);
+    assert(iter->element != NULL);
+    assert(iter->parent != NULL);
+
+    if (iter->path != NULL) {
+        // interior node parent links never change
+        iter->element = iter->parent;
+        iter->parent = iter->element->parent;
+        iter->depth--;
+        cbDefIterLoadPathRelation(iter);
+    } else {
+        cbDefIterLoad(iter, iter->parent);
+    }
+
+    return iter->parent != NULL;
+} // cbDefIterNext
+
+/**
+ * @brief node pair lowest common ancestor finding function
+ * 
+ * @param[in]  index LCA index (nullable)
+ * @param[in]  lhs   first node (non-null)
+ * @param[in]  rhs   second node (non-null)
+ * @param[out] dst   comparison destination (non-null)
+ * 
+ * @return true if compared, false if some of nodes isn't indexed
+ */
+static bool cbLcaIndexCompare( const CbLcaIndex *const index, const CbNode *const lhs, const CbNode *const rhs, CbComparison *const dst ) {
+    size_t lhsPosition = 0;
+    size_t rhsPosition = 0;
+
+    if (index == NULL || !cbLcaIndexFind(index, lhs, &lhsPosition) || !cbLcaIndexFind(index, rhs, &rhsPosition))
+        return false;
+
+    const size_t position = lhsPosition < rhsPosition
+        ? cbLcaIndexQuery(index, lhsPosition, rhsPosition)
+        : cbLcaIndexQuery(index, rhsPosition, lhsPosition);
+    const CbNode *const ancestor = index->entries[position].node;
+
+    // correct subtree precedes node in order
+    dst->splitProperty = ancestor->text;
+    dst->lhsRelation = lhsPosition < position;
+
+    dst->common.path = NULL;
+    dst->common.depth = 0;
+    cbDefIterLoad(&dst->common, ancestor);
+    dst->hasCommon = dst->common.parent != NULL;
+
+    return true;
+} // cbLcaIndexCompare
+
+/**
+ * @brief interior node depth getting function
+ * 
+ * @param[in] node interior node (nullable)
+ * 
+ * @return count of node ancestors, 0 for null node
+ */
+static size_t cbParentDepth( const CbNode *node ) {
+    size_t depth = 0;
+
+    while (node != NULL && (node = CB_LOAD_ACQUIRE(&node->parent)) != NULL)
+        depth++;
+
+    return depth;
+} // cbParentDepth
+
+/**
+ * @brief node pair lowest common ancestor by parent links finding function
+ * 
+ * @param[in]  lhs first leaf (non-null)
+ * @param[in]  rhs second leaf (non-null, not lhs)
+ * @param[out] dst comparison destination (non-null)
+ * 
+ * @return true if compared, false if leaves have no common ancestor (some of them is removed by version switch)
+ * 
+ * @note takes O(depth), used for leaves inserted after LCA index is built, must be called under LCA index lock.
+ * insertion without versions changes only leaf parent link, so it's loaded once with relation. versioned
+ * insertion and version switch relink interior nodes too, but they do it under LCA index write lock.
+ */
+static bool cbParentCompare( const CbNode *const lhs, const CbNode *const rhs, CbComparison *const dst ) {
+    CbDefIter lhsIter;
+    CbDefIter rhsIter;
+
+    cbDefIterLoad(&lhsIter, lhs);
+    cbDefIterLoad(&rhsIter, rhs);
+
+    const CbNode *lhsChild = lhs;
+    const CbNode *lhsParent = lhsIter.parent;
+    bool lhsRelation = lhsIter.isCorrect;
+    const CbNode *rhsParent = rhsIter.parent;
+    size_t lhsDepth = cbParentDepth(lhsParent);
+    size_t rhsDepth = cbParentDepth(rhsParent);
+
+    if (lhsParent == NULL || rhsParent == NULL)
+        return false;
+
+    while (lhsDepth > rhsDepth) {
+        lhsChild = lhsParent;
+        lhsParent = CB_LOAD_ACQUIRE(&lhsParent->parent);
+        lhsRelation = CB_LOAD_ACQUIRE(&lhsParent->interior.correct) == lhsChild;
+        lhsDepth--;
+    }
+
+    while (rhsDepth > lhsDepth) {
+        rhsParent = CB_LOAD_ACQUIRE(&rhsParent->parent);
+        rhsDepth--;
+    }
+
+    // chains of equal depth reach roots together, so different roots mean different trees
+    while (lhsParent != rhsParent) {
+        if (lhsDepth == 0)
+            return false;
+
+        lhsChild = lhsParent;
+        lhsParent = CB_LOAD_ACQUIRE(&lhsParent->parent);
+        lhsRelation = CB_LOAD_ACQUIRE(&lhsParent->interior.correct) == lhsChild;
+        rhsParent = CB_LOAD_ACQUIRE(&rhsParent->parent);
+        lhsDepth--;
+    }
+
+    dst->splitProperty = lhsParent->text;
+    dst->lhsRelation = lhsRelation;
+
+    dst->common.path = NULL;
+    dst->common.depth = 0;
+    cbDefIterLoad(&dst->common, lhsParent);
+    dst->hasCommon = dst->common.parent != NULL;
+
+    return true;
+} // cbParentCompare
+
+CbCompareStatus cbCompare( const Cb self, const char *lhs, const char *rhs, CbComparison *dst ) {
+    assert(self != NULL);
+    assert(lhs != NULL);
+    assert(rhs != NULL);
+    assert(dst != NULL);
+
+    const CbNode *const lhsNode = cbLeafIndexFind(self, lhs, cbHashStr(CB_STR(lhs)));
+    const CbNode *const rhsNode = cbLeafIndexFind(self, rhs, cbHashStr(CB_STR(rhs)));
+
+    if (lhsNode == NULL || rhsNode == NULL)
+        return CB_COMPARE_STATUS_NO_SUBJECT;
+
+    if (lhsNode == rhsNode)
+        return CB_COMPARE_STATUS_SAME;
+
+    // insertions never change LCA of existing nodes, so index is rebuilt only if new leaf is compared
+    pthread_rwlock_rdlock(&self->lcaLock);
+    bool compared = cbLcaIndexCompare(self->lcaIndex, lhsNode, rhsNode, dst);
+    bool isRelated = true;
+    const bool isRebuildDue = false
+        || compared
+        || self->lcaIndex == NULL
+        || CB_COUNT_RELAXED(&self->lcaMissCount) >= self->lcaIndex->count / CB_LCA_MISS_RATIO;
+
+    // O(n) rebuild is paid once per O(n) missed comparisons, each of them takes O(depth)
+    if (!isRebuildDue) {
+        isRelated = cbParentCompare(lhsNode, rhsNode, dst);
+        compared = true;
+    }
+    pthread_rwlock_unlock(&self->lcaLock);
+
+    if (!compared) {
+        pthread_rwlock_wrlock(&self->lcaLock);
+
+        // index may be rebuilt by other thread while lock was released
+        if (!(compared = cbLcaIndexCompare(self->lcaIndex, lhsNode, rhsNode, dst))) {
+            CbLcaIndex *const index = cbLcaIndexCtor(CB_LOAD_ACQUIRE(&self->treeRoot));
+
+            if (index != NULL) {
+                cbLcaIndexDtor(self->lcaIndex);
+                self->lcaIndex = index;
+                self->lcaMissCount = 0;
+                compared = cbLcaIndexCompare(self->lcaIndex, lhsNode, rhsNode, dst);
+            }
+        }
+
+        // parent links don't need memory, so failed rebuild is postponed to next missed comparison
+        if (!compared)
+            isRelated = cbParentCompare(lhsNode, rhsNode, dst);
+
+        pthread_rwlock_unlock(&self->lcaLock);
+    }
+
+    return isRelated
+        ? CB_COMPARE_STATUS_OK
+        : CB_COMPARE_STATUS_NO_SUBJECT;
+} // cbCompare
+
+/// @brief optimizer known property
+typedef struct __CbOptimizeProperty {
+    uint32_t question; ///< question index
+    bool     answer;   ///< answer to question
+} CbOptimizeProperty;
+
+/// @brief optimizer leaf
+typedef struct __CbOptimizeLeaf {
+    CbNode *node;          ///< leaf node
+    CbNode *parent;        ///< new leaf parent
+    double  frequency;     ///< leaf hit frequency
+    size_t  depth;         ///< leaf depth before optimization
+    size_t  propertyBegin; ///< index of first known property (properties are sorted by question)
+    size_t  propertyCount; ///< count of known properties
+} CbOptimizeLeaf;
+
+/// @brief optimizer leaf by node searching element
+typedef struct __CbOptimizeLeafRef {
+    const CbNode *node;  ///< leaf node
+    size_t        index; ///< leaf index
+} CbOptimizeLeafRef;
+
+/// @brief optimizer subtree building task
+typedef struct __CbOptimizeTask {
+    size_t  begin;     ///< first leaf order index
+    size_t  end;       ///< last leaf order index (exclusive)
+    CbNode *parent;    ///< subtree parent (NULL for root)
+    bool    isCorrect; ///< true if subtree is correct child of parent
+    size_t  depth;     ///< subtree root depth
+} CbOptimizeTask;
+
+/// @brief optimizer state
+typedef struct __CbOptimizer {
+    CbOptimizeLeaf     *leaves;           ///< leaves
+    size_t              leafCount;        ///< count of leaves
+    size_t              leafCapacity;     ///< leaf array capacity
+    CbOptimizeProperty *properties;       ///< known properties of all leaves
+    size_t              propertyCount;    ///< count of properties
+    size_t              propertyCapacity; ///< property array capacity
+    const CbNode      **questions;        ///< question nodes (one per distinct text)
+    size_t              questionCount;    ///< count of questions
+    size_t              questionCapacity; ///< question array capacity
+    uint32_t           *questionTable;    ///< question by text open addressing table (index + 1, 0 for empty)
+    size_t              questionTableCapacity; ///< question table capacity (power of two)
+} CbOptimizer;
+
+/**
+ * @brief optimizer property comparison function (for qsort)
+ * 
+ * @param[in] lhs first property pointer
+ * @param[in] rhs second property pointer
+ * 
+ * @return comparison result (by question, then by answer)
+ */
+static int cbOptimizePropertyCompare( const void *lhs, const void *rhs ) {
+    const CbOptimizeProperty *const l = (const CbOptimizeProperty *)lhs;
+    const CbOptimizeProperty *const r = (const CbOptimizeProperty *)rhs;
+
+    if (l->question != r->question)
+        return l->question < r->question ? -1 : 1;
+    return (int)l->answer - (int)r->answer;
+} // cbOptimizePropertyCompare
+
+/**
+ * @brief optimizer leaf reference comparison function (for qsort and bsearch)
+ * 
+ * @param[in] lhs first reference pointer
+ * @param[in] rhs second reference pointer
+ * 
+ * @return comparison result (by node address)
+ */
+static int cbOptimizeLeafRefCompare( const void *lhs, const void *rhs ) {
+    const uintptr_t l = (uintptr_t)((const CbOptimizeLeafRef *)lhs)->node;
+    const uintptr_t r = (uintptr_t)((const CbOptimizeLeafRef *)rhs)->node;
+
+    return (l > r) - (l < r);
+} // cbOptimizeLeafRefCompare
+
+/**
+ * @brief question by node text interning function
+ * 
+ * @param[in,out] self optimizer (non-null)
+ * @param[in]     node interior node (non-null)
+ * 
+ * @return question index, UINT32_MAX if allocation failed
+ * 
+ * @note questions with same text are considered same property.
+ */
+static uint32_t cbOptimizeInternQuestion( CbOptimizer *const self, const CbNode *const node ) {
+    // keep load factor below 1/2
+    if ((self->questionCount + 1) * 2 > self->questionTableCapacity) {
+        const size_t capacity = self->questionTableCapacity == 0 ? 64 : self->questionTableCapacity * 2;
+        uint32_t *const table = (uint32_t *)calloc(capacity, sizeof(uint32_t));
+
+        if (table == NULL || self->questionCount >= UINT32_MAX - 1) {
+            free(table);
+            return UINT32_MAX;
+        }
+
+        for (size_t i = 0; i < self->questionCount; i++) {
+            size_t slot = self->questions[i]->hash & (capacity - 1);
+
+            while (table[slot] != 0)
+                slot = (slot + 1) & (capacity - 1);
+            table[slot] = (uint32_t)i + 1;
+        }
+
+        free(self->questionTable);
+        self->questionTable = table;
+        self->questionTableCapacity = capacity;
+    }
+
+    size_t slot = node->hash & (self->questionTableCapacity - 1);
+
+    while (self->questionTable[slot] != 0) {
+        const CbNode *const question = self->questions[self->questionTable[slot] - 1];
+
+        // question texts are interned, so equal texts are same pointers
+        if (question->text == node->text)
+            return self->questionTable[slot] - 1;
+        slot = (slot + 1) & (self->questionTableCapacity - 1);
+    }
+
+    if (!cbReserve((void **)&self->questions, &self->questionCapacity, self->questionCount + 1, sizeof(const CbNode *)))
+        return UINT32_MAX;
+
+    self->questions[self->questionCount] = node;
+    self->questionTable[slot] = (uint32_t)self->questionCount + 1;
+
+    return (uint32_t)self->questionCount++;
+} // cbOptimizeInternQuestion
+
+/**
+ * @brief leaf with known properties adding function
+ * 
+ * @param[in,out] self      optimizer (non-null)
+ * @param[in]     leaf      leaf node (non-null)
+ * @param[in]     questions questions on path to leaf (non-null if depth isn't 0)
+ * @param[in]     answers   answers on path to leaf (non-null if depth isn't 0)
+ * @param[in]     depth     leaf depth
+ * 
+ * @return true if added, false if allocation failed
+ */
+static bool cbOptimizeAddLeaf( CbOptimizer *const self, CbNode *const leaf, const uint32_t *const questions, const bool *const answers, const size_t depth ) {
+    if (false
+        || !cbReserve((void **)&self->leaves, &self->leafCapacity, self->leafCount + 1, sizeof(CbOptimizeLeaf))
+        || !cbReserve((void **)&self->properties, &self->propertyCapacity, self->propertyCount + depth, sizeof(CbOptimizeProperty))
+    )
+        return false;
+
+    CbOptimizeProperty *const properties = self->properties + self->propertyCount;
+
+    for (size_t i = 0; i < depth; i++)
+        properties[i] = (CbOptimizeProperty) { questions[i], answers[i] };
+
+    qsort(properties, depth, sizeof(CbOptimizeProperty), cbOptimizePropertyCompare);
+
+    // question asked on path several times is known only if all answers to it are same
+    size_t count = 0;
+
+    for (size_t i = 0; i < depth; ) {
+        size_t next = i + 1;
+
+        while (next < depth && properties[next].question == properties[i].question)
+            next++;
+
+        if (properties[i].answer == properties[next - 1].answer)
+            properties[count++] = properties[i];
+        i = next;
+    }
+
+    self->leaves[self->leafCount++] = (CbOptimizeLeaf) {
+        .node          = leaf,
+        .parent        = NULL,
+        .frequency     = 0.0,
+        .depth         = depth,
+        .propertyBegin = self->propertyCount,
+        .propertyCount = count,
+    };
+    self->propertyCount += count;
+
+    return true;
+} // cbOptimizeAddLeaf
+
+/**
+ * @brief leaves with known properties collecting function
+ * 
+ * @param[in,out] self optimizer (non-null, empty)
+ * @param[in]     root tree root (non-null)
+ * 
+ * @return true if succeeded, false if allocation failed
+ */
+static bool cbOptimizeCollect( CbOptimizer *const self, const CbNode *const root ) {
+    uint32_t *questions = NULL;
+    bool *answers = NULL;
+    size_t questionCapacity = 0;
+    size_t answerCapacity = 0;
+    size_t depth = 0;
+    bool ok = true;
+
+    for (const CbNode *node = root; ok && node != NULL; ) {
+        if (node->isLeaf) {
+            ok = cbOptimizeAddLeaf(self, (CbNode *)node, questions, answers, depth);
+        } else {
+            const uint32_t question = cbOptimizeInternQuestion(self, node);
+
+            ok = true
+                && question != UINT32_MAX
+                && cbReserve((void **)&questions, &questionCapacity, depth + 1, sizeof(uint32_t))
+                && cbReserve((void **)&answers, &answerCapacity, depth + 1, sizeof(bool));
+
+            if (ok)
+                questions[depth] = question;
+        }
+
+        if (!ok)
+            break;
+
+        size_t closed = 0;
+        const CbNode *const next = cbNodeNextPreorder(node, root, &closed);
+
+        if (next != NULL && !node->isLeaf) {
+            // interior node is followed by its correct child
+            answers[depth++] = true;
+        } else if (next != NULL) {
+            // leaf is followed by incorrect child of its 'closed'-th ancestor
+            depth -= closed;
+            answers[depth - 1] = false;
+        }
+
+        node = next;
+    }
+
+    free(answers);
+    free(questions);
+
+    return ok;
+} // cbOptimizeCollect
+
+/**
+ * @brief leaf known property answer getting function
+ * 
+ * @param[in]  self     optimizer (non-null)
+ * @param[in]  leaf     leaf (non-null)
+ * @param[in]  question question index
+ * @param[out] answer   answer destination (non-null)
+ * 
+ * @return true if leaf knows answer to question, false otherwise
+ */
+static bool cbOptimizeLeafAnswer( const CbOptimizer *const self, const CbOptimizeLeaf *const leaf, const uint32_t question, bool *const answer ) {
+    const CbOptimizeProperty *const properties = self->properties + leaf->propertyBegin;
+    size_t begin = 0;
+    size_t end = leaf->propertyCount;
+
+    while (begin < end) {
+        const size_t middle = begin + (end - begin) / 2;
+
+        if (properties[middle].question < question) {
+            begin = middle + 1;
+        } else if (properties[middle].question > question) {
+            end = middle;
+        } else {
+            *answer = properties[middle].answer;
+            return true;
+        }
+    }
+
+    return false;
+} // cbOptimizeLeafAnswer
+
+/**
+ * @brief leaf range splitting question choosing function
+ * 
+ * @param[in] self  optimizer (non-null)
+ * @param[in] order leaf indices (non-null)
+ * @param[in] begin first range element
+ * @param[in] end   last range element (exclusive, range contains at least two leaves)
+ * 
+ * @return question all range leaves know answer to, which splits range into two
+ * parts with the closest frequencies (and then counts), UINT32_MAX if there is no such question.
+ * 
+ * @note greedy weight balancing keeps expected depth close to frequency entropy,
+ * as top-down Huffman-like (Shannon-Fano) coding does.
+ */
+static uint32_t cbOptimizeChooseQuestion( const CbOptimizer *const self, const size_t *const order, const size_t begin, const size_t end ) {
+    // every suitable question is known by leaf with fewest known properties
+    const CbOptimizeLeaf *shortest = &self->leaves[order[begin]];
+
+    for (size_t i = begin + 1; i < end; i++)
+        if (self->leaves[order[i]].propertyCount < shortest->propertyCount)
+            shortest = &self->leaves[order[i]];
+
+    uint32_t best = UINT32_MAX;
+    double bestFrequencyDifference = 0.0;
+    size_t bestCountDifference = 0;
+
+    for (size_t p = 0; p < shortest->propertyCount; p++) {
+        const uint32_t question = self->properties[shortest->propertyBegin + p].question;
+        double frequencies[2] = {0.0, 0.0};
+        size_t counts[2] = {0, 0};
+        bool isKnown = true;
+
+        for (size_t i = begin; isKnown && i < end; i++) {
+            const CbOptimizeLeaf *const leaf = &self->leaves[order[i]];
+            bool answer = false;
+
+            isKnown = cbOptimizeLeafAnswer(self, leaf, question, &answer);
+            frequencies[answer] += leaf->frequency;
+            counts[answer]++;
+        }
+
+        if (!isKnown || counts[0] == 0 || counts[1] == 0)
+            continue;
+
+        const double frequencyDifference = frequencies[1] > frequencies[0] ? frequencies[1] - frequencies[0] : frequencies[0] - frequencies[1];
+        const size_t countDifference = counts[1] > counts[0] ? counts[1] - counts[0] : counts[0] - counts[1];
+
+        if (false
+            || best == UINT32_MAX
+            || frequencyDifference < bestFrequencyDifference
+            || (frequencyDifference == bestFrequencyDifference && countDifference < bestCountDifference)
+        ) {
+            best = question;
+            bestFrequencyDifference = frequencyDifference;
+            bestCountDifference = countDifference;
+        }
+    }
+
+    return best;
+} // cbOptimizeChooseQuestion
+
+/**
+ * @brief leaf depth statistics computation function
+ * 
+ * @param[in]  self   optimizer (non-null)
+ * @param[in]  depths leaf depths (non-null)
+ * @param[out] dst    statistics destination (nullable)
+ */
+static void cbOptimizeGetStat( const CbOptimizer *const self, const size_t *const depths, CbDepthStat *const dst ) {
+    if (dst == NULL)
+        return;
+
+    double depthSum = 0.0;
+    double weightedDepthSum = 0.0;
+    double frequencySum = 0.0;
+
+    dst->maxDepth = 0;
+
+    for (size_t i = 0; i < self->leafCount; i++) {
+        depthSum += (double)depths[i];
+        weightedDepthSum += (double)depths[i] * self->leaves[i].frequency;
+        frequencySum += self->leaves[i].frequency;
+
+        if (depths[i] > dst->maxDepth)
+            dst->maxDepth = depths[i];
+    }
+
+    dst->averageDepth = depthSum / (double)self->leafCount;
+    dst->expectedDepth = frequencySum > 0.0
+        ? weightedDepthSum / frequencySum
+        : dst->averageDepth;
+} // cbOptimizeGetStat
+
+/**
+ * @brief optimized tree building function
+ * 
+ * @param[in,out] self      optimizer (non-null)
+ * @param[in,out] arena     arena to allocate interior nodes in (non-null)
+ * @param[out]    order     leaf index array to reorder (non-null, contains all leaf indices)
+ * @param[out]    depths    new leaf depths (non-null)
+ * @param[out]    root      new root destination (non-null)
+ * @param[in]     isCounted true if interior nodes should get visit counters
+ * 
+ * @return true if built, false if allocation failed or some leaves can't be distinguished by known properties
+ * 
+ * @note leaf nodes aren't changed, their new parents are stored in optimizer.
+ */
+static bool cbOptimizeBuild( CbOptimizer *const self, CbArena arena, size_t *const order, size_t *const depths, CbNode **const root, const bool isCounted ) {
+    CbOptimizeTask *tasks = NULL;
+    size_t taskCapacity = 0;
+    size_t taskCount = 0;
+
+    bool ok = cbReserve((void **)&tasks, &taskCapacity, 1, sizeof(CbOptimizeTask));
+
+    if (ok)
+        tasks[taskCount++] = (CbOptimizeTask) { 0, self->leafCount, NULL, false, 0 };
+
+    while (ok && taskCount > 0) {
+        const CbOptimizeTask task = tasks[--taskCount];
+        CbNode *node = NULL;
+
+        if (task.end - task.begin == 1) {
+            CbOptimizeLeaf *const leaf = &self->leaves[order[task.begin]];
+
+            leaf->parent = task.parent;
+            depths[order[task.begin]] = task.depth;
+            node = leaf->node;
+        } else {
+            const uint32_t question = cbOptimizeChooseQuestion(self, order, task.begin, task.end);
+
+            if (false
+                || question == UINT32_MAX
+                || (node = (CbNode *)cbArenaAlloc(arena, sizeof(CbNode))) == NULL
+                || (isCounted && (node->stat = (CbNodeStat *)cbArenaAlloc(arena, sizeof(CbNodeStat))) == NULL)
+                || !cbReserve((void **)&tasks, &taskCapacity, taskCount + 2, sizeof(CbOptimizeTask))
+            ) {
+                ok = false;
+                break;
+            }
+
+            // question text is already interned
+            node->text = self->questions[question]->text;
+            node->hash = self->questions[question]->hash;
+            node->parent = task.parent;
+
+            // leaves satisfying question go first
+            size_t middle = task.begin;
+
+            for (size_t i = task.begin; i < task.end; i++) {
+                bool answer = false;
+
+                cbOptimizeLeafAnswer(self, &self->leaves[order[i]], question, &answer);
+
+                if (answer) {
+                    const size_t index = order[i];
+
+                    order[i] = order[middle];
+                    order[middle++] = index;
+                }
+            }
+
+            tasks[taskCount++] = (CbOptimizeTask) { middle, task.end, node, false, task.depth + 1 };
+            tasks[taskCount++] = (CbOptimizeTask) { task.begin, middle, node, true, task.depth + 1 };
+        }
+
+        if (task.parent == NULL)
+            *root = node;
+        else if (task.isCorrect)
+            task.parent->interior.correct = node;
+        else
+            task.parent->interior.incorrect = node;
+    }
+
+    free(tasks);
+
+    return ok;
+} // cbOptimizeBuild
+
+/**
+ * @brief optimizer destructor
+ * 
+ * @param[in,out] self optimizer to free contents of (non-null)
+ */
+static void cbOptimizerDtor( CbOptimizer *const self ) {
+    free(self->questionTable);
+    free(self->questions);
+    free(self->properties);
+    free(self->leaves);
+} // cbOptimizerDtor
+
+bool cbOptimize( Cb self, const CbLeafFrequency *frequencies, size_t frequencyCount, CbDepthStat *before, CbDepthStat *after ) {
+    assert(self != NULL);
+    assert(frequencyCount == 0 || frequencies != NULL);
+
+    CbOptimizer optimizer = {0};
+    CbOptimizeLeafRef *refs = NULL;
+    size_t *order = NULL;
+    size_t *depths = NULL;
+
+    if (false
+        || !cbOptimizeCollect(&optimizer, self->treeRoot)
+        || (refs = (CbOptimizeLeafRef *)calloc(optimizer.leafCount, sizeof(CbOptimizeLeafRef))) == NULL
+        || (order = (size_t *)calloc(optimizer.leafCount, sizeof(size_t))) == NULL
+        || (depths = (size_t *)calloc(optimizer.leafCount, sizeof(size_t))) == NULL
+    ) {
+        free(depths);
+        free(order);
+        free(refs);
+        cbOptimizerDtor(&optimizer);
+        return false;
+    }
+
+    // frequencies are matched with leaves by node addresses
+    for (size_t i = 0; i < optimizer.leafCount; i++)
+        refs[i] = (CbOptimizeLeafRef) { optimizer.leaves[i].node, i };
+    qsort(refs, optimizer.leafCount, sizeof(CbOptimizeLeafRef), cbOptimizeLeafRefCompare);
+
+    for (size_t i = 0; i < frequencyCount; i++) {
+        const CbOptimizeLeafRef key = { cbLeafIndexFind(self, frequencies[i].name, cbHashStr(CB_STR(frequencies[i].name))), 0 };
+        const CbOptimizeLeafRef *const ref = key.node == NULL
+            ? NULL
+            : (const CbOptimizeLeafRef *)bsearch(&key, refs, optimizer.leafCount, sizeof(CbOptimizeLeafRef), cbOptimizeLeafRefCompare);
+
+        if (ref != NULL)
+            optimizer.leaves[ref->index].frequency += frequencies[i].frequency;
+    }
+
+    for (size_t i = 0; i < optimizer.leafCount; i++) {
+        order[i] = i;
+        depths[i] = optimizer.leaves[i].depth;
+    }
+
+    cbOptimizeGetStat(&optimizer, depths, before);
+
+    // new interior nodes are given back if optimization fails
+    const CbArenaMark mark = cbArenaMark(self->arena);
+    CbNode *root = NULL;
+    CbVersionImpl *version = NULL;
+    const bool built = true
+        && cbOptimizeBuild(&optimizer, self->arena, order, depths, &root, self->isStatEnabled)
+        && (self->version == NULL || (version = cbAllocVersion(self, root, NULL)) != NULL);
+
+    if (built) {
+        for (size_t i = 0; i < optimizer.leafCount; i++)
+            optimizer.leaves[i].node->parent = optimizer.leaves[i].parent;
+        self->treeRoot = root;
+
+        // old interior nodes aren't changed, so previous version stays readable
+        if (version != NULL)
+            cbVersionPublish(self, version);
+
+        cbOptimizeGetStat(&optimizer, depths, after);
+
+        // tree-shaped caches are rebuilt for new tree
+        cbLcaIndexDtor(self->lcaIndex);
+        self->lcaIndex = NULL;
+
+        if (self->isPathCached) {
+            self->isPathCached = false;
+            cbEnablePathCache(self);
+        }
+    } else {
+        cbArenaRollback(self->arena, &mark);
+    }
+
+    free(depths);
+    free(order);
+    free(refs);
+    cbOptimizerDtor(&optimizer);
+
+    return built;
+} // cbOptimize
+
+/// @brief tree merging state
+typedef struct __CbMerger {
+    CbNode     **questions;        ///< src interior nodes
+    size_t       questionCount;    ///< count of src interior nodes
+    size_t       questionCapacity; ///< src interior node array capacity
+    CbPoolStr   *texts;            ///< src question texts interned in dst pool (by question)
+    CbNode     **srcLeaves;        ///< src leaves (sorted by name for CB_LEAF_INDEX_TREE dst)
+    size_t       srcLeafCount;     ///< count of src leaves
+    size_t       srcLeafCapacity;  ///< src leaf array capacity
+    CbNode     **dstLeaves;        ///< dst leaves sorted by name (CB_LEAF_INDEX_TREE dst only)
+    CbNode     **leaves;           ///< all leaves of merged tree sorted by name (CB_LEAF_INDEX_TREE dst only)
+    size_t       leafCount;        ///< count of leaves of merged tree (CB_LEAF_INDEX_TREE dst only)
+    CbNode      *dstCommon;        ///< dst leaf src has leaf with same name as (nullable)
+    CbNode      *srcCommon;        ///< src leaf with dstCommon name (nullable)
+    size_t       commonCount;      ///< count of common leaf names
+} CbMerger;
+
+/**
+ * @brief leaf comparison function (for qsort)
+ * 
+ * @param[in] lhs first leaf pointer pointer
+ * @param[in] rhs second leaf pointer pointer
+ * 
+ * @return comparison result (by name)
+ */
+static int cbMergeLeafCompare( const void *lhs, const void *rhs ) {
+    return strcmp((*(const CbNode *const *)lhs)->text, (*(const CbNode *const *)rhs)->text);
+} // cbMergeLeafCompare
+
+/**
+ * @brief src nodes collecting function
+ * 
+ * @param[in,out] merger merging state (non-null)
+ * @param[in]     root   src tree root (non-null)
+ * 
+ * @return true if collected, false if allocation failed
+ */
+static bool cbMergeCollect( CbMerger *const merger, const CbNode *const root ) {
+    for (const CbNode *node = root; node != NULL; node = cbNodeNextPreorder(node, root, NULL)) {
+        if (node->isLeaf) {
+            if (!cbReserve((void **)&merger->srcLeaves, &merger->srcLeafCapacity, merger->srcLeafCount + 1, sizeof(CbNode *)))
+                return false;
+            merger->srcLeaves[merger->srcLeafCount++] = (CbNode *)node;
+        } else {
+            if (!cbReserve((void **)&merger->questions, &merger->questionCapacity, merger->questionCount + 1, sizeof(CbNode *)))
+                return false;
+            merger->questions[merger->questionCount++] = (CbNode *)node;
+        }
+    }
+
+    return true;
+} // cbMergeCollect
+
+/**
+ * @brief leaf tree leaves in name order collecting function
+ * 
+ * @param[in]  root leaf tree root (nullable)
+ * @param[out] dst  leaves destination (non-null, must have place for all leaves)
+ * 
+ * @return count of collected leaves
+ */
+static size_t cbLeafTreeCollect( CbNode *root, CbNode **const dst ) {
+    // tree is AVL-balanced, so its height is far below stack size
+    CbNode *stack[CB_LEAF_TREE_STACK_SIZE];
+    size_t stackSize = 0;
+    size_t count = 0;
+
+    while (root != NULL || stackSize > 0) {
+        while (root != NULL) {
+            stack[stackSize++] = root;
+            root = root->leaf.left;
+        }
+
+        root = stack[--stackSize];
+        dst[count++] = root;
+        root = root->leaf.right;
+    }
+
+    return count;
+} // cbLeafTreeCollect
+
+/**
+ * @brief balanced leaf tree from sorted leaves building function
+ * 
+ * @param[in,out] leaves leaves sorted by name (non-null if count isn't 0)
+ * @param[in]     count  count of leaves
+ * 
+ * @return leaf tree root, NULL if count is 0
+ * 
+ * @note halves differ by one leaf at most, so built tree is AVL-balanced.
+ */
+static CbNode * cbLeafTreeBuild( CbNode *const *const leaves, const size_t count ) {
+    if (count == 0)
+        return NULL;
+
+    const size_t middle = count / 2;
+    CbNode *const root = leaves[middle];
+
+    root->leaf.left = cbLeafTreeBuild(leaves, middle);
+    root->leaf.right = cbLeafTreeBuild(leaves + middle + 1, count - middle - 1);
+    cbLeafTreeUpdateHeight(root);
+
+    return root;
+} // cbLeafTreeBuild
+
+/**
+ * @brief common leaves finding function
+ * 
+ * @param[in,out] merger merging state (non-null, src nodes are collected)
+ * @param[in]     dst    cb to merge into (non-null)
+ * @param[in]     src    cb to merge (non-null)
+ * 
+ * @return true if succeeded, false if allocation failed
+ * 
+ * @note leaf tree of dst has to be rebuilt anyway, so leaves of both trees are merged in name order
+ * (dst leaf tree is traversed in order, src leaves are sorted unless src has leaf tree too).
+ * hash table lookup is O(1), so src leaves are just looked up in dst leaf table.
+ */
+static bool cbMergeFindCommon( CbMerger *const merger, CbImpl *const dst, CbImpl *const src ) {
+    if (dst->leafIndex == CB_LEAF_INDEX_HASH) {
+        for (size_t i = 0; i < merger->srcLeafCount; i++) {
+            CbNode *const leaf = merger->srcLeaves[i];
+            CbNode *const common = *cbLeafTableFind(dst->leafTable, leaf->text, leaf->hash);
+
+            if (common != NULL) {
+                merger->dstCommon = common;
+                merger->srcCommon = leaf;
+                merger->commonCount++;
+            }
+        }
+
+        return true;
+    }
+
+    if (false
+        || (merger->dstLeaves = (CbNode **)calloc(dst->leafTreeSize + 1, sizeof(CbNode *))) == NULL
+        || (merger->leaves = (CbNode **)calloc(dst->leafTreeSize + merger->srcLeafCount + 1, sizeof(CbNode *))) == NULL
+    )
+        return false;
+
+    const size_t dstCount = cbLeafTreeCollect(dst->leafTreeRoot, merger->dstLeaves);
+
+    if (src->leafIndex == CB_LEAF_INDEX_TREE)
+        cbLeafTreeCollect(src->leafTreeRoot, merger->srcLeaves);
+    else
+        qsort(merger->srcLeaves, merger->srcLeafCount, sizeof(CbNode *), cbMergeLeafCompare);
+
+    size_t dstIndex = 0;
+    size_t srcIndex = 0;
+
+    while (dstIndex < dstCount || srcIndex < merger->srcLeafCount) {
+        const int cmp = dstIndex == dstCount
+            ? 1
+            : srcIndex == merger->srcLeafCount
+                ? -1
+                : strcmp(merger->dstLeaves[dstIndex]->text, merger->srcLeaves[srcIndex]->text);
+
+        if (cmp == 0) {
+            merger->dstCommon = merger->dstLeaves[dstIndex];
+            merger->srcCommon = merger->srcLeaves[srcIndex];
+            merger->commonCount++;
+            srcIndex++;
+        }
+
+        // dst leaf of common name is kept
+        merger->leaves[merger->leafCount++] = cmp <= 0
+            ? merger->dstLeaves[dstIndex++]
+            : merger->srcLeaves[srcIndex++];
+    }
+
+    return true;
+} // cbMergeFindCommon
+
+/**
+ * @brief tree merging state destructor
+ * 
+ * @param[in,out] merger merging state to free contents of (non-null)
+ */
+static void cbMergerDtor( CbMerger *const merger ) {
+    free(merger->questions);
+    free(merger->texts);
+    free(merger->srcLeaves);
+    free(merger->dstLeaves);
+    free(merger->leaves);
+} // cbMergerDtor
+
+/**
+ * @brief child slot of node getting function
+ * 
+ * @param[in] root tree root slot (non-null)
+ * @param[in] node node (non-null)
+ * 
+ * @return pointer to parent link (or to root slot) that refers to node
+ */
+static CbNode ** cbNodeGetSlot( CbNode **const root, CbNode *const node ) {
+    CbNode *const parent = node->parent;
+
+    if (parent == NULL)
+        return root;
+
+    return parent->interior.correct == node
+        ? &parent->interior.correct
+        : &parent->interior.incorrect;
+} // cbNodeGetSlot
+
+CbMergeStatus cbMerge( Cb dst, Cb src, const char *condition ) {
+    assert(dst != NULL);
+    assert(src != NULL);
+    assert(dst != src);
+
+    CbMerger merger = {0};
+
+    // merge changes nodes in place, so it would change old versions too
+    if (dst->version != NULL || src->version != NULL)
+        return CB_MERGE_STATUS_VERSIONED;
+
+    if (false
+        || !cbMergeCollect(&merger, src->treeRoot)
+        || (merger.texts = (CbPoolStr *)calloc(merger.questionCount + 1, sizeof(CbPoolStr))) == NULL
+        || !cbMergeFindCommon(&merger, dst, src)
+    ) {
+        cbMergerDtor(&merger);
+        return CB_MERGE_STATUS_NO_MEMORY;
+    }
+
+    if (merger.commonCount > 1 || (merger.commonCount == 0 && condition == NULL)) {
+        cbMergerDtor(&merger);
+        return merger.commonCount > 1
+            ? CB_MERGE_STATUS_COLLISION
+            : CB_MERGE_STATUS_NO_CONDITION;
+    }
+
+    // everything that may fail is done before trees are changed
+    const CbArenaMark mark = cbArenaMark(dst->arena);
+    const size_t leafCount = dst->leafTreeSize + merger.srcLeafCount - merger.commonCount;
+    const size_t tableCapacity = dst->leafTable == NULL ? 0 : dst->leafTable->capacity;
+    size_t newTableCapacity = tableCapacity == 0 ? CB_LEAF_TABLE_MIN_CAPACITY : tableCapacity;
+    CbNode *root = NULL;
+    CbNodeStat *srcStats = NULL;
+    size_t srcStatCount = 0;
+    bool ok = true;
+
+    // src nodes without counters get them from dst arena at once, before anything is committed
+    if (dst->isStatEnabled) {
+        for (size_t i = 0; i < merger.questionCount; i++)
+            srcStatCount += merger.questions[i]->stat == NULL;
+        for (size_t i = 0; i < merger.srcLeafCount; i++)
+            srcStatCount += merger.srcLeaves[i]->stat == NULL;
+
+        ok = srcStatCount == 0 || (srcStats = (CbNodeStat *)cbArenaAlloc(dst->arena, srcStatCount * sizeof(CbNodeStat))) != NULL;
+    }
+
+    for (size_t i = 0; ok && i < merger.questionCount; i++) {
+        const char *const text = merger.questions[i]->text;
+
+        ok = cbStrPoolIntern(dst->textPool, text, strlen(text), &merger.texts[i]);
+    }
+
+    if (ok && merger.commonCount == 0)
+        ok = true
+            && (root = cbAllocQuestionNode(dst->arena, dst->textPool, CB_STR(condition))) != NULL
+            && (!dst->isStatEnabled || (root->stat = (CbNodeStat *)cbArenaAlloc(dst->arena, sizeof(CbNodeStat))) != NULL);
+
+    // table is grown once, load factor is kept below 1/2
+    if (ok && dst->leafIndex == CB_LEAF_INDEX_HASH) {
+        while (leafCount * 2 > newTableCapacity)
+            newTableCapacity *= 2;
+        ok = newTableCapacity == tableCapacity || cbLeafTableResize(dst, newTableCapacity);
+    }
+
+    if (!ok) {
+        cbArenaRollback(dst->arena, &mark);
+        cbMergerDtor(&merger);
+        return CB_MERGE_STATUS_NO_MEMORY;
+    }
+
+    // src nodes get dst texts and lose src-only caches
+    for (size_t i = 0; i < merger.questionCount; i++) {
+        CbNode *const question = merger.questions[i];
+
+        question->text = merger.texts[i].text;
+        question->hash = merger.texts[i].hash;
+        if (!dst->isStatEnabled)
+            question->stat = NULL;
+        else if (question->stat == NULL)
+            question->stat = srcStats++;
+    }
+
+    for (size_t i = 0; i < merger.srcLeafCount; i++) {
+        CbNode *const leaf = merger.srcLeaves[i];
+
+        leaf->leaf.path = NULL;
+        if (!dst->isStatEnabled)
+            leaf->stat = NULL;
+        else if (leaf->stat == NULL)
+            leaf->stat = srcStats++;
+    }
+
+    CbNode *srcRoot = src->treeRoot;
+
+    if (merger.commonCount != 0) {
+        // dst leaf takes place of src one, then src tree takes place of dst leaf
+        CbNode *const dstCommon = merger.dstCommon;
+        CbNode *const srcCommon = merger.srcCommon;
+        CbNode **const dstSlot = cbNodeGetSlot(&dst->treeRoot, dstCommon);
+        CbNode *const dstParent = dstCommon->parent;
+
+        *cbNodeGetSlot(&srcRoot, srcCommon) = dstCommon;
+        dstCommon->parent = srcCommon->parent;
+
+        srcRoot->parent = dstParent;
+        *dstSlot = srcRoot;
+    } else {
+        root->isLeaf = false;
+        root->parent = NULL;
+        root->interior.correct = srcRoot;
+        root->interior.incorrect = dst->treeRoot;
+
+        srcRoot->parent = root;
+        dst->treeRoot->parent = root;
+        dst->treeRoot = root;
+    }
+
+    if (dst->leafIndex == CB_LEAF_INDEX_TREE) {
+        dst->leafTreeRoot = cbLeafTreeBuild(merger.leaves, merger.leafCount);
+    } else {
+        for (size_t i = 0; i < merger.srcLeafCount; i++)
+            if (merger.srcLeaves[i] != merger.srcCommon)
+                *cbLeafTableFind(dst->leafTable, merger.srcLeaves[i]->text, merger.srcLeaves[i]->hash) = merger.srcLeaves[i];
+    }
+
+    dst->leafTreeSize = leafCount;
+    dst->treeSize += merger.commonCount == 0
+        ? src->treeSize + 1
+        : src->treeSize - 1;
+
+    dst->sessionStat.count += src->sessionStat.count;
+    dst->sessionStat.lengthSum += src->sessionStat.lengthSum;
+    for (size_t i = 0; i < CB_SESSION_LENGTH_COUNT; i++)
+        dst->sessionStat.lengths[i] += src->sessionStat.lengths[i];
+
+    // tree-shaped caches are rebuilt for new tree
+    cbLcaIndexDtor(dst->lcaIndex);
+    dst->lcaIndex = NULL;
+
+    // path cache needs merged tree, so it can't be built before commit, failed one is left disabled
+    if (dst->isPathCached) {
+        dst->isPathCached = false;
+        cbEnablePathCache(dst);
+    }
+
+    // src nodes are moved with all src arena blocks (src implementation is allocated there too)
+    cbLcaIndexDtor(src->lcaIndex);
+    pthread_rwlock_destroy(&src->lcaLock);
+    cbStrPoolDtor(src->textPool);
+    cbArenaAdopt(dst->arena, src->arena);
+
+    cbMergerDtor(&merger);
+
+    return CB_MERGE_STATUS_OK;
+} // cbMerge
 
 // cb.c
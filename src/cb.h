@@ -5,8 +5,12 @@
 #ifndef CB_H_
 #define CB_H_
 
+#include <stdint.h>
 #include <stdio.h>
 
+#include "cb_arena.h"
+#include "cb_strpool.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif // defined(__cplusplus)
@@ -14,14 +18,21 @@ extern "C" {
 /// @brief the main project structure - cactusbot
 typedef struct __CbImpl * Cb;
 
+/// @brief leaf (object) by name index kind
+typedef enum __CbLeafIndex {
+    CB_LEAF_INDEX_TREE, ///< balanced search tree built inside of nodes, no extra memory, O(log n) comparisons
+    CB_LEAF_INDEX_HASH, ///< open addressing hash table, separate buffer, O(1) comparisons on average
+} CbLeafIndex;
+
 /**
  * @brief cactus bot constructor
  * 
  * @param[in] rootEntry root entry name
+ * @param[in] leafIndex leaf index kind
  * 
  * @return cactusbot handle, may return null if construction failed.
  */
-Cb cbCtor( const char *rootEntry );
+Cb cbCtor( const char *rootEntry, CbLeafIndex leafIndex );
 
 /**
  * @brief cactus bot destructor
@@ -30,10 +41,30 @@ Cb cbCtor( const char *rootEntry );
  */
 void cbDtor( Cb self );
 
+/**
+ * @brief cactus bot resetting function
+ * 
+ * @param[in,out] self      cactusbot pointer (non-null)
+ * @param[in]     rootEntry new root entry name (non-null)
+ * 
+ * @return true if succeeded, false if root allocation failed (self may only be destroyed then).
+ * 
+ * @note whole tree is dropped, but its memory is reused for new tree instead of being returned to system.
+ * versions are dropped too, new tree starts new history if cb keeps versions.
+ */
+bool cbReset( Cb self, const char *rootEntry );
+
+/// @brief tree version handle, its child links are immutable (see cbEnableVersions)
+typedef const struct __CbVersionImpl * CbVersion;
+
 /// @brief entry representation structure
 typedef struct __CbIter {
-    Cb                self; ///< cb pointer
-    struct __CbNode **node; ///< pointer to pointer to current node
+    Cb                self;      ///< cb pointer
+    struct __CbNode **node;      ///< pointer to pointer to current node
+    struct __CbNode  *current;   ///< current node (loaded once, so iterator isn't affected by concurrent insertions)
+    size_t            depth;     ///< count of answers given since cbIter (session length)
+    CbVersion         version;   ///< version iterator walks (NULL if cb keeps no versions)
+    bool              isCounted; ///< true if iterator updates visit counters (see cbEnableStat)
 } CbIter;
 
 /**
@@ -45,6 +76,30 @@ typedef struct __CbIter {
  */
 CbIter cbIter( Cb self );
 
+/**
+ * @brief version root entry getting function
+ * 
+ * @param[in] self    cb pointer (non-null)
+ * @param[in] version version of self to walk (non-null)
+ * 
+ * @return new iterator
+ * 
+ * @note child links of version tree are immutable, so it may be walked concurrently with insertions and
+ * version switches. parent links follow current version only, so definitions aren't taken from old versions.
+ */
+CbIter cbIterVersion( Cb self, CbVersion version );
+
+/**
+ * @brief traversal root entry getting function
+ * 
+ * @param[in] self cb pointer (non-null)
+ * 
+ * @return new iterator
+ * 
+ * @note iterator (and its copies) doesn't update visit counters, so it's used by tree walks that aren't guessing sessions.
+ */
+CbIter cbIterTraversal( Cb self );
+
 /**
  * @brief next element getting function
  * 
@@ -79,12 +134,92 @@ bool cbIterFinished( const CbIter *entry );
  * @param[in] correct   correct condition string
  * 
  * @return true if succeeded, false if something went wrong
+ * 
+ * @note insertion may run concurrently with any count of readers (cbIter*, cbDefine and cbDefIter* functions),
+ * but insertions themselves must be serialized. insertion fails if iterator leaf was replaced after iterator got it.
+ * if cb keeps versions, insertion creates new version and fails if iterator doesn't walk current one.
  */
 bool cbIterInsertCorrect( CbIter *entry, const char *condition, const char *correct );
 
+/**
+ * @brief leaf iterator getting function
+ * 
+ * @param[in]  self cb pointer (non-null)
+ * @param[in]  leaf leaf name (non-null)
+ * @param[out] dst  iterator destination (non-null)
+ * 
+ * @return true if leaf is found, false otherwise
+ * 
+ * @note iterator may be used for cbIterInsertCorrect, its depth is 0, as no answers are given.
+ */
+bool cbIterFindLeaf( Cb self, const char *leaf, CbIter *dst );
+
+/**
+ * @brief insertion callback
+ * 
+ * @param[in,out] context   callback context
+ * @param[in]     leaf      name of leaf new condition is inserted at (the leaf becomes its incorrect child)
+ * @param[in]     condition condition text
+ * @param[in]     correct   new leaf name
+ */
+typedef void (* CbInsertHook)( void *context, const char *leaf, const char *condition, const char *correct );
+
+/**
+ * @brief insertion hook setting function
+ * 
+ * @param[in,out] self    cb pointer (non-null)
+ * @param[in]     hook    hook to call after every successful cbIterInsertCorrect (nullable, NULL removes hook)
+ * @param[in]     context hook context
+ * 
+ * @note hook is called in writer thread, after insertion is visible to readers.
+ * function requires exclusive access to cb.
+ */
+void cbSetInsertHook( Cb self, CbInsertHook hook, void *context );
+
+/**
+ * @brief insertion hook getting function
+ * 
+ * @param[in]  self    cb pointer (non-null)
+ * @param[out] context hook context destination (nullable)
+ * 
+ * @return hook set by cbSetInsertHook, NULL if there is no hook
+ */
+CbInsertHook cbGetInsertHook( const Cb self, void **context );
+
+/// @brief batch walk query
+typedef struct __CbWalkQuery {
+    const uint8_t *answers;     ///< answer bits, i-th answer is (answers[i / 8] >> (i % 8)) & 1 (1 for correct)
+    size_t         answerCount; ///< count of answers
+} CbWalkQuery;
+
+/// @brief batch walk result
+typedef struct __CbWalkResult {
+    const char *text;       ///< text of node walk stopped at (leaf text if walk is finished, question otherwise)
+    size_t      depth;      ///< count of answers used
+    bool        isFinished; ///< true if walk reached leaf, false if answers ended before
+} CbWalkResult;
+
+/**
+ * @brief many walks at once performing function
+ * 
+ * @param[in]  self        cb pointer (non-null)
+ * @param[in]  queries     walk queries (non-null if count is not 0)
+ * @param[out] results     walk results, i-th result is for i-th query (non-null if count is not 0)
+ * @param[in]  count       count of queries
+ * @param[in]  threadCount maximal count of threads to use (0 and 1 mean calling thread only)
+ * 
+ * @note walks are interleaved and next nodes are prefetched, so memory latencies of different walks overlap.
+ * function is a reader in terms of cbIterInsertCorrect concurrency.
+ */
+void cbWalkBatch( const Cb self, const CbWalkQuery *queries, CbWalkResult *results, size_t count, size_t threadCount );
+
 /// @brief object definition iterator representation structure
 typedef struct __CbDefIter {
-    const struct __CbNode *element; ///< element
+    const struct __CbNode     *element;   ///< element
+    const struct __CbNode     *parent;    ///< element parent (loaded once, so iterator isn't affected by concurrent insertions)
+    bool                       isCorrect; ///< true if element is correct child of parent
+    const struct __CbLeafPath *path;      ///< defined leaf path (path cache only, NULL otherwise)
+    size_t                     depth;     ///< element depth (path cache only)
 } CbDefIter;
 
 /// @brief object definition status
@@ -134,6 +269,315 @@ bool cbDefIterGetRelation( const CbDefIter *iter );
  */
 bool cbDefIterNext( CbDefIter *iter );
 
+/// @brief root-to-leaf path (answers leading to leaf)
+typedef struct __CbPath {
+    size_t          depth; ///< count of answers
+    const uint64_t *bits;  ///< answers, i-th answer is (bits[i / 64] >> (i % 64)) & 1 (1 for correct)
+} CbPath;
+
+/**
+ * @brief leaf path cache enabling function
+ * 
+ * @param[in,out] self cb pointer (non-null)
+ * 
+ * @return true if cache is enabled, false if allocation failed (cb isn't changed then)
+ * 
+ * @note each leaf gets depth and packed answers leading to it, insertions keep them up to date.
+ * cbDefine takes relations from path then, and cbGetPath becomes available.
+ * function requires exclusive access to cb, cache stays enabled until cbDtor.
+ * cache can't be enabled for cb that keeps versions.
+ */
+bool cbEnablePathCache( Cb self );
+
+/**
+ * @brief leaf path getting function
+ * 
+ * @param[in]  self    cb pointer (non-null)
+ * @param[in]  subject leaf name (non-null)
+ * @param[out] dst     path destination (non-null, path is valid until cbReset or cbDtor)
+ * 
+ * @return true if got path, false if there is no such leaf or path cache isn't enabled
+ */
+bool cbGetPath( const Cb self, const char *subject, CbPath *dst );
+
+/**
+ * @brief common path prefix length getting function
+ * 
+ * @param[in] lhs first path (non-null)
+ * @param[in] rhs second path (non-null)
+ * 
+ * @return count of first answers that are same in both paths (index of question leaves are split by for different leaves)
+ */
+size_t cbPathCommonLength( const CbPath *lhs, const CbPath *rhs );
+
+/// @brief object comparison status
+typedef enum __CbCompareStatus {
+    CB_COMPARE_STATUS_OK,         ///< objects are compared
+    CB_COMPARE_STATUS_NO_SUBJECT, ///< there is no such object(s) in database
+    CB_COMPARE_STATUS_SAME,       ///< both names refer to same object
+} CbCompareStatus;
+
+/// @brief object comparison result
+typedef struct __CbComparison {
+    const char *splitProperty; ///< first property objects differ by
+    bool        lhsRelation;   ///< true if first object satisfies split property (second one doesn't then)
+    CbDefIter   common;        ///< common properties iterator (valid only if hasCommon is true)
+    bool        hasCommon;     ///< true if objects have common properties
+} CbComparison;
+
+/**
+ * @brief two objects comparison function
+ * 
+ * @param[in]  self cb pointer (non-null)
+ * @param[in]  lhs  first object name (non-null)
+ * @param[in]  rhs  second object name (non-null)
+ * @param[out] dst  comparison destination (non-null, valid only if CB_COMPARE_STATUS_OK is returned)
+ * 
+ * @return comparison status
+ * 
+ * @note split property is found as lowest common ancestor in O(1) by index built lazily.
+ * leaves inserted after the last building are compared by parent links in O(depth), and
+ * index is rebuilt in O(n) once they are compared n / 8 times, so rebuild is amortized.
+ * function is a reader in terms of cbIterInsertCorrect concurrency.
+ */
+CbCompareStatus cbCompare( const Cb self, const char *lhs, const char *rhs, CbComparison *dst );
+
+/// @brief leaf hit frequency
+typedef struct __CbLeafFrequency {
+    const char *name;      ///< leaf name
+    double      frequency; ///< leaf hit frequency (non-negative, frequencies of same leaf are summed)
+} CbLeafFrequency;
+
+/// @brief leaf depth statistics
+typedef struct __CbDepthStat {
+    double averageDepth;  ///< average leaf depth
+    double expectedDepth; ///< leaf depth averaged with hit frequencies (expected question count per session)
+    size_t maxDepth;      ///< maximal leaf depth
+} CbDepthStat;
+
+/**
+ * @brief tree restructuring function, minimizes expected question count for given leaf hit frequencies
+ * 
+ * @param[in,out] self           cb pointer (non-null)
+ * @param[in]     frequencies    leaf hit frequencies (nullable if frequencyCount is 0, unknown names are ignored)
+ * @param[in]     frequencyCount count of frequencies
+ * @param[out]    before         depth statistics before optimization destination (nullable)
+ * @param[out]    after          depth statistics after optimization destination (nullable, set only if true is returned)
+ * 
+ * @return true if tree is restructured, false if allocation failed or leaves can't be
+ * distinguished by known properties (tree isn't changed then)
+ * 
+ * @note leaf is considered to know answer to question if question text is asked on its path
+ * (with same answer every time), so questions repeated in different branches make tree
+ * reshapeable. interior structure is built top-down, every node asks question known by all
+ * leaves below it which splits them by frequency most evenly, so every leaf keeps only
+ * properties it had before. leaves without frequency are weighted by 0.
+ * function requires exclusive access (no concurrent readers or writer), old interior nodes
+ * stay in arena until cbReset. if cb keeps versions, restructured tree becomes new version.
+ */
+bool cbOptimize( Cb self, const CbLeafFrequency *frequencies, size_t frequencyCount, CbDepthStat *before, CbDepthStat *after );
+
+/// @brief tree merging status
+typedef enum __CbMergeStatus {
+    CB_MERGE_STATUS_OK,           ///< trees are merged
+    CB_MERGE_STATUS_NO_CONDITION, ///< trees have no common leaf and no root condition is given
+    CB_MERGE_STATUS_COLLISION,    ///< trees have more than one common leaf
+    CB_MERGE_STATUS_NO_MEMORY,    ///< allocation failed
+    CB_MERGE_STATUS_VERSIONED,    ///< dst or src keeps versions (merge changes nodes in place)
+} CbMergeStatus;
+
+/**
+ * @brief tree into other tree merging function
+ * 
+ * @param[in,out] dst       cb to merge into (non-null)
+ * @param[in]     src       cb to merge (non-null, destroyed if CB_MERGE_STATUS_OK is returned)
+ * @param[in]     condition new root question (nullable, used only if trees have no common leaf)
+ * 
+ * @return merging status (trees aren't changed if it isn't CB_MERGE_STATUS_OK)
+ * 
+ * @note if trees have single common leaf, src tree replaces it in dst (dst leaf node takes place of src one),
+ * otherwise new root question is asked, src tree is its correct branch and dst tree is incorrect one.
+ * src nodes are moved with its arena, only question texts are interned in dst pool. common leaf is
+ * found by single pass over both leaf trees in name order (CB_LEAF_INDEX_TREE) or by table lookups
+ * (CB_LEAF_INDEX_HASH). function requires exclusive access to both trees, src must have no journal attached.
+ * src nodes get dst visit counters before trees are changed. dst path cache needs merged tree, so it's
+ * rebuilt after merge and is left disabled if that fails (cbEnablePathCache may be called again).
+ */
+CbMergeStatus cbMerge( Cb dst, Cb src, const char *condition );
+
+/// @brief tree version information
+typedef struct __CbVersionInfo {
+    size_t      number;   ///< version number (versions are numbered from 0 in creation order)
+    size_t      treeSize; ///< count of version tree elements
+    const char *leaf;     ///< name of leaf added by version (NULL for first version and cbOptimize ones)
+    CbVersion   prev;     ///< version this one is derived from (NULL for first version)
+} CbVersionInfo;
+
+/// @brief leaf difference between versions
+typedef struct __CbVersionChange {
+    const char *name;    ///< leaf name
+    bool        isAdded; ///< true if leaf is in 'to' version only, false if it's in 'from' version only
+} CbVersionChange;
+
+/**
+ * @brief tree versions enabling function
+ * 
+ * @param[in,out] self cb pointer (non-null)
+ * 
+ * @return true if versions are enabled, false if allocation failed or path cache is enabled
+ * 
+ * @note current tree becomes version 0. after that insertion doesn't change child links of tree, but copies
+ * O(depth) nodes from root to changed leaf and publishes new version with new root, rest of nodes is shared.
+ * parent links (and removal marks of leaves) of shared nodes follow current version, so insertion and
+ * cbSetVersion rewrite them: definitions walked concurrently may mix versions, cbCompare is excluded by lock.
+ * copied interior nodes are never freed, so insertion takes O(depth) memory instead of O(1): for tree
+ * of depth about 20 arena grows about 7 times faster than without versions.
+ * versions are kept until cbReset or cbDtor, so any handle stays readable. cbMerge can't be applied
+ * to cb that keeps versions. function requires exclusive access to cb, versions stay enabled until cbDtor.
+ */
+bool cbEnableVersions( Cb self );
+
+/**
+ * @brief current version getting function
+ * 
+ * @param[in] self cb pointer (non-null)
+ * 
+ * @return current version, NULL if cb keeps no versions
+ */
+CbVersion cbGetVersion( const Cb self );
+
+/**
+ * @brief version by number finding function
+ * 
+ * @param[in] self   cb pointer (non-null)
+ * @param[in] number version number
+ * 
+ * @return version with such number, NULL if there is no such version
+ * 
+ * @note versions are listed from newest one, so function takes O(count of newer versions).
+ */
+CbVersion cbFindVersion( const Cb self, size_t number );
+
+/**
+ * @brief version information getting function
+ * 
+ * @param[in]  version version (non-null)
+ * @param[out] dst     information destination (non-null)
+ */
+void cbVersionGetInfo( CbVersion version, CbVersionInfo *dst );
+
+/**
+ * @brief current version setting function (rollback)
+ * 
+ * @param[in,out] self    cb pointer (non-null, keeps versions)
+ * @param[in]     version version of self to make current (non-null)
+ * 
+ * @return true if version is set, false if allocation failed (current version isn't changed then)
+ * 
+ * @note trees are shared, so only parent links changed by versions between current and new one are
+ * restored, it takes O(depth) per insertion version and O(tree size) per cbOptimize one. leaves added
+ * after new version are hidden from leaf lookups, insertion of same name reuses them. new insertions
+ * derive from new version, versions set aside stay readable. function requires exclusive access to cb.
+ */
+bool cbSetVersion( Cb self, CbVersion version );
+
+/**
+ * @brief versions leaf sets difference getting function
+ * 
+ * @param[in]  from        version to compare with (non-null)
+ * @param[in]  to          version to compare (non-null, version of same cb)
+ * @param[out] dst         changes destination (nullable if capacity is 0)
+ * @param[in]  capacity    dst capacity
+ * @param[out] changeCount count of changes destination (non-null, only first capacity of them are written)
+ * 
+ * @return true if succeeded, false if allocation failed
+ * 
+ * @note subtrees shared by versions are skipped, so difference of versions split by few insertions takes
+ * O(depth) time for each of them. function may be called concurrently with insertions and version switches.
+ */
+bool cbVersionDiff( CbVersion from, CbVersion to, CbVersionChange *dst, size_t capacity, size_t *changeCount );
+
+/// @brief node visit counters
+typedef struct __CbNodeStat {
+    uint64_t visits;    ///< count of iterator visits (hits for leaves)
+    uint64_t correct;   ///< count of correct answers to node question (interior nodes only)
+    uint64_t incorrect; ///< count of incorrect answers to node question (interior nodes only)
+} CbNodeStat;
+
+/// @brief count of session length histogram buckets
+#define CB_SESSION_LENGTH_COUNT 64
+
+/// @brief session (walk from cbIter to leaf) statistics
+typedef struct __CbSessionStat {
+    uint64_t count;                            ///< count of finished sessions
+    uint64_t lengthSum;                        ///< total count of answers in finished sessions
+    uint64_t lengths[CB_SESSION_LENGTH_COUNT]; ///< count of sessions by answer count (last bucket counts longer sessions too)
+} CbSessionStat;
+
+/// @brief statistics report format
+typedef enum __CbStatFormat {
+    CB_STAT_FORMAT_TEXT, ///< human-readable text, visited nodes are indented by depth
+    CB_STAT_FORMAT_JSON, ///< single JSON object
+} CbStatFormat;
+
+/**
+ * @brief visit statistics enabling function
+ * 
+ * @param[in,out] self cb pointer (non-null)
+ * 
+ * @return true if statistics are enabled, false if allocation failed (cb isn't changed then)
+ * 
+ * @note every node gets visit counters, which cbIter and cbIterNext update with relaxed atomic
+ * increments (readers stay lock-free), and every session reaching a leaf is added to session statistics.
+ * tree walks started by cbIterTraversal (snapshots, leaf tries) aren't counted.
+ * function requires exclusive access to cb, statistics stay enabled until cbDtor and are zeroed by cbReset.
+ */
+bool cbEnableStat( Cb self );
+
+/**
+ * @brief iterator node visit counters getting function
+ * 
+ * @param[in]  iter iterator (non-null)
+ * @param[out] dst  counters destination (non-null)
+ * 
+ * @return true if got counters, false if statistics aren't enabled
+ */
+bool cbIterGetStat( const CbIter *iter, CbNodeStat *dst );
+
+/**
+ * @brief session statistics getting function
+ * 
+ * @param[in]  self cb pointer (non-null)
+ * @param[out] dst  statistics destination (non-null, zeroed if statistics aren't enabled)
+ */
+void cbGetSessionStat( const Cb self, CbSessionStat *dst );
+
+/**
+ * @brief leaf hit counts getting function
+ * 
+ * @param[in]  self     cb pointer (non-null)
+ * @param[out] dst      leaf hits destination (nullable if capacity is 0, names are valid until cbReset or cbDtor)
+ * @param[in]  capacity destination capacity
+ * 
+ * @return count of leaves (only first 'capacity' of them are written), 0 if statistics aren't enabled
+ * 
+ * @note result may be passed to cbOptimize as is.
+ */
+size_t cbGetLeafHits( const Cb self, CbLeafFrequency *dst, size_t capacity );
+
+/**
+ * @brief statistics report dumping function
+ * 
+ * @param[out] out    destination file (non-null)
+ * @param[in]  self   cb pointer (non-null)
+ * @param[in]  format report format
+ * 
+ * @return true if dumped, false if statistics aren't enabled or some write failed
+ * 
+ * @note report contains session statistics and counters of visited nodes in preorder.
+ */
+bool cbDumpStat( FILE *out, const Cb self, CbStatFormat format );
+
 /**
  * @brief CF text dumping function
  * 
@@ -142,15 +586,171 @@ bool cbDefIterNext( CbDefIter *iter );
  */
 void cbDump( FILE *out, const Cb self );
 
+/// @brief dump format
+typedef enum __CbDumpFormat {
+    CB_DUMP_FORMAT_INDENTED, ///< one node per line, 4 spaces per depth level (cbDump format)
+    CB_DUMP_FORMAT_COMPACT,  ///< no whitespace between tokens, size is linear for any tree shape
+    CB_DUMP_FORMAT_PACKED,   ///< binary: topology bits, front-coded texts, checksummed blocks (read by cbParsePacked)
+} CbDumpFormat;
+
+/**
+ * @brief CB text dumping function with explicit buffering
+ * 
+ * @param[out] out        destination file (non-null)
+ * @param[in]  self       self pointer (non-null)
+ * @param[in]  format     dump format
+ * @param[in]  buffer     write buffer (nullable, internal stack buffer is used if NULL)
+ * @param[in]  bufferSize write buffer size
+ * 
+ * @return true if dumped, false if some write (or packed format block allocation) failed.
+ * 
+ * @note text is written into buffer and passed to 'out' by whole-buffer blocks, no memory is allocated
+ * for text formats. packed format needs 'out' opened in binary mode, it uses native byte order.
+ */
+bool cbDumpBuffered( FILE *out, const Cb self, CbDumpFormat format, void *buffer, size_t bufferSize );
+
 /**
  * @brief CB from text parsing function
  * 
- * @param[in]  str string to parse CB from (non-null, zero-terminated.)
- * @param[out] dst parsing destination (non-null)
+ * @param[in]  str       string to parse CB from (non-null, zero-terminated.)
+ * @param[in]  leafIndex leaf index kind
+ * @param[out] dst       parsing destination (non-null)
  * 
  * @return true if parsed, false if not.
  */
-bool cbParse( const char *str, Cb *dst );
+bool cbParse( const char *str, CbLeafIndex leafIndex, Cb *dst );
+
+/**
+ * @brief input reading function pointer
+ * 
+ * @param[in]  context reading context
+ * @param[out] buffer  reading destination (non-null)
+ * @param[in]  size    maximal count of bytes to read
+ * 
+ * @return count of bytes read, 0 if input is finished.
+ */
+typedef size_t (* CbReadFunc)( void *context, char *buffer, size_t size );
+
+/**
+ * @brief CB from chunked input parsing function
+ * 
+ * @param[in]  read        input reading function (non-null)
+ * @param[in]  readContext input reading function context
+ * @param[in]  leafIndex   leaf index kind
+ * @param[out] dst         parsing destination (non-null)
+ * 
+ * @return true if parsed, false if not.
+ * 
+ * @note input is requested by fixed-size chunks, so memory usage doesn't depend on input size (except of longest string size).
+ */
+bool cbParseStream( CbReadFunc read, void *readContext, CbLeafIndex leafIndex, Cb *dst );
+
+/**
+ * @brief CB from file parsing function
+ * 
+ * @param[in]  file      file to parse CB from (non-null, may be pipe)
+ * @param[in]  leafIndex leaf index kind
+ * @param[out] dst       parsing destination (non-null)
+ * 
+ * @return true if parsed, false if not.
+ */
+bool cbParseFile( FILE *file, CbLeafIndex leafIndex, Cb *dst );
+
+/**
+ * @brief CB from packed format stream parsing function
+ * 
+ * @param[in]  read        reading function (non-null)
+ * @param[in]  readContext reading function context
+ * @param[in]  leafIndex   leaf index kind
+ * @param[out] dst         parsing destination (non-null)
+ * 
+ * @return true if parsed, false if stream isn't packed dump (CB_DUMP_FORMAT_PACKED),
+ * block checksum doesn't match or allocation failed.
+ * 
+ * @note stream is read by blocks, and nodes are decoded from them straight into arena,
+ * so memory taken besides tree is a single block and distinct question list.
+ */
+bool cbParsePacked( CbReadFunc read, void *readContext, CbLeafIndex leafIndex, Cb *dst );
+
+/**
+ * @brief CB from packed format file parsing function
+ * 
+ * @param[in]  file      file to parse (non-null, opened in binary mode)
+ * @param[in]  leafIndex leaf index kind
+ * @param[out] dst       parsing destination (non-null)
+ * 
+ * @return true if parsed, false if not.
+ */
+bool cbParsePackedFile( FILE *file, CbLeafIndex leafIndex, Cb *dst );
+
+/**
+ * @brief CB from stream of any dump format parsing function
+ * 
+ * @param[in]  read        reading function (non-null)
+ * @param[in]  readContext reading function context
+ * @param[in]  leafIndex   leaf index kind
+ * @param[out] dst         parsing destination (non-null)
+ * 
+ * @return true if parsed, false if not.
+ * 
+ * @note packed dump (CB_DUMP_FORMAT_PACKED) is detected by its magic, other input is parsed as text.
+ * magic bytes are given back to parser, so stream is read once and may be pipe.
+ */
+bool cbParseDetect( CbReadFunc read, void *readContext, CbLeafIndex leafIndex, Cb *dst );
+
+/**
+ * @brief CB from file of any dump format parsing function
+ * 
+ * @param[in]  file      file to parse (non-null, opened in binary mode, may be pipe)
+ * @param[in]  leafIndex leaf index kind
+ * @param[out] dst       parsing destination (non-null)
+ * 
+ * @return true if parsed, false if not.
+ */
+bool cbParseDetectFile( FILE *file, CbLeafIndex leafIndex, Cb *dst );
+
+/**
+ * @brief CB from text parallel parsing function
+ * 
+ * @param[in]  str         string to parse CB from (non-null, zero-terminated.)
+ * @param[in]  leafIndex   leaf index kind
+ * @param[in]  threadCount maximal count of threads to use (0 and 1 mean calling thread only)
+ * @param[out] dst         parsing destination (non-null)
+ * 
+ * @return true if parsed, false if not.
+ * 
+ * @note structural pass splits text into independent subtrees by bracket depth, subtrees are parsed
+ * concurrently into per-thread arenas and then attached to tree of large interior nodes. result is
+ * same as cbParse one (including leaf index), but trees of long chains of large subtrees parallelize badly.
+ */
+bool cbParseParallel( const char *str, CbLeafIndex leafIndex, size_t threadCount, Cb *dst );
+
+/**
+ * @brief leaf index memory usage getting function
+ * 
+ * @param[in] self cb pointer (non-null)
+ * 
+ * @return count of bytes leaf index takes in addition to tree nodes
+ */
+size_t cbLeafIndexMemoryUsage( const Cb self );
+
+/**
+ * @brief tree arena statistics getting function
+ * 
+ * @param[in]  self cb pointer (non-null)
+ * @param[out] dst  statistics destination (non-null)
+ */
+void cbGetArenaStat( const Cb self, CbArenaStat *dst );
+
+/**
+ * @brief question text pool statistics getting function
+ * 
+ * @param[in]  self cb pointer (non-null)
+ * @param[out] dst  statistics destination (non-null)
+ * 
+ * @note interior node texts are interned, so repeated questions take memory once (in pool, not in tree arena).
+ */
+void cbGetTextPoolStat( const Cb self, CbStrPoolStat *dst );
 
 /***
  * Debug functions
@@ -5,11 +5,18 @@
 #include <assert.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "cb_arena.h"
 
-/// @brief arena-allocated block size
-#define CB_ARENA_BLOCK_SIZE ((size_t)1024)
+/// @brief first arena block data size
+#define CB_ARENA_MIN_BLOCK_SIZE ((size_t)4096)
+
+/// @brief maximal size arena blocks grow to
+#define CB_ARENA_MAX_BLOCK_SIZE ((size_t)4 * 1024 * 1024)
+
+/// @brief allocations of this size or larger get dedicated block
+#define CB_ARENA_LARGE_ALLOCATION_SIZE (CB_ARENA_MAX_BLOCK_SIZE / 4)
 
 /// @brief allocation forward declaration
 typedef struct __CbArenaAllocation CbArenaAllocation;
@@ -17,17 +24,26 @@ typedef struct __CbArenaAllocation CbArenaAllocation;
 /// @brief arena block representation structure
 struct __CbArenaAllocation {
     union {
-        CbArenaAllocation *next;   ///< next allocation pointer
-        max_align_t        _align; ///< alignment forcer
+        struct {
+            CbArenaAllocation *next; ///< next (previously allocated or next free) block pointer
+            size_t             size; ///< block data size
+        };
+        max_align_t _align; ///< alignment forcer
     };
-    uint8_t            data[1]; ///< allocation data
+    uint8_t data[1]; ///< allocation data
 }; // struct __CbArenaAllocation
 
 /// @brief arena implementation structure
 typedef struct __CbArenaImpl {
-    CbArenaAllocation *allocations; ///< arena allocations stack
-    void              *curr;        ///< current block pointer
-    void              *end;         ///< block end pointer
+    CbArenaAllocation *allocations;   ///< arena blocks stack, most recently allocated block on top
+    CbArenaAllocation *freeBlocks;    ///< blocks released by rollback/reset, reused before asking system
+    uint8_t           *curr;          ///< current bump block free space begin
+    uint8_t           *end;           ///< current bump block end
+    size_t             nextBlockSize; ///< data size of next bump block
+    size_t             bytesReserved; ///< total size of block data (including free blocks)
+    size_t             bytesUsed;     ///< total size of allocations
+    size_t             bytesFree;     ///< total size of free block data
+    size_t             blockCount;    ///< count of blocks (including free blocks)
 } CbArenaImpl;
 
 CbArena cbArenaCtor( void ) {
@@ -35,6 +51,8 @@ CbArena cbArenaCtor( void ) {
     CbArenaImpl impl = {0};
     CbArena arena = NULL;
 
+    impl.nextBlockSize = CB_ARENA_MIN_BLOCK_SIZE;
+
     if ((arena = (CbArena)cbArenaAlloc(&impl, sizeof(CbArenaImpl))) != NULL)
         *arena = impl;
 
@@ -45,7 +63,15 @@ void cbArenaDtor( CbArena const arena ) {
     if (arena == NULL)
         return;
 
-    CbArenaAllocation *allocation = arena->allocations;
+    CbArenaAllocation *allocation = arena->freeBlocks;
+    while (allocation != NULL) {
+        CbArenaAllocation *const next = allocation->next;
+        free(allocation);
+        allocation = next;
+    }
+
+    // arena itself is located in the last block
+    allocation = arena->allocations;
     while (allocation != NULL) {
         CbArenaAllocation *const next = allocation->next;
         free(allocation);
@@ -65,41 +91,201 @@ static size_t cbArenaAlignUp( const size_t number, const size_t alignment ) {
     return alignment * (number / alignment + (size_t)(number % alignment != 0));
 } // cbArenaAlignUp
 
+/**
+ * @brief new block allocation function
+ * 
+ * @param[in,out] arena arena pointer (non-null)
+ * @param[in]     size  block data size
+ * 
+ * @return allocated block, NULL if allocation failed
+ */
+static CbArenaAllocation * cbArenaAllocBlock( CbArena const arena, const size_t size ) {
+    // reuse first fitting free block
+    for (CbArenaAllocation **freeBlock = &arena->freeBlocks; *freeBlock != NULL; freeBlock = &(*freeBlock)->next) {
+        CbArenaAllocation *const block = *freeBlock;
+
+        if (block->size < size)
+            continue;
+
+        *freeBlock = block->next;
+        arena->bytesFree -= block->size;
+
+        memset(block->data, 0, block->size);
+
+        block->next = arena->allocations;
+        arena->allocations = block;
+
+        return block;
+    }
+
+    CbArenaAllocation *const block = (CbArenaAllocation *)calloc(offsetof(CbArenaAllocation, data) + size, 1);
+
+    if (block == NULL)
+        return NULL;
+
+    block->next = arena->allocations;
+    block->size = size;
+    arena->allocations = block;
+
+    arena->bytesReserved += size;
+    arena->blockCount++;
+
+    return block;
+} // cbArenaAllocBlock
+
 void * cbArenaAlloc( CbArena const arena, const size_t size ) {
     assert(arena != NULL);
 
-    void *allocationStart = (void *)cbArenaAlignUp((size_t)arena->curr, sizeof(max_align_t));
-    void *allocationEnd = (uint8_t *)allocationStart + size;
+    if (size == 0)
+        return NULL;
 
-    if (allocationEnd >= arena->curr) {
-        // just in case if allocation size is somehow more than CB_ARENA_BLOCK_SIZE
-        const size_t requiredBlockCount = cbArenaAlignUp(size, CB_ARENA_BLOCK_SIZE);
+    const size_t alignedSize = cbArenaAlignUp(size, sizeof(max_align_t));
 
-        // allocate new block
-        CbArenaAllocation *newAllocation = (CbArenaAllocation *)calloc(
-            sizeof(CbArenaAllocation) + requiredBlockCount * CB_ARENA_BLOCK_SIZE,
-            1
-        );
+    // block data and curr are always max_align_t-aligned
+    if (alignedSize <= (size_t)(arena->end - arena->curr)) {
+        void *const allocation = arena->curr;
 
-        if (newAllocation == NULL)
-            return NULL;
+        arena->curr += alignedSize;
+        arena->bytesUsed += size;
 
-        // append new allocation to allocation stack
-        newAllocation->next = arena->allocations;
-        arena->allocations = newAllocation;
+        return allocation;
+    }
 
-        // setup curr/end pointers
-        arena->curr = newAllocation->data;
-        arena->end = newAllocation->data + requiredBlockCount * CB_ARENA_BLOCK_SIZE;
+    // large allocations don't replace current bump block
+    if (alignedSize >= CB_ARENA_LARGE_ALLOCATION_SIZE) {
+        CbArenaAllocation *const block = cbArenaAllocBlock(arena, alignedSize);
 
-        // calculate new allocationStart/allocationEnd pair
-        allocationStart = (void *)cbArenaAlignUp((size_t)arena->curr, sizeof(max_align_t));
-        allocationEnd = (uint8_t *)allocationStart + size;
+        if (block == NULL)
+            return NULL;
+
+        arena->bytesUsed += size;
+        return block->data;
     }
 
-    arena->curr = allocationEnd;
+    while (arena->nextBlockSize < alignedSize)
+        arena->nextBlockSize *= 2;
+
+    CbArenaAllocation *const block = cbArenaAllocBlock(arena, arena->nextBlockSize);
+
+    if (block == NULL)
+        return NULL;
 
-    return allocationStart;
+    if (arena->nextBlockSize < CB_ARENA_MAX_BLOCK_SIZE && block->size >= arena->nextBlockSize)
+        arena->nextBlockSize *= 2;
+
+    arena->curr = block->data + alignedSize;
+    arena->end = block->data + block->size;
+    arena->bytesUsed += size;
+
+    return block->data;
 } // cbArenaAlloc
 
+void cbArenaGetStat( CbArena const arena, CbArenaStat *const dst ) {
+    assert(arena != NULL);
+    assert(dst != NULL);
+
+    const size_t bytesAvailable = (size_t)(arena->end - arena->curr) + arena->bytesFree;
+
+    dst->bytesReserved = arena->bytesReserved;
+    dst->bytesUsed = arena->bytesUsed;
+    dst->blockCount = arena->blockCount;
+    dst->bytesWasted = arena->bytesReserved - arena->bytesUsed - bytesAvailable;
+} // cbArenaGetStat
+
+CbArenaMark cbArenaMark( CbArena const arena ) {
+    assert(arena != NULL);
+
+    return (CbArenaMark) {
+        .block     = arena->allocations,
+        .curr      = arena->curr,
+        .end       = arena->end,
+        .bytesUsed = arena->bytesUsed,
+    };
+} // cbArenaMark
+
+void cbArenaRollback( CbArena const arena, const CbArenaMark *const mark ) {
+    assert(arena != NULL);
+    assert(mark != NULL);
+
+    uint8_t *const markCurr = (uint8_t *)mark->curr;
+    uint8_t *const markEnd = (uint8_t *)mark->end;
+
+    // keep allocations zero-filled: bump block tail of mark is zeroed up to the point it was used to
+    if (arena->end == markEnd)
+        memset(markCurr, 0, (size_t)(arena->curr - markCurr));
+    else
+        memset(markCurr, 0, (size_t)(markEnd - markCurr));
+
+    // blocks allocated after mark are moved to free block list
+    while (arena->allocations != mark->block) {
+        CbArenaAllocation *const block = arena->allocations;
+
+        assert(block != NULL);
+
+        arena->allocations = block->next;
+        block->next = arena->freeBlocks;
+        arena->freeBlocks = block;
+        arena->bytesFree += block->size;
+    }
+
+    arena->curr = markCurr;
+    arena->end = markEnd;
+    arena->bytesUsed = mark->bytesUsed;
+} // cbArenaRollback
+
+void cbArenaReset( CbArena const arena ) {
+    assert(arena != NULL);
+
+    // arena implementation is the first allocation of the first block
+    CbArenaAllocation *first = arena->allocations;
+
+    while (first->next != NULL)
+        first = first->next;
+
+    const CbArenaMark mark = {
+        .block     = first,
+        .curr      = first->data + cbArenaAlignUp(sizeof(CbArenaImpl), sizeof(max_align_t)),
+        .end       = first->data + first->size,
+        .bytesUsed = sizeof(CbArenaImpl),
+    };
+
+    cbArenaRollback(arena, &mark);
+
+    arena->nextBlockSize = CB_ARENA_MIN_BLOCK_SIZE * 2;
+} // cbArenaReset
+
+void cbArenaAdopt( CbArena const arena, CbArena const other ) {
+    assert(arena != NULL);
+    assert(other != NULL);
+    assert(arena != other);
+
+    // 'other' is located in its own first block, so it's read before blocks are moved
+    const CbArenaImpl impl = *other;
+
+    if (impl.allocations != NULL) {
+        CbArenaAllocation *last = impl.allocations;
+
+        while (last->next != NULL)
+            last = last->next;
+
+        last->next = arena->allocations;
+        arena->allocations = impl.allocations;
+    }
+
+    if (impl.freeBlocks != NULL) {
+        CbArenaAllocation *last = impl.freeBlocks;
+
+        while (last->next != NULL)
+            last = last->next;
+
+        last->next = arena->freeBlocks;
+        arena->freeBlocks = impl.freeBlocks;
+    }
+
+    arena->bytesReserved += impl.bytesReserved;
+    arena->bytesUsed += impl.bytesUsed;
+    arena->bytesFree += impl.bytesFree;
+    arena->blockCount += impl.blockCount;
+} // cbArenaAdopt
+
 // cb_arena.c
@@ -42,6 +42,69 @@ void cbArenaDtor( CbArena arena );
  */
 void * cbArenaAlloc( CbArena arena, size_t size );
 
+/// @brief arena memory usage statistics
+typedef struct __CbArenaStat {
+    size_t bytesReserved; ///< total size of memory blocks requested from system
+    size_t bytesUsed;     ///< total size of allocations
+    size_t blockCount;    ///< count of memory blocks
+    size_t bytesWasted;   ///< reserved bytes that can't be used anymore (alignment padding and abandoned block tails)
+} CbArenaStat;
+
+/**
+ * @brief arena statistics getting function
+ * 
+ * @param[in]  arena arena pointer (non-null)
+ * @param[out] dst   statistics destination (non-null)
+ */
+void cbArenaGetStat( CbArena arena, CbArenaStat *dst );
+
+/// @brief arena state mark (contents are arena internals)
+typedef struct __CbArenaMark {
+    void   *block;     ///< most recently allocated block
+    void   *curr;      ///< current bump block free space begin
+    void   *end;       ///< current bump block end
+    size_t  bytesUsed; ///< total size of allocations
+} CbArenaMark;
+
+/**
+ * @brief current arena state marking function
+ * 
+ * @param[in] arena arena pointer (non-null)
+ * 
+ * @return mark to roll arena back to
+ */
+CbArenaMark cbArenaMark( CbArena arena );
+
+/**
+ * @brief arena state rollback function
+ * 
+ * @param[in,out] arena arena pointer (non-null)
+ * @param[in]     mark  mark got from the same arena (non-null, not invalidated by previous rollback to earlier mark or reset)
+ * 
+ * @note all allocations made after mark are invalidated. blocks allocated after mark are kept for reuse.
+ */
+void cbArenaRollback( CbArena arena, const CbArenaMark *mark );
+
+/**
+ * @brief arena reset function
+ * 
+ * @param[in,out] arena arena pointer (non-null)
+ * 
+ * @note all allocations are invalidated, but memory isn't returned to system, so arena may be reused without new system allocations.
+ */
+void cbArenaReset( CbArena arena );
+
+/**
+ * @brief other arena blocks adopting function
+ * 
+ * @param[in,out] arena arena pointer (non-null)
+ * @param[in]     other arena to take blocks of (non-null, destroyed by call)
+ * 
+ * @note allocations of 'other' stay valid and are freed with 'arena'. current bump block of 'arena' is kept,
+ *       so adopted blocks behave as ones of large allocations (rollback to earlier mark releases them).
+ */
+void cbArenaAdopt( CbArena arena, CbArena other );
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,521 @@
+/**
+ * @brief cactusbot mutation journal implementation file
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cb_journal.h"
+
+/// @brief journal file magic
+#define CB_JOURNAL_MAGIC "CBJRNL\0\1"
+
+/// @brief journal file header size
+#define CB_JOURNAL_HEADER_SIZE ((size_t)8)
+
+/// @brief count of strings in record payload
+#define CB_JOURNAL_RECORD_STRING_COUNT 3
+
+/// @brief journal record header
+typedef struct __CbJournalRecordHeader {
+    uint32_t size;     ///< payload size
+    uint32_t checksum; ///< payload checksum (32-bit FNV-1a)
+} CbJournalRecordHeader;
+
+/*
+ * journal file layout (native byte order):
+ *     char magic[8]; // CB_JOURNAL_MAGIC
+ *     records, each is
+ *         CbJournalRecordHeader header;
+ *         char                  payload[header.size]; // "leaf\0condition\0correct\0"
+ * 
+ * records are only appended, so crash may only leave torn record at the end, which is
+ * detected by size or checksum mismatch.
+ */
+
+/// @brief journal implementation structure
+typedef struct __CbJournalImpl {
+    int     fd;             ///< journal file descriptor (opened for appending)
+    size_t  groupSize;      ///< count of records per commit
+    char   *buffer;         ///< pending records
+    size_t  bufferSize;     ///< pending records size
+    size_t  bufferCapacity; ///< buffer capacity
+    size_t  pendingCount;   ///< count of pending records
+    size_t  recordCount;    ///< count of records in journal (including pending ones)
+    size_t  committedSize;  ///< journal file size after last successful commit
+    bool    isFailed;       ///< true if some write failed (records aren't appended until compaction then)
+} CbJournalImpl;
+
+/**
+ * @brief record payload checksum computation function (32-bit FNV-1a)
+ * 
+ * @param[in] data payload (non-null if size isn't 0)
+ * @param[in] size payload size
+ * 
+ * @return checksum
+ */
+static uint32_t cbJournalChecksum( const char *const data, const size_t size ) {
+    uint32_t hash = 0x811C9DC5;
+
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ (uint8_t)data[i]) * 0x01000193;
+
+    return hash;
+} // cbJournalChecksum
+
+/**
+ * @brief journal record parsing function
+ * 
+ * @param[in]     data    journal image (non-null)
+ * @param[in]     size    journal image size
+ * @param[in,out] offset  record offset, set to next record offset if record is valid (non-null)
+ * @param[out]    strings record strings (leaf, condition and correct) destination (non-null)
+ * 
+ * @return true if record is complete and valid, false at journal end or torn record
+ */
+static bool cbJournalNextRecord( const char *const data, const size_t size, size_t *const offset, const char **const strings ) {
+    CbJournalRecordHeader header;
+
+    if (size - *offset < sizeof(header))
+        return false;
+
+    memcpy(&header, data + *offset, sizeof(header));
+
+    const char *const payload = data + *offset + sizeof(header);
+
+    if (false
+        || header.size == 0
+        || header.size > size - *offset - sizeof(header)
+        || payload[header.size - 1] != '\0'
+        || cbJournalChecksum(payload, header.size) != header.checksum
+    )
+        return false;
+
+    // payload is exactly CB_JOURNAL_RECORD_STRING_COUNT zero-terminated strings
+    const char *string = payload;
+
+    for (size_t i = 0; i < CB_JOURNAL_RECORD_STRING_COUNT; i++) {
+        if (string >= payload + header.size)
+            return false;
+
+        strings[i] = string;
+        string += strlen(string) + 1;
+    }
+
+    if (string != payload + header.size)
+        return false;
+
+    *offset += sizeof(header) + header.size;
+
+    return true;
+} // cbJournalNextRecord
+
+/**
+ * @brief journal file mapping function
+ * 
+ * @param[in]  fd   file descriptor
+ * @param[out] data image destination (non-null, set to NULL for empty file)
+ * @param[out] size image size destination (non-null)
+ * 
+ * @return true if mapped, false otherwise
+ */
+static bool cbJournalMap( const int fd, const char **const data, size_t *const size ) {
+    struct stat fileStat;
+
+    if (fstat(fd, &fileStat) != 0)
+        return false;
+
+    *size = (size_t)fileStat.st_size;
+    *data = NULL;
+
+    if (*size == 0)
+        return true;
+
+    void *const mapping = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (mapping == MAP_FAILED)
+        return false;
+
+    *data = (const char *)mapping;
+
+    return true;
+} // cbJournalMap
+
+/**
+ * @brief whole buffer writing function
+ * 
+ * @param[in] fd   file descriptor
+ * @param[in] data data to write (non-null if size isn't 0)
+ * @param[in] size data size
+ * 
+ * @return true if written, false otherwise
+ */
+static bool cbJournalWrite( const int fd, const char *data, size_t size ) {
+    while (size > 0) {
+        const ssize_t written = write(fd, data, size);
+
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            return false;
+
+        data += written;
+        size -= (size_t)written;
+    }
+
+    return true;
+} // cbJournalWrite
+
+/**
+ * @brief pending records committing function
+ * 
+ * @param[in,out] self journal (non-null)
+ */
+static void cbJournalCommit( CbJournalImpl *const self ) {
+    // failed journal has no pending records
+    if (self->bufferSize == 0)
+        return;
+
+    // single write and sync for whole group
+    if (cbJournalWrite(self->fd, self->buffer, self->bufferSize) && fdatasync(self->fd) == 0) {
+        self->committedSize += self->bufferSize;
+    } else {
+        // partially written group is cut off, so replay wouldn't stop before later records;
+        // later records are refused anyway, as file state is unknown if truncation failed too
+        self->isFailed = true;
+        if (ftruncate(self->fd, (off_t)self->committedSize) == 0)
+            fdatasync(self->fd);
+        self->recordCount -= self->pendingCount;
+    }
+
+    self->bufferSize = 0;
+    self->pendingCount = 0;
+} // cbJournalCommit
+
+/**
+ * @brief record appending function (CbInsertHook implementation)
+ * 
+ * @param[in,out] context   journal
+ * @param[in]     leaf      leaf condition is inserted at
+ * @param[in]     condition condition text
+ * @param[in]     correct   new leaf name
+ */
+static void cbJournalAppend( void *const context, const char *const leaf, const char *const condition, const char *const correct ) {
+    CbJournalImpl *const self = (CbJournalImpl *)context;
+
+    // record after lost one couldn't be replayed
+    if (self->isFailed)
+        return;
+
+    const char *const strings[CB_JOURNAL_RECORD_STRING_COUNT] = {leaf, condition, correct};
+    size_t lengths[CB_JOURNAL_RECORD_STRING_COUNT] = {0};
+    size_t payloadSize = 0;
+
+    for (size_t i = 0; i < CB_JOURNAL_RECORD_STRING_COUNT; i++) {
+        lengths[i] = strlen(strings[i]) + 1;
+        payloadSize += lengths[i];
+    }
+
+    const size_t recordSize = sizeof(CbJournalRecordHeader) + payloadSize;
+
+    if (self->bufferSize + recordSize > self->bufferCapacity) {
+        const size_t capacity = (self->bufferSize + recordSize) * 2;
+        char *const buffer = (char *)realloc(self->buffer, capacity);
+
+        // records preceding lost one are still replayable
+        if (buffer == NULL || payloadSize > UINT32_MAX) {
+            cbJournalCommit(self);
+            self->isFailed = true;
+            return;
+        }
+
+        self->buffer = buffer;
+        self->bufferCapacity = capacity;
+    }
+
+    char *const record = self->buffer + self->bufferSize;
+    char *payload = record + sizeof(CbJournalRecordHeader);
+
+    for (size_t i = 0; i < CB_JOURNAL_RECORD_STRING_COUNT; i++) {
+        memcpy(payload, strings[i], lengths[i]);
+        payload += lengths[i];
+    }
+
+    const CbJournalRecordHeader header = {
+        .size     = (uint32_t)payloadSize,
+        .checksum = cbJournalChecksum(record + sizeof(CbJournalRecordHeader), payloadSize),
+    };
+
+    memcpy(record, &header, sizeof(header));
+
+    self->bufferSize += recordSize;
+    self->pendingCount++;
+    self->recordCount++;
+
+    if (self->pendingCount >= self->groupSize)
+        cbJournalCommit(self);
+} // cbJournalAppend
+
+CbJournal cbJournalCtor( const char *const path, const size_t groupSize ) {
+    assert(path != NULL);
+
+    const int fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+
+    if (fd == -1)
+        return NULL;
+
+    const char *data = NULL;
+    size_t size = 0;
+    size_t validSize = CB_JOURNAL_HEADER_SIZE;
+    size_t recordCount = 0;
+    bool ok = cbJournalMap(fd, &data, &size);
+
+    if (ok && size >= CB_JOURNAL_HEADER_SIZE) {
+        ok = memcmp(data, CB_JOURNAL_MAGIC, CB_JOURNAL_HEADER_SIZE) == 0;
+
+        const char *strings[CB_JOURNAL_RECORD_STRING_COUNT];
+
+        while (ok && cbJournalNextRecord(data, size, &validSize, strings))
+            recordCount++;
+    }
+
+    if (data != NULL)
+        munmap((void *)data, size);
+
+    // new journal (or one with torn header) gets header, torn record is cut off
+    if (ok && size < CB_JOURNAL_HEADER_SIZE)
+        ok = ftruncate(fd, 0) == 0 && cbJournalWrite(fd, CB_JOURNAL_MAGIC, CB_JOURNAL_HEADER_SIZE) && fdatasync(fd) == 0;
+    else if (ok && validSize < size)
+        ok = ftruncate(fd, (off_t)validSize) == 0 && fdatasync(fd) == 0;
+
+    CbJournalImpl *self = NULL;
+
+    if (!ok || (self = (CbJournalImpl *)calloc(1, sizeof(CbJournalImpl))) == NULL) {
+        close(fd);
+        return NULL;
+    }
+
+    self->fd = fd;
+    self->groupSize = groupSize == 0 ? 1 : groupSize;
+    self->recordCount = recordCount;
+    self->committedSize = validSize;
+
+    return self;
+} // cbJournalCtor
+
+void cbJournalDtor( CbJournal self ) {
+    if (self == NULL)
+        return;
+
+    cbJournalCommit(self);
+    close(self->fd);
+    free(self->buffer);
+    free(self);
+} // cbJournalDtor
+
+void cbJournalAttach( CbJournal self, Cb cb ) {
+    assert(self != NULL);
+    assert(cb != NULL);
+
+    cbSetInsertHook(cb, cbJournalAppend, self);
+} // cbJournalAttach
+
+void cbJournalDetach( CbJournal self, Cb cb ) {
+    assert(self != NULL);
+    assert(cb != NULL);
+
+    void *context = NULL;
+
+    // hook installed by someone else is kept
+    if (cbGetInsertHook(cb, &context) == cbJournalAppend && context == self)
+        cbSetInsertHook(cb, NULL, NULL);
+} // cbJournalDetach
+
+bool cbJournalSync( CbJournal self ) {
+    assert(self != NULL);
+
+    cbJournalCommit(self);
+
+    return !self->isFailed;
+} // cbJournalSync
+
+size_t cbJournalGetRecordCount( const CbJournal self ) {
+    assert(self != NULL);
+
+    return self->recordCount;
+} // cbJournalGetRecordCount
+
+/**
+ * @brief file parent directory syncing function (makes rename durable)
+ * 
+ * @param[in] path file path (non-null)
+ * 
+ * @return true if synced, false otherwise
+ */
+static bool cbJournalSyncDirectory( const char *const path ) {
+    const char *const slash = strrchr(path, '/');
+    char *directory = NULL;
+
+    if (slash == NULL) {
+        directory = strdup(".");
+    } else if ((directory = (char *)calloc(slash - path + 2, 1)) != NULL) {
+        // root directory keeps its slash
+        memcpy(directory, path, slash == path ? 1 : slash - path);
+    }
+
+    if (directory == NULL)
+        return false;
+
+    const int fd = open(directory, O_RDONLY);
+
+    free(directory);
+
+    if (fd == -1)
+        return false;
+
+    const bool ok = fsync(fd) == 0;
+
+    close(fd);
+
+    return ok;
+} // cbJournalSyncDirectory
+
+bool cbJournalCompact( CbJournal self, const Cb cb, const char *const basePath ) {
+    assert(self != NULL);
+    assert(cb != NULL);
+    assert(basePath != NULL);
+
+    // dump contains everything journal lost, so failed journal is recovered by compaction
+    cbJournalCommit(self);
+
+    const size_t basePathLength = strlen(basePath);
+    char *const tmpPath = (char *)calloc(basePathLength + sizeof(".tmp"), 1);
+
+    if (tmpPath == NULL)
+        return false;
+
+    memcpy(tmpPath, basePath, basePathLength);
+    memcpy(tmpPath + basePathLength, ".tmp", sizeof(".tmp"));
+
+    // base is replaced only by completely written and synced dump
+    FILE *const file = fopen(tmpPath, "wb");
+    bool ok = true
+        && file != NULL
+        && cbDumpBuffered(file, cb, CB_DUMP_FORMAT_COMPACT, NULL, 0)
+        && fflush(file) == 0
+        && fsync(fileno(file)) == 0;
+
+    if (file != NULL)
+        ok = fclose(file) == 0 && ok;
+
+    ok = ok && rename(tmpPath, basePath) == 0;
+
+    if (!ok)
+        remove(tmpPath);
+    free(tmpPath);
+
+    // journal is truncated only after new base is durable
+    ok = true
+        && ok
+        && cbJournalSyncDirectory(basePath)
+        && ftruncate(self->fd, (off_t)CB_JOURNAL_HEADER_SIZE) == 0
+        && fdatasync(self->fd) == 0;
+
+    if (ok) {
+        self->recordCount = 0;
+        self->committedSize = CB_JOURNAL_HEADER_SIZE;
+        self->isFailed = false;
+    }
+
+    return ok;
+} // cbJournalCompact
+
+bool cbJournalReplay( const char *const path, Cb cb, size_t *const recordCount ) {
+    assert(path != NULL);
+    assert(cb != NULL);
+
+    if (recordCount != NULL)
+        *recordCount = 0;
+
+    const int fd = open(path, O_RDONLY);
+
+    if (fd == -1)
+        return errno == ENOENT;
+
+    const char *data = NULL;
+    size_t size = 0;
+    bool ok = cbJournalMap(fd, &data, &size);
+
+    close(fd);
+
+    // torn header means no records are written
+    if (!ok || size < CB_JOURNAL_HEADER_SIZE) {
+        if (data != NULL)
+            munmap((void *)data, size);
+        return ok;
+    }
+
+    ok = memcmp(data, CB_JOURNAL_MAGIC, CB_JOURNAL_HEADER_SIZE) == 0;
+
+    const char *strings[CB_JOURNAL_RECORD_STRING_COUNT];
+    size_t offset = CB_JOURNAL_HEADER_SIZE;
+    size_t count = 0;
+
+    while (ok && cbJournalNextRecord(data, size, &offset, strings)) {
+        CbIter iter;
+
+        // record may be already folded into base by interrupted compaction
+        if (cbIterFindLeaf(cb, strings[2], &iter))
+            continue;
+
+        ok = true
+            && cbIterFindLeaf(cb, strings[0], &iter)
+            && cbIterInsertCorrect(&iter, strings[1], strings[2]);
+        count++;
+    }
+
+    munmap((void *)data, size);
+
+    if (recordCount != NULL)
+        *recordCount = count;
+
+    return ok;
+} // cbJournalReplay
+
+bool cbJournalLoad( const char *const basePath, const char *const journalPath, const CbLeafIndex leafIndex, Cb *const dst ) {
+    assert(basePath != NULL);
+    assert(journalPath != NULL);
+    assert(dst != NULL);
+
+    FILE *const file = fopen(basePath, "rb");
+
+    if (file == NULL)
+        return false;
+
+    Cb cb = NULL;
+    const bool parsed = cbParseFile(file, leafIndex, &cb);
+
+    fclose(file);
+
+    if (!parsed)
+        return false;
+
+    if (!cbJournalReplay(journalPath, cb, NULL)) {
+        cbDtor(cb);
+        return false;
+    }
+
+    *dst = cb;
+
+    return true;
+} // cbJournalLoad
+
+// cb_journal.c
@@ -0,0 +1,129 @@
+/**
+ * @brief cactusbot mutation journal declaration file
+ */
+
+#ifndef CB_JOURNAL_H_
+#define CB_JOURNAL_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "cb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // defined(__cplusplus)
+
+/// @brief append-only insertion journal handle
+typedef struct __CbJournalImpl * CbJournal;
+
+/**
+ * @brief journal constructor
+ * 
+ * @param[in] path      journal file path (non-null, file is created if it doesn't exist)
+ * @param[in] groupSize count of records written by single write and fsync (group commit), 0 is treated as 1
+ * 
+ * @return journal handle, NULL if file can't be opened or isn't a journal.
+ * 
+ * @note torn record at the end of existing journal (left by crash during write) is cut off.
+ */
+CbJournal cbJournalCtor( const char *path, size_t groupSize );
+
+/**
+ * @brief journal destructor
+ * 
+ * @param[in] self journal to sync and close (nullable, must be detached from cb)
+ */
+void cbJournalDtor( CbJournal self );
+
+/**
+ * @brief journal to cb attaching function
+ * 
+ * @param[in,out] self journal (non-null)
+ * @param[in,out] cb   cb to journal insertions of (non-null)
+ * 
+ * @note every successful cbIterInsertCorrect appends record (leaf name, condition, new leaf name).
+ * records are durable only after group is committed, cbJournalSync or cbJournalDtor.
+ * after failed write journal is cut back to last committed group and appends nothing until cbJournalCompact.
+ * other mutations (cbReset, cbOptimize, cbMerge, cbSetVersion) aren't journaled, cbJournalCompact should follow them.
+ * function requires exclusive access to cb.
+ */
+void cbJournalAttach( CbJournal self, Cb cb );
+
+/**
+ * @brief journal from cb detaching function
+ * 
+ * @param[in,out] self journal (non-null)
+ * @param[in,out] cb   cb journal is attached to (non-null)
+ * 
+ * @note hook is removed only if it's this journal one, other hooks are kept.
+ * function requires exclusive access to cb.
+ */
+void cbJournalDetach( CbJournal self, Cb cb );
+
+/**
+ * @brief pending records committing function
+ * 
+ * @param[in,out] self journal (non-null)
+ * 
+ * @return true if all records are written and synced, false if some write failed (since journal construction or last compaction)
+ */
+bool cbJournalSync( CbJournal self );
+
+/**
+ * @brief count of records in journal getting function
+ * 
+ * @param[in] self journal (non-null)
+ * 
+ * @return count of records appended since journal file start (or last compaction), including pending ones
+ */
+size_t cbJournalGetRecordCount( const CbJournal self );
+
+/**
+ * @brief journal into full dump folding function
+ * 
+ * @param[in,out] self     journal (non-null)
+ * @param[in]     cb       cb journal describes (non-null)
+ * @param[in]     basePath base dump path (non-null)
+ * 
+ * @return true if compacted, false if something went wrong (journal isn't truncated then)
+ * 
+ * @note cb is dumped in compact format to temporary file, which replaces base file atomically,
+ * and journal is truncated after that. journal replay is idempotent, so crash between
+ * these steps loses nothing. successful compaction recovers journal after failed write.
+ */
+bool cbJournalCompact( CbJournal self, const Cb cb, const char *basePath );
+
+/**
+ * @brief journal replaying function
+ * 
+ * @param[in]  path        journal file path (non-null)
+ * @param[in]  cb          cb to apply records to (non-null, usually parsed from base dump)
+ * @param[out] recordCount count of applied records destination (nullable)
+ * 
+ * @return true if replayed, false if journal can't be read or record refers to unknown leaf.
+ * 
+ * @note records with already present new leaf are skipped, missing journal is considered empty,
+ * replay stops at torn record. cb must have no journal attached.
+ */
+bool cbJournalReplay( const char *path, Cb cb, size_t *recordCount );
+
+/**
+ * @brief base dump and journal loading function
+ * 
+ * @param[in]  basePath    base dump path (non-null)
+ * @param[in]  journalPath journal path (non-null)
+ * @param[in]  leafIndex   leaf index kind
+ * @param[out] dst         loading destination (non-null)
+ * 
+ * @return true if loaded, false if base can't be parsed or journal can't be replayed.
+ */
+bool cbJournalLoad( const char *basePath, const char *journalPath, CbLeafIndex leafIndex, Cb *dst );
+
+#ifdef __cplusplus
+}
+#endif // defined(__cplusplus)
+
+#endif // !defined(CB_JOURNAL_H_)
+
+// cb_journal.h
@@ -9,8 +9,30 @@
 #include <errno.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <signal.h>
 
 #include "cb.h"
+#include "cb_journal.h"
+#include "cb_server.h"
+#include "cb_trie.h"
+
+/// @brief count of journal records that triggers journal compaction
+#define CLI_JOURNAL_COMPACT_RECORD_COUNT 4096
+
+/// @brief maximal count of printed search results
+#define CLI_SEARCH_RESULT_COUNT 10
+
+/// @brief maximal edit distance of suggested leaf names
+#define CLI_SUGGEST_DISTANCE 2
+
+/// @brief maximal count of printed versions
+#define CLI_VERSION_LIST_COUNT 10
+
+/// @brief maximal count of simultaneous server connections
+#define CLI_SERVER_SESSION_COUNT 16384
+
+/// @brief running server (stopped by signal handler)
+static CbServer cliServer = NULL;
 
 /**
  * @brief string start comparison function
@@ -33,10 +55,16 @@ void cliPrintHelp( void ) {
         "    выход      - выйти из программы \n"
         "    вывести    - вывести всё дерево данных \n"
         "    сохранить  - сохранить дерево в файл \n"
-        "    загрузить  - загрузить дерево из файла \n"
+        "    сжать      - сохранить дерево в файл в сжатом двоичном формате \n"
+        "    загрузить  - загрузить дерево из файла (текстового или сжатого) \n"
         "    начать     - начать проход по дереву \n"
         "    очистить   - пересоздать дерево \n"
         "    определить - вывести определение объекта согласно дереву \n"
+        "    найти      - вывести объекты, названия которых начинаются с заданной строки \n"
+        "    журнал     - сохранять каждое изменение дерева в файл (дерево загружается из него, если файл есть) \n"
+        "    версии     - вывести последние версии дерева \n"
+        "    откатить   - вернуть дерево к заданной версии \n"
+        "    изменения  - вывести объекты, добавленные и убранные после заданной версии \n"
     );
 } // cliPrintHelp
 
@@ -47,6 +75,8 @@ void cliPrintDbgHelp( void ) {
     puts(
         "    сохранитьЛистовоеДерево - сохранить внутреннее дерево, построенное для оптимизации поиска листьев, в файл в формате dot.\n"
         "    сохранитьДерево         - сохранить основное дерево в файл в формате dot.\n"
+        "    статистика              - вывести статистику проходов по дереву.\n"
+        "    сохранитьСтатистику     - сохранить статистику проходов по дереву в файл в формате JSON.\n"
     );
 } // cliPrintDbgHelp
 
@@ -74,13 +104,180 @@ FILE * cliOpenFile( const char *mode ) {
     return file;
 } // cliOpenFile
 
+/**
+ * @brief CLI path reading 'menu'
+ * 
+ * @param[out] buffer     path buffer (non-null)
+ * @param[in]  bufferSize path buffer size
+ */
+void cliReadPath( char *buffer, size_t bufferSize ) {
+    printf("    Путь? ");
+    buffer[0] = '\0';
+    fgets(buffer, bufferSize, stdin);
+
+    const size_t len = strlen(buffer);
+    if (len > 0)
+        buffer[len - 1] = '\0';
+} // cliReadPath
+
+/**
+ * @brief CLI version reading 'menu'
+ * 
+ * @param[in] cb cb to find version of (non-null)
+ * 
+ * @return version with read number, NULL if there is no such version.
+ */
+CbVersion cliReadVersion( const Cb cb ) {
+    char buffer[64] = {0};
+
+    printf("    Номер версии? ");
+    fgets(buffer, sizeof(buffer), stdin);
+
+    char *end = NULL;
+    const size_t number = strtoull(buffer, &end, 10);
+    const CbVersion version = end != buffer ? cbFindVersion(cb, number) : NULL;
+
+    if (version == NULL)
+        printf("    Нет такой версии\n");
+    return version;
+} // cliReadVersion
+
+/**
+ * @brief leaf trie getting function
+ * 
+ * @param[in]     cb   cb to index leaves of (non-null)
+ * @param[in,out] trie cached trie (non-null, NULL is replaced by trie built for cb)
+ * 
+ * @return trie, NULL if it can't be built
+ * 
+ * @note trie isn't updated by insertions, so cached trie is dropped by every tree change and rebuilt by next search.
+ */
+CbLeafTrie cliGetTrie( const Cb cb, CbLeafTrie *trie ) {
+    if (*trie == NULL)
+        *trie = cbLeafTrieCtor(cb);
+    return *trie;
+} // cliGetTrie
+
+/**
+ * @brief cached leaf trie dropping function
+ * 
+ * @param[in,out] trie cached trie (non-null, set to NULL)
+ */
+void cliDropTrie( CbLeafTrie *trie ) {
+    cbLeafTrieDtor(*trie);
+    *trie = NULL;
+} // cliDropTrie
+
+/**
+ * @brief server stopping signal handler
+ * 
+ * @param[in] signalNumber signal number
+ */
+void cliStopServer( int signalNumber ) {
+    (void)signalNumber;
+
+    if (cliServer != NULL)
+        cbServerStop(cliServer);
+} // cliStopServer
+
+/**
+ * @brief server mode running function
+ * 
+ * @param[in] socketPath Unix domain socket path (non-null)
+ * @param[in] treePath   tree file path (nullable, tree is loaded from it and saved back on stop)
+ * 
+ * @return exit status
+ */
+int cliServe( const char *socketPath, const char *treePath ) {
+    Cb cb = NULL;
+    FILE *file = treePath != NULL ? fopen(treePath, "r") : NULL;
+
+    if (file != NULL) {
+        const bool parsed = cbParseFile(file, CB_LEAF_INDEX_HASH, &cb);
+
+        fclose(file);
+        if (!parsed) {
+            printf("Ошибка парсинга\n");
+            return 1;
+        }
+    } else {
+        cb = cbCtor("пустота", CB_LEAF_INDEX_HASH);
+    }
+
+    // sessions insert concurrently, so tree keeps no versions (see cbServerRun)
+    cliServer = cb != NULL ? cbServerCtor(cb, socketPath, CLI_SERVER_SESSION_COUNT) : NULL;
+
+    if (cliServer == NULL) {
+        printf("Ошибка запуска сервера: %s\n", strerror(errno));
+        cbDtor(cb);
+        return 1;
+    }
+
+    signal(SIGINT, cliStopServer);
+    signal(SIGTERM, cliStopServer);
+
+    printf("Сервер запущен: %s\n", socketPath);
+    fflush(stdout);
+
+    const bool isStopped = cbServerRun(cliServer);
+    CbServerStat stat = {0};
+
+    cbServerGetStat(cliServer, &stat);
+    printf("Сервер остановлен: %zu сессий, %zu добавлений, %zu запросов\n", stat.sessionCount, stat.insertionCount, stat.requestCount);
+
+    cbServerDtor(cliServer);
+    cliServer = NULL;
+
+    // tree file is replaced only by completely written dump, so failed save keeps previous tree
+    bool isSaved = true;
+
+    if (treePath != NULL) {
+        char tmpPath[512] = {0};
+
+        file = NULL;
+        isSaved = true
+            && (size_t)snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", treePath) < sizeof(tmpPath)
+            && (file = fopen(tmpPath, "w")) != NULL
+            && cbDumpBuffered(file, cb, CB_DUMP_FORMAT_INDENTED, NULL, 0);
+
+        if (file != NULL)
+            isSaved = fclose(file) == 0 && isSaved;
+        isSaved = isSaved && rename(tmpPath, treePath) == 0;
+
+        if (!isSaved) {
+            printf("Ошибка сохранения дерева: %s\n", strerror(errno));
+            remove(tmpPath);
+        }
+    }
+
+    cbDtor(cb);
+
+    return isStopped && isSaved ? 0 : 1;
+} // cliServe
+
 /**
  * @brief main project function
  * 
+ * @param[in] argc argument count
+ * @param[in] argv arguments ('--server socket [tree file]' runs server mode, interactive session is run otherwise)
+ * 
  * @return exit status
  */
-int main( void ) {
-    Cb cb = cbCtor("пустота");
+int main( int argc, const char **argv ) {
+    if (argc > 2 && strcmp(argv[1], "--server") == 0)
+        return cliServe(argv[2], argc > 3 ? argv[3] : NULL);
+
+    Cb cb = cbCtor("пустота", CB_LEAF_INDEX_TREE);
+
+    // journal and base file it's compacted into, NULL if tree isn't journaled
+    CbJournal journal = NULL;
+    char journalBasePath[512] = {0};
+
+    // leaf trie for search, NULL until first search after tree change
+    CbLeafTrie trie = NULL;
+
+    cbEnableStat(cb);
+    cbEnableVersions(cb);
 
     setlocale(LC_ALL, "RU");
 
@@ -112,36 +309,49 @@ int main( void ) {
             continue;
         }
 
-        if (startsWith(commandBuffer, "загрузить")) {
-            FILE *file = cliOpenFile("r");
+        if (startsWith(commandBuffer, "сжать")) {
+            FILE *file = cliOpenFile("wb");
             if (file == NULL)
                 continue;
 
-            fseek(file, 0, SEEK_END);
-            size_t size = ftell(file);
-            fseek(file, 0, SEEK_SET);
+            if (!cbDumpBuffered(file, cb, CB_DUMP_FORMAT_PACKED, NULL, 0))
+                printf("    Ошибка сохранения\n");
+            fclose(file);
 
-            char *text = (char *)calloc(size, sizeof(char));
+            continue;
+        }
 
-            if (text == NULL) {
-                fclose(file);
-                printf("    Ошибка выделения памяти.\n");
+        if (startsWith(commandBuffer, "загрузить")) {
+            FILE *file = cliOpenFile("rb");
+            if (file == NULL)
                 continue;
-            }
 
-            fread(text, 1, size, file);
+            // packed dump is detected by its magic
+            Cb newCb = NULL;
+            const bool parsed = cbParseDetectFile(file, CB_LEAF_INDEX_TREE, &newCb);
 
             fclose(file);
 
-            Cb newCb = NULL;
-
-            if (!cbParse(text, &newCb)) {
+            if (!parsed) {
                 printf("    Ошибка парсинга");
                 continue;
             }
 
+            if (journal != NULL)
+                cbJournalDetach(journal, cb);
+
             cbDtor(cb);
             cb = newCb;
+            cliDropTrie(&trie);
+            cbEnableStat(cb);
+            cbEnableVersions(cb);
+
+            // loaded tree isn't described by journal, so it's folded into base
+            if (journal != NULL) {
+                cbJournalAttach(journal, cb);
+                if (!cbJournalCompact(journal, cb, journalBasePath))
+                    printf("    Ошибка сохранения журнала\n");
+            }
 
             continue;
         }
@@ -185,6 +395,15 @@ int main( void ) {
                     printf("Произошла внутренняя ошибка...\n");
                     break;
                 }
+
+                cliDropTrie(&trie);
+
+                if (true
+                    && journal != NULL
+                    && cbJournalGetRecordCount(journal) >= CLI_JOURNAL_COMPACT_RECORD_COUNT
+                    && !cbJournalCompact(journal, cb, journalBasePath)
+                )
+                    printf("    Ошибка сохранения журнала\n");
             }
 
 
@@ -201,15 +420,64 @@ int main( void ) {
             if (bufferLen != 0)
                 buffer[bufferLen - 1] = '\0';
 
-            Cb newCb = cbCtor(buffer);
-
-            if (newCb == NULL) {
+            // old tree memory is reused by new one
+            if (!cbReset(cb, buffer)) {
                 printf("Произошла внутренняя ошибка...");
+                break;
+            }
+
+            cliDropTrie(&trie);
+
+            // reset isn't journaled
+            if (journal != NULL && !cbJournalCompact(journal, cb, journalBasePath))
+                printf("    Ошибка сохранения журнала\n");
+
+            continue;
+        }
+
+        if (startsWith(commandBuffer, "журнал")) {
+            if (journal != NULL) {
+                cbJournalDetach(journal, cb);
+                cbJournalDtor(journal);
+                journal = NULL;
+            }
+
+            cliReadPath(journalBasePath, sizeof(journalBasePath));
+
+            char journalPath[sizeof(journalBasePath) + sizeof(".journal")] = {0};
+            snprintf(journalPath, sizeof(journalPath), "%s.journal", journalBasePath);
+
+            // existing base is loaded with journal tail, current tree is saved otherwise
+            FILE *base = fopen(journalBasePath, "r");
+
+            if (base != NULL) {
+                fclose(base);
+
+                Cb newCb = NULL;
+
+                if (!cbJournalLoad(journalBasePath, journalPath, CB_LEAF_INDEX_TREE, &newCb)) {
+                    printf("    Ошибка загрузки журнала\n");
+                    continue;
+                }
+
+                cbDtor(cb);
+                cb = newCb;
+                cliDropTrie(&trie);
+                cbEnableStat(cb);
+                cbEnableVersions(cb);
+            }
+
+            journal = cbJournalCtor(journalPath, 1);
+
+            if (journal == NULL) {
+                printf("    Ошибка открытия журнала: %s\n", strerror(errno));
                 continue;
             }
 
-            cbDtor(cb);
-            cb = newCb;
+            cbJournalAttach(journal, cb);
+
+            if (!cbJournalCompact(journal, cb, journalBasePath))
+                printf("    Ошибка сохранения журнала\n");
 
             continue;
         }
@@ -256,6 +524,17 @@ int main( void ) {
 
             case CB_DEFINE_STATUS_NO_SUBJECT: {
                 printf("    \"%s\" неизвестен.", buffer);
+
+                const CbLeafTrie searchTrie = cliGetTrie(cb, &trie);
+                CbLeafMatch matches[CLI_SEARCH_RESULT_COUNT];
+                const size_t matchCount = searchTrie != NULL
+                    ? cbLeafTrieFindFuzzy(searchTrie, buffer, CLI_SUGGEST_DISTANCE, matches, CLI_SEARCH_RESULT_COUNT)
+                    : 0;
+
+                for (size_t i = 0; i < matchCount && i < CLI_SEARCH_RESULT_COUNT; i++)
+                    printf("%s\"%s\"", i == 0 ? " Возможно, имелся в виду " : ", ", matches[i].name);
+                printf("\n");
+
                 break;
             }
             }
@@ -263,6 +542,97 @@ int main( void ) {
             continue;
         }
 
+        if (startsWith(commandBuffer, "найти")) {
+            char buffer[512];
+
+            printf("    Начало названия? ");
+            fgets(buffer, sizeof(buffer), stdin);
+            const size_t len = strlen(buffer);
+            if (len != 0)
+                buffer[len - 1] = '\0';
+
+            const CbLeafTrie searchTrie = cliGetTrie(cb, &trie);
+
+            if (searchTrie == NULL) {
+                printf("Произошла внутренняя ошибка...\n");
+                continue;
+            }
+
+            const char *names[CLI_SEARCH_RESULT_COUNT];
+            const size_t nameCount = cbLeafTrieFindPrefix(searchTrie, buffer, names, CLI_SEARCH_RESULT_COUNT);
+
+            for (size_t i = 0; i < nameCount && i < CLI_SEARCH_RESULT_COUNT; i++)
+                printf("    %s\n", names[i]);
+            if (nameCount > CLI_SEARCH_RESULT_COUNT)
+                printf("    ... и ещё %zu\n", nameCount - CLI_SEARCH_RESULT_COUNT);
+            if (nameCount == 0)
+                printf("    Ничего не найдено.\n");
+
+            continue;
+        }
+
+        if (startsWith(commandBuffer, "версии")) {
+            CbVersion version = cbGetVersion(cb);
+
+            // current version goes first, then ones it's derived from
+            for (size_t i = 0; version != NULL && i < CLI_VERSION_LIST_COUNT; i++) {
+                CbVersionInfo info = {0};
+
+                cbVersionGetInfo(version, &info);
+                if (info.leaf != NULL)
+                    printf("    %zu: %zu элементов, добавлен \"%s\"\n", info.number, info.treeSize, info.leaf);
+                else
+                    printf("    %zu: %zu элементов\n", info.number, info.treeSize);
+                version = info.prev;
+            }
+
+            continue;
+        }
+
+        if (startsWith(commandBuffer, "откатить")) {
+            const CbVersion version = cliReadVersion(cb);
+
+            if (version == NULL)
+                continue;
+
+            if (!cbSetVersion(cb, version)) {
+                printf("Произошла внутренняя ошибка...\n");
+                continue;
+            }
+
+            cliDropTrie(&trie);
+
+            // rollback isn't journaled
+            if (journal != NULL && !cbJournalCompact(journal, cb, journalBasePath))
+                printf("    Ошибка сохранения журнала\n");
+
+            continue;
+        }
+
+        if (startsWith(commandBuffer, "изменения")) {
+            const CbVersion version = cliReadVersion(cb);
+
+            if (version == NULL)
+                continue;
+
+            CbVersionChange changes[CLI_SEARCH_RESULT_COUNT];
+            size_t changeCount = 0;
+
+            if (!cbVersionDiff(version, cbGetVersion(cb), changes, CLI_SEARCH_RESULT_COUNT, &changeCount)) {
+                printf("Произошла внутренняя ошибка...\n");
+                continue;
+            }
+
+            for (size_t i = 0; i < changeCount && i < CLI_SEARCH_RESULT_COUNT; i++)
+                printf("    %c %s\n", changes[i].isAdded ? '+' : '-', changes[i].name);
+            if (changeCount > CLI_SEARCH_RESULT_COUNT)
+                printf("    ... и ещё %zu\n", changeCount - CLI_SEARCH_RESULT_COUNT);
+            if (changeCount == 0)
+                printf("    Изменений нет.\n");
+
+            continue;
+        }
+
         // debug command set
         if (commandBuffer[0] == '!') {
             if (startsWith(commandBuffer + 1, "сохранитьЛистовоеДерево")) {
@@ -277,6 +647,14 @@ int main( void ) {
                     continue;
                 cbDbgDumpDot(file, cb);
                 fclose(file);
+            } else if (startsWith(commandBuffer + 1, "статистика")) {
+                cbDumpStat(stdout, cb, CB_STAT_FORMAT_TEXT);
+            } else if (startsWith(commandBuffer + 1, "сохранитьСтатистику")) {
+                FILE *file = cliOpenFile("w");
+                if (file == NULL)
+                    continue;
+                cbDumpStat(file, cb, CB_STAT_FORMAT_JSON);
+                fclose(file);
             } else {
                 cliPrintDbgHelp();
             }
@@ -288,83 +666,15 @@ int main( void ) {
         cliPrintHelp();
     }
 
+    if (journal != NULL) {
+        cbJournalDetach(journal, cb);
+        cbJournalDtor(journal);
+    }
+
+    cbLeafTrieDtor(trie);
     cbDtor(cb);
 
     return 0;
 } // main
 
-// unused functions that may become too useful to be completely deleted from project
-#if 0
-
-/**
- * @brief single UTF-8 character from byte array to UTF-32 format decoding function
- * 
- * @param[in] str     array to decode character from pointer
- * @param[in] charDst character decoding destination
- * 
- * @return true if decoded, false if not
- */
-bool utf8StrNextChar( const char **str, uint32_t *charDst ) {
-    *charDst = 0;
-
-    int8_t *dst = (int8_t *)charDst;
-
-    dst[0] = *(*str)++;
-
-    if (dst[0] == '\0')
-        return true;
-
-    // 1 char
-    if ((dst[0] & 0x80) == 0x00)
-        return true;
-
-    // 2 chars
-    if ((dst[0] & 0xE0) == 0xC0) {
-        dst[1] = *(*str)++;
-
-        return true
-            && (dst[1] & 0xC0) == 0x80;
-    }
-
-    // 3 chars
-    if ((dst[0] & 0xF0) == 0xE0) {
-        dst[1] = *(*str)++;
-        dst[2] = *(*str)++;
-        return true
-            && (dst[1] & 0xC0) == 0x80
-            && (dst[2] & 0xC0) == 0x80
-        ;
-    }
-
-    // 4 chars
-    if ((dst[0] & 0xF1) == 0xF0) {
-        dst[1] = *(*str)++;
-        dst[2] = *(*str)++;
-        dst[3] = *(*str)++;
-        return true
-            && (dst[1] & 0xC0) == 0x80
-            && (dst[2] & 0xC0) == 0x80
-            && (dst[3] & 0xC0) == 0x80
-        ;
-    }
-
-    return false;
-} // utf8StrNextChar
-
-bool utf8StrLength( const char *str, size_t *dst ) {
-    uint32_t ch = 0;
-    size_t len = 0;
-
-    for (;;) {
-        if (!utf8StrNextChar(&str, &ch))
-            return false;
-        if (ch == 0) {
-            *dst = len;
-            return true;
-        }
-        len++;
-    }
-} // utf8StrLength
-#endif
-
 // cb_main.c
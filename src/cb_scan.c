@@ -0,0 +1,235 @@
+/**
+ * @brief text format scanning primitives implementation file
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cb_scan.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define CB_SCAN_X86
+    #include <immintrin.h>
+#endif
+
+/// @brief scanning function pointer
+typedef const char * (* CbScanFunc)( const char *begin, const char *end );
+
+/**
+ * @brief space character checking function
+ * 
+ * @param[in] ch character to check
+ * 
+ * @return true if character is space, false if not.
+ */
+static bool cbScanIsSpace( const char ch ) {
+    return false
+        || ch == ' '
+        || ch == '\r'
+        || ch == '\n'
+        || ch == '\t'
+    ;
+} // cbScanIsSpace
+
+/**
+ * @brief scalar cbScanSpaces implementation
+ */
+static const char * cbScanSpacesScalar( const char *begin, const char *const end ) {
+    while (begin < end && cbScanIsSpace(*begin))
+        begin++;
+    return begin;
+} // cbScanSpacesScalar
+
+/**
+ * @brief scalar cbScanQuote implementation
+ */
+static const char * cbScanQuoteScalar( const char *begin, const char *const end ) {
+    while (begin < end && *begin != '\"')
+        begin++;
+    return begin;
+} // cbScanQuoteScalar
+
+#ifdef CB_SCAN_X86
+
+/**
+ * @brief SSE2 cbScanSpaces implementation
+ */
+__attribute__((target("sse2")))
+static const char * cbScanSpacesSse2( const char *begin, const char *const end ) {
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i tab = _mm_set1_epi8('\t');
+
+    while (end - begin >= 16) {
+        const __m128i chunk = _mm_loadu_si128((const __m128i *)begin);
+        const __m128i isSpace = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, cr)),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, lf), _mm_cmpeq_epi8(chunk, tab))
+        );
+        const uint32_t mask = ~(uint32_t)_mm_movemask_epi8(isSpace) & 0xFFFF;
+
+        if (mask != 0)
+            return begin + __builtin_ctz(mask);
+        begin += 16;
+    }
+
+    return cbScanSpacesScalar(begin, end);
+} // cbScanSpacesSse2
+
+/**
+ * @brief SSE2 cbScanQuote implementation
+ */
+__attribute__((target("sse2")))
+static const char * cbScanQuoteSse2( const char *begin, const char *const end ) {
+    const __m128i quote = _mm_set1_epi8('\"');
+
+    while (end - begin >= 16) {
+        const __m128i chunk = _mm_loadu_si128((const __m128i *)begin);
+        const uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, quote));
+
+        if (mask != 0)
+            return begin + __builtin_ctz(mask);
+        begin += 16;
+    }
+
+    return cbScanQuoteScalar(begin, end);
+} // cbScanQuoteSse2
+
+/**
+ * @brief AVX2 cbScanSpaces implementation
+ */
+__attribute__((target("avx2")))
+static const char * cbScanSpacesAvx2( const char *begin, const char *const end ) {
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const __m256i tab = _mm256_set1_epi8('\t');
+
+    while (end - begin >= 32) {
+        const __m256i chunk = _mm256_loadu_si256((const __m256i *)begin);
+        const __m256i isSpace = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, space), _mm256_cmpeq_epi8(chunk, cr)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, lf), _mm256_cmpeq_epi8(chunk, tab))
+        );
+        const uint32_t mask = ~(uint32_t)_mm256_movemask_epi8(isSpace);
+
+        if (mask != 0)
+            return begin + __builtin_ctz(mask);
+        begin += 32;
+    }
+
+    return cbScanSpacesSse2(begin, end);
+} // cbScanSpacesAvx2
+
+/**
+ * @brief AVX2 cbScanQuote implementation
+ */
+__attribute__((target("avx2")))
+static const char * cbScanQuoteAvx2( const char *begin, const char *const end ) {
+    const __m256i quote = _mm256_set1_epi8('\"');
+
+    while (end - begin >= 32) {
+        const __m256i chunk = _mm256_loadu_si256((const __m256i *)begin);
+        const uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, quote));
+
+        if (mask != 0)
+            return begin + __builtin_ctz(mask);
+        begin += 32;
+    }
+
+    return cbScanQuoteSse2(begin, end);
+} // cbScanQuoteAvx2
+
+#endif // defined(CB_SCAN_X86)
+
+/*
+ * level is selected by first scan of any thread, so variables below are accessed atomically:
+ * threads racing on first scan select same level, and level is stored before implementations
+ * are released, so thread that sees implementation sees its level too.
+ */
+
+/// @brief current level cbScanSpaces implementation, NULL if level isn't selected yet
+static CbScanFunc cbScanSpacesImpl = NULL;
+
+/// @brief current level cbScanQuote implementation, NULL if level isn't selected yet
+static CbScanFunc cbScanQuoteImpl = NULL;
+
+/// @brief current level
+static CbScanLevel cbScanLevel = CB_SCAN_LEVEL_SCALAR;
+
+CbScanLevel cbScanGetMaxLevel( void ) {
+#ifdef CB_SCAN_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2"))
+        return CB_SCAN_LEVEL_AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return CB_SCAN_LEVEL_SSE2;
+#endif
+
+    return CB_SCAN_LEVEL_SCALAR;
+} // cbScanGetMaxLevel
+
+void cbScanSetLevel( CbScanLevel level ) {
+    const CbScanLevel maxLevel = cbScanGetMaxLevel();
+
+    if (level > maxLevel)
+        level = maxLevel;
+
+    CbScanFunc spaces = cbScanSpacesScalar;
+    CbScanFunc quote = cbScanQuoteScalar;
+
+    switch (level) {
+#ifdef CB_SCAN_X86
+    case CB_SCAN_LEVEL_AVX2:
+        spaces = cbScanSpacesAvx2;
+        quote = cbScanQuoteAvx2;
+        break;
+
+    case CB_SCAN_LEVEL_SSE2:
+        spaces = cbScanSpacesSse2;
+        quote = cbScanQuoteSse2;
+        break;
+#endif
+
+    default:
+        break;
+    }
+
+    __atomic_store_n(&cbScanLevel, level, __ATOMIC_RELAXED);
+    __atomic_store_n(&cbScanQuoteImpl, quote, __ATOMIC_RELEASE);
+    __atomic_store_n(&cbScanSpacesImpl, spaces, __ATOMIC_RELEASE);
+} // cbScanSetLevel
+
+CbScanLevel cbScanGetLevel( void ) {
+    if (__atomic_load_n(&cbScanSpacesImpl, __ATOMIC_ACQUIRE) == NULL)
+        cbScanSetLevel(cbScanGetMaxLevel());
+
+    return __atomic_load_n(&cbScanLevel, __ATOMIC_RELAXED);
+} // cbScanGetLevel
+
+const char * cbScanSpaces( const char *const begin, const char *const end ) {
+    CbScanFunc impl = __atomic_load_n(&cbScanSpacesImpl, __ATOMIC_ACQUIRE);
+
+    if (impl == NULL) {
+        cbScanSetLevel(cbScanGetMaxLevel());
+        impl = __atomic_load_n(&cbScanSpacesImpl, __ATOMIC_ACQUIRE);
+    }
+
+    return impl(begin, end);
+} // cbScanSpaces
+
+const char * cbScanQuote( const char *const begin, const char *const end ) {
+    CbScanFunc impl = __atomic_load_n(&cbScanQuoteImpl, __ATOMIC_ACQUIRE);
+
+    if (impl == NULL) {
+        cbScanSetLevel(cbScanGetMaxLevel());
+        impl = __atomic_load_n(&cbScanQuoteImpl, __ATOMIC_ACQUIRE);
+    }
+
+    return impl(begin, end);
+} // cbScanQuote
+
+// cb_scan.c
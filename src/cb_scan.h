@@ -0,0 +1,69 @@
+/**
+ * @brief text format scanning primitives declaration file
+ */
+
+#ifndef CB_SCAN_H_
+#define CB_SCAN_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif // defined(__cplusplus)
+
+/// @brief scanner implementation level
+typedef enum __CbScanLevel {
+    CB_SCAN_LEVEL_SCALAR, ///< byte by byte scanning
+    CB_SCAN_LEVEL_SSE2,   ///< 16 bytes per step
+    CB_SCAN_LEVEL_AVX2,   ///< 32 bytes per step
+} CbScanLevel;
+
+/**
+ * @brief best supported by current CPU scanner level getting function
+ * 
+ * @return scanner level
+ */
+CbScanLevel cbScanGetMaxLevel( void );
+
+/**
+ * @brief scanner level setting function
+ * 
+ * @param[in] level required level (clamped to cbScanGetMaxLevel result)
+ * 
+ * @note best supported level is selected by first scan of any thread, this function exists mostly for benchmarking
+ * and shouldn't be called concurrently with scans.
+ */
+void cbScanSetLevel( CbScanLevel level );
+
+/**
+ * @brief current scanner level getting function
+ * 
+ * @return scanner level
+ */
+CbScanLevel cbScanGetLevel( void );
+
+/**
+ * @brief first non-space character searching function
+ * 
+ * @param[in] begin range begin (inclusive)
+ * @param[in] end   range end (exclusive)
+ * 
+ * @return pointer to first character that isn't ' ', '\r', '\n' or '\t', 'end' if there is no such character.
+ */
+const char * cbScanSpaces( const char *begin, const char *end );
+
+/**
+ * @brief first quote character searching function
+ * 
+ * @param[in] begin range begin (inclusive)
+ * @param[in] end   range end (exclusive)
+ * 
+ * @return pointer to first '"' character, 'end' if there is no such character.
+ */
+const char * cbScanQuote( const char *begin, const char *end );
+
+#ifdef __cplusplus
+}
+#endif // defined(__cplusplus)
+
+#endif // !defined(CB_SCAN_H_)
+
+// cb_scan.h
@@ -0,0 +1,599 @@
+/**
+ * @brief cactusbot session server implementation file
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "cb_server.h"
+
+/// @brief request buffer size (longer request lines close connection)
+#define CB_SERVER_INPUT_SIZE ((size_t)1024)
+
+/// @brief reply buffer size (single reply is buffered at once, so it bounds reply length)
+#define CB_SERVER_OUTPUT_SIZE ((size_t)4096)
+
+/// @brief count of sessions allocated by pool at once
+#define CB_SERVER_POOL_BLOCK_SIZE ((size_t)256)
+
+/// @brief count of events taken by single epoll_wait
+#define CB_SERVER_EVENT_COUNT 256
+
+/// @brief pending connection queue length
+#define CB_SERVER_BACKLOG 1024
+
+/// @brief session state
+typedef enum __CbServerSessionState {
+    CB_SERVER_SESSION_STATE_IDLE, ///< no session is started
+    CB_SERVER_SESSION_STATE_WALK, ///< session walks tree
+    CB_SERVER_SESSION_STATE_ADD,  ///< guess is rejected, new leaf is expected
+} CbServerSessionState;
+
+/// @brief connection state (allocated by session pool)
+typedef struct __CbServerSession {
+    struct __CbServerSession *nextFree;        ///< next free session (free sessions only)
+    int                       fd;              ///< connection socket, -1 for free sessions
+    CbServerSessionState      state;           ///< session state
+    CbIter                    iter;            ///< session position (valid unless session is idle)
+    bool                      isWaitingOutput; ///< true if socket is watched for writability instead of readability
+    size_t                    inputSize;       ///< count of received bytes that aren't processed yet
+    size_t                    outputBegin;     ///< first unsent reply byte
+    size_t                    outputEnd;       ///< reply end
+    char                      input[CB_SERVER_INPUT_SIZE];   ///< received bytes
+    char                      output[CB_SERVER_OUTPUT_SIZE]; ///< reply bytes
+} CbServerSession;
+
+/// @brief session pool block
+typedef struct __CbServerSessionBlock {
+    struct __CbServerSessionBlock *next;                                ///< previously allocated block
+    CbServerSession                sessions[CB_SERVER_POOL_BLOCK_SIZE]; ///< sessions
+} CbServerSessionBlock;
+
+/// @brief server implementation structure
+typedef struct __CbServerImpl {
+    Cb                     cb;              ///< served cb
+    int                    listenFd;        ///< listening socket (epoll data pointer is NULL)
+    int                    epollFd;         ///< epoll instance
+    int                    stopFd;          ///< stop event counter (epoll data pointer is server itself)
+    bool                   isBound;         ///< true if socket file is created by server
+    size_t                 maxSessionCount; ///< maximal count of connections (0 means unlimited)
+    CbServerSessionBlock  *blocks;          ///< session pool blocks
+    CbServerSession       *freeSessions;    ///< free session list
+    CbServerStat           stat;            ///< counters (changed by relaxed atomic increments)
+    struct sockaddr_un     address;         ///< socket address
+} CbServerImpl;
+
+/**
+ * @brief counter changing function
+ * 
+ * @param[in,out] counter counter (non-null)
+ * @param[in]     delta   value to add (wrapped for decrement)
+ */
+static void cbServerCount( size_t *const counter, const size_t delta ) {
+    __atomic_fetch_add(counter, delta, __ATOMIC_RELAXED);
+} // cbServerCount
+
+/**
+ * @brief session from pool allocation function
+ * 
+ * @param[in,out] self server (non-null)
+ * @param[in]     fd   connection socket
+ * 
+ * @return session, NULL if allocation failed
+ * 
+ * @note sessions are allocated by blocks and reused, so connection churn doesn't reach system allocator.
+ */
+static CbServerSession * cbServerSessionAlloc( CbServerImpl *const self, const int fd ) {
+    if (self->freeSessions == NULL) {
+        CbServerSessionBlock *const block = (CbServerSessionBlock *)calloc(1, sizeof(CbServerSessionBlock));
+
+        if (block == NULL)
+            return NULL;
+
+        block->next = self->blocks;
+        self->blocks = block;
+
+        for (size_t i = CB_SERVER_POOL_BLOCK_SIZE; i > 0; i--) {
+            block->sessions[i - 1].fd = -1;
+            block->sessions[i - 1].nextFree = self->freeSessions;
+            self->freeSessions = &block->sessions[i - 1];
+        }
+    }
+
+    CbServerSession *const session = self->freeSessions;
+
+    self->freeSessions = session->nextFree;
+
+    session->nextFree = NULL;
+    session->fd = fd;
+    session->state = CB_SERVER_SESSION_STATE_IDLE;
+    session->isWaitingOutput = false;
+    session->inputSize = 0;
+    session->outputBegin = 0;
+    session->outputEnd = 0;
+
+    cbServerCount(&self->stat.connectionCount, 1);
+
+    return session;
+} // cbServerSessionAlloc
+
+/**
+ * @brief session closing and into pool returning function
+ * 
+ * @param[in,out] self    server (non-null)
+ * @param[in,out] session session to close (non-null)
+ */
+static void cbServerSessionFree( CbServerImpl *const self, CbServerSession *const session ) {
+    // closed socket is removed from epoll set automatically
+    close(session->fd);
+
+    session->fd = -1;
+    session->nextFree = self->freeSessions;
+    self->freeSessions = session;
+
+    cbServerCount(&self->stat.connectionCount, (size_t)-1);
+} // cbServerSessionFree
+
+/**
+ * @brief reply string appending function
+ * 
+ * @param[in,out] session session (non-null)
+ * @param[in]     str     string to append (non-null)
+ * 
+ * @return true if string is appended, false if output buffer is full
+ */
+static bool cbServerAppend( CbServerSession *const session, const char *const str ) {
+    const size_t length = strlen(str);
+
+    if (length > CB_SERVER_OUTPUT_SIZE - session->outputEnd)
+        return false;
+
+    memcpy(session->output + session->outputEnd, str, length);
+    session->outputEnd += length;
+
+    return true;
+} // cbServerAppend
+
+/**
+ * @brief reply line writing function
+ * 
+ * @param[in,out] session session (non-null, output must be empty)
+ * @param[in]     prefix  reply kind (non-null)
+ * @param[in]     text    reply text (nullable)
+ */
+static void cbServerReply( CbServerSession *const session, const char *const prefix, const char *const text ) {
+    if (true
+        && cbServerAppend(session, prefix)
+        && (text == NULL || (cbServerAppend(session, " ") && cbServerAppend(session, text)))
+        && cbServerAppend(session, "\n")
+    )
+        return;
+
+    // client still gets single line
+    session->outputEnd = 0;
+    cbServerAppend(session, "ERR long reply\n");
+} // cbServerReply
+
+/**
+ * @brief current session node replying function
+ * 
+ * @param[in,out] session walking session (non-null, output must be empty)
+ */
+static void cbServerReplyNode( CbServerSession *const session ) {
+    cbServerReply(session, cbIterFinished(&session->iter) ? "L" : "Q", cbIterGetText(&session->iter));
+} // cbServerReplyNode
+
+/**
+ * @brief definition replying function
+ * 
+ * @param[in]     self    server (non-null)
+ * @param[in,out] session session (non-null, output must be empty)
+ * @param[in]     subject leaf name (non-null)
+ */
+static void cbServerReplyDefinition( const CbServerImpl *const self, CbServerSession *const session, const char *const subject ) {
+    CbDefIter iter = {0};
+    const CbDefineStatus status = cbDefine(self->cb, subject, &iter);
+
+    if (status == CB_DEFINE_STATUS_NO_SUBJECT) {
+        cbServerReply(session, "ERR", "unknown subject");
+        return;
+    }
+
+    bool isWritten = cbServerAppend(session, "DEF");
+
+    if (status == CB_DEFINE_STATUS_OK) {
+        do {
+            isWritten = true
+                && isWritten
+                && cbServerAppend(session, cbDefIterGetRelation(&iter) ? "\t+" : "\t-")
+                && cbServerAppend(session, cbDefIterGetProperty(&iter));
+        } while (isWritten && cbDefIterNext(&iter));
+    }
+
+    if (!isWritten || !cbServerAppend(session, "\n")) {
+        session->outputEnd = 0;
+        cbServerReply(session, "ERR", "long reply");
+    }
+} // cbServerReplyDefinition
+
+/**
+ * @brief request line handling function
+ * 
+ * @param[in,out] self    server (non-null)
+ * @param[in,out] session session (non-null, output must be empty)
+ * @param[in,out] line    request line without line end (non-null, may be changed)
+ * 
+ * @return true if connection should stay open, false if it should be closed
+ */
+static bool cbServerHandleLine( CbServerImpl *const self, CbServerSession *const session, char *const line ) {
+    cbServerCount(&self->stat.requestCount, 1);
+
+    if (strcmp(line, "START") == 0) {
+        session->iter = cbIter(self->cb);
+        session->state = CB_SERVER_SESSION_STATE_WALK;
+        cbServerReplyNode(session);
+        return true;
+    }
+
+    if (strcmp(line, "YES") == 0 || strcmp(line, "NO") == 0) {
+        const bool isCorrect = line[0] == 'Y';
+
+        if (session->state != CB_SERVER_SESSION_STATE_WALK) {
+            cbServerReply(session, "ERR", "no question");
+        } else if (!cbIterFinished(&session->iter)) {
+            cbIterNext(&session->iter, isCorrect);
+            cbServerReplyNode(session);
+        } else if (isCorrect) {
+            session->state = CB_SERVER_SESSION_STATE_IDLE;
+            cbServerCount(&self->stat.sessionCount, 1);
+            cbServerReply(session, "OK", NULL);
+        } else {
+            session->state = CB_SERVER_SESSION_STATE_ADD;
+            cbServerReply(session, "ASK", NULL);
+        }
+
+        return true;
+    }
+
+    if (strncmp(line, "ADD ", 4) == 0) {
+        char *const condition = line + 4;
+        char *const separator = strchr(condition, '\t');
+
+        if (session->state != CB_SERVER_SESSION_STATE_ADD) {
+            cbServerReply(session, "ERR", "no leaf to add");
+        } else if (separator == NULL || separator == condition || separator[1] == '\0') {
+            cbServerReply(session, "ERR", "syntax");
+        } else {
+            *separator = '\0';
+
+            // leaf may exist or session leaf may be replaced by other session, iterator stays stale then,
+            // so session is dropped and client has to START again
+            if (!cbIterInsertCorrect(&session->iter, condition, separator + 1)) {
+                session->state = CB_SERVER_SESSION_STATE_IDLE;
+                cbServerReply(session, "ERR", "insertion failed, START again");
+            } else {
+                session->state = CB_SERVER_SESSION_STATE_IDLE;
+                cbServerCount(&self->stat.insertionCount, 1);
+                cbServerCount(&self->stat.sessionCount, 1);
+                cbServerReply(session, "OK", NULL);
+            }
+        }
+
+        return true;
+    }
+
+    if (strncmp(line, "DEFINE ", 7) == 0) {
+        cbServerReplyDefinition(self, session, line + 7);
+        return true;
+    }
+
+    if (strcmp(line, "QUIT") == 0)
+        return false;
+
+    cbServerReply(session, "ERR", "unknown command");
+
+    return true;
+} // cbServerHandleLine
+
+/**
+ * @brief pending reply sending function
+ * 
+ * @param[in,out] session session (non-null)
+ * 
+ * @return true if reply is sent or socket is full, false if connection is broken
+ */
+static bool cbServerFlush( CbServerSession *const session ) {
+    while (session->outputBegin < session->outputEnd) {
+        const ssize_t size = send(session->fd, session->output + session->outputBegin, session->outputEnd - session->outputBegin, MSG_NOSIGNAL);
+
+        if (size < 0) {
+            if (errno == EINTR)
+                continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+
+        session->outputBegin += (size_t)size;
+    }
+
+    session->outputBegin = 0;
+    session->outputEnd = 0;
+
+    return true;
+} // cbServerFlush
+
+/**
+ * @brief buffered requests processing function
+ * 
+ * @param[in,out] self    server (non-null)
+ * @param[in,out] session session (non-null)
+ * 
+ * @return true if connection should stay open, false if it should be closed
+ * 
+ * @note requests are processed while replies are sent at once, so client that doesn't read
+ * replies stops being read (socket is watched for writability only).
+ */
+static bool cbServerProcess( CbServerImpl *const self, CbServerSession *const session ) {
+    size_t begin = 0;
+    bool isOpen = true;
+
+    while (isOpen && session->outputBegin == session->outputEnd) {
+        char *const line = session->input + begin;
+        char *const end = (char *)memchr(line, '\n', session->inputSize - begin);
+
+        if (end == NULL)
+            break;
+
+        *end = '\0';
+        if (end != line && end[-1] == '\r')
+            end[-1] = '\0';
+        begin = (size_t)(end + 1 - session->input);
+
+        isOpen = cbServerHandleLine(self, session, line) && cbServerFlush(session);
+    }
+
+    memmove(session->input, session->input + begin, session->inputSize - begin);
+    session->inputSize -= begin;
+
+    // line longer than buffer can't be completed, full buffer of complete lines just waits for replies to be sent
+    if (!isOpen || (session->inputSize == CB_SERVER_INPUT_SIZE && memchr(session->input, '\n', session->inputSize) == NULL))
+        return false;
+
+    const bool isWaitingOutput = session->outputBegin != session->outputEnd;
+
+    if (isWaitingOutput == session->isWaitingOutput)
+        return true;
+
+    struct epoll_event event = {};
+
+    event.events = isWaitingOutput ? EPOLLOUT : EPOLLIN;
+    event.data.ptr = session;
+    session->isWaitingOutput = isWaitingOutput;
+
+    return epoll_ctl(self->epollFd, EPOLL_CTL_MOD, session->fd, &event) == 0;
+} // cbServerProcess
+
+/**
+ * @brief connection event handling function
+ * 
+ * @param[in,out] self    server (non-null)
+ * @param[in,out] session session (non-null)
+ * @param[in]     events  epoll event mask
+ * 
+ * @return true if connection should stay open, false if it should be closed
+ */
+static bool cbServerHandleEvent( CbServerImpl *const self, CbServerSession *const session, const uint32_t events ) {
+    if ((events & EPOLLERR) != 0)
+        return false;
+
+    if ((events & EPOLLOUT) != 0 && !cbServerFlush(session))
+        return false;
+
+    // single read per event keeps loop fair, level-triggered epoll reports rest of data again
+    if ((events & (EPOLLIN | EPOLLHUP)) != 0 && !session->isWaitingOutput) {
+        const ssize_t size = recv(session->fd, session->input + session->inputSize, CB_SERVER_INPUT_SIZE - session->inputSize, 0);
+
+        if (size == 0 || (size < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+            return false;
+
+        if (size > 0)
+            session->inputSize += (size_t)size;
+    }
+
+    return cbServerProcess(self, session);
+} // cbServerHandleEvent
+
+/**
+ * @brief pending connections accepting function
+ * 
+ * @param[in,out] self server (non-null)
+ */
+static void cbServerAccept( CbServerImpl *const self ) {
+    for (;;) {
+        const int fd = accept4(self->listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+        if (fd < 0)
+            return;
+
+        cbServerCount(&self->stat.acceptedCount, 1);
+
+        CbServerSession *session = NULL;
+
+        if (false
+            || (self->maxSessionCount != 0 && self->stat.connectionCount >= self->maxSessionCount)
+            || (session = cbServerSessionAlloc(self, fd)) == NULL
+        ) {
+            cbServerCount(&self->stat.rejectedCount, 1);
+            close(fd);
+            continue;
+        }
+
+        struct epoll_event event = {};
+
+        event.events = EPOLLIN;
+        event.data.ptr = session;
+
+        if (epoll_ctl(self->epollFd, EPOLL_CTL_ADD, fd, &event) != 0)
+            cbServerSessionFree(self, session);
+    }
+} // cbServerAccept
+
+CbServer cbServerCtor( Cb cb, const char *socketPath, size_t maxSessionCount ) {
+    assert(cb != NULL);
+    assert(socketPath != NULL);
+
+    CbServerImpl *const self = (CbServerImpl *)calloc(1, sizeof(CbServerImpl));
+
+    if (self == NULL)
+        return NULL;
+
+    self->cb = cb;
+    self->maxSessionCount = maxSessionCount;
+    self->listenFd = -1;
+    self->epollFd = -1;
+    self->stopFd = -1;
+    self->address.sun_family = AF_UNIX;
+
+    if (strlen(socketPath) >= sizeof(self->address.sun_path)) {
+        free(self);
+        return NULL;
+    }
+
+    strcpy(self->address.sun_path, socketPath);
+
+    // socket file left by previous run would make bind fail, any other file is kept
+    struct stat fileStat;
+
+    if (lstat(socketPath, &fileStat) == 0 && (!S_ISSOCK(fileStat.st_mode) || unlink(socketPath) != 0)) {
+        if (!S_ISSOCK(fileStat.st_mode))
+            errno = EEXIST;
+        free(self);
+        return NULL;
+    }
+
+    struct epoll_event listenEvent = {};
+    struct epoll_event stopEvent = {};
+
+    listenEvent.events = EPOLLIN;
+    listenEvent.data.ptr = NULL;
+    stopEvent.events = EPOLLIN;
+    stopEvent.data.ptr = self;
+
+    if (false
+        || (self->listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) < 0
+        || bind(self->listenFd, (const struct sockaddr *)&self->address, sizeof(self->address)) != 0
+    ) {
+        cbServerDtor(self);
+        return NULL;
+    }
+
+    self->isBound = true;
+
+    if (false
+        || listen(self->listenFd, CB_SERVER_BACKLOG) != 0
+        || (self->epollFd = epoll_create1(EPOLL_CLOEXEC)) < 0
+        || (self->stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0
+        || epoll_ctl(self->epollFd, EPOLL_CTL_ADD, self->listenFd, &listenEvent) != 0
+        || epoll_ctl(self->epollFd, EPOLL_CTL_ADD, self->stopFd, &stopEvent) != 0
+    ) {
+        cbServerDtor(self);
+        return NULL;
+    }
+
+    return self;
+} // cbServerCtor
+
+void cbServerDtor( CbServer self ) {
+    if (self == NULL)
+        return;
+
+    for (CbServerSessionBlock *block = self->blocks; block != NULL; ) {
+        CbServerSessionBlock *const next = block->next;
+
+        for (size_t i = 0; i < CB_SERVER_POOL_BLOCK_SIZE; i++)
+            if (block->sessions[i].fd >= 0)
+                close(block->sessions[i].fd);
+
+        free(block);
+        block = next;
+    }
+
+    if (self->stopFd >= 0)
+        close(self->stopFd);
+    if (self->epollFd >= 0)
+        close(self->epollFd);
+    if (self->listenFd >= 0)
+        close(self->listenFd);
+    if (self->isBound)
+        unlink(self->address.sun_path);
+
+    free(self);
+} // cbServerDtor
+
+bool cbServerRun( CbServer self ) {
+    assert(self != NULL);
+
+    struct epoll_event events[CB_SERVER_EVENT_COUNT];
+
+    for (;;) {
+        const int eventCount = epoll_wait(self->epollFd, events, CB_SERVER_EVENT_COUNT, -1);
+
+        if (eventCount < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+
+        // every socket is reported once per wait, so session freed here isn't met again in same batch
+        for (int i = 0; i < eventCount; i++) {
+            void *const data = events[i].data.ptr;
+
+            if (data == NULL) {
+                cbServerAccept(self);
+            } else if (data == self) {
+                uint64_t stopCount = 0;
+
+                if (read(self->stopFd, &stopCount, sizeof(stopCount)) == (ssize_t)sizeof(stopCount))
+                    return true;
+            } else {
+                CbServerSession *const session = (CbServerSession *)data;
+
+                if (!cbServerHandleEvent(self, session, events[i].events))
+                    cbServerSessionFree(self, session);
+            }
+        }
+    }
+} // cbServerRun
+
+void cbServerStop( CbServer self ) {
+    assert(self != NULL);
+
+    // eventfd write is async-signal-safe
+    const uint64_t stopCount = 1;
+    const ssize_t size = write(self->stopFd, &stopCount, sizeof(stopCount));
+
+    (void)size;
+} // cbServerStop
+
+void cbServerGetStat( const CbServer self, CbServerStat *const dst ) {
+    assert(self != NULL);
+    assert(dst != NULL);
+
+    dst->connectionCount = __atomic_load_n(&self->stat.connectionCount, __ATOMIC_RELAXED);
+    dst->acceptedCount = __atomic_load_n(&self->stat.acceptedCount, __ATOMIC_RELAXED);
+    dst->rejectedCount = __atomic_load_n(&self->stat.rejectedCount, __ATOMIC_RELAXED);
+    dst->requestCount = __atomic_load_n(&self->stat.requestCount, __ATOMIC_RELAXED);
+    dst->sessionCount = __atomic_load_n(&self->stat.sessionCount, __ATOMIC_RELAXED);
+    dst->insertionCount = __atomic_load_n(&self->stat.insertionCount, __ATOMIC_RELAXED);
+} // cbServerGetStat
+
+// cb_server.c
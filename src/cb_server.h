@@ -0,0 +1,99 @@
+/**
+ * @brief cactusbot session server declaration file
+ */
+
+#ifndef CB_SERVER_H_
+#define CB_SERVER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "cb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // defined(__cplusplus)
+
+/// @brief event-driven multi-session server handle
+typedef struct __CbServerImpl * CbServer;
+
+/// @brief server counters
+typedef struct __CbServerStat {
+    size_t connectionCount; ///< count of currently open connections
+    size_t acceptedCount;   ///< count of accepted connections
+    size_t rejectedCount;   ///< count of connections closed because session limit is reached
+    size_t requestCount;    ///< count of processed request lines
+    size_t sessionCount;    ///< count of finished sessions (guessed leaves and insertions)
+    size_t insertionCount;  ///< count of successful insertions
+} CbServerStat;
+
+/*
+ * protocol (UTF-8 lines terminated by '\n', every request gets single reply line):
+ *     START                     - start new session, reply is current node
+ *     YES / NO                  - answer to current question or guess, reply is next node,
+ *                                 OK if guess is confirmed or ASK if new leaf should be added
+ *     ADD condition\tname       - insert new leaf after ASK, reply is OK (failed insertion ends session)
+ *     DEFINE name               - get definition, reply is DEF followed by \t+property or \t-property for every property
+ *     QUIT                      - close connection
+ * 
+ * node is replied as 'Q text' for questions and 'L text' for leaves (guesses).
+ * request that can't be done is replied by 'ERR reason', session isn't changed then (except failed ADD).
+ */
+
+/**
+ * @brief server constructor
+ * 
+ * @param[in,out] cb              cb to serve (non-null, must outlive server)
+ * @param[in]     socketPath      Unix domain socket path (non-null, existing socket file is replaced)
+ * @param[in]     maxSessionCount maximal count of simultaneous connections (0 means unlimited)
+ * 
+ * @return server handle, NULL if socket can't be created, path is taken by file that isn't socket or allocation failed.
+ */
+CbServer cbServerCtor( Cb cb, const char *socketPath, size_t maxSessionCount );
+
+/**
+ * @brief server destructor
+ * 
+ * @param[in] self server to destroy (nullable, must not be running), all connections are closed and socket file is removed
+ */
+void cbServerDtor( CbServer self );
+
+/**
+ * @brief server event loop running function
+ * 
+ * @param[in,out] self server (non-null)
+ * 
+ * @return true if loop is stopped by cbServerStop, false if polling failed
+ * 
+ * @note all connections are served by single thread, so insertions are serialized without locks, and
+ * cb may be read by other threads meanwhile (see cb.h concurrency model). cb that keeps versions rejects
+ * insertion of session that started before other session's insertion.
+ */
+bool cbServerRun( CbServer self );
+
+/**
+ * @brief server stopping function
+ * 
+ * @param[in,out] self server (non-null)
+ * 
+ * @note function may be called from any thread and from signal handler, cbServerRun returns soon after.
+ */
+void cbServerStop( CbServer self );
+
+/**
+ * @brief server counters getting function
+ * 
+ * @param[in]  self server (non-null)
+ * @param[out] dst  counters destination (non-null)
+ * 
+ * @note counters may be read during cbServerRun, but aren't a consistent snapshot then.
+ */
+void cbServerGetStat( const CbServer self, CbServerStat *dst );
+
+#ifdef __cplusplus
+}
+#endif // defined(__cplusplus)
+
+#endif // !defined(CB_SERVER_H_)
+
+// cb_server.h
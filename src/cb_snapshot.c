@@ -0,0 +1,653 @@
+/**
+ * @brief cactusbot binary snapshot implementation file
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cb_snapshot.h"
+
+/// @brief snapshot file magic
+#define CB_SNAPSHOT_MAGIC "CBSNAP\0\0"
+
+/// @brief current snapshot format version
+#define CB_SNAPSHOT_VERSION ((uint32_t)2)
+
+/// @brief 'no node' index
+#define CB_SNAPSHOT_NONE ((uint32_t)0xFFFFFFFF)
+
+/// @brief snapshot section alignment (in bytes)
+#define CB_SNAPSHOT_ALIGNMENT ((size_t)8)
+
+/// @brief snapshot file header
+typedef struct __CbSnapshotHeader {
+    char     magic[8];       ///< CB_SNAPSHOT_MAGIC
+    uint32_t version;        ///< format version
+    uint32_t nodeCount;      ///< count of nodes, root node has 0 index
+    uint32_t leafCount;      ///< count of leaves
+    uint32_t _reserved;      ///< reserved, zero
+    uint64_t stringPoolSize; ///< string pool size (in bytes)
+} CbSnapshotHeader;
+
+/*
+ * snapshot file layout (structure of arrays, each section is aligned by CB_SNAPSHOT_ALIGNMENT):
+ *     CbSnapshotHeader header;
+ *     uint32_t         parents[header.nodeCount];         // CB_SNAPSHOT_NONE for root
+ *     uint32_t         corrects[header.nodeCount];        // CB_SNAPSHOT_NONE for leaves
+ *     uint32_t         incorrects[header.nodeCount];      // CB_SNAPSHOT_NONE for leaves
+ *     uint64_t         leafBits[(header.nodeCount + 63) / 64];
+ *     uint64_t         texts[header.nodeCount];           // zero-terminated text offsets in string pool
+ *     uint32_t         leaves[header.leafCount];          // leaf indices sorted by text
+ *     char             strings[header.stringPoolSize];    // question texts are deduplicated, so offsets may repeat
+ *
+ * nodes are stored in preorder, correct subtree first. walking and definition touch
+ * only topology arrays (parents, corrects, incorrects, leafBits), texts are read only on demand.
+ */
+
+/// @brief snapshot section offsets
+typedef struct __CbSnapshotLayout {
+    size_t parents;    ///< parent index array offset
+    size_t corrects;   ///< correct child index array offset
+    size_t incorrects; ///< incorrect child index array offset
+    size_t leafBits;   ///< leaf bit array offset
+    size_t texts;      ///< text offset array offset
+    size_t leaves;     ///< sorted leaf array offset
+    size_t strings;    ///< string pool offset
+    size_t size;       ///< total snapshot size
+} CbSnapshotLayout;
+
+/// @brief snapshot implementation structure
+typedef struct __CbSnapshotImpl {
+    void           *image;      ///< snapshot image (mapped file or allocated buffer)
+    size_t          imageSize;  ///< snapshot image size
+    bool            isMapped;   ///< true if image is mapped file, false if it's allocated by malloc
+    const uint32_t *parents;    ///< parent index array
+    const uint32_t *corrects;   ///< correct child index array
+    const uint32_t *incorrects; ///< incorrect child index array
+    const uint64_t *leafBits;   ///< leaf bit array
+    const uint64_t *texts;      ///< text offset array
+    const uint32_t *leaves;     ///< sorted leaf index array
+    uint32_t        leafCount;  ///< count of leaves
+    const char     *strings;    ///< string pool
+} CbSnapshotImpl;
+
+/// @brief snapshot building stack element
+typedef struct __CbSnapshotStackElement {
+    CbIter   iter;      ///< iterator to node
+    uint32_t parent;    ///< parent index
+    bool     isCorrect; ///< true if node is correct child of parent
+} CbSnapshotStackElement;
+
+/// @brief leaf sorting element
+typedef struct __CbSnapshotLeaf {
+    const char *text;  ///< leaf text
+    uint32_t    index; ///< leaf node index
+} CbSnapshotLeaf;
+
+/// @brief snapshot building state
+typedef struct __CbSnapshotBuilder {
+    uint32_t       *parents;            ///< parent index array (nullable, nodes are only counted if null)
+    uint32_t       *corrects;           ///< correct child index array
+    uint32_t       *incorrects;         ///< incorrect child index array
+    uint64_t       *leafBits;           ///< leaf bit array
+    uint64_t       *texts;              ///< text offset array
+    char           *strings;            ///< string pool
+    CbSnapshotLeaf *leaves;             ///< leaves to sort
+    size_t          nodeCount;          ///< count of visited nodes
+    size_t          leafCount;          ///< count of visited leaves
+    uint64_t        stringPoolSize;     ///< total size of distinct visited texts
+    CbStrPool       textPool;           ///< visited question text pool (deduplicates string pool)
+    uint64_t       *textOffsets;        ///< string pool offsets by text pool index
+    size_t          textOffsetCount;    ///< count of distinct visited question texts
+    size_t          textOffsetCapacity; ///< text offset array capacity
+} CbSnapshotBuilder;
+
+/**
+ * @brief leaf comparison function (for qsort)
+ *
+ * @param[in] lhs first leaf pointer
+ * @param[in] rhs second leaf pointer
+ *
+ * @return leaf text comparison result
+ */
+static int cbSnapshotLeafCompare( const void *lhs, const void *rhs ) {
+    return strcmp(((const CbSnapshotLeaf *)lhs)->text, ((const CbSnapshotLeaf *)rhs)->text);
+} // cbSnapshotLeafCompare
+
+/**
+ * @brief array capacity ensuring function
+ *
+ * @param[in,out] array       array pointer (non-null)
+ * @param[in,out] capacity    array capacity (non-null)
+ * @param[in]     size        required array size
+ * @param[in]     elementSize array element size
+ *
+ * @return true if array has at least 'size' capacity, false if reallocation failed
+ */
+static bool cbSnapshotReserve( void **const array, size_t *const capacity, const size_t size, const size_t elementSize ) {
+    if (size <= *capacity)
+        return true;
+
+    const size_t newCapacity = *capacity * 2 > size ? *capacity * 2 : size;
+    void *const newArray = realloc(*array, newCapacity * elementSize);
+
+    if (newArray == NULL)
+        return false;
+
+    *array = newArray;
+    *capacity = newCapacity;
+    return true;
+} // cbSnapshotReserve
+
+/**
+ * @brief snapshot section size aligning function
+ * 
+ * @param[in] size section size
+ * 
+ * @return size rounded up to CB_SNAPSHOT_ALIGNMENT
+ */
+static size_t cbSnapshotAlign( const size_t size ) {
+    return (size + CB_SNAPSHOT_ALIGNMENT - 1) / CB_SNAPSHOT_ALIGNMENT * CB_SNAPSHOT_ALIGNMENT;
+} // cbSnapshotAlign
+
+/**
+ * @brief snapshot layout computation function
+ * 
+ * @param[in]  header snapshot header (non-null)
+ * @param[out] dst    layout destination (non-null)
+ */
+static void cbSnapshotGetLayout( const CbSnapshotHeader *const header, CbSnapshotLayout *const dst ) {
+    const size_t nodeCount = header->nodeCount;
+
+    dst->parents    = cbSnapshotAlign(sizeof(CbSnapshotHeader));
+    dst->corrects   = dst->parents    + cbSnapshotAlign(nodeCount * sizeof(uint32_t));
+    dst->incorrects = dst->corrects   + cbSnapshotAlign(nodeCount * sizeof(uint32_t));
+    dst->leafBits   = dst->incorrects + cbSnapshotAlign(nodeCount * sizeof(uint32_t));
+    dst->texts      = dst->leafBits   + (nodeCount + 63) / 64 * sizeof(uint64_t);
+    dst->leaves     = dst->texts      + nodeCount * sizeof(uint64_t);
+    dst->strings    = dst->leaves     + cbSnapshotAlign((size_t)header->leafCount * sizeof(uint32_t));
+    dst->size       = dst->strings    + header->stringPoolSize;
+} // cbSnapshotGetLayout
+
+/**
+ * @brief snapshot image arrays binding function
+ * 
+ * @param[in,out] self snapshot with image set (non-null, image must have valid header)
+ */
+static void cbSnapshotBind( CbSnapshotImpl *const self ) {
+    const char *const image = (const char *)self->image;
+    const CbSnapshotHeader *const header = (const CbSnapshotHeader *)image;
+    CbSnapshotLayout layout;
+
+    cbSnapshotGetLayout(header, &layout);
+
+    self->parents    = (const uint32_t *)(image + layout.parents);
+    self->corrects   = (const uint32_t *)(image + layout.corrects);
+    self->incorrects = (const uint32_t *)(image + layout.incorrects);
+    self->leafBits   = (const uint64_t *)(image + layout.leafBits);
+    self->texts      = (const uint64_t *)(image + layout.texts);
+    self->leaves     = (const uint32_t *)(image + layout.leaves);
+    self->leafCount  = header->leafCount;
+    self->strings    = image + layout.strings;
+} // cbSnapshotBind
+
+/**
+ * @brief node leaf bit getting function
+ * 
+ * @param[in] self snapshot (non-null)
+ * @param[in] node node index
+ * 
+ * @return true if node is leaf, false otherwise
+ */
+static bool cbSnapshotIsLeaf( const CbSnapshotImpl *const self, const uint32_t node ) {
+    return (self->leafBits[node / 64] >> (node % 64)) & 1;
+} // cbSnapshotIsLeaf
+
+/**
+ * @brief loaded snapshot contents validation function
+ * 
+ * @param[in] self           snapshot with image bound (non-null, header must be validated)
+ * @param[in] nodeCount      count of nodes
+ * @param[in] stringPoolSize string pool size (last pool byte must be zero)
+ * 
+ * @return true if every index and text offset refers inside its section, false otherwise
+ * 
+ * @note children must follow their parent (as preorder does), so walks and definitions
+ * built on checked links always terminate.
+ */
+static bool cbSnapshotValidate( const CbSnapshotImpl *const self, const uint32_t nodeCount, const uint64_t stringPoolSize ) {
+    uint32_t leafCount = 0;
+
+    if (self->parents[0] != CB_SNAPSHOT_NONE)
+        return false;
+
+    for (uint32_t node = 0; node < nodeCount; node++) {
+        const uint32_t parent = self->parents[node];
+        const uint32_t correct = self->corrects[node];
+        const uint32_t incorrect = self->incorrects[node];
+
+        if (self->texts[node] >= stringPoolSize)
+            return false;
+
+        if (node != 0 && (false
+            || parent >= node
+            || (self->corrects[parent] != node && self->incorrects[parent] != node)
+        ))
+            return false;
+
+        if (cbSnapshotIsLeaf(self, node)) {
+            leafCount++;
+            if (correct != CB_SNAPSHOT_NONE || incorrect != CB_SNAPSHOT_NONE)
+                return false;
+            continue;
+        }
+
+        if (false
+            || correct <= node || correct >= nodeCount
+            || incorrect <= node || incorrect >= nodeCount
+            || correct == incorrect
+            || self->parents[correct] != node
+            || self->parents[incorrect] != node
+        )
+            return false;
+    }
+
+    if (leafCount != self->leafCount)
+        return false;
+
+    for (uint32_t i = 0; i < self->leafCount; i++)
+        if (self->leaves[i] >= nodeCount || !cbSnapshotIsLeaf(self, self->leaves[i]))
+            return false;
+
+    return true;
+} // cbSnapshotValidate
+
+/**
+ * @brief tree traversing function
+ * 
+ * @param[in]     self    cb to traverse (non-null)
+ * @param[in,out] builder building state (non-null, arrays are filled only if they are non-null)
+ * 
+ * @return true if succeeded, false if allocation failed or tree is too large
+ * 
+ * @note preorder traversal by iterator copies, so snapshot doesn't depend on node layout.
+ */
+static bool cbSnapshotTraverse( const Cb self, CbSnapshotBuilder *const builder ) {
+    CbSnapshotStackElement *stack = NULL;
+    size_t stackCapacity = 0;
+    size_t stackSize = 0;
+
+    builder->nodeCount = 0;
+    builder->leafCount = 0;
+    builder->stringPoolSize = 0;
+
+    // both traversals intern texts in same order, so they assign same offsets
+    cbStrPoolClear(builder->textPool);
+    builder->textOffsetCount = 0;
+
+    bool ok = cbSnapshotReserve((void **)&stack, &stackCapacity, 1, sizeof(CbSnapshotStackElement));
+
+    if (ok)
+        stack[stackSize++] = (CbSnapshotStackElement) { cbIterTraversal(self), CB_SNAPSHOT_NONE, false };
+
+    while (ok && stackSize > 0) {
+        const CbSnapshotStackElement element = stack[--stackSize];
+
+        if (builder->nodeCount >= CB_SNAPSHOT_NONE) {
+            ok = false;
+            break;
+        }
+
+        const uint32_t index = (uint32_t)builder->nodeCount++;
+        const char *const text = cbIterGetText(&element.iter);
+        const size_t textSize = strlen(text) + 1;
+        const bool isLeaf = cbIterFinished(&element.iter);
+        bool isNewText = true;
+        uint64_t textOffset = builder->stringPoolSize;
+
+        // leaf names are unique, so only questions are deduplicated: first occurrence is written, other ones refer to it
+        if (!isLeaf) {
+            CbPoolStr str;
+
+            if (false
+                || !cbStrPoolIntern(builder->textPool, text, textSize - 1, &str)
+                || !cbSnapshotReserve((void **)&builder->textOffsets, &builder->textOffsetCapacity, str.index + 1, sizeof(uint64_t))
+            ) {
+                ok = false;
+                break;
+            }
+
+            isNewText = str.index == builder->textOffsetCount;
+            if (isNewText)
+                builder->textOffsets[builder->textOffsetCount++] = builder->stringPoolSize;
+            textOffset = builder->textOffsets[str.index];
+        }
+
+        if (builder->parents != NULL) {
+            builder->parents[index] = element.parent;
+            builder->corrects[index] = CB_SNAPSHOT_NONE;
+            builder->incorrects[index] = CB_SNAPSHOT_NONE;
+            builder->texts[index] = textOffset;
+            if (isNewText)
+                memcpy(builder->strings + textOffset, text, textSize);
+
+            if (element.parent != CB_SNAPSHOT_NONE) {
+                if (element.isCorrect)
+                    builder->corrects[element.parent] = index;
+                else
+                    builder->incorrects[element.parent] = index;
+            }
+
+            if (isLeaf) {
+                builder->leafBits[index / 64] |= (uint64_t)1 << (index % 64);
+                builder->leaves[builder->leafCount] = (CbSnapshotLeaf) { builder->strings + textOffset, index };
+            }
+        }
+
+        if (isNewText)
+            builder->stringPoolSize += textSize;
+
+        if (isLeaf) {
+            builder->leafCount++;
+            continue;
+        }
+
+        if (!cbSnapshotReserve((void **)&stack, &stackCapacity, stackSize + 2, sizeof(CbSnapshotStackElement))) {
+            ok = false;
+            break;
+        }
+
+        CbSnapshotStackElement correct = { element.iter, index, true };
+        CbSnapshotStackElement incorrect = { element.iter, index, false };
+
+        cbIterNext(&correct.iter, true);
+        cbIterNext(&incorrect.iter, false);
+
+        // correct subtree goes first
+        stack[stackSize++] = incorrect;
+        stack[stackSize++] = correct;
+    }
+
+    free(stack);
+
+    return ok;
+} // cbSnapshotTraverse
+
+/**
+ * @brief snapshot building state destructor
+ * 
+ * @param[in,out] builder building state (non-null, image arrays aren't freed)
+ */
+static void cbSnapshotBuilderDtor( CbSnapshotBuilder *const builder ) {
+    cbStrPoolDtor(builder->textPool);
+    free(builder->textOffsets);
+    builder->textPool = NULL;
+    builder->textOffsets = NULL;
+} // cbSnapshotBuilderDtor
+
+CbSnapshot cbSnapshotCtor( const Cb self ) {
+    assert(self != NULL);
+
+    // first traversal only measures tree, so image is allocated once
+    CbSnapshotBuilder builder = {0};
+
+    if ((builder.textPool = cbStrPoolCtor()) == NULL)
+        return NULL;
+
+    if (!cbSnapshotTraverse(self, &builder)) {
+        cbSnapshotBuilderDtor(&builder);
+        return NULL;
+    }
+
+    CbSnapshotHeader header = {
+        .magic          = {0},
+        .version        = CB_SNAPSHOT_VERSION,
+        .nodeCount      = (uint32_t)builder.nodeCount,
+        .leafCount      = (uint32_t)builder.leafCount,
+        ._reserved      = 0,
+        .stringPoolSize = builder.stringPoolSize,
+    };
+    memcpy(header.magic, CB_SNAPSHOT_MAGIC, sizeof(header.magic));
+
+    CbSnapshotLayout layout;
+    cbSnapshotGetLayout(&header, &layout);
+
+    CbSnapshotImpl *impl = NULL;
+    char *image = NULL;
+    CbSnapshotLeaf *leaves = NULL;
+
+    if (false
+        || (impl = (CbSnapshotImpl *)calloc(1, sizeof(CbSnapshotImpl))) == NULL
+        || (image = (char *)calloc(layout.size, 1)) == NULL
+        || (leaves = (CbSnapshotLeaf *)calloc(builder.leafCount, sizeof(CbSnapshotLeaf))) == NULL
+    ) {
+        free(leaves);
+        free(image);
+        free(impl);
+        cbSnapshotBuilderDtor(&builder);
+        return NULL;
+    }
+
+    memcpy(image, &header, sizeof(header));
+
+    builder.parents    = (uint32_t *)(image + layout.parents);
+    builder.corrects   = (uint32_t *)(image + layout.corrects);
+    builder.incorrects = (uint32_t *)(image + layout.incorrects);
+    builder.leafBits   = (uint64_t *)(image + layout.leafBits);
+    builder.texts      = (uint64_t *)(image + layout.texts);
+    builder.strings    = image + layout.strings;
+    builder.leaves     = leaves;
+
+    const bool traversed = cbSnapshotTraverse(self, &builder);
+
+    cbSnapshotBuilderDtor(&builder);
+
+    if (!traversed) {
+        free(leaves);
+        free(image);
+        free(impl);
+        return NULL;
+    }
+
+    qsort(leaves, builder.leafCount, sizeof(CbSnapshotLeaf), cbSnapshotLeafCompare);
+
+    uint32_t *const sortedLeaves = (uint32_t *)(image + layout.leaves);
+
+    for (size_t i = 0; i < builder.leafCount; i++)
+        sortedLeaves[i] = leaves[i].index;
+
+    free(leaves);
+
+    impl->image = image;
+    impl->imageSize = layout.size;
+    impl->isMapped = false;
+    cbSnapshotBind(impl);
+
+    return impl;
+} // cbSnapshotCtor
+
+bool cbSaveSnapshot( FILE *const out, const Cb self ) {
+    assert(out != NULL);
+    assert(self != NULL);
+
+    CbSnapshot snapshot = cbSnapshotCtor(self);
+
+    const bool ok = true
+        && snapshot != NULL
+        && fwrite(snapshot->image, snapshot->imageSize, 1, out) == 1;
+
+    cbSnapshotDtor(snapshot);
+
+    return ok;
+} // cbSaveSnapshot
+
+CbSnapshot cbLoadSnapshot( const char *const path ) {
+    assert(path != NULL);
+
+    const int fd = open(path, O_RDONLY);
+
+    if (fd == -1)
+        return NULL;
+
+    struct stat fileStat;
+    void *mapping = MAP_FAILED;
+
+    if (fstat(fd, &fileStat) == 0 && (size_t)fileStat.st_size >= sizeof(CbSnapshotHeader))
+        mapping = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    close(fd);
+
+    if (mapping == MAP_FAILED)
+        return NULL;
+
+    const size_t size = (size_t)fileStat.st_size;
+    const CbSnapshotHeader *const header = (const CbSnapshotHeader *)mapping;
+
+    CbSnapshotLayout layout;
+    cbSnapshotGetLayout(header, &layout);
+
+    CbSnapshotImpl *impl = NULL;
+
+    // header is validated before any section is touched
+    if (false
+        || memcmp(header->magic, CB_SNAPSHOT_MAGIC, sizeof(header->magic)) != 0
+        || header->version != CB_SNAPSHOT_VERSION
+        || header->nodeCount == 0
+        || header->leafCount == 0
+        || header->leafCount > header->nodeCount
+        || header->stringPoolSize > size
+        || layout.size != size
+        || ((const char *)mapping)[size - 1] != '\0'
+        || (impl = (CbSnapshotImpl *)calloc(1, sizeof(CbSnapshotImpl))) == NULL
+    ) {
+        munmap(mapping, size);
+        return NULL;
+    }
+
+    impl->image = mapping;
+    impl->imageSize = size;
+    impl->isMapped = true;
+    cbSnapshotBind(impl);
+
+    // sections are checked once, so walks and lookups don't check indices
+    if (!cbSnapshotValidate(impl, header->nodeCount, header->stringPoolSize)) {
+        cbSnapshotDtor(impl);
+        return NULL;
+    }
+
+    return impl;
+} // cbLoadSnapshot
+
+void cbSnapshotDtor( CbSnapshot self ) {
+    if (self == NULL)
+        return;
+
+    if (self->isMapped)
+        munmap(self->image, self->imageSize);
+    else
+        free(self->image);
+    free(self);
+} // cbSnapshotDtor
+
+CbSnapshotIter cbSnapshotIter( CbSnapshot const self ) {
+    assert(self != NULL);
+
+    return (CbSnapshotIter) {
+        .self = self,
+        .node = 0,
+    };
+} // cbSnapshotIter
+
+void cbSnapshotIterNext( CbSnapshotIter *const iter, const bool isCorrect ) {
+    assert(iter != NULL);
+
+    if (cbSnapshotIsLeaf(iter->self, iter->node))
+        return;
+
+    iter->node = isCorrect
+        ? iter->self->corrects[iter->node]
+        : iter->self->incorrects[iter->node];
+} // cbSnapshotIterNext
+
+const char * cbSnapshotIterGetText( const CbSnapshotIter *const iter ) {
+    assert(iter != NULL);
+
+    return iter->self->strings + iter->self->texts[iter->node];
+} // cbSnapshotIterGetText
+
+bool cbSnapshotIterFinished( const CbSnapshotIter *const iter ) {
+    assert(iter != NULL);
+
+    return cbSnapshotIsLeaf(iter->self, iter->node);
+} // cbSnapshotIterFinished
+
+CbDefineStatus cbSnapshotDefine( CbSnapshot const self, const char *const subject, CbSnapshotDefIter *const dst ) {
+    assert(self != NULL);
+    assert(subject != NULL);
+
+    // binary search in sorted leaf array
+    size_t begin = 0;
+    size_t end = self->leafCount;
+
+    while (begin < end) {
+        const size_t middle = begin + (end - begin) / 2;
+        const uint32_t leaf = self->leaves[middle];
+        const int cmp = strcmp(subject, self->strings + self->texts[leaf]);
+
+        if (cmp < 0) {
+            end = middle;
+        } else if (cmp > 0) {
+            begin = middle + 1;
+        } else {
+            if (dst != NULL)
+                *dst = (CbSnapshotDefIter) { .self = self, .element = leaf };
+
+            return self->parents[leaf] == CB_SNAPSHOT_NONE
+                ? CB_DEFINE_STATUS_NO_DEFINITION
+                : CB_DEFINE_STATUS_OK;
+        }
+    }
+
+    return CB_DEFINE_STATUS_NO_SUBJECT;
+} // cbSnapshotDefine
+
+const char * cbSnapshotDefIterGetProperty( const CbSnapshotDefIter *const iter ) {
+    assert(iter != NULL);
+
+    const uint32_t parent = iter->self->parents[iter->element];
+
+    assert(parent != CB_SNAPSHOT_NONE);
+
+    return iter->self->strings + iter->self->texts[parent];
+} // cbSnapshotDefIterGetProperty
+
+bool cbSnapshotDefIterGetRelation( const CbSnapshotDefIter *const iter ) {
+    assert(iter != NULL);
+
+    const uint32_t parent = iter->self->parents[iter->element];
+
+    assert(parent != CB_SNAPSHOT_NONE);
+
+    return iter->self->corrects[parent] == iter->element;
+} // cbSnapshotDefIterGetRelation
+
+bool cbSnapshotDefIterNext( CbSnapshotDefIter *const iter ) {
+    assert(iter != NULL);
+
+    const uint32_t *const parents = iter->self->parents;
+
+    assert(parents[iter->element] != CB_SNAPSHOT_NONE);
+
+    iter->element = parents[iter->element];
+
+    return parents[iter->element] != CB_SNAPSHOT_NONE;
+} // cbSnapshotDefIterNext
+
+// cb_snapshot.c
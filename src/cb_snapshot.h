@@ -0,0 +1,153 @@
+/**
+ * @brief cactusbot binary snapshot declaration file
+ */
+
+#ifndef CB_SNAPSHOT_H_
+#define CB_SNAPSHOT_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "cb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // defined(__cplusplus)
+
+/// @brief read-only compact tree snapshot handle (topology is kept in arrays of 32-bit indices, texts in separate pool)
+typedef struct __CbSnapshotImpl * CbSnapshot;
+
+/**
+ * @brief in-memory snapshot constructor
+ * 
+ * @param[in] self cb to build snapshot of (non-null)
+ * 
+ * @return snapshot handle, NULL if allocation failed or tree has too many nodes.
+ * 
+ * @note snapshot doesn't depend on cb, so cb may be changed or destroyed after.
+ */
+CbSnapshot cbSnapshotCtor( const Cb self );
+
+/**
+ * @brief binary snapshot writing function
+ * 
+ * @param[out] out  destination file (non-null, opened in binary mode)
+ * @param[in]  self cb to save (non-null)
+ * 
+ * @return true if saved, false if something went wrong
+ * 
+ * @note snapshot uses native byte order.
+ */
+bool cbSaveSnapshot( FILE *out, const Cb self );
+
+/**
+ * @brief binary snapshot loading function
+ * 
+ * @param[in] path snapshot file path (non-null)
+ * 
+ * @return snapshot handle, NULL if file can't be mapped or isn't a valid snapshot.
+ * 
+ * @note file is mapped into memory, so nodes are never copied or allocated. every node index and
+ * text offset is checked against section sizes, so loading takes O(count of nodes).
+ */
+CbSnapshot cbLoadSnapshot( const char *path );
+
+/**
+ * @brief snapshot destructor
+ * 
+ * @param[in] self snapshot to unmap (nullable)
+ */
+void cbSnapshotDtor( CbSnapshot self );
+
+/// @brief snapshot iterator representation structure
+typedef struct __CbSnapshotIter {
+    CbSnapshot self; ///< snapshot pointer
+    uint32_t   node; ///< current node index
+} CbSnapshotIter;
+
+/**
+ * @brief snapshot root iterator getting function
+ * 
+ * @param[in] self snapshot pointer (non-null)
+ * 
+ * @return new iterator
+ */
+CbSnapshotIter cbSnapshotIter( CbSnapshot self );
+
+/**
+ * @brief next element getting function
+ * 
+ * @param[in,out] iter      iterator (non-null)
+ * @param[in]     isCorrect true if go to correct, false otherwise
+ */
+void cbSnapshotIterNext( CbSnapshotIter *iter, bool isCorrect );
+
+/**
+ * @brief node text getting function
+ * 
+ * @param[in] iter iterator (non-null)
+ * 
+ * @return iterator text
+ */
+const char * cbSnapshotIterGetText( const CbSnapshotIter *iter );
+
+/**
+ * @brief leaf condition checking function
+ * 
+ * @param[in] iter iterator (non-null)
+ * 
+ * @return true if iterator points to leaf, false otherwise.
+ */
+bool cbSnapshotIterFinished( const CbSnapshotIter *iter );
+
+/// @brief snapshot definition iterator representation structure
+typedef struct __CbSnapshotDefIter {
+    CbSnapshot self;    ///< snapshot pointer
+    uint32_t   element; ///< element index
+} CbSnapshotDefIter;
+
+/**
+ * @brief definition iterator getting function
+ * 
+ * @param[in]  self    snapshot pointer (non-null)
+ * @param[in]  subject subject to define name (non-null)
+ * @param[out] dst     iterator destination (nullable)
+ * 
+ * @return definition status
+ */
+CbDefineStatus cbSnapshotDefine( CbSnapshot self, const char *subject, CbSnapshotDefIter *dst );
+
+/**
+ * @brief property getting function
+ * 
+ * @param[in] iter iterator (non-null, not finished)
+ * 
+ * @return property text
+ */
+const char * cbSnapshotDefIterGetProperty( const CbSnapshotDefIter *iter );
+
+/**
+ * @brief relation to property getting function
+ * 
+ * @param[in] iter iterator (non-null, not finished)
+ * 
+ * @return true if defined object satisfies property got from cbSnapshotDefIterGetProperty function.
+ */
+bool cbSnapshotDefIterGetRelation( const CbSnapshotDefIter *iter );
+
+/**
+ * @brief next property getting function
+ * 
+ * @param[in,out] iter iterator (non-null, not finished)
+ * 
+ * @return true if it's ok to continue definition iteration by iter, false if not.
+ */
+bool cbSnapshotDefIterNext( CbSnapshotDefIter *iter );
+
+#ifdef __cplusplus
+}
+#endif // defined(__cplusplus)
+
+#endif // !defined(CB_SNAPSHOT_H_)
+
+// cb_snapshot.h
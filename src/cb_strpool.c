@@ -0,0 +1,218 @@
+/**
+ * @brief interning string pool implementation file
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cb_arena.h"
+#include "cb_strpool.h"
+
+/// @brief string pool implementation structure
+typedef struct __CbStrPoolImpl {
+    CbArena        arena;        ///< string arena
+    CbPoolStr     *table;        ///< open addressing table (NULL text for empty slots)
+    size_t         capacity;     ///< table capacity (power of two)
+    const char   **texts;        ///< texts by index
+    size_t         textCapacity; ///< text array capacity
+    CbStrPoolStat  stat;         ///< usage statistics
+} CbStrPoolImpl;
+
+CbStrPool cbStrPoolCtor( void ) {
+    CbStrPoolImpl *const self = (CbStrPoolImpl *)calloc(1, sizeof(CbStrPoolImpl));
+
+    if (self == NULL)
+        return NULL;
+
+    if ((self->arena = cbArenaCtor()) == NULL) {
+        free(self);
+        return NULL;
+    }
+
+    return self;
+} // cbStrPoolCtor
+
+void cbStrPoolDtor( CbStrPool self ) {
+    if (self == NULL)
+        return;
+
+    cbArenaDtor(self->arena);
+    free(self->table);
+    free(self->texts);
+    free(self);
+} // cbStrPoolDtor
+
+/**
+ * @brief table growing function
+ * 
+ * @param[in,out] self pool (non-null)
+ * 
+ * @return true if grown, false if allocation failed
+ */
+static bool cbStrPoolGrow( CbStrPoolImpl *const self ) {
+    const size_t capacity = self->capacity == 0 ? 64 : self->capacity * 2;
+    CbPoolStr *const table = (CbPoolStr *)calloc(capacity, sizeof(CbPoolStr));
+
+    if (table == NULL)
+        return false;
+
+    for (size_t i = 0; i < self->capacity; i++) {
+        if (self->table[i].text == NULL)
+            continue;
+
+        size_t slot = self->table[i].hash & (capacity - 1);
+
+        while (table[slot].text != NULL)
+            slot = (slot + 1) & (capacity - 1);
+        table[slot] = self->table[i];
+    }
+
+    free(self->table);
+    self->table = table;
+    self->capacity = capacity;
+
+    return true;
+} // cbStrPoolGrow
+
+/**
+ * @brief string slot finding function
+ * 
+ * @param[in] self   pool (non-null, table is allocated)
+ * @param[in] str    string
+ * @param[in] length string length
+ * @param[in] hash   string hash
+ * 
+ * @return slot with string if it's interned, empty slot it should be inserted to otherwise
+ */
+static size_t cbStrPoolFindSlot( const CbStrPoolImpl *const self, const char *const str, const size_t length, const uint32_t hash ) {
+    size_t slot = hash & (self->capacity - 1);
+
+    while (self->table[slot].text != NULL) {
+        const CbPoolStr *const entry = &self->table[slot];
+
+        if (true
+            && entry->hash == hash
+            && strncmp(entry->text, str, length) == 0
+            && entry->text[length] == '\0'
+        )
+            break;
+
+        slot = (slot + 1) & (self->capacity - 1);
+    }
+
+    return slot;
+} // cbStrPoolFindSlot
+
+/**
+ * @brief string hash computation function (32-bit FNV-1a)
+ * 
+ * @param[in] str    string
+ * @param[in] length string length
+ * 
+ * @return string hash
+ */
+static uint32_t cbStrPoolHash( const char *const str, const size_t length ) {
+    uint32_t hash = 0x811C9DC5;
+
+    for (size_t i = 0; i < length; i++)
+        hash = (hash ^ (uint8_t)str[i]) * 0x01000193;
+
+    return hash;
+} // cbStrPoolHash
+
+bool cbStrPoolFind( const CbStrPool self, const char *const str, const size_t length, CbPoolStr *const dst ) {
+    assert(self != NULL);
+    assert(str != NULL || length == 0);
+    assert(dst != NULL);
+
+    if (self->capacity == 0)
+        return false;
+
+    const size_t slot = cbStrPoolFindSlot(self, str, length, cbStrPoolHash(str, length));
+
+    if (self->table[slot].text == NULL)
+        return false;
+
+    *dst = self->table[slot];
+
+    return true;
+} // cbStrPoolFind
+
+const char * cbStrPoolGet( const CbStrPool self, const uint32_t index ) {
+    assert(self != NULL);
+    assert(index < self->stat.stringCount);
+
+    return self->texts[index];
+} // cbStrPoolGet
+
+bool cbStrPoolIntern( CbStrPool self, const char *const str, const size_t length, CbPoolStr *const dst ) {
+    assert(self != NULL);
+    assert(str != NULL || length == 0);
+    assert(dst != NULL);
+
+    // keep load factor below 1/2
+    if ((self->stat.stringCount + 1) * 2 > self->capacity && !cbStrPoolGrow(self))
+        return false;
+
+    const uint32_t hash = cbStrPoolHash(str, length);
+    const size_t slot = cbStrPoolFindSlot(self, str, length, hash);
+
+    self->stat.internCount++;
+    self->stat.internSize += length + 1;
+
+    if (self->table[slot].text != NULL) {
+        *dst = self->table[slot];
+        return true;
+    }
+
+    if (self->stat.stringCount >= UINT32_MAX)
+        return false;
+
+    if (self->stat.stringCount == self->textCapacity) {
+        const size_t textCapacity = self->textCapacity == 0 ? 64 : self->textCapacity * 2;
+        const char **const texts = (const char **)realloc(self->texts, textCapacity * sizeof(const char *));
+
+        if (texts == NULL)
+            return false;
+
+        self->texts = texts;
+        self->textCapacity = textCapacity;
+    }
+
+    // arena memory is zeroed, so copy is terminated
+    char *const text = (char *)cbArenaAlloc(self->arena, length + 1);
+
+    if (text == NULL)
+        return false;
+
+    memcpy(text, str, length);
+
+    self->table[slot] = (CbPoolStr) { text, hash, (uint32_t)self->stat.stringCount };
+    self->texts[self->stat.stringCount] = text;
+    self->stat.stringCount++;
+    self->stat.stringSize += length + 1;
+
+    *dst = self->table[slot];
+
+    return true;
+} // cbStrPoolIntern
+
+void cbStrPoolClear( CbStrPool self ) {
+    assert(self != NULL);
+
+    cbArenaReset(self->arena);
+
+    if (self->table != NULL)
+        memset(self->table, 0, self->capacity * sizeof(CbPoolStr));
+    memset(&self->stat, 0, sizeof(CbStrPoolStat));
+} // cbStrPoolClear
+
+void cbStrPoolGetStat( const CbStrPool self, CbStrPoolStat *const dst ) {
+    assert(self != NULL);
+    assert(dst != NULL);
+
+    *dst = self->stat;
+} // cbStrPoolGetStat
+
+// cb_strpool.c
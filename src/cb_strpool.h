@@ -0,0 +1,111 @@
+/**
+ * @brief interning string pool declaration file
+ */
+
+#ifndef CB_STRPOOL_H_
+#define CB_STRPOOL_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // defined(__cplusplus)
+
+/// @brief interning string pool handle
+typedef struct __CbStrPoolImpl * CbStrPool;
+
+/// @brief interned string
+typedef struct __CbPoolStr {
+    const char *text;  ///< canonical zero-terminated text (equal strings have same pointer)
+    uint32_t    hash;  ///< text hash (32-bit FNV-1a)
+    uint32_t    index; ///< index of string in order of first interning (dense, starts from 0)
+} CbPoolStr;
+
+/// @brief string pool usage statistics
+typedef struct __CbStrPoolStat {
+    size_t stringCount; ///< count of distinct strings
+    size_t stringSize;  ///< total size of distinct strings (including terminators)
+    size_t internCount; ///< count of interning requests
+    size_t internSize;  ///< total size of interned strings (including terminators), would be taken without pool
+} CbStrPoolStat;
+
+/**
+ * @brief string pool constructor
+ * 
+ * @return created pool, NULL if allocation failed
+ * 
+ * @note strings are kept in pool own arena, so they aren't affected by rollbacks of other arenas.
+ */
+CbStrPool cbStrPoolCtor( void );
+
+/**
+ * @brief string pool destructor
+ * 
+ * @param[in] self pool to destroy (nullable)
+ */
+void cbStrPoolDtor( CbStrPool self );
+
+/**
+ * @brief string interning function
+ * 
+ * @param[in,out] self   pool (non-null)
+ * @param[in]     str    string (non-null if length isn't 0, may be not zero-terminated)
+ * @param[in]     length string length
+ * @param[out]    dst    interned string destination (non-null)
+ * 
+ * @return true if interned, false if allocation failed
+ * 
+ * @note pool isn't thread-safe, but interned texts may be read by any thread until pool is cleared.
+ */
+bool cbStrPoolIntern( CbStrPool self, const char *str, size_t length, CbPoolStr *dst );
+
+/**
+ * @brief interned string finding function
+ * 
+ * @param[in]  self   pool (non-null)
+ * @param[in]  str    string (non-null if length isn't 0, may be not zero-terminated)
+ * @param[in]  length string length
+ * @param[out] dst    interned string destination (non-null)
+ * 
+ * @return true if string is interned, false otherwise
+ * 
+ * @note function doesn't change pool, so it may be called by many threads at once.
+ */
+bool cbStrPoolFind( const CbStrPool self, const char *str, size_t length, CbPoolStr *dst );
+
+/**
+ * @brief interned text by index getting function
+ * 
+ * @param[in] self  pool (non-null)
+ * @param[in] index string index (less than count of distinct strings)
+ * 
+ * @return interned text
+ */
+const char * cbStrPoolGet( const CbStrPool self, uint32_t index );
+
+/**
+ * @brief pool clearing function
+ * 
+ * @param[in,out] self pool (non-null)
+ * 
+ * @note all interned texts are invalidated, pool memory is kept for reuse.
+ */
+void cbStrPoolClear( CbStrPool self );
+
+/**
+ * @brief pool statistics getting function
+ * 
+ * @param[in]  self pool (non-null)
+ * @param[out] dst  statistics destination (non-null)
+ */
+void cbStrPoolGetStat( const CbStrPool self, CbStrPoolStat *dst );
+
+#ifdef __cplusplus
+}
+#endif // defined(__cplusplus)
+
+#endif // !defined(CB_STRPOOL_H_)
+
+// cb_strpool.h
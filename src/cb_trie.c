@@ -0,0 +1,522 @@
+/**
+ * @brief leaf name trie implementation file
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cb_trie.h"
+#include "cb_utf8.h"
+
+/// @brief 'no node' index
+#define CB_TRIE_NONE ((uint32_t)0xFFFFFFFF)
+
+/// @brief radix trie node (node prefix is name prefix of labelEnd bytes, common for all node names)
+typedef struct __CbTrieNode {
+    uint32_t labelBegin; ///< offset of edge label start in node names (parent label end)
+    uint32_t labelEnd;   ///< offset of edge label end in node names
+    uint32_t nameBegin;  ///< first name with node prefix (name equal to prefix goes first, if any)
+    uint32_t nameEnd;    ///< name after last name with node prefix
+    uint32_t firstChild; ///< first child index (children are contiguous and sorted by first label code point)
+    uint32_t childCount; ///< count of children
+} CbTrieNode;
+
+/// @brief leaf trie implementation structure
+typedef struct __CbLeafTrieImpl {
+    char        *strings;     ///< name string pool
+    size_t       stringsSize; ///< name string pool size
+    const char **names;       ///< names sorted by code points
+    size_t       nameCount;   ///< count of names
+    CbTrieNode  *nodes;       ///< nodes in breadth-first order (root is first)
+    size_t       nodeCount;   ///< count of nodes
+    size_t       maxLength;   ///< maximal name length (in code points)
+} CbLeafTrieImpl;
+
+/// @brief fuzzy search stack element
+typedef struct __CbTrieFuzzyElement {
+    uint32_t node;  ///< node index
+    uint32_t depth; ///< node label start depth (in code points)
+} CbTrieFuzzyElement;
+
+/// @brief fuzzy search match
+typedef struct __CbTrieFuzzyMatch {
+    uint32_t name;     ///< name index
+    uint32_t distance; ///< edit distance
+} CbTrieFuzzyMatch;
+
+/**
+ * @brief array reservation function
+ * 
+ * @param[in,out] array       array pointer (non-null)
+ * @param[in,out] capacity    array capacity (non-null)
+ * @param[in]     required    required element count
+ * @param[in]     elementSize element size
+ * 
+ * @return true if array has required capacity, false if allocation failed
+ */
+static bool cbTrieReserve( void **const array, size_t *const capacity, const size_t required, const size_t elementSize ) {
+    if (required <= *capacity)
+        return true;
+
+    size_t newCapacity = *capacity == 0 ? 64 : *capacity * 2;
+
+    while (newCapacity < required)
+        newCapacity *= 2;
+
+    void *const newArray = realloc(*array, newCapacity * elementSize);
+
+    if (newArray == NULL)
+        return false;
+
+    *array = newArray;
+    *capacity = newCapacity;
+
+    return true;
+} // cbTrieReserve
+
+/**
+ * @brief name comparison function (for qsort)
+ * 
+ * @param[in] lhs first name pointer
+ * @param[in] rhs second name pointer
+ * 
+ * @return comparison result (by code points)
+ */
+static int cbTrieNameCompare( const void *lhs, const void *rhs ) {
+    const char *l = *(const char *const *)lhs;
+    const char *r = *(const char *const *)rhs;
+    size_t i = 0;
+
+    while (l[i] == r[i] && l[i] != '\0')
+        i++;
+
+    // ASCII bytes are whole code points, so names are ordered by them
+    if ((uint8_t)l[i] < 0x80 && (uint8_t)r[i] < 0x80)
+        return (int)(uint8_t)l[i] - (int)(uint8_t)r[i];
+
+    for (;;) {
+        const uint32_t lc = cbUtf8Next(&l);
+        const uint32_t rc = cbUtf8Next(&r);
+
+        if (lc != rc)
+            return lc < rc ? -1 : 1;
+        if (lc == 0)
+            return 0;
+    }
+} // cbTrieNameCompare
+
+/**
+ * @brief leaf names collecting function
+ * 
+ * @param[in]     cb   cb to collect leaves of (non-null)
+ * @param[in,out] self trie to fill names of (non-null)
+ * 
+ * @return true if collected, false if allocation failed or tree has too many leaves
+ * 
+ * @note names are sorted by code points.
+ */
+static bool cbLeafTrieCollect( const Cb cb, CbLeafTrieImpl *const self ) {
+    CbIter *stack = NULL;
+    size_t stackCapacity = 0;
+    size_t stackSize = 0;
+    size_t nameCapacity = 0;
+
+    bool ok = cbTrieReserve((void **)&stack, &stackCapacity, 1, sizeof(CbIter));
+
+    if (ok)
+        stack[stackSize++] = cbIterTraversal(cb);
+
+    // names point to cb texts until they are copied
+    while (ok && stackSize > 0) {
+        const CbIter iter = stack[--stackSize];
+
+        if (cbIterFinished(&iter)) {
+            const char *const name = cbIterGetText(&iter);
+            const size_t length = strlen(name);
+
+            if (false
+                || self->nameCount >= CB_TRIE_NONE / 2
+                || length >= CB_TRIE_NONE
+                || !cbTrieReserve((void **)&self->names, &nameCapacity, self->nameCount + 1, sizeof(const char *))
+            ) {
+                ok = false;
+                break;
+            }
+
+            self->names[self->nameCount++] = name;
+            self->stringsSize += length + 1;
+
+            const size_t codePointCount = cbUtf8Length(name);
+
+            if (codePointCount > self->maxLength)
+                self->maxLength = codePointCount;
+            continue;
+        }
+
+        if (!cbTrieReserve((void **)&stack, &stackCapacity, stackSize + 2, sizeof(CbIter))) {
+            ok = false;
+            break;
+        }
+
+        CbIter correct = iter;
+        CbIter incorrect = iter;
+
+        cbIterNext(&correct, true);
+        cbIterNext(&incorrect, false);
+
+        stack[stackSize++] = incorrect;
+        stack[stackSize++] = correct;
+    }
+
+    free(stack);
+
+    if (!ok || (self->strings = (char *)malloc(self->stringsSize == 0 ? 1 : self->stringsSize)) == NULL)
+        return false;
+
+    // names are copied in sorted order, so names of every node are adjacent in memory
+    qsort(self->names, self->nameCount, sizeof(const char *), cbTrieNameCompare);
+
+    char *string = self->strings;
+
+    for (size_t i = 0; i < self->nameCount; i++) {
+        const size_t size = strlen(self->names[i]) + 1;
+
+        memcpy(string, self->names[i], size);
+        self->names[i] = string;
+        string += size;
+    }
+
+    return true;
+} // cbLeafTrieCollect
+
+/**
+ * @brief common prefix end computation function
+ * 
+ * @param[in] lhs    first name
+ * @param[in] rhs    second name
+ * @param[in] offset offset names are known to be equal up to
+ * 
+ * @return common prefix end offset (on code point boundary)
+ */
+static uint32_t cbTrieCommonEnd( const char *const lhs, const char *const rhs, const uint32_t offset ) {
+    const char *l = lhs + offset;
+    const char *r = rhs + offset;
+
+    for (;;) {
+        const char *const start = l;
+        const uint32_t lc = cbUtf8Next(&l);
+        const uint32_t rc = cbUtf8Next(&r);
+
+        if (lc != rc || lc == 0)
+            return (uint32_t)(start - lhs);
+    }
+} // cbTrieCommonEnd
+
+/**
+ * @brief node children building function
+ * 
+ * @param[in,out] self  trie (non-null, nodes have capacity for all children)
+ * @param[in]     index index of node to build children of
+ * 
+ * @note names with same code point after node prefix form child, child label is their common prefix.
+ */
+static void cbLeafTrieBuildChildren( CbLeafTrieImpl *const self, const uint32_t index ) {
+    CbTrieNode *const node = &self->nodes[index];
+    uint32_t name = node->nameBegin;
+
+    node->firstChild = (uint32_t)self->nodeCount;
+    node->childCount = 0;
+
+    // names equal to node prefix go first
+    while (name < node->nameEnd && self->names[name][node->labelEnd] == '\0')
+        name++;
+
+    while (name < node->nameEnd) {
+        const char *start = self->names[name] + node->labelEnd;
+        const uint32_t codePoint = cbUtf8Next(&start);
+        uint32_t end = name + 1;
+
+        for (;;) {
+            if (end == node->nameEnd)
+                break;
+
+            const char *next = self->names[end] + node->labelEnd;
+
+            if (cbUtf8Next(&next) != codePoint)
+                break;
+            end++;
+        }
+
+        self->nodes[self->nodeCount++] = (CbTrieNode) {
+            node->labelEnd,
+            cbTrieCommonEnd(self->names[name], self->names[end - 1], node->labelEnd),
+            name,
+            end,
+            CB_TRIE_NONE,
+            0,
+        };
+        node->childCount++;
+
+        name = end;
+    }
+} // cbLeafTrieBuildChildren
+
+CbLeafTrie cbLeafTrieCtor( const Cb cb ) {
+    assert(cb != NULL);
+
+    CbLeafTrieImpl *const self = (CbLeafTrieImpl *)calloc(1, sizeof(CbLeafTrieImpl));
+
+    if (self == NULL)
+        return NULL;
+
+    if (!cbLeafTrieCollect(cb, self)) {
+        cbLeafTrieDtor(self);
+        return NULL;
+    }
+
+    // every inner node except root has at least two children, so there are less than 2 * nameCount + 1 nodes
+    if ((self->nodes = (CbTrieNode *)malloc((2 * self->nameCount + 1) * sizeof(CbTrieNode))) == NULL) {
+        cbLeafTrieDtor(self);
+        return NULL;
+    }
+
+    self->nodes[0] = (CbTrieNode) { 0, 0, 0, (uint32_t)self->nameCount, CB_TRIE_NONE, 0 };
+    self->nodeCount = 1;
+
+    // node array is building queue itself
+    for (size_t i = 0; i < self->nodeCount; i++)
+        cbLeafTrieBuildChildren(self, (uint32_t)i);
+
+    CbTrieNode *const nodes = (CbTrieNode *)realloc(self->nodes, self->nodeCount * sizeof(CbTrieNode));
+
+    if (nodes != NULL)
+        self->nodes = nodes;
+
+    return self;
+} // cbLeafTrieCtor
+
+void cbLeafTrieDtor( CbLeafTrie self ) {
+    if (self == NULL)
+        return;
+
+    free(self->strings);
+    free(self->names);
+    free(self->nodes);
+    free(self);
+} // cbLeafTrieDtor
+
+/**
+ * @brief node terminality checking function
+ * 
+ * @param[in] self trie (non-null)
+ * @param[in] node node (non-null)
+ * 
+ * @return true if some name is equal to node prefix, false otherwise
+ */
+static bool cbLeafTrieIsTerminal( const CbLeafTrieImpl *const self, const CbTrieNode *const node ) {
+    return node->nameBegin < node->nameEnd && self->names[node->nameBegin][node->labelEnd] == '\0';
+} // cbLeafTrieIsTerminal
+
+/**
+ * @brief child by label first code point finding function
+ * 
+ * @param[in] self      trie (non-null)
+ * @param[in] node      parent node (non-null)
+ * @param[in] codePoint code point to find child by
+ * 
+ * @return child node, NULL if there's no such child
+ */
+static const CbTrieNode * cbLeafTrieFindChild( const CbLeafTrieImpl *const self, const CbTrieNode *const node, const uint32_t codePoint ) {
+    size_t left = node->firstChild;
+    size_t right = left + node->childCount;
+
+    while (left < right) {
+        const size_t middle = left + (right - left) / 2;
+        const CbTrieNode *const child = &self->nodes[middle];
+        const char *label = self->names[child->nameBegin] + child->labelBegin;
+        const uint32_t childCodePoint = cbUtf8Next(&label);
+
+        if (childCodePoint == codePoint)
+            return child;
+
+        if (childCodePoint < codePoint)
+            left = middle + 1;
+        else
+            right = middle;
+    }
+
+    return NULL;
+} // cbLeafTrieFindChild
+
+size_t cbLeafTrieFindPrefix( const CbLeafTrie self, const char *prefix, const char **const dst, const size_t capacity ) {
+    assert(self != NULL);
+    assert(prefix != NULL);
+    assert(dst != NULL || capacity == 0);
+
+    const CbTrieNode *node = &self->nodes[0];
+    uint32_t offset = 0;
+
+    for (;;) {
+        const uint32_t codePoint = cbUtf8Next(&prefix);
+
+        if (codePoint == 0)
+            break;
+
+        if (offset == node->labelEnd) {
+            if ((node = cbLeafTrieFindChild(self, node, codePoint)) == NULL)
+                return 0;
+            offset = node->labelBegin;
+        }
+
+        const char *const name = self->names[node->nameBegin];
+        const char *label = name + offset;
+
+        if (cbUtf8Next(&label) != codePoint)
+            return 0;
+        offset = (uint32_t)(label - name);
+    }
+
+    const size_t count = node->nameEnd - node->nameBegin;
+
+    for (size_t i = 0; i < count && i < capacity; i++)
+        dst[i] = self->names[node->nameBegin + i];
+
+    return count;
+} // cbLeafTrieFindPrefix
+
+/**
+ * @brief fuzzy match comparison function (for qsort)
+ * 
+ * @param[in] lhs first match pointer
+ * @param[in] rhs second match pointer
+ * 
+ * @return comparison result (by distance, then by name order)
+ */
+static int cbTrieFuzzyMatchCompare( const void *lhs, const void *rhs ) {
+    const CbTrieFuzzyMatch *const l = (const CbTrieFuzzyMatch *)lhs;
+    const CbTrieFuzzyMatch *const r = (const CbTrieFuzzyMatch *)rhs;
+
+    if (l->distance != r->distance)
+        return l->distance < r->distance ? -1 : 1;
+    return (l->name > r->name) - (l->name < r->name);
+} // cbTrieFuzzyMatchCompare
+
+size_t cbLeafTrieFindFuzzy( const CbLeafTrie self, const char *name, const size_t maxDistance, CbLeafMatch *const dst, const size_t capacity ) {
+    assert(self != NULL);
+    assert(name != NULL);
+    assert(dst != NULL || capacity == 0);
+
+    const size_t length = cbUtf8Length(name);
+    const size_t rowSize = length + 1;
+
+    // query code points, then distance rows by depth (row of depth d is distances from d-character name prefix to query prefixes)
+    uint32_t *const query = (uint32_t *)malloc(length * sizeof(uint32_t) + 1);
+    size_t *const rows = (size_t *)malloc((self->maxLength + 1) * rowSize * sizeof(size_t));
+    CbTrieFuzzyElement *stack = NULL;
+    size_t stackCapacity = 0;
+    size_t stackSize = 0;
+    CbTrieFuzzyMatch *matches = NULL;
+    size_t matchCapacity = 0;
+    size_t matchCount = 0;
+
+    bool ok = true
+        && query != NULL
+        && rows != NULL
+        && cbTrieReserve((void **)&stack, &stackCapacity, 1, sizeof(CbTrieFuzzyElement));
+
+    if (ok) {
+        for (size_t i = 0; i < length; i++)
+            query[i] = cbUtf8Next(&name);
+        for (size_t i = 0; i < rowSize; i++)
+            rows[i] = i;
+
+        stack[stackSize++] = (CbTrieFuzzyElement) { 0, 0 };
+    }
+
+    while (ok && stackSize > 0) {
+        const CbTrieFuzzyElement element = stack[--stackSize];
+        const CbTrieNode *const node = &self->nodes[element.node];
+        const char *label = self->names[node->nameBegin] + node->labelBegin;
+        const char *const labelEnd = self->names[node->nameBegin] + node->labelEnd;
+        size_t depth = element.depth;
+        bool isPruned = false;
+
+        while (label < labelEnd) {
+            const uint32_t codePoint = cbUtf8Next(&label);
+            const size_t *const prev = rows + depth * rowSize;
+            size_t *const row = rows + (depth + 1) * rowSize;
+            size_t rowMin = row[0] = depth + 1;
+
+            for (size_t i = 1; i < rowSize; i++) {
+                const size_t replace = prev[i - 1] + (query[i - 1] != codePoint);
+                const size_t insert = prev[i] + 1;
+                const size_t remove = row[i - 1] + 1;
+                size_t distance = replace < insert ? replace : insert;
+
+                if (remove < distance)
+                    distance = remove;
+                row[i] = distance;
+                if (distance < rowMin)
+                    rowMin = distance;
+            }
+
+            depth++;
+
+            // distances never decrease down the branch
+            if (rowMin > maxDistance) {
+                isPruned = true;
+                break;
+            }
+        }
+
+        if (isPruned)
+            continue;
+
+        const size_t distance = rows[depth * rowSize + length];
+
+        if (cbLeafTrieIsTerminal(self, node) && distance <= maxDistance) {
+            if (!cbTrieReserve((void **)&matches, &matchCapacity, matchCount + 1, sizeof(CbTrieFuzzyMatch))) {
+                ok = false;
+                break;
+            }
+            matches[matchCount++] = (CbTrieFuzzyMatch) { node->nameBegin, (uint32_t)distance };
+        }
+
+        if (!cbTrieReserve((void **)&stack, &stackCapacity, stackSize + node->childCount, sizeof(CbTrieFuzzyElement))) {
+            ok = false;
+            break;
+        }
+
+        for (uint32_t i = 0; i < node->childCount; i++)
+            stack[stackSize++] = (CbTrieFuzzyElement) { node->firstChild + i, (uint32_t)depth };
+    }
+
+    if (ok && matchCount != 0) {
+        qsort(matches, matchCount, sizeof(CbTrieFuzzyMatch), cbTrieFuzzyMatchCompare);
+
+        for (size_t i = 0; i < matchCount && i < capacity; i++)
+            dst[i] = (CbLeafMatch) { self->names[matches[i].name], matches[i].distance };
+    }
+
+    free(query);
+    free(rows);
+    free(stack);
+    free(matches);
+
+    return ok ? matchCount : 0;
+} // cbLeafTrieFindFuzzy
+
+size_t cbLeafTrieMemoryUsage( const CbLeafTrie self ) {
+    assert(self != NULL);
+
+    return 0
+        + sizeof(CbLeafTrieImpl)
+        + self->stringsSize
+        + self->nameCount * sizeof(const char *)
+        + self->nodeCount * sizeof(CbTrieNode);
+} // cbLeafTrieMemoryUsage
+
+// cb_trie.c
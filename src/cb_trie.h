@@ -0,0 +1,87 @@
+/**
+ * @brief leaf name trie declaration file
+ */
+
+#ifndef CB_TRIE_H_
+#define CB_TRIE_H_
+
+#include <stddef.h>
+
+#include "cb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // defined(__cplusplus)
+
+/// @brief read-only leaf name index handle (radix trie keyed on UTF-8 code points)
+typedef struct __CbLeafTrieImpl * CbLeafTrie;
+
+/// @brief approximate leaf name match
+typedef struct __CbLeafMatch {
+    const char *name;     ///< leaf name (owned by trie)
+    size_t      distance; ///< edit distance to query (in code points)
+} CbLeafMatch;
+
+/**
+ * @brief leaf trie constructor
+ * 
+ * @param[in] cb cb to index leaves of (non-null)
+ * 
+ * @return trie handle, NULL if allocation failed or tree has too many leaves.
+ * 
+ * @note names are copied, so cb may be changed or destroyed after. trie isn't updated
+ * by insertions, so it takes O(n log n) and should be built once per tree change, not per search.
+ */
+CbLeafTrie cbLeafTrieCtor( const Cb cb );
+
+/**
+ * @brief leaf trie destructor
+ * 
+ * @param[in] self trie to destroy (nullable)
+ */
+void cbLeafTrieDtor( CbLeafTrie self );
+
+/**
+ * @brief leaf names by prefix finding function
+ * 
+ * @param[in]  self     trie (non-null)
+ * @param[in]  prefix   name prefix (non-null, compared by code points)
+ * @param[out] dst      found names destination (nullable if capacity is 0)
+ * @param[in]  capacity dst capacity
+ * 
+ * @return count of names with such prefix (only first capacity of them are written, in code point order)
+ */
+size_t cbLeafTrieFindPrefix( const CbLeafTrie self, const char *prefix, const char **dst, size_t capacity );
+
+/**
+ * @brief leaf names by edit distance finding function
+ * 
+ * @param[in]  self        trie (non-null)
+ * @param[in]  name        name to find close ones to (non-null)
+ * @param[in]  maxDistance maximal Levenshtein distance (in code points)
+ * @param[out] dst         matches destination (nullable if capacity is 0)
+ * @param[in]  capacity    dst capacity
+ * 
+ * @return count of names within maxDistance (only first capacity of them are written, closest first),
+ *         0 if allocation failed
+ * 
+ * @note branches that can't come within maxDistance are skipped, so small distances are fast.
+ */
+size_t cbLeafTrieFindFuzzy( const CbLeafTrie self, const char *name, size_t maxDistance, CbLeafMatch *dst, size_t capacity );
+
+/**
+ * @brief trie memory usage getting function
+ * 
+ * @param[in] self trie (non-null)
+ * 
+ * @return count of bytes allocated by trie
+ */
+size_t cbLeafTrieMemoryUsage( const CbLeafTrie self );
+
+#ifdef __cplusplus
+}
+#endif // defined(__cplusplus)
+
+#endif // !defined(CB_TRIE_H_)
+
+// cb_trie.h
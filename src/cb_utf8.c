@@ -0,0 +1,73 @@
+/**
+ * @brief UTF-8 decoding utilities implementation file
+ */
+
+#include <assert.h>
+
+#include "cb_utf8.h"
+
+uint32_t cbUtf8Next( const char **const str ) {
+    assert(str != NULL && *str != NULL);
+
+    const uint8_t *const bytes = (const uint8_t *)*str;
+    uint32_t codePoint = bytes[0];
+    size_t length = 1;
+
+    if (bytes[0] == 0)
+        return 0;
+
+    // 1 byte
+    if ((bytes[0] & 0x80) == 0x00) {
+        *str += 1;
+        return codePoint;
+    }
+
+    // 2, 3 and 4 bytes, lead byte keeps 5, 4 and 3 bits
+    if ((bytes[0] & 0xE0) == 0xC0) {
+        length = 2;
+        codePoint = bytes[0] & 0x1F;
+    } else if ((bytes[0] & 0xF0) == 0xE0) {
+        length = 3;
+        codePoint = bytes[0] & 0x0F;
+    } else if ((bytes[0] & 0xF8) == 0xF0) {
+        length = 4;
+        codePoint = bytes[0] & 0x07;
+    } else {
+        *str += 1;
+        return CB_UTF8_INVALID + bytes[0];
+    }
+
+    // terminator isn't continuation byte, so truncated sequence is never read past string end
+    for (size_t i = 1; i < length; i++) {
+        if ((bytes[i] & 0xC0) != 0x80) {
+            *str += 1;
+            return CB_UTF8_INVALID + bytes[0];
+        }
+        codePoint = (codePoint << 6) | (bytes[i] & 0x3F);
+    }
+
+    // overlong and out of range sequences would make different strings equal
+    static const uint32_t minCodePoints[] = {0, 0, 0x80, 0x800, 0x10000};
+
+    if (codePoint < minCodePoints[length] || codePoint >= CB_UTF8_INVALID) {
+        *str += 1;
+        return CB_UTF8_INVALID + bytes[0];
+    }
+
+    *str += length;
+
+    return codePoint;
+} // cbUtf8Next
+
+size_t cbUtf8Length( const char *str ) {
+    assert(str != NULL);
+
+    size_t length = 0;
+
+    while (cbUtf8Next(&str) != 0)
+        length++;
+
+    return length;
+} // cbUtf8Length
+
+// cb_utf8.c
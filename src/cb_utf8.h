@@ -0,0 +1,46 @@
+/**
+ * @brief UTF-8 decoding utilities declaration file
+ */
+
+#ifndef CB_UTF8_H_
+#define CB_UTF8_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // defined(__cplusplus)
+
+/// @brief first code point invalid bytes are decoded to (invalid byte b is decoded to CB_UTF8_INVALID + b)
+#define CB_UTF8_INVALID ((uint32_t)0x110000)
+
+/**
+ * @brief single UTF-8 character decoding function
+ * 
+ * @param[in,out] str pointer to string to decode character from (non-null, zero-terminated, moved to next character)
+ * 
+ * @return code point, 0 at string end (string isn't moved then)
+ * 
+ * @note invalid byte (including byte of truncated sequence) is decoded as single character above Unicode range,
+ *       so any string is decoded deterministically and different strings are decoded differently.
+ */
+uint32_t cbUtf8Next( const char **str );
+
+/**
+ * @brief UTF-8 string length computation function
+ * 
+ * @param[in] str zero-terminated string (non-null)
+ * 
+ * @return count of characters (in terms of cbUtf8Next)
+ */
+size_t cbUtf8Length( const char *str );
+
+#ifdef __cplusplus
+}
+#endif // defined(__cplusplus)
+
+#endif // !defined(CB_UTF8_H_)
+
+// cb_utf8.h